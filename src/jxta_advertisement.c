@@ -73,6 +73,7 @@ static const char *__log_cat = "ADV";
 #include "jxta_discovery_config_adv.h"
 #include "jxta_endpoint_config_adv.h"
 #include "jxta_rdv_config_adv.h"
+#include "jxta_resolver_config_adv.h"
 #include "jxta_srdi_config_adv.h"
 #include "jxta_tls_config_adv.h"
 #include "jxta_rdv_lease_options.h"
@@ -940,6 +941,7 @@ void jxta_advertisement_register_global_handlers(void)
     jxta_advertisement_register_global_handler("jxta:DiscoveryConfig", (JxtaAdvertisementNewFunc) jxta_DiscoveryConfigAdvertisement_new );
     jxta_advertisement_register_global_handler("jxta:EndPointConfig", (JxtaAdvertisementNewFunc) jxta_EndPointConfigAdvertisement_new );
     jxta_advertisement_register_global_handler("jxta:RdvConfig", (JxtaAdvertisementNewFunc) jxta_RdvConfigAdvertisement_new );
+    jxta_advertisement_register_global_handler("jxta:ResolverConfig", (JxtaAdvertisementNewFunc) jxta_ResolverConfigAdvertisement_new );
     jxta_advertisement_register_global_handler("jxta:SrdiConfig", (JxtaAdvertisementNewFunc) jxta_SrdiConfigAdvertisement_new );
     jxta_advertisement_register_global_handler("jxta:TCPTransportAdvertisement", (JxtaAdvertisementNewFunc) jxta_TCPTransportAdvertisement_new );
     jxta_advertisement_register_global_handler("jxta:TlsConfigAdvertisement", (JxtaAdvertisementNewFunc) jxta_TlsConfigAdvertisement_new );
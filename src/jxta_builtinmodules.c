@@ -71,6 +71,7 @@ Jxta_builtinmodule_record jxta_builtinmodules_tbl[] = {
     {"transport_http", jxta_transport_http_new_instance},
     {"transport_tcp", jxta_transport_tcp_new_instance},
     {"transport_tls", jxta_transport_tls_new_instance},
+    {"transport_loopback", jxta_transport_loopback_new_instance},
     {"router_client", jxta_router_client_new_instance},
     {"pipe_service", jxta_pipe_service_new_instance},
     {"null_membership_service", jxta_membership_service_null_new_instance},
@@ -85,6 +85,7 @@ extern Jxta_module *jxta_discovery_service_ref_new_instance(void);
 extern Jxta_module *jxta_transport_http_new_instance(void);
 extern Jxta_module *jxta_transport_tcp_new_instance(void);
 extern Jxta_module *jxta_transport_tls_new_instance(void);
+extern Jxta_module *jxta_transport_loopback_new_instance(void);
 extern Jxta_module *jxta_netpg_new_instance(void);
 extern Jxta_module *jxta_stdpg_new_instance(void);
 extern Jxta_module *jxta_router_client_new_instance(void);
@@ -191,6 +191,20 @@ JXTA_DECLARE(Jxta_status)
 
 }
 
+JXTA_DECLARE(Jxta_status)
+    discovery_service_add_publish_listener(Jxta_discovery_service * service, Jxta_listener * listener)
+{
+    PTValid(service, Jxta_discovery_service);
+    return VTBL->add_publish_listener(service, listener);
+}
+
+JXTA_DECLARE(Jxta_status)
+    discovery_service_remove_publish_listener(Jxta_discovery_service * service, Jxta_listener * listener)
+{
+    PTValid(service, Jxta_discovery_service);
+    return VTBL->remove_publish_listener(service, listener);
+}
+
 JXTA_DECLARE(Jxta_status)
     discovery_service_get_lifetime(Jxta_discovery_service * service, short type, Jxta_id * advId, Jxta_expiration_time * exp)
 {
@@ -321,6 +321,25 @@ JXTA_DECLARE(Jxta_status) discovery_service_add_discovery_listener(Jxta_discover
 JXTA_DECLARE(Jxta_status) discovery_service_remove_discovery_listener(Jxta_discovery_service * service,
                                                                       Jxta_discovery_listener * listener);
 
+/**
+ * register a listener to be notified of the advertisements saved in the local cache, either published locally or
+ * received in discovery responses. The listener is invoked by the publishing thread with the advertisement.
+ * @param  Jxta_discovery_service the service
+ * @param  Jxta_listener the listener to register
+ * @return Jxta_status
+ * @see Jxta_status
+ */
+JXTA_DECLARE(Jxta_status) discovery_service_add_publish_listener(Jxta_discovery_service * service, Jxta_listener * listener);
+
+/**
+ * remove a publish listener
+ * @param  Jxta_discovery_service the service
+ * @param  Jxta_listener to remove
+ * @return Jxta_status
+ * @see Jxta_status
+ */
+JXTA_DECLARE(Jxta_status) discovery_service_remove_publish_listener(Jxta_discovery_service * service, Jxta_listener * listener);
+
 /**
  * Get an advertisement's lifetime value
  *
@@ -125,6 +125,10 @@ struct _jxta_discovery_service_methods {
      Jxta_status(*getLifetime) (Jxta_discovery_service * service, short type, Jxta_id * advId, Jxta_expiration_time * exp);
 
      Jxta_status(*getExpiration) (Jxta_discovery_service * service, short type, Jxta_id * advId, Jxta_expiration_time * exp);
+
+     Jxta_status(*add_publish_listener) (Jxta_discovery_service * self, Jxta_listener * listener);
+
+     Jxta_status(*remove_publish_listener) (Jxta_discovery_service * self, Jxta_listener * listener);
 };
 
 Jxta_status getLocalGroupsQuery (Jxta_discovery_service * self, const char *query,
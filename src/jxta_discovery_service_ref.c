@@ -109,6 +109,8 @@ typedef struct {
     Jxta_srdi_service *srdi;
     /* vector to hold generic discovery listeners */
     Jxta_vector *listener_vec;
+    /* vector to hold the listeners of the advertisements saved in the cm */
+    Jxta_vector *publish_listener_vec;
     /* hashtable to hold specific query listeners */
     Jxta_hashtable *listeners;
     Jxta_PID *localPeerId;
@@ -313,6 +315,7 @@ static Jxta_status init(Jxta_module * module, Jxta_PG * group, Jxta_id * assigne
 
     /* Create vector and hashtable for the listeners */
     discovery->listener_vec = jxta_vector_new(1);
+    discovery->publish_listener_vec = jxta_vector_new(1);
     discovery->listeners = jxta_hashtable_new(1);
 
     /* Mark the service as running now. */
@@ -1005,6 +1008,23 @@ static Jxta_status query_srdi(Jxta_discovery_service_ref * self, Jxta_query_cont
     return status;
 }
 
+static void publish_notify(Jxta_discovery_service_ref * discovery, Jxta_advertisement * adv)
+{
+    Jxta_listener *listener = NULL;
+    unsigned int i;
+
+    if (NULL == discovery->publish_listener_vec) {
+        return;
+    }
+    for (i = 0; i < jxta_vector_size(discovery->publish_listener_vec); i++) {
+        if (JXTA_SUCCESS != jxta_vector_get_object_at(discovery->publish_listener_vec, JXTA_OBJECT_PPTR(&listener), i)) {
+            continue;
+        }
+        jxta_listener_process_object(listener, (Jxta_object *) adv);
+        JXTA_OBJECT_RELEASE(listener);
+    }
+}
+
 static Jxta_status publish_priv(Jxta_discovery_service * service, Jxta_advertisement * adv, short type,
                     Jxta_expiration_time lifetime, Jxta_expiration_time lifetimeForOthers, Jxta_boolean update)
 {
@@ -1051,6 +1071,9 @@ static Jxta_status publish_priv(Jxta_discovery_service * service, Jxta_advertise
     stat = cm_save(self->cm, (char *) dirname[type], (char *) jstring_get_string(id_str), adv, lifetime, lifetimeForOthers, update);
     JXTA_OBJECT_RELEASE(id);
     JXTA_OBJECT_RELEASE(id_str);
+    if (JXTA_SUCCESS == stat) {
+        publish_notify(self, adv);
+    }
     return stat;
 }
 
@@ -1227,6 +1250,28 @@ Jxta_status remove_listener(Jxta_discovery_service * service, Jxta_discovery_lis
     return JXTA_SUCCESS;
 }
 
+Jxta_status add_publish_listener(Jxta_discovery_service * service, Jxta_listener * listener)
+{
+    Jxta_discovery_service_ref *discovery = (Jxta_discovery_service_ref *) service;
+
+    return (jxta_vector_add_object_last(discovery->publish_listener_vec, (Jxta_object *) listener));
+}
+
+Jxta_status remove_publish_listener(Jxta_discovery_service * service, Jxta_listener * listener)
+{
+    Jxta_discovery_service_ref *me = (Jxta_discovery_service_ref *) service;
+
+    if (!service) {
+        return JXTA_INVALID_ARGUMENT;
+    }
+
+    if (jxta_vector_remove_object(me->publish_listener_vec, (Jxta_object *) listener) < 0) {
+        return JXTA_FAILED;
+    }
+
+    return JXTA_SUCCESS;
+}
+
 /* BEGINING OF STANDARD SERVICE IMPLEMENTATION CODE */
 
 /**
@@ -1262,7 +1307,9 @@ Jxta_discovery_service_ref_methods jxta_discovery_service_ref_methods = {
     add_listener,
     remove_listener,
     getLifetime,
-    getExpiration
+    getExpiration,
+    add_publish_listener,
+    remove_publish_listener
 };
 
 void jxta_discovery_service_ref_construct(Jxta_discovery_service_ref * discovery, Jxta_discovery_service_ref_methods * methods)
@@ -1309,6 +1356,9 @@ void jxta_discovery_service_ref_destruct(Jxta_discovery_service_ref * discovery)
     if (discovery->listener_vec != NULL) {
         JXTA_OBJECT_RELEASE(discovery->listener_vec);
     }
+    if (discovery->publish_listener_vec != NULL) {
+        JXTA_OBJECT_RELEASE(discovery->publish_listener_vec);
+    }
     if (discovery->listeners != NULL) {
         JXTA_OBJECT_RELEASE(discovery->listeners);
     }
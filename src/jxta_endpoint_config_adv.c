@@ -84,6 +84,15 @@ struct _jxta_EndPointConfigAdvertisement {
     Jxta_time_diff nc_timeout_max;
     size_t ncrq_size;
     size_t ncrq_retry;
+    size_t ncrq_bytes;
+    size_t nc_total_bytes;
+    int poll_reactors;
+    int pollset_size;
+    int outq_depth;
+    int outq_workers;
+    int outq_quantum;
+    int msgr_max;
+    Jxta_time_diff msgr_idle_timeout;
 };
 
 /* Forward decl. of un-exported function */
@@ -122,6 +131,66 @@ static void handleNegativeCache(void *me, const XML_Char * cd, int len)
             _self->ncrq_size = atoi(atts[1]);
         } else if (0 == strcmp(*atts, "msgToRetry")) {
             _self->ncrq_retry = atoi(atts[1]);
+        } else if (0 == strcmp(*atts, "queueBytes")) {
+            _self->ncrq_bytes = atoi(atts[1]);
+        } else if (0 == strcmp(*atts, "totalBytes")) {
+            _self->nc_total_bytes = atoi(atts[1]);
+        }
+        atts += 2;
+    }
+}
+
+static void handlePoll(void *me, const XML_Char * cd, int len)
+{
+    Jxta_EndPointConfigAdvertisement *_self = (Jxta_EndPointConfigAdvertisement *) me;
+    const char **atts = ((Jxta_advertisement *) me)->atts;
+
+    while (atts && *atts) {
+        if (0 == strcmp(*atts, "reactors")) {
+            _self->poll_reactors = atoi(atts[1]);
+            if (_self->poll_reactors < 1) {
+                _self->poll_reactors = 1;
+            }
+        } else if (0 == strcmp(*atts, "pollsetSize")) {
+            _self->pollset_size = atoi(atts[1]);
+        }
+        atts += 2;
+    }
+}
+
+static void handleMessengers(void *me, const XML_Char * cd, int len)
+{
+    Jxta_EndPointConfigAdvertisement *_self = (Jxta_EndPointConfigAdvertisement *) me;
+    const char **atts = ((Jxta_advertisement *) me)->atts;
+
+    while (atts && *atts) {
+        if (0 == strcmp(*atts, "max")) {
+            _self->msgr_max = atoi(atts[1]);
+        } else if (0 == strcmp(*atts, "idleTimeout")) {
+            _self->msgr_idle_timeout = apr_atoi64(atts[1]) * 1000;
+        }
+        atts += 2;
+    }
+}
+
+static void handleOutQueue(void *me, const XML_Char * cd, int len)
+{
+    Jxta_EndPointConfigAdvertisement *_self = (Jxta_EndPointConfigAdvertisement *) me;
+    const char **atts = ((Jxta_advertisement *) me)->atts;
+
+    while (atts && *atts) {
+        if (0 == strcmp(*atts, "depth")) {
+            _self->outq_depth = atoi(atts[1]);
+        } else if (0 == strcmp(*atts, "workers")) {
+            _self->outq_workers = atoi(atts[1]);
+            if (_self->outq_workers < 1) {
+                _self->outq_workers = 1;
+            }
+        } else if (0 == strcmp(*atts, "quantum")) {
+            _self->outq_quantum = atoi(atts[1]);
+            if (_self->outq_quantum < 1) {
+                _self->outq_quantum = 1;
+            }
         }
         atts += 2;
     }
@@ -167,6 +236,96 @@ JXTA_DECLARE(size_t) jxta_epcfg_get_ncrq_retry(Jxta_EndPointConfigAdvertisement
     return me->ncrq_retry;
 }
 
+JXTA_DECLARE(void) jxta_epcfg_set_ncrq_bytes(Jxta_EndPointConfigAdvertisement * me, size_t sz)
+{
+    me->ncrq_bytes = sz;
+}
+
+JXTA_DECLARE(size_t) jxta_epcfg_get_ncrq_bytes(Jxta_EndPointConfigAdvertisement * me)
+{
+    return me->ncrq_bytes;
+}
+
+JXTA_DECLARE(void) jxta_epcfg_set_nc_total_bytes(Jxta_EndPointConfigAdvertisement * me, size_t sz)
+{
+    me->nc_total_bytes = sz;
+}
+
+JXTA_DECLARE(size_t) jxta_epcfg_get_nc_total_bytes(Jxta_EndPointConfigAdvertisement * me)
+{
+    return me->nc_total_bytes;
+}
+
+JXTA_DECLARE(void) jxta_epcfg_set_poll_reactors(Jxta_EndPointConfigAdvertisement * me, int cnt)
+{
+    me->poll_reactors = (cnt < 1) ? 1 : cnt;
+}
+
+JXTA_DECLARE(int) jxta_epcfg_get_poll_reactors(Jxta_EndPointConfigAdvertisement * me)
+{
+    return me->poll_reactors;
+}
+
+JXTA_DECLARE(void) jxta_epcfg_set_pollset_size(Jxta_EndPointConfigAdvertisement * me, int sz)
+{
+    me->pollset_size = sz;
+}
+
+JXTA_DECLARE(int) jxta_epcfg_get_pollset_size(Jxta_EndPointConfigAdvertisement * me)
+{
+    return me->pollset_size;
+}
+
+JXTA_DECLARE(void) jxta_epcfg_set_outq_depth(Jxta_EndPointConfigAdvertisement * me, int depth)
+{
+    me->outq_depth = depth;
+}
+
+JXTA_DECLARE(int) jxta_epcfg_get_outq_depth(Jxta_EndPointConfigAdvertisement * me)
+{
+    return me->outq_depth;
+}
+
+JXTA_DECLARE(void) jxta_epcfg_set_outq_workers(Jxta_EndPointConfigAdvertisement * me, int cnt)
+{
+    me->outq_workers = (cnt < 1) ? 1 : cnt;
+}
+
+JXTA_DECLARE(int) jxta_epcfg_get_outq_workers(Jxta_EndPointConfigAdvertisement * me)
+{
+    return me->outq_workers;
+}
+
+JXTA_DECLARE(void) jxta_epcfg_set_outq_quantum(Jxta_EndPointConfigAdvertisement * me, int quantum)
+{
+    me->outq_quantum = (quantum < 1) ? 1 : quantum;
+}
+
+JXTA_DECLARE(int) jxta_epcfg_get_outq_quantum(Jxta_EndPointConfigAdvertisement * me)
+{
+    return me->outq_quantum;
+}
+
+JXTA_DECLARE(void) jxta_epcfg_set_messengers_max(Jxta_EndPointConfigAdvertisement * me, int max)
+{
+    me->msgr_max = max;
+}
+
+JXTA_DECLARE(int) jxta_epcfg_get_messengers_max(Jxta_EndPointConfigAdvertisement * me)
+{
+    return me->msgr_max;
+}
+
+JXTA_DECLARE(void) jxta_epcfg_set_messengers_idle_timeout(Jxta_EndPointConfigAdvertisement * me, int timeout)
+{
+    me->msgr_idle_timeout = (Jxta_time_diff) timeout * 1000;
+}
+
+JXTA_DECLARE(Jxta_time_diff) jxta_epcfg_get_messengers_idle_timeout(Jxta_EndPointConfigAdvertisement * me)
+{
+    return me->msgr_idle_timeout;
+}
+
 /** Now, build an array of the keyword structs.  Since 
  * a top-level, or null state may be of interest, 
  * let that lead off.  Then, walk through the enums,
@@ -179,6 +338,9 @@ static const Kwdtab Jxta_EndPointConfigAdvertisement_tags[] = {
     {"Null", Null_, NULL, NULL, NULL},
     {"jxta:EndPointConfig", Null_, *handleJxta_EndPointConfigAdvertisement, NULL, NULL},
     {"NegativeCache", Null_, *handleNegativeCache, NULL, NULL},
+    {"Poll", Null_, *handlePoll, NULL, NULL},
+    {"OutQueue", Null_, *handleOutQueue, NULL, NULL},
+    {"Messengers", Null_, *handleMessengers, NULL, NULL},
     {NULL, 0, 0, NULL, NULL}
 };
 
@@ -202,7 +364,23 @@ JXTA_DECLARE(Jxta_status) jxta_EndPointConfigAdvertisement_get_xml(Jxta_EndPoint
     jstring_append_2(string, tmpbuf);
     apr_snprintf(tmpbuf, sizeof(tmpbuf), " msgToRetry=\"%d\"\n", me->ncrq_retry);
     jstring_append_2(string, tmpbuf);
+    apr_snprintf(tmpbuf, sizeof(tmpbuf), "  queueBytes=\"%d\"", me->ncrq_bytes);
+    jstring_append_2(string, tmpbuf);
+    apr_snprintf(tmpbuf, sizeof(tmpbuf), " totalBytes=\"%d\"\n", me->nc_total_bytes);
+    jstring_append_2(string, tmpbuf);
     jstring_append_2(string, "/>\n");
+    jstring_append_2(string, "<!-- Poll reactors - number of pollset shards serving the connections -->\n");
+    apr_snprintf(tmpbuf, sizeof(tmpbuf), "<Poll reactors=\"%d\" pollsetSize=\"%d\"/>\n", me->poll_reactors,
+                 me->pollset_size);
+    jstring_append_2(string, tmpbuf);
+    jstring_append_2(string, "<!-- OutQueue - messages queued per destination, sending threads, messages sent per turn -->\n");
+    apr_snprintf(tmpbuf, sizeof(tmpbuf), "<OutQueue depth=\"%d\" workers=\"%d\" quantum=\"%d\"/>\n", me->outq_depth,
+                 me->outq_workers, me->outq_quantum);
+    jstring_append_2(string, tmpbuf);
+    jstring_append_2(string, "<!-- Messengers - cached messengers, idle timeout in seconds -->\n");
+    apr_snprintf(tmpbuf, sizeof(tmpbuf), "<Messengers max=\"%d\" idleTimeout=\"%d\"/>\n", me->msgr_max,
+                 (int) (me->msgr_idle_timeout / 1000));
+    jstring_append_2(string, tmpbuf);
     jstring_append_2(string, "</jxta:EndPointConfig>\n");
 
     *result = string;
@@ -225,6 +403,15 @@ Jxta_EndPointConfigAdvertisement *jxta_EndPointConfigAdvertisement_construct(Jxt
         self->nc_timeout_max = (Jxta_time_diff) 5 * 60 * 1000;
         self->ncrq_size = 5;
         self->ncrq_retry = 20;
+        self->ncrq_bytes = 256 * 1024;
+        self->nc_total_bytes = 4 * 1024 * 1024;
+        self->poll_reactors = 4;
+        self->pollset_size = 1024;
+        self->outq_depth = 256;
+        self->outq_workers = 4;
+        self->outq_quantum = 4;
+        self->msgr_max = 4096;
+        self->msgr_idle_timeout = (Jxta_time_diff) 15 * 60 * 1000;
     }
 
     return self;
@@ -90,6 +90,49 @@ JXTA_DECLARE(size_t) jxta_epcfg_get_ncrq_size(Jxta_EndPointConfigAdvertisement *
 JXTA_DECLARE(void) jxta_epcfg_set_ncrq_retry(Jxta_EndPointConfigAdvertisement * me, size_t cnt);
 JXTA_DECLARE(size_t) jxta_epcfg_get_ncrq_retry(Jxta_EndPointConfigAdvertisement * me);
 
+/**
+*   Maximum number of bytes held by the retransmit queue of an unreachable peer and by all the retransmit queues, 0 for no
+*   limit. The oldest messages are dropped first.
+**/
+JXTA_DECLARE(void) jxta_epcfg_set_ncrq_bytes(Jxta_EndPointConfigAdvertisement * me, size_t sz);
+JXTA_DECLARE(size_t) jxta_epcfg_get_ncrq_bytes(Jxta_EndPointConfigAdvertisement * me);
+
+JXTA_DECLARE(void) jxta_epcfg_set_nc_total_bytes(Jxta_EndPointConfigAdvertisement * me, size_t sz);
+JXTA_DECLARE(size_t) jxta_epcfg_get_nc_total_bytes(Jxta_EndPointConfigAdvertisement * me);
+
+/**
+*   Number of reactors (pollset shards) used by the endpoint service to poll the transport connections, and the number of
+*   sockets each of the pollsets is created for.
+**/
+JXTA_DECLARE(void) jxta_epcfg_set_poll_reactors(Jxta_EndPointConfigAdvertisement * me, int cnt);
+JXTA_DECLARE(int) jxta_epcfg_get_poll_reactors(Jxta_EndPointConfigAdvertisement * me);
+
+JXTA_DECLARE(void) jxta_epcfg_set_pollset_size(Jxta_EndPointConfigAdvertisement * me, int sz);
+JXTA_DECLARE(int) jxta_epcfg_get_pollset_size(Jxta_EndPointConfigAdvertisement * me);
+
+/**
+*   Outgoing message queues: maximum number of messages queued per destination (0 for no limit), number of threads
+*   sending the queued messages and number of messages sent to a destination before moving on to the next one.
+**/
+JXTA_DECLARE(void) jxta_epcfg_set_outq_depth(Jxta_EndPointConfigAdvertisement * me, int depth);
+JXTA_DECLARE(int) jxta_epcfg_get_outq_depth(Jxta_EndPointConfigAdvertisement * me);
+
+JXTA_DECLARE(void) jxta_epcfg_set_outq_workers(Jxta_EndPointConfigAdvertisement * me, int cnt);
+JXTA_DECLARE(int) jxta_epcfg_get_outq_workers(Jxta_EndPointConfigAdvertisement * me);
+
+JXTA_DECLARE(void) jxta_epcfg_set_outq_quantum(Jxta_EndPointConfigAdvertisement * me, int quantum);
+JXTA_DECLARE(int) jxta_epcfg_get_outq_quantum(Jxta_EndPointConfigAdvertisement * me);
+
+/**
+*   Messenger cache: maximum number of cached messengers (0 for no limit) and time in seconds after which a messenger not
+*   used to send is released (0 to keep them).
+**/
+JXTA_DECLARE(void) jxta_epcfg_set_messengers_max(Jxta_EndPointConfigAdvertisement * me, int max);
+JXTA_DECLARE(int) jxta_epcfg_get_messengers_max(Jxta_EndPointConfigAdvertisement * me);
+
+JXTA_DECLARE(void) jxta_epcfg_set_messengers_idle_timeout(Jxta_EndPointConfigAdvertisement * me, int timeout);
+JXTA_DECLARE(Jxta_time_diff) jxta_epcfg_get_messengers_idle_timeout(Jxta_EndPointConfigAdvertisement * me);
+
 /**
 *   For other advertisement types which want to parse EndPointConfig as a sub-section.    
 **/
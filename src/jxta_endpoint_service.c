@@ -84,24 +84,67 @@ static const char *__log_cat = "ENDPOINT";
 #include "jxta_endpoint_service_priv.h"
 #include "jxta_util_priv.h"
 
+/* message queued for retransmission to an unreachable peer */
+typedef struct _nc_msg {
+    APR_RING_ENTRY(_nc_msg) link;       /* retransmit queue of the peer */
+    APR_RING_ENTRY(_nc_msg) fifo;       /* all the queued messages, oldest first */
+    struct _nc_entry *peer;
+    Jxta_message *msg;
+    apr_size_t size;
+} Nc_msg;
+
 /* negative cache entry */
 typedef struct _nc_entry {
+    APR_RING_ENTRY(_nc_entry) timer;    /* timer wheel slot of the expiration */
     char *addr;
     Jxta_time_diff timeout;
     Jxta_time expiration;
-    Jxta_message **rq;
-    int rq_head;
-    int rq_tail;
+    Jxta_boolean closed;        /* no retransmit queue, or dropped after the maximum timeout */
+    APR_RING_HEAD(nc_rq, _nc_msg) rq;
+    int rq_cnt;
     int rq_capacity;
+    apr_size_t rq_bytes;
 } Nc_entry;
 
+/* negative cache timer wheel, a tick of NC_WHEEL_TICK ms per slot */
+#define NC_WHEEL_SLOTS 64
+#define NC_WHEEL_TICK 1000
+
 /* outgoing message task for thread pool */
 typedef struct _msg_task {
     Jxta_endpoint_service *ep_svc;
     Jxta_message *msg;
+    struct _msg_task *next;     /* next message of the destination queue */
     struct _msg_task *recycle;
+    struct ep_sched_dest *dest; /* destination and class the message was taken from */
+    struct ep_sched_class *cls;
 } Msg_task;
 
+/*
+ * Queue of the outgoing messages of a priority class for one destination. A destination is served by one task at a time,
+ * it leaves the active ring while busy.
+ */
+typedef struct ep_sched_dest {
+    APR_RING_ENTRY(ep_sched_dest) link;
+    char *ta;
+    int weight;
+    int deficit;
+    apr_size_t depth;
+    Jxta_boolean busy;
+    Msg_task *head;
+    Msg_task *tail;
+} Ep_sched_dest;
+
+/* priority class of the outgoing scheduler, destinations with queued messages are served round robin */
+typedef struct ep_sched_class {
+    apr_hash_t *dests;
+    APR_RING_HEAD(ep_sched_ring, ep_sched_dest) active;
+    Jxta_endpoint_send_stats stats;
+} Ep_sched_class;
+
+/* number of messages a scheduler task sends before giving its thread back to the pool */
+#define EP_SCHED_BATCH 16
+
 /* recipient callback */
 typedef struct _cb_elt {
     Jxta_endpoint_service *ep_svc;
@@ -111,18 +154,58 @@ typedef struct _cb_elt {
     struct _cb_elt *recycle;
 } Cb_elt;
 
+/* poll reactor, one shard of the sockets polled by the endpoint */
+typedef struct ep_reactor {
+    Jxta_endpoint_service *ep_svc;
+    int idx;
+    apr_thread_mutex_t *mutex;
+    apr_pollset_t *pollset;
+    volatile apr_size_t pollfd_cnt;
+} Ep_reactor;
+
 /* transport connection */
 typedef struct tc_elt {
     apr_pollfd_t fd;
     Jxta_callback_fn fn;
     void * arg;
+    Ep_reactor *reactor;
+    Jxta_boolean paused;
 } Tc_elt;
 
+/* entry of a demux snapshot hash table, empty when key is NULL */
+typedef struct demux_entry {
+    unsigned int hash;
+    char *key;
+    Jxta_callback_func func;
+    void *arg;
+    Jxta_listener *listener;
+} Demux_entry;
+
+/*
+ * Immutable copy of the filters, recipients and listeners used by the demux path. A new snapshot is published on each
+ * registration change, readers hold a reference on the snapshot they use.
+ */
+typedef struct demux_snapshot {
+    volatile apr_uint32_t refs;
+    int filter_cnt;
+    struct _Filter *filters;
+    unsigned int cb_mask;
+    Demux_entry *cbs;
+    unsigned int listener_mask;
+    Demux_entry *listeners;
+} Demux_snapshot;
+
 typedef struct peer_route_elt {
+    APR_RING_ENTRY(peer_route_elt) lru;
     char * ta;
     JxtaEndpointMessenger * msgr;
+    Jxta_time last_used;
+    struct peer_route_elt * alias;  /* entry of the same messenger under the other address of the peer */
 } Peer_route_elt;
 
+/* period of the check for idle messengers, in ms */
+#define MSGR_CHECK_INTERVAL (60 * 1000)
+
 struct jxta_endpoint_service {
     Extends(Jxta_service);
 
@@ -141,14 +224,33 @@ struct jxta_endpoint_service {
     /* Current messengers */
     /* Each messenger could have two entries, one for peer ID, the other with transport addr */
     apr_hash_t *messengers;
+    APR_RING_HEAD(msgr_lru, peer_route_elt) msgr_lru;  /* least recently used first */
+    apr_size_t msgr_max;
+    Jxta_time_diff msgr_idle;
+    Jxta_endpoint_messenger_stats msgr_stats;
+    Jxta_boolean msgr_trim_pending;
 
     /* Outgoing messages */
     Msg_task *recycled_tasks;
     volatile apr_uint32_t msg_task_cnt;
+    apr_thread_mutex_t *sched_mutex;
+    Ep_sched_class sched[JXTA_ENDPOINT_SEND_CLASSES];
+    apr_hash_t *sched_weights;  /* weights set per transport address */
+    int sched_workers;
+    int sched_max_workers;
+    int sched_quantum;
+    apr_size_t sched_max_depth;
 
     /* Negatice cache */
     apr_thread_mutex_t *nc_wlock; /* write lock for nc, use mutex for read lock */
     apr_hash_t *nc;             /* negative cache */
+    APR_RING_HEAD(nc_slot, _nc_entry) nc_wheel[NC_WHEEL_SLOTS];
+    apr_int64_t nc_tick;        /* last tick reviewed */
+    Jxta_boolean nc_timer_armed;
+    APR_RING_HEAD(nc_fifo, _nc_msg) nc_fifo;
+    apr_size_t nc_max_bytes;
+    apr_size_t nc_peer_max_bytes;
+    Jxta_endpoint_nc_stats nc_stats;
 
     /* Endpoint demux */
     apr_thread_mutex_t *demux_mutex;
@@ -156,14 +258,26 @@ struct jxta_endpoint_service {
     Cb_elt *recycled_cbs;
     Dlist *filter_list;
     apr_hash_t *listener_table;
+    /* current snapshot of the above for the demux path, changed only with demux_mutex held */
+    Demux_snapshot * volatile demux_snap;
+    volatile apr_uint32_t demux_epoch;
+    volatile apr_uint32_t demux_readers[2];
 
     /* Nonblocking I/O */
-    volatile apr_size_t pollfd_cnt;
-    apr_pollset_t *pollset;
+    int reactor_cnt;
+    Ep_reactor *reactors;
 };
 
 static Jxta_listener *lookup_listener(Jxta_endpoint_service * me, Jxta_endpoint_address * addr);
-static void *APR_THREAD_FUNC outgoing_message_thread(apr_thread_t * t, void *arg);
+static Jxta_status demux_publish(Jxta_endpoint_service * me);
+static Demux_snapshot *demux_acquire(Jxta_endpoint_service * me);
+static void demux_release(Demux_snapshot * snap);
+static void *APR_THREAD_FUNC sched_dispatch(apr_thread_t * t, void *arg);
+static void *APR_THREAD_FUNC sched_connect(apr_thread_t * t, void *arg);
+static void sched_dest_done_locked(Jxta_endpoint_service * me, Ep_sched_class * cls, Ep_sched_dest * dest);
+static void sched_dests_release(Jxta_endpoint_service * me);
+static void sched_kick(Jxta_endpoint_service * me);
+static void sched_destroy(Jxta_endpoint_service * me);
 static Jxta_status outgoing_message_process(Jxta_endpoint_service * service, Jxta_message * msg);
 static Jxta_status send_message(Jxta_endpoint_service * me, Jxta_message * msg, Jxta_endpoint_address * dest);
 
@@ -172,14 +286,22 @@ static Nc_entry *nc_add_peer(Jxta_endpoint_service * me, const char *addr, Jxta_
 static void nc_remove_peer(Jxta_endpoint_service * me, Nc_entry * ptr);
 static void nc_destroy(Jxta_endpoint_service * me);
 static Jxta_status nc_peer_queue_msg(Jxta_endpoint_service * me, Nc_entry * ptr, Jxta_message * msg);
-static void nc_review_all(Jxta_endpoint_service * me);
+static void nc_review_due(Jxta_endpoint_service * me);
+
+/* poll reactor ops */
+static Jxta_status reactors_create(Jxta_endpoint_service * me, apr_pool_t * pool);
+static Ep_reactor *reactor_for_socket(Jxta_endpoint_service * me, apr_socket_t * s);
+static Jxta_status reactor_poll(Ep_reactor * reactor, apr_interval_time_t timeout);
+static void* APR_THREAD_FUNC do_poll(apr_thread_t * thd, void * arg);
 
 /* transport connection ops */
 static Jxta_status tc_new(Tc_elt ** me, Jxta_callback_fn fn, apr_socket_t * s, void * arg, apr_pool_t * pool);
 static Jxta_status tc_destroy(Tc_elt * me);
 
-static void messenger_add(Jxta_endpoint_service * me, Jxta_endpoint_address *ea, JxtaEndpointMessenger * msgr);
+static Peer_route_elt *messenger_add(Jxta_endpoint_service * me, Jxta_endpoint_address *ea, JxtaEndpointMessenger * msgr);
 static void messenger_remove(Jxta_endpoint_service * me, Jxta_endpoint_address *ea);
+static void messengers_trim(Jxta_endpoint_service * me);
+static void *APR_THREAD_FUNC messengers_timer(apr_thread_t * thread, void *arg);
 static void messengers_destroy(Jxta_endpoint_service * me);
 static Jxta_status try_existing_messenger(Jxta_endpoint_service * me, Jxta_message * msg, Jxta_endpoint_address * dest);
     
@@ -239,6 +361,142 @@ static Jxta_status emit_local_route_change_event(Jxta_endpoint_service * me)
     return JXTA_SUCCESS;
 }
 
+/*
+ * Approximate size of the message, the sum of the element names and values. Used to account the memory held by the
+ * retransmit queues without serializing the message.
+ */
+static apr_size_t nc_msg_size(Jxta_message * msg)
+{
+    Jxta_vector *elements;
+    Jxta_message_element *el;
+    Jxta_bytevector *value;
+    apr_size_t size = 0;
+    unsigned int i;
+
+    elements = jxta_message_get_elements(msg);
+    if (NULL == elements) {
+        return 0;
+    }
+    for (i = 0; i < jxta_vector_size(elements); i++) {
+        if (JXTA_SUCCESS != jxta_vector_get_object_at(elements, JXTA_OBJECT_PPTR(&el), i)) {
+            continue;
+        }
+        size += strlen(jxta_message_element_get_name(el));
+        value = jxta_message_element_get_value(el);
+        if (NULL != value) {
+            size += jxta_bytevector_size(value);
+            JXTA_OBJECT_RELEASE(value);
+        }
+        JXTA_OBJECT_RELEASE(el);
+    }
+    JXTA_OBJECT_RELEASE(elements);
+    return size;
+}
+
+/* put the entry in the timer wheel slot of its expiration, must be called with nc_wlock held */
+static void nc_schedule(Jxta_endpoint_service * me, Nc_entry * ptr)
+{
+    int slot = (int) ((ptr->expiration / NC_WHEEL_TICK) & (NC_WHEEL_SLOTS - 1));
+
+    APR_RING_INSERT_TAIL(&me->nc_wheel[slot], ptr, _nc_entry, timer);
+}
+
+static void nc_reschedule(Jxta_endpoint_service * me, Nc_entry * ptr)
+{
+    APR_RING_REMOVE(ptr, timer);
+    nc_schedule(me, ptr);
+}
+
+static void *APR_THREAD_FUNC nc_timer(apr_thread_t * thread, void *arg)
+{
+    Jxta_endpoint_service *me = PTValid(arg, Jxta_endpoint_service);
+
+    apr_thread_mutex_lock(me->nc_wlock);
+    me->nc_timer_armed = FALSE;
+    apr_thread_mutex_unlock(me->nc_wlock);
+    nc_review_due(me);
+    return NULL;
+}
+
+/* run the review on the next tick while there are entries in the cache, must be called with nc_wlock held */
+static void nc_timer_arm(Jxta_endpoint_service * me)
+{
+    if (me->nc_timer_armed || 0 == apr_hash_count(me->nc) || JXTA_MODULE_STARTED != jxta_module_state((Jxta_module *) me)) {
+        return;
+    }
+    if (APR_SUCCESS == apr_thread_pool_schedule(jxta_PG_thread_pool_get(me->my_group), nc_timer, me,
+                                                (apr_interval_time_t) NC_WHEEL_TICK * 1000, me)) {
+        me->nc_timer_armed = TRUE;
+    }
+}
+
+/* unlink and release a queued message, must be called with nc_wlock held */
+static void nc_msg_drop(Jxta_endpoint_service * me, Nc_msg * m)
+{
+    APR_RING_REMOVE(m, link);
+    APR_RING_REMOVE(m, fifo);
+    m->peer->rq_cnt--;
+    m->peer->rq_bytes -= m->size;
+    me->nc_stats.queued_msgs--;
+    me->nc_stats.queued_bytes -= m->size;
+    JXTA_OBJECT_RELEASE(m->msg);
+    free(m);
+}
+
+/*
+ * Queue a message for retransmission. The oldest messages of the peer are dropped to stay within the per peer count and
+ * byte limits, then the oldest messages of all the peers to stay within the global byte limit.
+ * Must be called with nc_wlock held.
+ */
+static Jxta_status nc_peer_enqueue(Jxta_endpoint_service * me, Nc_entry * ptr, Jxta_message * msg)
+{
+    Nc_msg *m;
+    apr_size_t size;
+
+    size = nc_msg_size(msg);
+    if ((me->nc_peer_max_bytes > 0 && size > me->nc_peer_max_bytes) || (me->nc_max_bytes > 0 && size > me->nc_max_bytes)) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Message[%pp] of %" APR_SIZE_T_FMT
+                        " bytes is larger than the retransmit queue, drop it.\n", msg, size);
+        me->nc_stats.evicted++;
+        return JXTA_BUSY;
+    }
+
+    while (!APR_RING_EMPTY(&ptr->rq, _nc_msg, link)
+           && (ptr->rq_cnt >= ptr->rq_capacity || (me->nc_peer_max_bytes > 0 && ptr->rq_bytes + size > me->nc_peer_max_bytes))) {
+        m = APR_RING_FIRST(&ptr->rq);
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG,
+                        "Peer at %s has filled up(%d, %" APR_SIZE_T_FMT " bytes) retransmit queue, drop oldest message[%pp]\n",
+                        ptr->addr, ptr->rq_cnt, ptr->rq_bytes, m->msg);
+        nc_msg_drop(me, m);
+        me->nc_stats.evicted++;
+    }
+    while (!APR_RING_EMPTY(&me->nc_fifo, _nc_msg, fifo) && me->nc_max_bytes > 0
+           && me->nc_stats.queued_bytes + size > me->nc_max_bytes) {
+        m = APR_RING_FIRST(&me->nc_fifo);
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG,
+                        "Retransmit queues are full(%" APR_SIZE_T_FMT " bytes), drop oldest message[%pp] for peer at %s\n",
+                        me->nc_stats.queued_bytes, m->msg, m->peer->addr);
+        nc_msg_drop(me, m);
+        me->nc_stats.evicted++;
+    }
+
+    m = calloc(1, sizeof(*m));
+    if (NULL == m) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+        return JXTA_NOMEM;
+    }
+    m->peer = ptr;
+    m->msg = JXTA_OBJECT_SHARE(msg);
+    m->size = size;
+    APR_RING_INSERT_TAIL(&ptr->rq, m, _nc_msg, link);
+    APR_RING_INSERT_TAIL(&me->nc_fifo, m, _nc_msg, fifo);
+    ptr->rq_cnt++;
+    ptr->rq_bytes += size;
+    me->nc_stats.queued_msgs++;
+    me->nc_stats.queued_bytes += size;
+    return JXTA_SUCCESS;
+}
+
 static Nc_entry *nc_add_peer(Jxta_endpoint_service * me, const char *addr, Jxta_message * msg)
 {
     Nc_entry *ptr = NULL;
@@ -247,6 +505,16 @@ static Nc_entry *nc_add_peer(Jxta_endpoint_service * me, const char *addr, Jxta_
     assert(NULL != me);
 
     apr_thread_mutex_lock(me->nc_wlock);
+    /* another thread may have failed to reach the peer at the same time */
+    ptr = apr_hash_get(me->nc, addr, APR_HASH_KEY_STRING);
+    if (NULL != ptr) {
+        if (!ptr->closed) {
+            nc_peer_enqueue(me, ptr, msg);
+        }
+        apr_thread_mutex_unlock(me->nc_wlock);
+        return ptr;
+    }
+
     ptr = calloc(1, sizeof(*ptr));
     if (NULL == ptr) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Fail to allocate negative cache entry, out of memory?\n");
@@ -263,61 +531,42 @@ static Nc_entry *nc_add_peer(Jxta_endpoint_service * me, const char *addr, Jxta_
     ptr->timeout = jxta_epcfg_get_nc_timeout_init(me->config);
     ptr->expiration = jpr_time_now() + ptr->timeout;
     ptr->rq_capacity = jxta_epcfg_get_ncrq_size(me->config);
-    if (0 != ptr->rq_capacity) {
-        ptr->rq = calloc(ptr->rq_capacity, sizeof(*ptr->rq));
-        if (NULL == ptr->rq) {
-            free(ptr->addr);
-            free(ptr);
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Fail to allocate retransmit queue, out of memory?\n");
-            apr_thread_mutex_unlock(me->nc_wlock);
-            return NULL;
-        }
-        ptr->rq[0] = JXTA_OBJECT_SHARE(msg);
-        ptr->rq_tail = 1;
+    APR_RING_INIT(&ptr->rq, _nc_msg, link);
+    ptr->closed = (0 == ptr->rq_capacity);
+    if (!ptr->closed) {
+        nc_peer_enqueue(me, ptr, msg);
     }
     apr_thread_mutex_lock(me->mutex);
     apr_hash_set(me->nc, ptr->addr, APR_HASH_KEY_STRING, ptr);
     apr_thread_mutex_unlock(me->mutex);
+    nc_schedule(me, ptr);
+    nc_timer_arm(me);
     apr_thread_mutex_unlock(me->nc_wlock);
     return ptr;
 }
 
 static void nc_remove_peer(Jxta_endpoint_service * me, Nc_entry * ptr)
 {
-    assert(NULL == ptr->rq || -1 == ptr->rq_tail);
-
     apr_thread_mutex_lock(me->nc_wlock);
+    while (!APR_RING_EMPTY(&ptr->rq, _nc_msg, link)) {
+        nc_msg_drop(me, APR_RING_FIRST(&ptr->rq));
+    }
+    APR_RING_REMOVE(ptr, timer);
     apr_thread_mutex_lock(me->mutex);
     apr_hash_set(me->nc, ptr->addr, APR_HASH_KEY_STRING, NULL);
     apr_thread_mutex_unlock(me->mutex);
     apr_thread_mutex_unlock(me->nc_wlock);
     free(ptr->addr);
-    free(ptr->rq);
     free(ptr);
 }
 
-static void nc_peer_drop_retransmit_queue(Nc_entry * me)
+static void nc_peer_drop_retransmit_queue(Jxta_endpoint_service * me, Nc_entry * ptr)
 {
-    if (NULL == me->rq) {
-        return;
-    }
-
-    if (-1 != me->rq_tail) {
-        do {
-            Jxta_message *msg = NULL;
-
-            assert(me->rq_capacity > me->rq_head);
-            msg = me->rq[me->rq_head++];
-            assert(NULL != msg);
-            JXTA_OBJECT_RELEASE(msg);
-            if (me->rq_head == me->rq_capacity) {
-                me->rq_head = 0;
-            }
-        } while (me->rq_head != me->rq_tail);
+    me->nc_stats.expired += ptr->rq_cnt;
+    while (!APR_RING_EMPTY(&ptr->rq, _nc_msg, link)) {
+        nc_msg_drop(me, APR_RING_FIRST(&ptr->rq));
     }
-
-    free(me->rq);
-    me->rq = NULL;
+    ptr->closed = TRUE;
 }
 
 static void nc_destroy(Jxta_endpoint_service * me)
@@ -329,22 +578,53 @@ static void nc_destroy(Jxta_endpoint_service * me)
         apr_hash_this(hi, NULL, NULL, (void **) &ptr);
         assert(NULL != ptr);
 
-        nc_peer_drop_retransmit_queue(ptr);
+        while (!APR_RING_EMPTY(&ptr->rq, _nc_msg, link)) {
+            nc_msg_drop(me, APR_RING_FIRST(&ptr->rq));
+        }
         free(ptr->addr);
         free(ptr);
     }
 }
 
+/**
+ * The peer is still unreachable, double the timeout period. If the timeout period is already maximum, drop the queue
+ * completely. Must be called with nc_wlock held.
+ */
+static void nc_peer_backoff(Jxta_endpoint_service * me, Nc_entry * ptr)
+{
+    Jxta_time_diff timeout_max;
+
+    timeout_max = jxta_epcfg_get_nc_timeout_max(me->config);
+    if (ptr->timeout >= timeout_max) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Peer at %s is still unreachable after timeout %" APR_INT64_T_FMT
+                        "ms over maximum %" APR_INT64_T_FMT "ms, drop retransmit queue.\n", ptr->addr, ptr->timeout,
+                        timeout_max);
+        nc_peer_drop_retransmit_queue(me, ptr);
+        ptr->timeout = timeout_max;
+    } else {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Peer at %s is still unreachable after timeout %" APR_INT64_T_FMT
+                        "ms, double it(limit to a maximum of %" APR_INT64_T_FMT "ms).\n", ptr->addr, ptr->timeout,
+                        timeout_max);
+        ptr->timeout *= 2;
+        if (ptr->timeout > timeout_max) {
+            ptr->timeout = timeout_max;
+        }
+    }
+    ptr->expiration = jpr_time_now() + ptr->timeout;
+    nc_reschedule(me, ptr);
+}
+
 /**
  * Review the negative cache entry.
  * Try to send messages in the retransmit queue after timeout
  * In case failed, double the timeout period. If the timeout period is already maximum, drop the queue completely
+ * Must be called with nc_wlock held.
  * @return JXTA_SUCCESS if the peer is out of timeout period and no msg remains in the queue. JXTA_UNREACHABLE_DEST if the peer
  * still is unreachable.
  */
 static Jxta_status nc_peer_process_queue(Jxta_endpoint_service * me, Nc_entry * ptr)
 {
-    Jxta_message *msg = NULL;
+    Nc_msg *m;
     Jxta_status res = JXTA_SUCCESS;
     int sent = 0;
 
@@ -354,47 +634,31 @@ static Jxta_status nc_peer_process_queue(Jxta_endpoint_service * me, Nc_entry *
         return JXTA_UNREACHABLE_DEST;
     }
 
-    if (!ptr->rq || -1 == ptr->rq_tail) {
+    if (ptr->closed || APR_RING_EMPTY(&ptr->rq, _nc_msg, link)) {
         return JXTA_SUCCESS;
     }
 
-    do {
-        msg = ptr->rq[ptr->rq_head];
-        res = send_message(me, msg, NULL);
+    me->nc_stats.retries++;
+    while (!APR_RING_EMPTY(&ptr->rq, _nc_msg, link)) {
+        m = APR_RING_FIRST(&ptr->rq);
+        res = send_message(me, m->msg, NULL);
         if (JXTA_SUCCESS != res) {
             break;
         }
-        JXTA_OBJECT_RELEASE(msg);
+        nc_msg_drop(me, m);
         ++sent;
-        if (++ptr->rq_head >= ptr->rq_capacity) {
-            ptr->rq_head = 0;
-        }
-    } while (ptr->rq_head != ptr->rq_tail);
+    }
+    me->nc_stats.retransmitted += sent;
 
     if (JXTA_SUCCESS == res) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Peer at %s is now reachable after timeout %" APR_INT64_T_FMT
                         "ms, retransmit queue is flushed.\n", ptr->addr, ptr->timeout);
-        ptr->rq_tail = -1;
     } else if (!sent && JXTA_UNREACHABLE_DEST == res) {
-        Jxta_time_diff timeout_max;
-
-        timeout_max = jxta_epcfg_get_nc_timeout_max(me->config);
-        if (ptr->timeout >= timeout_max) {
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Peer at %s is still unreachable after timeout %" APR_INT64_T_FMT
-                            "ms over maximum %" APR_INT64_T_FMT "ms, drop retransmit queue.\n", ptr->addr, ptr->timeout,
-                            timeout_max);
-            nc_peer_drop_retransmit_queue(ptr);
-            ptr->timeout = timeout_max;
-        } else {
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Peer at %s is still unreachable after timeout %" APR_INT64_T_FMT
-                            "ms, double it(limit to a maximum of %" APR_INT64_T_FMT "ms).\n", ptr->addr, ptr->timeout,
-                            timeout_max);
-            ptr->timeout *= 2;
-            if (ptr->timeout > timeout_max) {
-                ptr->timeout = timeout_max;
-            }
-        }
+        nc_peer_backoff(me, ptr);
+    } else {
+        /* some progress, try the rest on the next period */
         ptr->expiration = jpr_time_now() + ptr->timeout;
+        nc_reschedule(me, ptr);
     }
     return res;
 }
@@ -414,7 +678,7 @@ static Jxta_status nc_peer_queue_msg(Jxta_endpoint_service * me, Nc_entry * ptr,
         }
     }
 
-    if (NULL == ptr->rq) {
+    if (ptr->closed) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Peer at %s is still unreachable with maximum timeout %" APR_INT64_T_FMT
                         "ms, drop message[%pp]\n", ptr->addr, ptr->timeout, msg);
         apr_thread_mutex_unlock(me->nc_wlock);
@@ -423,50 +687,76 @@ static Jxta_status nc_peer_queue_msg(Jxta_endpoint_service * me, Nc_entry * ptr,
 
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Queueing msg[%pp] for peer at %s for later retransmission.\n", msg,
                     ptr->addr);
-    if (ptr->rq_head == ptr->rq_tail) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG,
-                        "Peer at %s has filled up(%d) retransmit queue, drop oldest message[%pp]\n", ptr->addr, ptr->rq_capacity,
-                        ptr->rq[ptr->rq_head]);
-        JXTA_OBJECT_RELEASE(ptr->rq[ptr->rq_head]);
-        ptr->rq[ptr->rq_head++] = JXTA_OBJECT_SHARE(msg);
-        if (ptr->rq_head >= ptr->rq_capacity) {
-            ptr->rq_head = 0;
-        }
-    } else {
-        if (-1 == ptr->rq_tail) {
-            ptr->rq_tail = ptr->rq_head;
-        }
-        ptr->rq[ptr->rq_tail++] = JXTA_OBJECT_SHARE(msg);
-        if (ptr->rq_tail >= ptr->rq_capacity) {
-            ptr->rq_tail = 0;
-        }
-    }
+    nc_peer_enqueue(me, ptr, msg);
     apr_thread_mutex_unlock(me->nc_wlock);
     return JXTA_UNREACHABLE_DEST;
 }
 
-static void nc_review_all(Jxta_endpoint_service * me)
+/**
+ * Review the entries of the negative cache whose timeout expired since the last review. Only the timer wheel slots of the
+ * elapsed ticks are visited.
+ */
+static void nc_review_due(Jxta_endpoint_service * me)
 {
-    apr_hash_index_t *hi = NULL;
-    Nc_entry *ptr = NULL;
-    Jxta_status res = JXTA_SUCCESS;
+    APR_RING_HEAD(nc_due, _nc_entry) due;
+    Nc_entry *ptr;
+    Nc_entry *next;
+    Jxta_time now;
+    apr_int64_t tick;
+    apr_int64_t tick_now;
+    Jxta_status res;
+    int slot;
+
+    APR_RING_INIT(&due, _nc_entry, timer);
 
     apr_thread_mutex_lock(me->nc_wlock);
-    for (hi = apr_hash_first(NULL, me->nc); hi;) {
-        apr_hash_this(hi, NULL, NULL, (void **) &ptr);
-        /* move index before calling nc_remove_peer which removes entry from cache table and could screw the index */
-        hi = apr_hash_next(hi);
-        assert(NULL != ptr);
+    now = jpr_time_now();
+    tick_now = now / NC_WHEEL_TICK;
+    tick = me->nc_tick;
+    if (tick_now - tick >= NC_WHEEL_SLOTS) {
+        tick = tick_now - NC_WHEEL_SLOTS + 1;
+    }
+    for (; tick <= tick_now; tick++) {
+        slot = (int) (tick & (NC_WHEEL_SLOTS - 1));
+        for (ptr = APR_RING_FIRST(&me->nc_wheel[slot]); ptr != APR_RING_SENTINEL(&me->nc_wheel[slot], _nc_entry, timer);
+             ptr = next) {
+            next = APR_RING_NEXT(ptr, timer);
+            if (ptr->expiration <= now) {
+                APR_RING_REMOVE(ptr, timer);
+                APR_RING_INSERT_TAIL(&due, ptr, _nc_entry, timer);
+            }
+        }
+    }
+    /* the current tick is visited again by the next review for the entries expiring later in the tick */
+    me->nc_tick = tick_now;
+
+    while (!APR_RING_EMPTY(&due, _nc_entry, timer)) {
+        ptr = APR_RING_FIRST(&due);
+        APR_RING_REMOVE(ptr, timer);
+        nc_schedule(me, ptr);
 
         res = nc_peer_process_queue(me, ptr);
-        if (JXTA_SUCCESS == res && NULL != ptr->rq) {
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Peer at %s is back online.\n", ptr->addr);
+        if (JXTA_SUCCESS == res) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Peer at %s is %s.\n", ptr->addr,
+                            ptr->closed ? "out of the negative cache" : "back online");
             nc_remove_peer(me, ptr);
         }
     }
+    nc_timer_arm(me);
     apr_thread_mutex_unlock(me->nc_wlock);
 }
 
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_get_nc_stats(Jxta_endpoint_service * me, Jxta_endpoint_nc_stats * stats)
+{
+    PTValid(me, Jxta_endpoint_service);
+
+    apr_thread_mutex_lock(me->nc_wlock);
+    *stats = me->nc_stats;
+    stats->peers = apr_hash_count(me->nc);
+    apr_thread_mutex_unlock(me->nc_wlock);
+    return JXTA_SUCCESS;
+}
+
 /* transport connection ops */
 static Jxta_status tc_new(Tc_elt ** me, Jxta_callback_fn fn, apr_socket_t * s, void * arg, apr_pool_t * pool)
 {
@@ -500,7 +790,86 @@ static Jxta_status tc_destroy(Tc_elt * me)
     return JXTA_SUCCESS;
 }
 
-static void messenger_add(Jxta_endpoint_service * me, Jxta_endpoint_address *ea, JxtaEndpointMessenger *msgr)
+/* poll reactor ops */
+static Jxta_status reactors_create(Jxta_endpoint_service * me, apr_pool_t * pool)
+{
+    Ep_reactor *reactor;
+    int pollset_size;
+    apr_uint32_t flags;
+    apr_status_t rv;
+    int i;
+
+    me->reactor_cnt = jxta_epcfg_get_poll_reactors(me->config);
+    if (me->reactor_cnt < 1) {
+        me->reactor_cnt = 1;
+    }
+    pollset_size = jxta_epcfg_get_pollset_size(me->config);
+    if (pollset_size < 1) {
+        pollset_size = 100;
+    }
+
+#ifdef APR_POLLSET_THREADSAFE
+    /* sockets are added and removed by other threads while the reactor is polling */
+    flags = APR_POLLSET_THREADSAFE;
+#else
+    flags = 0;
+#endif
+
+    me->reactors = apr_pcalloc(pool, me->reactor_cnt * sizeof(Ep_reactor));
+    if (NULL == me->reactors) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+        return JXTA_NOMEM;
+    }
+
+    for (i = 0; i < me->reactor_cnt; i++) {
+        reactor = &me->reactors[i];
+        reactor->ep_svc = me;
+        reactor->idx = i;
+        reactor->pollfd_cnt = 0;
+        apr_thread_mutex_create(&reactor->mutex, APR_THREAD_MUTEX_NESTED, pool);
+
+#if CHECK_APR_VERSION(1, 3, 0)
+        rv = apr_pollset_create_ex(&reactor->pollset, pollset_size, pool, flags, APR_POLLSET_EPOLL);
+        if (APR_SUCCESS != rv) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "epoll is not available(%d), use default pollset for reactor %d.\n",
+                            rv, i);
+            rv = apr_pollset_create(&reactor->pollset, pollset_size, pool, flags);
+        }
+#else
+        rv = apr_pollset_create(&reactor->pollset, pollset_size, pool, flags);
+#endif
+        if (APR_SUCCESS != rv) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "Failed to create pollset for reactor %d with status %d\n", i, rv);
+            return JXTA_FAILED;
+        }
+    }
+
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Created %d poll reactors of %d sockets each.\n", me->reactor_cnt,
+                    pollset_size);
+    return JXTA_SUCCESS;
+}
+
+static Ep_reactor *reactor_for_socket(Jxta_endpoint_service * me, apr_socket_t * s)
+{
+    apr_os_sock_t os_sock;
+    apr_size_t h;
+
+    if (1 == me->reactor_cnt || APR_SUCCESS != apr_os_sock_get(&os_sock, s)) {
+        return &me->reactors[0];
+    }
+
+    h = (apr_size_t) os_sock;
+    /* descriptors are mostly allocated in sequence, mix the bits a little before taking the modulo */
+    h ^= h >> 7;
+    return &me->reactors[h % me->reactor_cnt];
+}
+
+/*
+ * Add or replace the messenger for the transport address of ea, must be called with mutex held.
+ *
+ * @return the cache entry of the address or NULL.
+ */
+static Peer_route_elt *messenger_add(Jxta_endpoint_service * me, Jxta_endpoint_address *ea, JxtaEndpointMessenger *msgr)
 {
     char * ta;
     Peer_route_elt *ptr;
@@ -512,29 +881,93 @@ static void messenger_add(Jxta_endpoint_service * me, Jxta_endpoint_address *ea,
         /* hardcode TCP preference */
         if (0 == strncasecmp("tcp://", ptr->ta, 6) && strcasecmp("tcp", jxta_endpoint_address_get_protocol_name(ea))) {
             jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG,
-                            "Keep current messenger[%pp] which is preferred than new one[%pp] for peer at %s.\n", 
+                            "Keep current messenger[%pp] which is preferred than new one[%pp] for peer at %s.\n",
                             ptr->msgr, msgr, ta);
+            free(ta);
+            return NULL;
         } else {
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, FILEANDLINE 
-                            "The old messenger[%pp] will be replaced with new one[%pp] for peer at %s.\n", 
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, FILEANDLINE
+                            "The old messenger[%pp] will be replaced with new one[%pp] for peer at %s.\n",
                             ptr->msgr, msgr, ta);
             JXTA_OBJECT_RELEASE(ptr->msgr);
             ptr->msgr = JXTA_OBJECT_SHARE(msgr);
+            if (ptr->alias) {
+                ptr->alias->alias = NULL;
+                ptr->alias = NULL;
+            }
+            ptr->last_used = jpr_time_now();
+            APR_RING_REMOVE(ptr, lru);
+            APR_RING_INSERT_TAIL(&me->msgr_lru, ptr, peer_route_elt, lru);
         }
         free(ta);
-        return;
+        return ptr;
     }
 
     ptr = calloc(1, sizeof(*ptr));
     if (!ptr) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory");
         free(ta);
-        return;
+        return NULL;
     }
 
     ptr->ta = ta;
     ptr->msgr = JXTA_OBJECT_SHARE(msgr);
+    ptr->last_used = jpr_time_now();
     apr_hash_set(me->messengers, ta, APR_HASH_KEY_STRING, ptr);
+    APR_RING_INSERT_TAIL(&me->msgr_lru, ptr, peer_route_elt, lru);
+    me->msgr_stats.messengers++;
+    return ptr;
+}
+
+/* the two entries were added for the same messenger, evict them together */
+static void messenger_link(Peer_route_elt * a, Peer_route_elt * b)
+{
+    if (NULL == a || NULL == b || a == b || a->msgr != b->msgr) {
+        return;
+    }
+    if (a->alias) {
+        a->alias->alias = NULL;
+    }
+    if (b->alias) {
+        b->alias->alias = NULL;
+    }
+    a->alias = b;
+    b->alias = a;
+}
+
+/*
+ * Mark the entry and its alias as just used, so they stay together at the most recently used end of the cache. Must be
+ * called with mutex held.
+ */
+static void messenger_touch(Jxta_endpoint_service * me, Peer_route_elt * ptr)
+{
+    ptr->last_used = jpr_time_now();
+    APR_RING_REMOVE(ptr, lru);
+    APR_RING_INSERT_TAIL(&me->msgr_lru, ptr, peer_route_elt, lru);
+    if (ptr->alias) {
+        ptr->alias->last_used = ptr->last_used;
+        APR_RING_REMOVE(ptr->alias, lru);
+        APR_RING_INSERT_TAIL(&me->msgr_lru, ptr->alias, peer_route_elt, lru);
+    }
+}
+
+/* remove the entry from the cache without releasing it, must be called with mutex held */
+static void messenger_unlink(Jxta_endpoint_service * me, Peer_route_elt * ptr)
+{
+    apr_hash_set(me->messengers, ptr->ta, APR_HASH_KEY_STRING, NULL);
+    APR_RING_REMOVE(ptr, lru);
+    if (ptr->alias) {
+        ptr->alias->alias = NULL;
+        ptr->alias = NULL;
+    }
+    me->msgr_stats.messengers--;
+}
+
+static void messenger_free(Peer_route_elt * ptr)
+{
+    free(ptr->ta);
+    JXTA_OBJECT_RELEASE(ptr->msgr);
+    free(ptr);
 }
 
 static void messenger_remove(Jxta_endpoint_service * me, Jxta_endpoint_address *ea)
@@ -546,13 +979,96 @@ static void messenger_remove(Jxta_endpoint_service * me, Jxta_endpoint_address *
     ptr = apr_hash_get(me->messengers, ta, APR_HASH_KEY_STRING);
     free(ta);
     if (ptr) {
-        apr_hash_set(me->messengers, ptr->ta, APR_HASH_KEY_STRING, NULL);
-        free(ptr->ta);
-        JXTA_OBJECT_RELEASE(ptr->msgr);
-        free(ptr);
+        messenger_unlink(me, ptr);
+        messenger_free(ptr);
+    }
+}
+
+/*
+ * Evict the messengers idle for longer than the idle timeout and the least recently used ones over the cache size. An
+ * entry is evicted with its alias so the transport can release the connection once the last reference to the messenger is
+ * gone. The messengers are released outside of the lock as closing a connection emits an event back to the endpoint.
+ */
+static void messengers_trim(Jxta_endpoint_service * me)
+{
+    APR_RING_HEAD(msgr_victims, peer_route_elt) victims;
+    Peer_route_elt *ptr;
+    Peer_route_elt *alias;
+    Jxta_time now;
+    Jxta_boolean expired;
+
+    APR_RING_INIT(&victims, peer_route_elt, lru);
+    now = jpr_time_now();
+
+    apr_thread_mutex_lock(me->mutex);
+    while (!APR_RING_EMPTY(&me->msgr_lru, peer_route_elt, lru)) {
+        ptr = APR_RING_FIRST(&me->msgr_lru);
+        expired = (me->msgr_idle > 0 && ptr->last_used + me->msgr_idle < now);
+        if (!expired && (0 == me->msgr_max || me->msgr_stats.messengers <= me->msgr_max)) {
+            break;
+        }
+        if (expired) {
+            me->msgr_stats.expired++;
+        } else {
+            me->msgr_stats.evicted++;
+        }
+        alias = ptr->alias;
+        messenger_unlink(me, ptr);
+        APR_RING_INSERT_TAIL(&victims, ptr, peer_route_elt, lru);
+        if (alias) {
+            messenger_unlink(me, alias);
+            APR_RING_INSERT_TAIL(&victims, alias, peer_route_elt, lru);
+        }
+    }
+    apr_thread_mutex_unlock(me->mutex);
+
+    while (!APR_RING_EMPTY(&victims, peer_route_elt, lru)) {
+        ptr = APR_RING_FIRST(&victims);
+        APR_RING_REMOVE(ptr, lru);
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Release messenger[%pp] for peer at %s.\n", ptr->msgr, ptr->ta);
+        messenger_free(ptr);
+    }
+}
+
+static void *APR_THREAD_FUNC messengers_trim_task(apr_thread_t * thread, void *arg)
+{
+    Jxta_endpoint_service *me = PTValid(arg, Jxta_endpoint_service);
+
+    apr_thread_mutex_lock(me->mutex);
+    me->msgr_trim_pending = FALSE;
+    apr_thread_mutex_unlock(me->mutex);
+    messengers_trim(me);
+    return NULL;
+}
+
+/*
+ * Trim the cache from the thread pool once it grows over its size. Transport events can be emitted with transport locks held,
+ * so the messengers are not released from the event handler. Must be called with mutex held.
+ */
+static void messengers_trim_later(Jxta_endpoint_service * me)
+{
+    if (me->msgr_trim_pending || 0 == me->msgr_max || me->msgr_stats.messengers <= me->msgr_max) {
+        return;
+    }
+    if (APR_SUCCESS == apr_thread_pool_push(jxta_PG_thread_pool_get(me->my_group), messengers_trim_task, me,
+                                            APR_THREAD_TASK_PRIORITY_NORMAL, me)) {
+        me->msgr_trim_pending = TRUE;
     }
 }
 
+static void *APR_THREAD_FUNC messengers_timer(apr_thread_t * thread, void *arg)
+{
+    Jxta_endpoint_service *me = PTValid(arg, Jxta_endpoint_service);
+
+    if (JXTA_MODULE_STARTED != jxta_module_state((Jxta_module *) me)) {
+        return NULL;
+    }
+    messengers_trim(me);
+    apr_thread_pool_schedule(jxta_PG_thread_pool_get(me->my_group), messengers_timer, me,
+                             (apr_interval_time_t) MSGR_CHECK_INTERVAL * 1000, me);
+    return NULL;
+}
+
 static void messengers_destroy(Jxta_endpoint_service * me)
 {
     apr_hash_index_t *hi = NULL;
@@ -564,10 +1080,20 @@ static void messengers_destroy(Jxta_endpoint_service * me)
         assert(NULL != ptr);
         assert(ta == ptr->ta);
 
-        free(ptr->ta);
-        JXTA_OBJECT_RELEASE(ptr->msgr);
-        free(ptr);
+        messenger_free(ptr);
     }
+    APR_RING_INIT(&me->msgr_lru, peer_route_elt, lru);
+}
+
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_get_messenger_stats(Jxta_endpoint_service * me,
+                                                                    Jxta_endpoint_messenger_stats * stats)
+{
+    PTValid(me, Jxta_endpoint_service);
+
+    apr_thread_mutex_lock(me->mutex);
+    *stats = me->msgr_stats;
+    apr_thread_mutex_unlock(me->mutex);
+    return JXTA_SUCCESS;
 }
 
 /*
@@ -580,6 +1106,7 @@ static Jxta_status endpoint_init(Jxta_module * it, Jxta_PG * group, Jxta_id * as
     Jxta_svc *svc = NULL;
     apr_pool_t *pool;
     Jxta_PG *parentgroup;
+    int i;
 
     Jxta_endpoint_service *self = PTValid(it, Jxta_endpoint_service);
 
@@ -589,8 +1116,14 @@ static Jxta_status endpoint_init(Jxta_module * it, Jxta_PG * group, Jxta_id * as
     pool = jxta_PG_pool_get(group);
     self->listener_table = apr_hash_make(pool);
     self->nc = apr_hash_make(pool);
+    for (i = 0; i < NC_WHEEL_SLOTS; i++) {
+        APR_RING_INIT(&self->nc_wheel[i], _nc_entry, timer);
+    }
+    APR_RING_INIT(&self->nc_fifo, _nc_msg, fifo);
+    self->nc_tick = jpr_time_now() / NC_WHEEL_TICK;
     self->cb_table = apr_hash_make(pool);
     self->messengers = apr_hash_make(pool);
+    APR_RING_INIT(&self->msgr_lru, peer_route_elt, lru);
     self->filter_list = dl_make();
     self->transport_table = jxta_hashtable_new(2);
     if (self->transport_table == NULL || self->filter_list == NULL) {
@@ -600,8 +1133,17 @@ static Jxta_status endpoint_init(Jxta_module * it, Jxta_PG * group, Jxta_id * as
     apr_thread_mutex_create(&self->mutex, APR_THREAD_MUTEX_NESTED, pool);
     apr_thread_mutex_create(&self->nc_wlock, APR_THREAD_MUTEX_NESTED, pool);
     apr_thread_mutex_create(&self->demux_mutex, APR_THREAD_MUTEX_NESTED, pool);
+    if (JXTA_SUCCESS != demux_publish(self)) {
+        return JXTA_NOMEM;
+    }
 
     self->msg_task_cnt = 0;
+    apr_thread_mutex_create(&self->sched_mutex, APR_THREAD_MUTEX_NESTED, pool);
+    self->sched_weights = apr_hash_make(pool);
+    for (i = 0; i < JXTA_ENDPOINT_SEND_CLASSES; i++) {
+        self->sched[i].dests = apr_hash_make(pool);
+        APR_RING_INIT(&self->sched[i].active, ep_sched_dest, link);
+    }
 
     /* advs and groups are jxta_objects that we share */
     if (impl_adv != NULL) {
@@ -643,16 +1185,29 @@ static Jxta_status endpoint_init(Jxta_module * it, Jxta_PG * group, Jxta_id * as
         }
     }
 
-    apr_pollset_create(&self->pollset, 100, pool, 0);
-    self->pollfd_cnt = 0;
+    if (JXTA_SUCCESS != reactors_create(self, pool)) {
+        return JXTA_FAILED;
+    }
+
+    self->msgr_max = jxta_epcfg_get_messengers_max(self->config);
+    self->msgr_idle = jxta_epcfg_get_messengers_idle_timeout(self->config);
+    self->nc_max_bytes = jxta_epcfg_get_nc_total_bytes(self->config);
+    self->nc_peer_max_bytes = jxta_epcfg_get_ncrq_bytes(self->config);
+    self->sched_max_depth = jxta_epcfg_get_outq_depth(self->config);
+    self->sched_max_workers = jxta_epcfg_get_outq_workers(self->config);
+    self->sched_quantum = jxta_epcfg_get_outq_quantum(self->config);
 
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Initialized\n");
     return JXTA_SUCCESS;
 }
 
+/*
+ * Each reactor is serviced by its own poll task, so the shards are polled concurrently by different threads of the pool.
+ */
 static void* APR_THREAD_FUNC do_poll(apr_thread_t * thd, void * arg)
 {
-    Jxta_endpoint_service * me = arg;
+    Ep_reactor * reactor = arg;
+    Jxta_endpoint_service * me = reactor->ep_svc;
     Jxta_status rv;
     Jxta_module_state running;
 
@@ -660,25 +1215,42 @@ static void* APR_THREAD_FUNC do_poll(apr_thread_t * thd, void * arg)
      * a. poll won't return when close local listening socket as 9/1/2006
      * b. give this thread a chance to serve other tasks in thread pool
      */
-    rv = endpoint_service_poll(me, 1000000L);
+    rv = reactor_poll(reactor, 1000000L);
+    apr_thread_mutex_lock(reactor->mutex);
     running = jxta_module_state((Jxta_module*) me);
-    if ((JXTA_MODULE_STARTED == running || JXTA_MODULE_STARTING == running) && me->pollfd_cnt) {
-        apr_thread_pool_push(jxta_PG_thread_pool_get(me->my_group), do_poll, me, APR_THREAD_TASK_PRIORITY_HIGHEST, me);
+    if ((JXTA_MODULE_STARTED == running || JXTA_MODULE_STARTING == running) && reactor->pollfd_cnt) {
+        apr_thread_pool_push(jxta_PG_thread_pool_get(me->my_group), do_poll, reactor, APR_THREAD_TASK_PRIORITY_HIGHEST, me);
     }
+    apr_thread_mutex_unlock(reactor->mutex);
     return JXTA_SUCCESS;
 }
 
 static Jxta_status endpoint_start(Jxta_module * me, const char *args[])
 {
     Jxta_endpoint_service * myself = (Jxta_endpoint_service *) me;
+    Ep_reactor *reactor;
+    int i;
 
     /* construct + init have done everything already */
     PTValid(myself, Jxta_endpoint_service);
 
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Starting ...\n");
-    if (myself->pollfd_cnt) {
-        apr_thread_pool_push(jxta_PG_thread_pool_get(myself->my_group), do_poll, myself, APR_THREAD_TASK_PRIORITY_HIGHEST, myself);
-    }
+    for (i = 0; i < myself->reactor_cnt; i++) {
+        reactor = &myself->reactors[i];
+        apr_thread_mutex_lock(reactor->mutex);
+        if (reactor->pollfd_cnt) {
+            apr_thread_pool_push(jxta_PG_thread_pool_get(myself->my_group), do_poll, reactor, APR_THREAD_TASK_PRIORITY_HIGHEST,
+                                 myself);
+        }
+        apr_thread_mutex_unlock(reactor->mutex);
+    }
+    /* messages sent before the service was started */
+    sched_kick(myself);
+    apr_thread_mutex_lock(myself->nc_wlock);
+    nc_timer_arm(myself);
+    apr_thread_mutex_unlock(myself->nc_wlock);
+    apr_thread_pool_schedule(jxta_PG_thread_pool_get(myself->my_group), messengers_timer, myself,
+                             (apr_interval_time_t) MSGR_CHECK_INTERVAL * 1000, myself);
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Started\n");
     return JXTA_SUCCESS;
 }
@@ -689,6 +1261,16 @@ static void endpoint_stop(Jxta_module * self)
 
     /* stop the thread that processes outgoing messages */
     apr_thread_pool_tasks_cancel(jxta_PG_thread_pool_get(me->my_group), me);
+    apr_thread_mutex_lock(me->sched_mutex);
+    me->sched_workers = 0;
+    apr_thread_mutex_unlock(me->sched_mutex);
+    sched_dests_release(me);
+    apr_thread_mutex_lock(me->mutex);
+    me->msgr_trim_pending = FALSE;
+    apr_thread_mutex_unlock(me->mutex);
+    apr_thread_mutex_lock(me->nc_wlock);
+    me->nc_timer_armed = FALSE;
+    apr_thread_mutex_unlock(me->nc_wlock);
     if (NULL != me->router_transport) {
         JXTA_OBJECT_RELEASE(me->router_transport);
         me->router_transport = NULL;
@@ -741,12 +1323,269 @@ struct _Filter {
     void *arg;
 };
 
+static void filter_free(void *me)
+{
+    Filter *filter = me;
+
+    free(filter->str);
+    free(filter);
+}
+
+/*
+ * FNV-1a hash of the name, the separator if not '\0', and the param. Equal to the hash of the concatenated key so entries
+ * can be looked up without building the key.
+ */
+static unsigned int demux_hash(const char *name, char sep, const char *param)
+{
+    unsigned int h = 2166136261U;
+
+    for (; *name; name++) {
+        h = (h ^ (unsigned char) *name) * 16777619U;
+    }
+    if (NULL != param) {
+        if ('\0' != sep) {
+            h = (h ^ (unsigned char) sep) * 16777619U;
+        }
+        for (; *param; param++) {
+            h = (h ^ (unsigned char) *param) * 16777619U;
+        }
+    }
+    return h;
+}
+
+static Jxta_boolean demux_key_equals(const char *key, const char *name, char sep, const char *param)
+{
+    for (; *name; name++, key++) {
+        if (*key != *name) {
+            return FALSE;
+        }
+    }
+    if (NULL != param) {
+        if ('\0' != sep && *key++ != sep) {
+            return FALSE;
+        }
+        return 0 == strcmp(key, param);
+    }
+    return '\0' == *key;
+}
+
+static Demux_entry *demux_lookup(Demux_entry * table, unsigned int mask, const char *name, char sep, const char *param)
+{
+    unsigned int h = demux_hash(name, sep, param);
+    unsigned int i;
+
+    for (i = h & mask; NULL != table[i].key; i = (i + 1) & mask) {
+        if (table[i].hash == h && demux_key_equals(table[i].key, name, sep, param)) {
+            return &table[i];
+        }
+    }
+    return NULL;
+}
+
+static Demux_entry *demux_table_new(unsigned int cnt, unsigned int *mask)
+{
+    unsigned int size = 8;
+
+    while (size < 2 * cnt) {
+        size <<= 1;
+    }
+    *mask = size - 1;
+    return calloc(size, sizeof(Demux_entry));
+}
+
+static Demux_entry *demux_table_add(Demux_entry * table, unsigned int mask, const char *key)
+{
+    unsigned int h = demux_hash(key, '\0', NULL);
+    unsigned int i;
+
+    for (i = h & mask; NULL != table[i].key; i = (i + 1) & mask);
+    table[i].key = strdup(key);
+    if (NULL == table[i].key) {
+        return NULL;
+    }
+    table[i].hash = h;
+    return &table[i];
+}
+
+static void demux_snapshot_free(Demux_snapshot * snap)
+{
+    unsigned int i;
+    int j;
+
+    if (NULL != snap->cbs) {
+        for (i = 0; i <= snap->cb_mask; i++) {
+            free(snap->cbs[i].key);
+        }
+        free(snap->cbs);
+    }
+    if (NULL != snap->listeners) {
+        for (i = 0; i <= snap->listener_mask; i++) {
+            free(snap->listeners[i].key);
+            if (NULL != snap->listeners[i].listener) {
+                JXTA_OBJECT_RELEASE(snap->listeners[i].listener);
+            }
+        }
+        free(snap->listeners);
+    }
+    for (j = 0; j < snap->filter_cnt; j++) {
+        free(snap->filters[j].str);
+    }
+    free(snap->filters);
+    free(snap);
+}
+
+/* must be called with demux_mutex held */
+static Demux_snapshot *demux_snapshot_build(Jxta_endpoint_service * me)
+{
+    Demux_snapshot *snap;
+    Demux_entry *entry;
+    apr_hash_index_t *hi;
+    const void *key;
+    void *val;
+    Dlist *cur;
+    Filter *filter;
+    int cnt;
+
+    snap = calloc(1, sizeof(*snap));
+    if (NULL == snap) {
+        return NULL;
+    }
+    snap->refs = 1;
+
+    cnt = 0;
+    dl_traverse(cur, me->filter_list) {
+        cnt++;
+    }
+    snap->filters = calloc(cnt + 1, sizeof(Filter));
+    if (NULL == snap->filters) {
+        goto ERROR_EXIT;
+    }
+    dl_traverse(cur, me->filter_list) {
+        filter = cur->val;
+        snap->filters[snap->filter_cnt] = *filter;
+        snap->filters[snap->filter_cnt].str = strdup(filter->str);
+        if (NULL == snap->filters[snap->filter_cnt++].str) {
+            goto ERROR_EXIT;
+        }
+    }
+
+    snap->cbs = demux_table_new(apr_hash_count(me->cb_table), &snap->cb_mask);
+    if (NULL == snap->cbs) {
+        goto ERROR_EXIT;
+    }
+    for (hi = apr_hash_first(NULL, me->cb_table); hi; hi = apr_hash_next(hi)) {
+        Cb_elt *cb;
+
+        apr_hash_this(hi, &key, NULL, &val);
+        cb = val;
+        entry = demux_table_add(snap->cbs, snap->cb_mask, key);
+        if (NULL == entry) {
+            goto ERROR_EXIT;
+        }
+        entry->func = cb->func;
+        entry->arg = cb->arg;
+    }
+
+    snap->listeners = demux_table_new(apr_hash_count(me->listener_table), &snap->listener_mask);
+    if (NULL == snap->listeners) {
+        goto ERROR_EXIT;
+    }
+    for (hi = apr_hash_first(NULL, me->listener_table); hi; hi = apr_hash_next(hi)) {
+        apr_hash_this(hi, &key, NULL, &val);
+        entry = demux_table_add(snap->listeners, snap->listener_mask, key);
+        if (NULL == entry) {
+            goto ERROR_EXIT;
+        }
+        entry->listener = JXTA_OBJECT_SHARE(val);
+    }
+
+    return snap;
+
+  ERROR_EXIT:
+    demux_snapshot_free(snap);
+    return NULL;
+}
+
+/*
+ * Wait until no reader can still be looking at a snapshot published before the call. Each reader registers in the current
+ * epoch while it grabs a reference on the snapshot, flipping the epoch twice and waiting for the readers of each epoch to
+ * leave covers the readers which registered before the flip but loaded the snapshot after the publication.
+ */
+static void demux_synchronize(Jxta_endpoint_service * me)
+{
+    apr_uint32_t epoch;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        epoch = apr_atomic_read32(&me->demux_epoch) & 1;
+        apr_atomic_inc32(&me->demux_epoch);
+        while (apr_atomic_read32(&me->demux_readers[epoch]) > 0) {
+            apr_thread_yield();
+        }
+    }
+}
+
+/*
+ * Publish a new snapshot of the demux tables, must be called with demux_mutex held or before the service is started.
+ */
+static Jxta_status demux_publish(Jxta_endpoint_service * me)
+{
+    Demux_snapshot *snap;
+    Demux_snapshot *old;
+
+    snap = demux_snapshot_build(me);
+    if (NULL == snap) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory, demux tables not updated\n");
+        return JXTA_NOMEM;
+    }
+
+    old = me->demux_snap;
+    apr_atomic_casptr((volatile void **) &me->demux_snap, snap, old);
+    if (NULL != old) {
+        demux_synchronize(me);
+        demux_release(old);
+    }
+    return JXTA_SUCCESS;
+}
+
+/*
+ * Get a reference on the current demux snapshot without locking.
+ */
+static Demux_snapshot *demux_acquire(Jxta_endpoint_service * me)
+{
+    Demux_snapshot *snap;
+    apr_uint32_t epoch;
+
+    while (1) {
+        epoch = apr_atomic_read32(&me->demux_epoch) & 1;
+        apr_atomic_inc32(&me->demux_readers[epoch]);
+        if (epoch == (apr_atomic_read32(&me->demux_epoch) & 1)) {
+            break;
+        }
+        apr_atomic_dec32(&me->demux_readers[epoch]);
+    }
+    snap = apr_atomic_casptr((volatile void **) &me->demux_snap, NULL, NULL);
+    apr_atomic_inc32(&snap->refs);
+    apr_atomic_dec32(&me->demux_readers[epoch]);
+    return snap;
+}
+
+static void demux_release(Demux_snapshot * snap)
+{
+    if (0 == apr_atomic_dec32(&snap->refs)) {
+        demux_snapshot_free(snap);
+    }
+}
+
 void jxta_endpoint_service_destruct(Jxta_endpoint_service * service)
 {
+    int i;
+
     PTValid(service, Jxta_endpoint_service);
 
     /* delete tables and stuff */
     nc_destroy(service);
+    sched_destroy(service);
     messengers_destroy(service);
     JXTA_OBJECT_RELEASE(service->transport_table);
 
@@ -754,9 +1593,18 @@ void jxta_endpoint_service_destruct(Jxta_endpoint_service * service)
         free(service->relay_addr);
     if (service->relay_proto)
         free(service->relay_proto);
-    dl_free(service->filter_list, free);
+    dl_free(service->filter_list, filter_free);
+    if (NULL != service->demux_snap) {
+        demux_release(service->demux_snap);
+        service->demux_snap = NULL;
+    }
+
+    for (i = 0; service->reactors && i < service->reactor_cnt; i++) {
+        apr_thread_mutex_destroy(service->reactors[i].mutex);
+    }
 
     apr_thread_mutex_destroy(service->nc_wlock);
+    apr_thread_mutex_destroy(service->sched_mutex);
     apr_thread_mutex_destroy(service->demux_mutex);
     apr_thread_mutex_destroy(service->mutex);
 
@@ -833,27 +1681,36 @@ Jxta_endpoint_service *jxta_endpoint_service_new_instance(void)
 
 Jxta_status endpoint_service_demux(Jxta_endpoint_service * me, const char *name, const char *param, Jxta_message * msg)
 {
-    char *key;
     Jxta_status rv;
-    Cb_elt *cb;
+    Demux_snapshot *snap;
+    Demux_entry *cb;
+    Jxta_callback_func func = NULL;
+    void *arg = NULL;
 
-    key = get_service_key(name, param);
-    apr_thread_mutex_lock(me->demux_mutex);
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Demux: Looking up callback for %s\n", key);
-    cb = apr_hash_get(me->cb_table, key, APR_HASH_KEY_STRING);
+    if (NULL == name) {
+        return JXTA_ITEM_NOTFOUND;
+    }
+
+    snap = demux_acquire(me);
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Demux: Looking up callback for %s/%s\n", name, param ? param : "");
+    cb = demux_lookup(snap->cbs, snap->cb_mask, name, '/', param);
     if (!cb && param) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Demux: Looking up callback for fallback %s\n", name);
-        cb = apr_hash_get(me->cb_table, name, APR_HASH_KEY_STRING);
+        cb = demux_lookup(snap->cbs, snap->cb_mask, name, '/', NULL);
     }
-    apr_thread_mutex_unlock(me->demux_mutex);
     if (cb) {
+        func = cb->func;
+        arg = cb->arg;
+    }
+    demux_release(snap);
+
+    if (func) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Demux: Calling found callback.\n");
-        rv = cb->func((Jxta_object *) msg, cb->arg);
+        rv = func((Jxta_object *) msg, arg);
     } else {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Demux: No callback found for %s.\n", key);
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Demux: No callback found for %s/%s.\n", name, param ? param : "");
         rv = JXTA_ITEM_NOTFOUND;
     }
-    free(key);
     return rv;
 }
 
@@ -878,11 +1735,12 @@ JXTA_DECLARE(void) jxta_endpoint_service_demux(Jxta_endpoint_service * service,
 JXTA_DECLARE(void) jxta_endpoint_service_demux_addr(Jxta_endpoint_service * service, Jxta_endpoint_address * dest,
                                                     Jxta_message * msg)
 {
-    Dlist *cur;
     Filter *cur_filter;
     Jxta_vector *vector = NULL;
     char *destStr;
     Jxta_listener *listener;
+    Demux_snapshot *snap;
+    int i;
 
     PTValid(service, Jxta_endpoint_service);
     JXTA_OBJECT_CHECK_VALID(msg);
@@ -910,19 +1768,24 @@ JXTA_DECLARE(void) jxta_endpoint_service_demux_addr(Jxta_endpoint_service * serv
    **/
 
     /* pass message through appropriate filters */
-    apr_thread_mutex_lock(service->demux_mutex);
+    snap = demux_acquire(service);
 
-    dl_traverse(cur, service->filter_list) {
+    for (i = 0; i < snap->filter_cnt; i++) {
         Jxta_message_element *el = NULL;
-        cur_filter = cur->val;
+        cur_filter = &snap->filters[i];
 
         if ((vector = jxta_message_get_elements_of_namespace(msg, cur_filter->str)) != NULL
             || (JXTA_SUCCESS == jxta_message_get_element_1(msg, cur_filter->str, &el))) {
 
-            JXTA_OBJECT_RELEASE(el);
+            if (el != NULL) {
+                JXTA_OBJECT_RELEASE(el);
+            }
             /* discard the message if the filter returned false */
             if (!cur_filter->func(msg, cur_filter->arg)) {
-                apr_thread_mutex_unlock(service->demux_mutex);
+                if (vector != NULL) {
+                    JXTA_OBJECT_RELEASE(vector);
+                }
+                demux_release(snap);
                 return;
             }
 
@@ -932,7 +1795,7 @@ JXTA_DECLARE(void) jxta_endpoint_service_demux_addr(Jxta_endpoint_service * serv
         }
     }
 
-    apr_thread_mutex_unlock(service->demux_mutex);
+    demux_release(snap);
 
     destStr = jxta_endpoint_address_to_string(dest);
 
@@ -947,6 +1810,7 @@ JXTA_DECLARE(void) jxta_endpoint_service_demux_addr(Jxta_endpoint_service * serv
     if (listener != NULL) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Demux: Calling listener for %s\n", destStr);
         jxta_listener_process_object(listener, (Jxta_object *) msg);
+        JXTA_OBJECT_RELEASE(listener);
 
         JXTA_OBJECT_CHECK_VALID(msg);
         goto FINAL_EXIT;
@@ -958,16 +1822,15 @@ JXTA_DECLARE(void) jxta_endpoint_service_demux_addr(Jxta_endpoint_service * serv
     free(destStr);
 }
 
-Jxta_status endpoint_service_poll(Jxta_endpoint_service * me, apr_interval_time_t timeout)
+static Jxta_status reactor_poll(Ep_reactor * reactor, apr_interval_time_t timeout)
 {
     apr_status_t rv;
     const apr_pollfd_t * fds;
     int i;
     apr_int32_t num_sockets;
 
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_PARANOID, "before the pollset poll\n");
-    assert(me->pollfd_cnt > 0);
-    rv = apr_pollset_poll(me->pollset, timeout, &num_sockets, &fds);
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_PARANOID, "before the pollset poll of reactor %d\n", reactor->idx);
+    rv = apr_pollset_poll(reactor->pollset, timeout, &num_sockets, &fds);
 
 /* Not sure if we can safely ignore when endpoint is stopping. Transport should still get a chance to handle it.
     if (! me->running) {
@@ -982,7 +1845,7 @@ Jxta_status endpoint_service_poll(Jxta_endpoint_service * me, apr_interval_time_
         return rv;
     }
 
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "num sockets = %d\n", num_sockets);
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "reactor %d: num sockets = %d\n", reactor->idx, num_sockets);
     for (i = 0; i < num_sockets; i++) {
         int ev;
         Tc_elt * tc;
@@ -996,7 +1859,21 @@ Jxta_status endpoint_service_poll(Jxta_endpoint_service * me, apr_interval_time_
         rv = tc->fn(&tc->fd, tc->arg);
         fds++;
     }
-    return JXTA_SUCCESS;
+    return JXTA_SUCCESS;
+}
+
+Jxta_status endpoint_service_poll(Jxta_endpoint_service * me, apr_interval_time_t timeout)
+{
+    Jxta_status rv = JXTA_SUCCESS;
+    int i;
+
+    for (i = 0; i < me->reactor_cnt; i++) {
+        if (0 == me->reactors[i].pollfd_cnt) {
+            continue;
+        }
+        rv = reactor_poll(&me->reactors[i], timeout / me->reactor_cnt);
+    }
+    return rv;
 }
 
 JXTA_DECLARE(void) jxta_endpoint_service_get_route_from_PA(Jxta_PA * padv, Jxta_RouteAdvertisement ** route)
@@ -1141,6 +2018,7 @@ JXTA_DECLARE(Jxta_status) jxta_endpoint_service_add_poll(Jxta_endpoint_service *
 {
     Jxta_status rv;
     Tc_elt * tc;
+    Ep_reactor * reactor;
     Jxta_module_state running;
     
     rv = tc_new(&tc, fn, s, arg, jxta_PG_pool_get(me->my_group));
@@ -1149,21 +2027,26 @@ JXTA_DECLARE(Jxta_status) jxta_endpoint_service_add_poll(Jxta_endpoint_service *
         return rv;
     }
 
-    apr_thread_mutex_lock(me->mutex);
-    rv = apr_pollset_add(me->pollset, &tc->fd);
-    running = jxta_module_state((Jxta_module*) me);
-    if (0 == me->pollfd_cnt++ && (JXTA_MODULE_STARTED == running || JXTA_MODULE_STARTING == running)) {
-        apr_thread_pool_push(jxta_PG_thread_pool_get(me->my_group), do_poll, me, APR_THREAD_TASK_PRIORITY_HIGHEST, me);
+    reactor = reactor_for_socket(me, s);
+    tc->reactor = reactor;
+
+    apr_thread_mutex_lock(reactor->mutex);
+    rv = apr_pollset_add(reactor->pollset, &tc->fd);
+    if (APR_SUCCESS == rv) {
+        running = jxta_module_state((Jxta_module*) me);
+        if (0 == reactor->pollfd_cnt++ && (JXTA_MODULE_STARTED == running || JXTA_MODULE_STARTING == running)) {
+            apr_thread_pool_push(jxta_PG_thread_pool_get(me->my_group), do_poll, reactor, APR_THREAD_TASK_PRIORITY_HIGHEST, me);
+        }
     }
-    apr_thread_mutex_unlock(me->mutex);
+    apr_thread_mutex_unlock(reactor->mutex);
     if (rv != JXTA_SUCCESS) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "Failed to add poll[%pp] with error %d\n", tc, rv);
         *cookie = NULL;
         tc_destroy(tc);
         return rv;
     }
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Add poll[%pp] with socket[%pp], total %d sockets to poll\n", tc, s,
-                    me->pollfd_cnt);
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Add poll[%pp] with socket[%pp] to reactor %d, total %d sockets to poll\n",
+                    tc, s, reactor->idx, reactor->pollfd_cnt);
 
     *cookie = tc;
     return JXTA_SUCCESS;
@@ -1173,24 +2056,87 @@ JXTA_DECLARE(Jxta_status) jxta_endpoint_service_remove_poll(Jxta_endpoint_servic
 {
     Jxta_status rv;
     Tc_elt *tc = cookie;
+    Ep_reactor *reactor = tc->reactor;
 
-    apr_thread_mutex_lock(me->mutex);
-    assert(me->pollfd_cnt > 0);
-    rv = apr_pollset_remove (me->pollset, &tc->fd);
-    if (APR_SUCCESS == rv) {
-        --me->pollfd_cnt;
+    apr_thread_mutex_lock(reactor->mutex);
+    if (tc->paused) {
+        /* not in the pollset while paused */
+        rv = APR_SUCCESS;
+    } else {
+        assert(reactor->pollfd_cnt > 0);
+        rv = apr_pollset_remove (reactor->pollset, &tc->fd);
+        if (APR_SUCCESS == rv) {
+            --reactor->pollfd_cnt;
+        }
     }
-    apr_thread_mutex_unlock(me->mutex);
+    apr_thread_mutex_unlock(reactor->mutex);
     if (APR_SUCCESS != rv) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "Failed to remove poll[%pp] with error %d\n", tc, rv);
     } else {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Removed poll[%pp] with socket[%pp], remaining %d sockets to poll\n", 
-                        tc, tc->fd.desc.s, me->pollfd_cnt);
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, 
+                        "Removed poll[%pp] with socket[%pp] from reactor %d, remaining %d sockets to poll\n", 
+                        tc, tc->fd.desc.s, reactor->idx, reactor->pollfd_cnt);
     }
     tc_destroy(tc);
     return (APR_SUCCESS == rv) ? JXTA_SUCCESS : JXTA_FAILED;
 }
 
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_pause_poll(Jxta_endpoint_service * me, void * cookie)
+{
+    Jxta_status rv;
+    Tc_elt *tc = cookie;
+    Ep_reactor *reactor = tc->reactor;
+
+    apr_thread_mutex_lock(reactor->mutex);
+    if (tc->paused) {
+        apr_thread_mutex_unlock(reactor->mutex);
+        return JXTA_SUCCESS;
+    }
+    rv = apr_pollset_remove(reactor->pollset, &tc->fd);
+    if (APR_SUCCESS == rv) {
+        --reactor->pollfd_cnt;
+        tc->paused = TRUE;
+    }
+    apr_thread_mutex_unlock(reactor->mutex);
+    if (APR_SUCCESS != rv) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "Failed to pause poll[%pp] with error %d\n", tc, rv);
+        return JXTA_FAILED;
+    }
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Paused poll[%pp] with socket[%pp] on reactor %d\n", tc, tc->fd.desc.s,
+                    reactor->idx);
+    return JXTA_SUCCESS;
+}
+
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_resume_poll(Jxta_endpoint_service * me, void * cookie)
+{
+    Jxta_status rv;
+    Tc_elt *tc = cookie;
+    Ep_reactor *reactor = tc->reactor;
+    Jxta_module_state running;
+
+    apr_thread_mutex_lock(reactor->mutex);
+    if (!tc->paused) {
+        apr_thread_mutex_unlock(reactor->mutex);
+        return JXTA_SUCCESS;
+    }
+    rv = apr_pollset_add(reactor->pollset, &tc->fd);
+    if (APR_SUCCESS == rv) {
+        tc->paused = FALSE;
+        running = jxta_module_state((Jxta_module*) me);
+        if (0 == reactor->pollfd_cnt++ && (JXTA_MODULE_STARTED == running || JXTA_MODULE_STARTING == running)) {
+            apr_thread_pool_push(jxta_PG_thread_pool_get(me->my_group), do_poll, reactor, APR_THREAD_TASK_PRIORITY_HIGHEST, me);
+        }
+    }
+    apr_thread_mutex_unlock(reactor->mutex);
+    if (APR_SUCCESS != rv) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "Failed to resume poll[%pp] with error %d\n", tc, rv);
+        return JXTA_FAILED;
+    }
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Resumed poll[%pp] with socket[%pp] on reactor %d\n", tc, tc->fd.desc.s,
+                    reactor->idx);
+    return JXTA_SUCCESS;
+}
+
 JXTA_DECLARE(Jxta_RouteAdvertisement *) jxta_endpoint_service_get_local_route(Jxta_endpoint_service * service)
 {
     PTValid(service, Jxta_endpoint_service);
@@ -1266,12 +2212,19 @@ JXTA_DECLARE(void) jxta_endpoint_service_add_filter(Jxta_endpoint_service * serv
     }
     PTValid(service, Jxta_endpoint_service);
 
+    filter->str = strdup(str);
     filter->func = f;
     filter->arg = arg;
+    if (filter->str == NULL) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+        free(filter);
+        return;
+    }
 
     /* insert the filter into the list */
     apr_thread_mutex_lock(service->demux_mutex);
     dl_insert_b(service->filter_list, filter);
+    demux_publish(service);
     apr_thread_mutex_unlock(service->demux_mutex);
 }
 
@@ -1293,9 +2246,10 @@ JXTA_DECLARE(void) jxta_endpoint_service_remove_filter(Jxta_endpoint_service * s
     }
 
     /* remove this filter from the list */
-    if (cur != NULL) {
-        free(cur->val);
+    if (cur != dl_nil(service->filter_list)) {
+        filter_free(cur->val);
         dl_delete_node(cur);
+        demux_publish(service);
     }
 
     apr_thread_mutex_unlock(service->demux_mutex);
@@ -1366,6 +2320,7 @@ Jxta_status endpoint_service_add_recipient(Jxta_endpoint_service * me, void **co
     } else {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Adding recipient[%pp] for %s.\n", cb->func, cb->recipient);
         apr_hash_set(me->cb_table, cb->recipient, APR_HASH_KEY_STRING, cb);
+        demux_publish(me);
         *cookie = cb->recipient;
         rv = JXTA_SUCCESS;
     }
@@ -1384,6 +2339,7 @@ Jxta_status endpoint_service_remove_recipient(Jxta_endpoint_service * me, void *
         rv = JXTA_ITEM_NOTFOUND;
     } else {
         apr_hash_set(me->cb_table, cookie, APR_HASH_KEY_STRING, NULL);
+        demux_publish(me);
         cb_elt_recycle(old_cb);
         rv = JXTA_SUCCESS;
     }
@@ -1426,6 +2382,7 @@ JXTA_DECLARE(Jxta_status)
 
     JXTA_OBJECT_SHARE(listener);
     apr_hash_set(service->listener_table, str, APR_HASH_KEY_STRING, (void *) listener);
+    demux_publish(service);
 
     apr_thread_mutex_unlock(service->demux_mutex);
     return JXTA_SUCCESS;
@@ -1446,24 +2403,32 @@ JXTA_DECLARE(Jxta_status)
     listener = (Jxta_listener *) apr_hash_get(service->listener_table, str, APR_HASH_KEY_STRING);
     if (listener != NULL) {
         apr_hash_set(service->listener_table, str, APR_HASH_KEY_STRING, NULL);
+        demux_publish(service);
         JXTA_OBJECT_RELEASE(listener);
     }
     apr_thread_mutex_unlock(service->demux_mutex);
     return JXTA_SUCCESS;
 }
 
+/*
+ * Lookup the listener for the address in the demux snapshot. The direct lookup does not allocate, the cross-group fallbacks
+ * only allocate for service params longer than the local buffer.
+ *
+ * @return a shared listener or NULL
+ */
 static Jxta_listener *lookup_listener(Jxta_endpoint_service * service, Jxta_endpoint_address * addr)
 {
     Jxta_listener *listener = NULL;
-    unsigned int i;
-    int index;
-    int pt = 0;
-    int j;
-    int str_length;
-    char *str;
-    char *str1;
+    Demux_snapshot *snap;
+    Demux_entry *entry;
     const char *ea_svc_name;
     const char *ea_svc_params;
+    const char *src;
+    char buf[256];
+    char *str1;
+    size_t len;
+    size_t j;
+    size_t pt;
 
     PTValid(service, Jxta_endpoint_service);
     JXTA_OBJECT_CHECK_VALID(addr);
@@ -1471,35 +2436,19 @@ static Jxta_listener *lookup_listener(Jxta_endpoint_service * service, Jxta_endp
     ea_svc_name = jxta_endpoint_address_get_service_name(addr);
     ea_svc_params = jxta_endpoint_address_get_service_params(addr);
     if (ea_svc_name == NULL) {
-        str = jxta_endpoint_address_to_string(addr);
-        if (str == NULL) {
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory");
-            return NULL;
-        }
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "No listener associated with this address %s\n", str);
+        char *str = jxta_endpoint_address_to_string(addr);
 
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "No listener associated with this address %s\n", str ? str : "");
         if (str != NULL)
             free(str);
         return NULL;
     }
 
-    str_length = strlen(ea_svc_name) + (ea_svc_params != NULL ? strlen(ea_svc_params) : 0) + 1;
-    str = calloc(str_length, sizeof(char));
-    if (str == NULL) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
-        return NULL;
-    }
-  
-    strcpy( str, ea_svc_name );
-
-    if( NULL != ea_svc_params ) {
-        strcat( str, ea_svc_params );
-    }
-
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Lookup for listener : %s\n", str );
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Lookup for listener : %s%s\n", ea_svc_name,
+                    ea_svc_params ? ea_svc_params : "");
 
-    apr_thread_mutex_lock(service->demux_mutex);
-    listener = (Jxta_listener *) apr_hash_get(service->listener_table, str, APR_HASH_KEY_STRING);
+    snap = demux_acquire(service);
+    entry = demux_lookup(snap->listeners, snap->listener_mask, ea_svc_name, '\0', ea_svc_params);
 
     /*
      * Note: 20040510 tra
@@ -1511,39 +2460,29 @@ static Jxta_listener *lookup_listener(Jxta_endpoint_service * service, Jxta_endp
      *    EndpointService:uuid-groupId/"real address"
      * We need to remove the beginning of the address
      */
-    if (listener == NULL) {
-
-        str1 = calloc(strlen(ea_svc_params) + 1, sizeof(char));
+    if (entry == NULL && ea_svc_params != NULL) {
+        len = strlen(ea_svc_params);
+        str1 = (len < sizeof(buf)) ? buf : malloc(len + 1);
         if (str1 == NULL) {
             jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
-            free(str);
+            demux_release(snap);
             return NULL;
         }
-        index = strlen(ea_svc_name);
 
-        /* 
-         * copy the address from the param position, skipping the service name
-         */
+        /* copy the params, removing the extra '/' */
         j = 0;
         pt = 0;
-        for (i = 0; i < strlen(ea_svc_params); i++) {
-            *(str1 + j) = *(str + index);
-
-            /*
-             * remove the extra '/'
-             */
-            if (*(str1 + j) == '/') {
-                index++;
-                pt = i; /* save location of end of first parameter */
+        for (src = ea_svc_params; *src; src++) {
+            if (*src == '/') {
+                pt = src - ea_svc_params; /* save location of end of first parameter */
             } else {
-                index++;
-                j++;
+                str1[j++] = *src;
             }
         }
-        *(str1 + j) = '\0';
+        str1[j] = '\0';
 
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "looking for subgroup endpoint %s\n", str1);
-        listener = (Jxta_listener *) apr_hash_get(service->listener_table, str1, APR_HASH_KEY_STRING);
+        entry = demux_lookup(snap->listeners, snap->listener_mask, str1, '\0', NULL);
 
         /*
          * FIXME: 20040706 tra
@@ -1555,18 +2494,22 @@ static Jxta_listener *lookup_listener(Jxta_endpoint_service * service, Jxta_endp
          * when multiple relay connections were supported. This should
          * have been removed.
          */
-        if (listener == NULL && pt != 0) {
-            strncpy(str1, ea_svc_params, pt - 1);
-            *(str1 + pt) = '\0';
+        if (entry == NULL && pt != 0) {
+            strncpy(str1, ea_svc_params, pt);
+            str1[pt] = '\0';
             jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "looking for relay endpoint %s\n", str1);
-            listener = (Jxta_listener *) apr_hash_get(service->listener_table, str1, APR_HASH_KEY_STRING);
+            entry = demux_lookup(snap->listeners, snap->listener_mask, str1, '\0', NULL);
         }
 
-        free(str1);
+        if (str1 != buf) {
+            free(str1);
+        }
     }
 
-    apr_thread_mutex_unlock(service->demux_mutex);
-    free(str);
+    if (entry != NULL) {
+        listener = JXTA_OBJECT_SHARE(entry->listener);
+    }
+    demux_release(snap);
     return listener;
 }
 
@@ -1684,6 +2627,396 @@ static long task_priority(Jxta_message * msg)
     return (pri >> 8) & APR_THREAD_TASK_PRIORITY_HIGHEST;
 }
 
+static Jxta_boolean msg_expired(Jxta_message * msg, time_t * lifespan)
+{
+    return JXTA_SUCCESS == jxta_message_get_lifespan(msg, lifespan) && time(NULL) >= *lifespan;
+}
+
+static int sched_class(long priority)
+{
+    return (int) (priority * JXTA_ENDPOINT_SEND_CLASSES / (APR_THREAD_TASK_PRIORITY_HIGHEST + 1));
+}
+
+/*
+ * Pool priority of the scheduler task, the one of the highest class with queued messages, -1 if there is none.
+ * Must be called with sched_mutex held.
+ */
+static long sched_priority(Jxta_endpoint_service * me)
+{
+    int i;
+
+    for (i = JXTA_ENDPOINT_SEND_CLASSES - 1; i >= 0; i--) {
+        if (!APR_RING_EMPTY(&me->sched[i].active, ep_sched_dest, link)) {
+            return (long) i * (APR_THREAD_TASK_PRIORITY_HIGHEST + 1) / JXTA_ENDPOINT_SEND_CLASSES;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Start scheduler tasks while there are queued messages and less than the configured number of tasks are running.
+ * Must be called with sched_mutex held.
+ */
+static void sched_kick_locked(Jxta_endpoint_service * me)
+{
+    long priority;
+
+    if (JXTA_MODULE_STARTED != jxta_module_state((Jxta_module *) me)) {
+        return;
+    }
+    while (me->sched_workers < me->sched_max_workers) {
+        priority = sched_priority(me);
+        if (priority < 0) {
+            break;
+        }
+        if (APR_SUCCESS != apr_thread_pool_push(jxta_PG_thread_pool_get(me->my_group), sched_dispatch, me, priority, me)) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Failed to start outgoing message task\n");
+            break;
+        }
+        me->sched_workers++;
+    }
+}
+
+static void sched_kick(Jxta_endpoint_service * me)
+{
+    apr_thread_mutex_lock(me->sched_mutex);
+    sched_kick_locked(me);
+    apr_thread_mutex_unlock(me->sched_mutex);
+}
+
+/*
+ * Queue the message for the destination transport address in the class given by its priority.
+ */
+static Jxta_status sched_enqueue(Jxta_endpoint_service * me, Jxta_message * msg, const char *ta)
+{
+    Ep_sched_class *cls;
+    Ep_sched_dest *dest;
+    Msg_task *task;
+    time_t lifespan;
+    int *weight;
+
+    cls = &me->sched[sched_class(task_priority(msg))];
+    if (msg_expired(msg, &lifespan)) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Message [%pp] is discarded with lifespan %ld\n", msg, lifespan);
+        apr_thread_mutex_lock(me->sched_mutex);
+        cls->stats.expired++;
+        apr_thread_mutex_unlock(me->sched_mutex);
+        return JXTA_SUCCESS;
+    }
+
+    apr_thread_mutex_lock(me->sched_mutex);
+    dest = apr_hash_get(cls->dests, ta, APR_HASH_KEY_STRING);
+    if (NULL != dest && me->sched_max_depth > 0 && dest->depth >= me->sched_max_depth) {
+        cls->stats.overflow++;
+        apr_thread_mutex_unlock(me->sched_mutex);
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Outgoing queue for %s is full. Message [%pp] is discarded.\n",
+                        ta, msg);
+        return JXTA_BUSY;
+    }
+    if (NULL == dest) {
+        dest = calloc(1, sizeof(*dest));
+        if (NULL != dest) {
+            dest->ta = strdup(ta);
+        }
+        if (NULL == dest || NULL == dest->ta) {
+            apr_thread_mutex_unlock(me->sched_mutex);
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+            free(dest);
+            return JXTA_NOMEM;
+        }
+        weight = apr_hash_get(me->sched_weights, ta, APR_HASH_KEY_STRING);
+        dest->weight = (NULL == weight) ? 1 : *weight;
+        apr_hash_set(cls->dests, dest->ta, APR_HASH_KEY_STRING, dest);
+        APR_RING_INSERT_TAIL(&cls->active, dest, ep_sched_dest, link);
+    }
+
+    task = msg_task_create(me, msg);
+    task->next = NULL;
+    if (NULL == dest->tail) {
+        dest->head = task;
+    } else {
+        dest->tail->next = task;
+    }
+    dest->tail = task;
+    dest->depth++;
+    cls->stats.enqueued++;
+    if (++cls->stats.depth > cls->stats.max_depth) {
+        cls->stats.max_depth = cls->stats.depth;
+    }
+    apr_atomic_inc32(&me->msg_task_cnt);
+    sched_kick_locked(me);
+    apr_thread_mutex_unlock(me->sched_mutex);
+    return JXTA_SUCCESS;
+}
+
+/*
+ * The destination of a message taken by sched_dequeue is served again, or freed if it has no more messages.
+ * Must be called with sched_mutex held.
+ */
+static void sched_dest_done_locked(Jxta_endpoint_service * me, Ep_sched_class * cls, Ep_sched_dest * dest)
+{
+    dest->busy = FALSE;
+    if (0 == dest->depth) {
+        apr_hash_set(cls->dests, dest->ta, APR_HASH_KEY_STRING, NULL);
+        free(dest->ta);
+        free(dest);
+    } else if (dest->deficit > 0) {
+        APR_RING_INSERT_HEAD(&cls->active, dest, ep_sched_dest, link);
+    } else {
+        APR_RING_INSERT_TAIL(&cls->active, dest, ep_sched_dest, link);
+    }
+}
+
+/*
+ * A message for the transport address is handled without blocking: there is a messenger for it, or it is queued in the
+ * negative cache.
+ */
+static Jxta_boolean sched_dest_ready(Jxta_endpoint_service * me, const char *ta)
+{
+    Jxta_boolean ready;
+
+    apr_thread_mutex_lock(me->mutex);
+    ready = NULL != apr_hash_get(me->messengers, ta, APR_HASH_KEY_STRING)
+        || NULL != apr_hash_get(me->nc, ta, APR_HASH_KEY_STRING);
+    apr_thread_mutex_unlock(me->mutex);
+    return ready;
+}
+
+/*
+ * Take the next message to send. The highest class with queued messages is served first, the destinations of a class are
+ * served by deficit round robin with a quantum of weight * sched_quantum messages.
+ * Must be called with sched_mutex held.
+ */
+static Msg_task *sched_dequeue(Jxta_endpoint_service * me, Ep_sched_class ** pcls)
+{
+    Ep_sched_class *cls;
+    Ep_sched_dest *dest;
+    Msg_task *task;
+    int i;
+
+    for (i = JXTA_ENDPOINT_SEND_CLASSES - 1; i >= 0; i--) {
+        cls = &me->sched[i];
+        if (APR_RING_EMPTY(&cls->active, ep_sched_dest, link)) {
+            continue;
+        }
+        dest = APR_RING_FIRST(&cls->active);
+        if (dest->deficit <= 0) {
+            dest->deficit += dest->weight * me->sched_quantum;
+        }
+        task = dest->head;
+        dest->head = task->next;
+        if (NULL == dest->head) {
+            dest->tail = NULL;
+        }
+        task->next = NULL;
+        dest->deficit--;
+        dest->depth--;
+        cls->stats.depth--;
+
+        /* back in the ring once the message is handled, see sched_dest_done_locked */
+        APR_RING_REMOVE(dest, link);
+        dest->busy = TRUE;
+        task->dest = dest;
+        task->cls = cls;
+        *pcls = cls;
+        return task;
+    }
+    return NULL;
+}
+
+static void *APR_THREAD_FUNC sched_dispatch(apr_thread_t * thread, void *arg)
+{
+    Jxta_endpoint_service *me = PTValid(arg, Jxta_endpoint_service);
+    Ep_sched_class *cls = NULL;
+    Ep_sched_dest *dest;
+    Msg_task *task;
+    time_t lifespan;
+    Jxta_boolean expired;
+    int i;
+
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Endpoint outgoing message handler awake.\n");
+
+    for (i = 0; i < EP_SCHED_BATCH; i++) {
+        if (JXTA_MODULE_STARTED != jxta_module_state((Jxta_module *) me)) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Endpoint service is stopped, interrupt handler.\n");
+            break;
+        }
+        apr_thread_mutex_lock(me->sched_mutex);
+        task = sched_dequeue(me, &cls);
+        apr_thread_mutex_unlock(me->sched_mutex);
+        if (NULL == task) {
+            break;
+        }
+
+        apr_atomic_dec32(&me->msg_task_cnt);
+        JXTA_OBJECT_CHECK_VALID(task->msg);
+        dest = task->dest;
+        expired = msg_expired(task->msg, &lifespan);
+        if (expired) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Message [%pp] is discarded with lifespan %ld\n", task->msg,
+                            lifespan);
+        } else if (!sched_dest_ready(me, dest->ta)
+                   && APR_SUCCESS == apr_thread_pool_push(jxta_PG_thread_pool_get(me->my_group), sched_connect, task,
+                                                          APR_THREAD_TASK_PRIORITY_NORMAL, me)) {
+            /* getting a messenger may block on a connection, the destination stays busy until sched_connect is done */
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "No messenger for %s, sending message [%pp] apart\n", dest->ta,
+                            task->msg);
+            continue;
+        } else {
+            outgoing_message_process(me, task->msg);
+        }
+        msg_task_recycle(task);
+
+        apr_thread_mutex_lock(me->sched_mutex);
+        if (expired) {
+            cls->stats.expired++;
+        } else {
+            cls->stats.sent++;
+        }
+        sched_dest_done_locked(me, cls, dest);
+        apr_thread_mutex_unlock(me->sched_mutex);
+    }
+
+    /* give the thread back to the pool, a new task is pushed if there are more messages */
+    apr_thread_mutex_lock(me->sched_mutex);
+    if (me->sched_workers > 0) {
+        me->sched_workers--;
+    }
+    sched_kick_locked(me);
+    apr_thread_mutex_unlock(me->sched_mutex);
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Endpoint outgoing message handler stopped.\n");
+    return NULL;
+}
+
+/*
+ * Send the message of a destination without a messenger, apart from the scheduler tasks so that an unreachable peer does not
+ * hold one of them. Once it failed the peer is in the negative cache and its next messages are queued there right away.
+ */
+static void *APR_THREAD_FUNC sched_connect(apr_thread_t * thread, void *arg)
+{
+    Msg_task *task = arg;
+    Jxta_endpoint_service *me = task->ep_svc;
+    Ep_sched_class *cls = task->cls;
+    Ep_sched_dest *dest = task->dest;
+
+    if (JXTA_MODULE_STARTED == jxta_module_state((Jxta_module *) me)) {
+        outgoing_message_process(me, task->msg);
+    }
+    msg_task_recycle(task);
+
+    apr_thread_mutex_lock(me->sched_mutex);
+    cls->stats.sent++;
+    sched_dest_done_locked(me, cls, dest);
+    sched_kick_locked(me);
+    apr_thread_mutex_unlock(me->sched_mutex);
+    return NULL;
+}
+
+/*
+ * Put the destinations left busy by cancelled tasks back in service. Must be called once no scheduler task runs.
+ */
+static void sched_dests_release(Jxta_endpoint_service * me)
+{
+    apr_hash_index_t *hi;
+    Ep_sched_dest *dest;
+    int i;
+
+    apr_thread_mutex_lock(me->sched_mutex);
+    for (i = 0; i < JXTA_ENDPOINT_SEND_CLASSES; i++) {
+        if (NULL == me->sched[i].dests) {
+            continue;
+        }
+        for (hi = apr_hash_first(NULL, me->sched[i].dests); hi; hi = apr_hash_next(hi)) {
+            apr_hash_this(hi, NULL, NULL, (void **) &dest);
+            if (dest->busy) {
+                sched_dest_done_locked(me, &me->sched[i], dest);
+            }
+        }
+    }
+    apr_thread_mutex_unlock(me->sched_mutex);
+}
+
+static void sched_destroy(Jxta_endpoint_service * me)
+{
+    Ep_sched_class *cls;
+    Ep_sched_dest *dest;
+    Msg_task *task;
+    Msg_task *next;
+    int i;
+
+    /* the busy destinations are out of the active rings */
+    sched_dests_release(me);
+    for (i = 0; i < JXTA_ENDPOINT_SEND_CLASSES; i++) {
+        cls = &me->sched[i];
+        if (NULL == cls->dests) {
+            continue;
+        }
+        while (!APR_RING_EMPTY(&cls->active, ep_sched_dest, link)) {
+            dest = APR_RING_FIRST(&cls->active);
+            APR_RING_REMOVE(dest, link);
+            for (task = dest->head; NULL != task; task = next) {
+                next = task->next;
+                task->next = NULL;
+                apr_atomic_dec32(&me->msg_task_cnt);
+                msg_task_recycle(task);
+            }
+            dest->head = dest->tail = NULL;
+            free(dest->ta);
+            free(dest);
+        }
+        cls->dests = NULL;
+    }
+}
+
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_get_send_stats(Jxta_endpoint_service * me, Jxta_endpoint_send_stats * stats)
+{
+    int i;
+
+    PTValid(me, Jxta_endpoint_service);
+
+    apr_thread_mutex_lock(me->sched_mutex);
+    for (i = 0; i < JXTA_ENDPOINT_SEND_CLASSES; i++) {
+        stats[i] = me->sched[i].stats;
+    }
+    apr_thread_mutex_unlock(me->sched_mutex);
+    return JXTA_SUCCESS;
+}
+
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_set_send_weight(Jxta_endpoint_service * me, Jxta_endpoint_address * dest_addr,
+                                                                int weight)
+{
+    apr_pool_t *pool;
+    Ep_sched_dest *dest;
+    char *ta;
+    int *val;
+    int i;
+
+    PTValid(me, Jxta_endpoint_service);
+
+    if (weight < 1) {
+        return JXTA_INVALID_ARGUMENT;
+    }
+
+    pool = jxta_PG_pool_get(me->my_group);
+    ta = jxta_endpoint_address_get_transport_addr(dest_addr);
+    apr_thread_mutex_lock(me->sched_mutex);
+    val = apr_hash_get(me->sched_weights, ta, APR_HASH_KEY_STRING);
+    if (NULL == val) {
+        val = apr_palloc(pool, sizeof(*val));
+        apr_hash_set(me->sched_weights, apr_pstrdup(pool, ta), APR_HASH_KEY_STRING, val);
+    }
+    *val = weight;
+    for (i = 0; i < JXTA_ENDPOINT_SEND_CLASSES; i++) {
+        dest = apr_hash_get(me->sched[i].dests, ta, APR_HASH_KEY_STRING);
+        if (NULL != dest) {
+            dest->weight = weight;
+        }
+    }
+    apr_thread_mutex_unlock(me->sched_mutex);
+    free(ta);
+    return JXTA_SUCCESS;
+}
+
 JXTA_DECLARE(Jxta_status) jxta_endpoint_service_send_ex(Jxta_endpoint_service * me, Jxta_message * msg,
                                                         Jxta_endpoint_address * dest_addr, Jxta_boolean sync)
 {
@@ -1705,18 +3038,16 @@ JXTA_DECLARE(Jxta_status) jxta_endpoint_service_send_ex(Jxta_endpoint_service *
     } else {
         char *baseAddrStr = NULL;
         Nc_entry *ptr = NULL;
-        Msg_task *task;
-
-        task = msg_task_create(me, msg);
-        apr_thread_pool_push(jxta_PG_thread_pool_get(me->my_group), outgoing_message_thread, task, task_priority(msg), me);
-        apr_atomic_inc32(&me->msg_task_cnt);
 
         baseAddrStr = jxta_endpoint_address_get_transport_addr(dest_addr);
-        apr_thread_mutex_lock(me->mutex);
-        ptr = apr_hash_get(me->nc, baseAddrStr, APR_HASH_KEY_STRING);
-        apr_thread_mutex_unlock(me->mutex);
+        res = sched_enqueue(me, msg, baseAddrStr);
+        if (JXTA_SUCCESS == res) {
+            apr_thread_mutex_lock(me->mutex);
+            ptr = apr_hash_get(me->nc, baseAddrStr, APR_HASH_KEY_STRING);
+            apr_thread_mutex_unlock(me->mutex);
+            res = (NULL == ptr) ? JXTA_SUCCESS : JXTA_UNREACHABLE_DEST;
+        }
         free(baseAddrStr);
-        res = (NULL == ptr) ? JXTA_SUCCESS : JXTA_UNREACHABLE_DEST;
     }
 
     return res;
@@ -1814,28 +3145,6 @@ JXTA_DECLARE(char *) jxta_endpoint_service_get_relay_proto(Jxta_endpoint_service
     return proto;
 }
 
-static void *APR_THREAD_FUNC outgoing_message_thread(apr_thread_t * thread, void *arg)
-{
-    Msg_task *task = arg;
-    Jxta_endpoint_service *me = PTValid(task->ep_svc, Jxta_endpoint_service);
-    Jxta_message *msg;
-
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Endpoint outgoing message handler awake.\n");
-
-    if (JXTA_MODULE_STARTED != jxta_module_state((Jxta_module*)me)) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Endpoint service is stopped, interrupt handler.\n");
-        return NULL;
-    }
-
-    apr_atomic_dec32(&me->msg_task_cnt);
-    msg = task->msg;
-    JXTA_OBJECT_CHECK_VALID(msg);
-    outgoing_message_process(me, msg);
-    msg_task_recycle(task);
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Endpoint outgoing message handler stopped.\n");
-    return NULL;
-}
-
 static Jxta_status try_existing_messenger(Jxta_endpoint_service * me, Jxta_message * msg, Jxta_endpoint_address * dest)
 {
     Peer_route_elt *ptr;
@@ -1848,17 +3157,22 @@ static Jxta_status try_existing_messenger(Jxta_endpoint_service * me, Jxta_messa
     ptr = apr_hash_get(me->messengers, ta, APR_HASH_KEY_STRING);
     free(ta);
     if (!ptr) {
+        me->msgr_stats.misses++;
         apr_thread_mutex_unlock(me->mutex);
         return JXTA_ITEM_NOTFOUND;
     }
 
+    me->msgr_stats.hits++;
+    messenger_touch(me, ptr);
     messenger = JXTA_OBJECT_SHARE(ptr->msgr);
     apr_thread_mutex_unlock(me->mutex);
 
     JXTA_OBJECT_CHECK_VALID(messenger);
     res = messenger->jxta_send(messenger, msg);
     if (JXTA_SUCCESS != res) {
+        apr_thread_mutex_lock(me->mutex);
         messenger_remove(me, dest);
+        apr_thread_mutex_unlock(me->mutex);
     }
     JXTA_OBJECT_RELEASE(messenger);
     return res;
@@ -1925,7 +3239,7 @@ static Jxta_status outgoing_message_process(Jxta_endpoint_service * me, Jxta_mes
         return JXTA_SUCCESS;
     }
 
-    if (JXTA_SUCCESS == jxta_message_get_lifespan(msg, &lifespan) && time(NULL) >= lifespan) {
+    if (msg_expired(msg, &lifespan)) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Message [%pp] is discarded with lifespan %ld\n", msg, lifespan);
         return JXTA_SUCCESS;
     }
@@ -1967,7 +3281,7 @@ static Jxta_status outgoing_message_process(Jxta_endpoint_service * me, Jxta_mes
 
     if (apr_atomic_inc32(&cnt) >= jxta_epcfg_get_ncrq_retry(me->config) || 0 == apr_atomic_read32(&me->msg_task_cnt)) {
         apr_atomic_set32(&cnt, 0);
-        nc_review_all(me);
+        nc_review_due(me);
     }
 
     return res;
@@ -1998,6 +3312,7 @@ void jxta_endpoint_service_transport_event(Jxta_endpoint_service * me, Jxta_tran
     char *addr = NULL;
     Jxta_endpoint_address *ea = NULL;
     Nc_entry *ptr = NULL;
+    Peer_route_elt *elt;
 
     switch (e->type) {
     case JXTA_TRANSPORT_INBOUND_CONNECTED:
@@ -2011,10 +3326,11 @@ void jxta_endpoint_service_transport_event(Jxta_endpoint_service * me, Jxta_tran
         ea = jxta_endpoint_address_new_3(e->peer_id, NULL, NULL);
 
         apr_thread_mutex_lock(me->mutex);
-        messenger_add(me, e->dest_addr, e->msgr);
+        elt = messenger_add(me, e->dest_addr, e->msgr);
         if (ea) {
-            messenger_add(me, ea, e->msgr);
+            messenger_link(elt, messenger_add(me, ea, e->msgr));
         }
+        messengers_trim_later(me);
         apr_thread_mutex_unlock(me->mutex);
 
         check_nc_entry(me, addr);
@@ -2039,11 +3355,12 @@ void jxta_endpoint_service_transport_event(Jxta_endpoint_service * me, Jxta_tran
         ea = jxta_endpoint_address_new_3(e->peer_id, NULL, NULL);
 
         apr_thread_mutex_lock(me->mutex);
-        messenger_add(me, e->dest_addr, e->msgr);
+        elt = messenger_add(me, e->dest_addr, e->msgr);
         if (ea) {
-            messenger_add(me, ea, e->msgr);
+            messenger_link(elt, messenger_add(me, ea, e->msgr));
             JXTA_OBJECT_RELEASE(ea);
         }
+        messengers_trim_later(me);
         apr_thread_mutex_unlock(me->mutex);
         break;
 
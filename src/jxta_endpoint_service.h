@@ -170,6 +170,25 @@ JXTA_DECLARE(Jxta_status) jxta_endpoint_service_add_poll(Jxta_endpoint_service *
  */
 JXTA_DECLARE(Jxta_status) jxta_endpoint_service_remove_poll(Jxta_endpoint_service * me, void * cookie);
 
+/**
+ * Temporarily stops polling a registered socket, the callback won't be called until the socket is resumed. The socket stays
+ * registered and can still be unregistered with jxta_endpoint_service_remove_poll.
+ *
+ * @param service Handle of the endpoint service object to which the
+ * operation is applied.
+ * @param cookie Transport demux element returned by the register function
+ */
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_pause_poll(Jxta_endpoint_service * me, void * cookie);
+
+/**
+ * Resumes polling a socket paused with jxta_endpoint_service_pause_poll.
+ *
+ * @param service Handle of the endpoint service object to which the
+ * operation is applied.
+ * @param cookie Transport demux element returned by the register function
+ */
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_resume_poll(Jxta_endpoint_service * me, void * cookie);
+
 /*
  * Registers a filter routine with this endpoint service.
  * That filter will be invoked for every message received by this endpoint if
@@ -249,6 +268,79 @@ JXTA_DECLARE(Jxta_status) jxta_endpoint_service_send_async(Jxta_PG * pg, Jxta_en
 JXTA_DECLARE(Jxta_status) jxta_endpoint_service_send_ex(Jxta_endpoint_service * me, Jxta_message * msg,
                                                         Jxta_endpoint_address * dest_addr, Jxta_boolean sync);
 
+/**
+ * Number of priority classes of the outgoing message queues. The class of a message is taken from the high byte of its
+ * QoS priority, higher classes are always sent first.
+ */
+#define JXTA_ENDPOINT_SEND_CLASSES 4
+
+typedef struct jxta_endpoint_send_stats {
+    apr_size_t depth;           /* messages currently queued */
+    apr_size_t max_depth;       /* highest number of messages queued */
+    apr_uint32_t enqueued;
+    apr_uint32_t sent;
+    apr_uint32_t expired;       /* dropped because the QoS lifespan elapsed */
+    apr_uint32_t overflow;      /* dropped because the destination queue was full */
+} Jxta_endpoint_send_stats;
+
+/**
+ * Get the counters of the outgoing message queues, one entry per priority class.
+ *
+ * @param me Handle of the endpoint service object to which the operation is applied.
+ * @param stats array of JXTA_ENDPOINT_SEND_CLASSES entries to fill, indexed by priority class.
+ * @return JXTA_SUCCESS
+ */
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_get_send_stats(Jxta_endpoint_service * me, Jxta_endpoint_send_stats * stats);
+
+/**
+ * Set the share of the outgoing bandwidth given to a destination relative to the others of the same priority class.
+ * Each time its turn comes, a destination can send weight times the configured quantum of messages.
+ *
+ * @param me Handle of the endpoint service object to which the operation is applied.
+ * @param dest_addr The destination, only the protocol name and address are used.
+ * @param weight The weight of the destination, 1 by default.
+ * @return JXTA_SUCCESS or JXTA_INVALID_ARGUMENT if weight is less than 1.
+ */
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_set_send_weight(Jxta_endpoint_service * me, Jxta_endpoint_address * dest_addr,
+                                                                int weight);
+
+typedef struct jxta_endpoint_nc_stats {
+    apr_size_t peers;           /* unreachable peers in the negative cache */
+    apr_size_t queued_msgs;     /* messages waiting for retransmission */
+    apr_size_t queued_bytes;
+    apr_uint32_t retries;       /* retransmit attempts */
+    apr_uint32_t retransmitted; /* messages delivered from the retransmit queues */
+    apr_uint32_t expired;       /* dropped because the peer stayed unreachable for the maximum timeout */
+    apr_uint32_t evicted;       /* oldest messages dropped to stay within the queue limits */
+} Jxta_endpoint_nc_stats;
+
+/**
+ * Get the counters of the negative cache and of the retransmit queues for unreachable peers.
+ *
+ * @param me Handle of the endpoint service object to which the operation is applied.
+ * @param stats the structure to fill.
+ * @return JXTA_SUCCESS
+ */
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_get_nc_stats(Jxta_endpoint_service * me, Jxta_endpoint_nc_stats * stats);
+
+typedef struct jxta_endpoint_messenger_stats {
+    apr_size_t messengers;      /* cached messengers, one per address of a peer */
+    apr_uint32_t hits;
+    apr_uint32_t misses;
+    apr_uint32_t evicted;       /* least recently used messengers released to stay within the cache size */
+    apr_uint32_t expired;       /* messengers released after being idle for the idle timeout */
+} Jxta_endpoint_messenger_stats;
+
+/**
+ * Get the counters of the messenger cache.
+ *
+ * @param me Handle of the endpoint service object to which the operation is applied.
+ * @param stats the structure to fill.
+ * @return JXTA_SUCCESS
+ */
+JXTA_DECLARE(Jxta_status) jxta_endpoint_service_get_messenger_stats(Jxta_endpoint_service * me,
+                                                                    Jxta_endpoint_messenger_stats * stats);
+
 /*
  * Propagate the given message to the given service destination using 
  * any available propagation transport. There is no guarantee
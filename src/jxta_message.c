@@ -70,6 +70,10 @@ static const char *__log_cat = "MESSAGE";
 
 #include <assert.h>
 
+#if defined(GZIP_ENABLED) || defined(GUNZIP_ENABLED)
+#include <zlib.h>
+#endif
+
 #include "jxta_errno.h"
 #include "jxta_log.h"
 #include "jxta_debug.h"
@@ -89,6 +93,7 @@ static const char *MESSAGE_SOURCE_NAME = "EndpointSourceAddress";
 static const char *MESSAGE_DESTINATION_NAME = "EndpointDestinationAddress";
 static const char *MESSAGE_QOS_SETTING_NAME = "QoS_Setting";
 static const char *MESSAGE_JXTABINARYWIRE_MIME = "application/x-jxta-msg";
+static const char *MESSAGE_DEFLATE_ENCODING = "deflate";
 
 static const char JXTAMSG_MSGMAGICSIG[] = { 'j', 'x', 'm', 'g' };
 
@@ -141,6 +146,12 @@ struct _Jxta_message_element {
 
 typedef struct _Jxta_message_element Jxta_message_element_mutable;
 
+/* Element compression settings when writing a message */
+typedef struct {
+    apr_size_t compress_threshold;
+    Jxta_message_compress_stats *stats;
+} Msg_write_ctx;
+
 static void jxta_message_delete(Jxta_object * ptr);
 static void Jxta_message_element_delete(Jxta_object * ptr);
 
@@ -153,7 +164,8 @@ static char *parseqname(char const *srcqname, char **ns, char **ncname);
 
 static Jxta_status JXTA_STDCALL get_message_to_jstring(void *stream, char const *buf, size_t len);
 
-static Jxta_status message_write_v2(Jxta_message * msg, char const *mime_type, WriteFunc write_func, void *stream);
+static Jxta_status message_write_v2(Jxta_message * msg, char const *mime_type, WriteFunc write_func, void *stream,
+                                    Msg_write_ctx const *ctx);
 static int build_v2_names_table(Jxta_message * msg, char const ***names_table);
 static apr_uint16_t lookup_name_token(char const *name, char const **names_table, int names_count);
 static char const *lookup_name_string(apr_uint16_t token, char const **names_table, int names_count);
@@ -161,7 +173,7 @@ static Jxta_status read_v1_element(Jxta_message_element ** anElement, ReadFunc r
                                    char const **names_table, int names_count);
 static Jxta_status read_v2_element(Jxta_message_element ** anElement, ReadFunc read_func, void *stream,
                                    char const **names_table, int names_count);
-static Jxta_status write_v2_element(Jxta_message_element * anElement, WriteFunc write_func, void *stream,
+static Jxta_status write_v2_element(Jxta_message_element * anElement, Msg_write_ctx const *ctx, WriteFunc write_func, void *stream,
                                     char const **names_table, int names_count);
 
 static Jxta_status add_qos_element(Jxta_message * me);
@@ -1264,14 +1276,31 @@ JXTA_DECLARE(Jxta_status) jxta_message_write_1(Jxta_message * msg, char const *m
     if (0 == version) {
         return message_write_v1(msg, mime_type, write_func, stream);
     } else if (1 == version) {
-        return message_write_v2(msg, mime_type, write_func, stream);
+        return message_write_v2(msg, mime_type, write_func, stream, NULL);
     } else {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "Error writing element.\n");
         return JXTA_INVALID_ARGUMENT;
     }
 }
 
-static Jxta_status message_write_v2(Jxta_message * msg, char const *mime_type, WriteFunc write_func, void *stream)
+JXTA_DECLARE(Jxta_status) jxta_message_write_2(Jxta_message * msg, char const *mime_type, int version,
+                                               apr_size_t compress_threshold, Jxta_message_compress_stats * stats,
+                                               WriteFunc write_func, void *stream)
+{
+    Msg_write_ctx ctx;
+
+    if (1 != version || 0 == compress_threshold) {
+        return jxta_message_write_1(msg, mime_type, version, write_func, stream);
+    }
+
+    add_qos_element(msg);
+    ctx.compress_threshold = compress_threshold;
+    ctx.stats = stats;
+    return message_write_v2(msg, mime_type, write_func, stream, &ctx);
+}
+
+static Jxta_status message_write_v2(Jxta_message * msg, char const *mime_type, WriteFunc write_func, void *stream,
+                                    Msg_write_ctx const *ctx)
 {
     Jxta_status res;
     size_t names_count = 2;     /* start with the two default names */
@@ -1358,7 +1387,7 @@ static Jxta_status message_write_v2(Jxta_message * msg, char const *mime_type, W
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_PARANOID, "[msg= %pp] #%d Writing element [%pp]  -- %s:%s \n", msg, eachElement,
                         anElement, anElement->usr.ns, anElement->usr.name);
 
-        res = write_v2_element(anElement, write_func, stream, names_table, names_count);
+        res = write_v2_element(anElement, ctx, write_func, stream, names_table, names_count);
 
         JXTA_OBJECT_RELEASE(anElement);
 
@@ -1526,7 +1555,103 @@ static char const *lookup_name_string(apr_uint16_t token, char const **names_tab
 }
 
 
-static Jxta_status write_v2_element(Jxta_message_element * anElement, WriteFunc write_func,
+#ifdef GZIP_ENABLED
+/**
+ * Deflate the element value. The encoded body is the length of the value as a 32 bit network order integer followed by the
+ * zlib stream.
+ *
+ * @return the encoded body or NULL if the value does not compress.
+ **/
+static Jxta_bytevector *element_deflate(Jxta_bytevector * value)
+{
+    size_t length = jxta_bytevector_size(value);
+    unsigned char *raw;
+    unsigned char *out;
+    uLongf out_len;
+    apr_uint32_t raw_len;
+
+    if (length > JXTA_MESSAGE_INFLATE_MAX) {
+        return NULL;
+    }
+
+    raw = malloc(length);
+    if (NULL == raw) {
+        return NULL;
+    }
+    jxta_bytevector_get_bytes_at(value, raw, 0, length);
+
+    out_len = compressBound(length);
+    out = malloc(sizeof(raw_len) + out_len);
+    if (NULL == out) {
+        free(raw);
+        return NULL;
+    }
+
+    if (Z_OK != compress2(out + sizeof(raw_len), &out_len, raw, length, Z_DEFAULT_COMPRESSION)
+        || sizeof(raw_len) + out_len >= length) {
+        free(raw);
+        free(out);
+        return NULL;
+    }
+    free(raw);
+
+    raw_len = htonl((apr_uint32_t) length);
+    memcpy(out, &raw_len, sizeof(raw_len));
+    return jxta_bytevector_new_3((char *) out, sizeof(raw_len) + out_len, TRUE);
+}
+#endif /* GZIP_ENABLED */
+
+#ifdef GUNZIP_ENABLED
+/**
+ * Inflate an element body encoded by element_deflate. The announced length comes from the peer, it is checked against
+ * JXTA_MESSAGE_INFLATE_MAX before anything is allocated for it.
+ **/
+static Jxta_status element_inflate(Jxta_bytevector * body, Jxta_bytevector ** value)
+{
+    size_t length = jxta_bytevector_size(body);
+    unsigned char *in;
+    unsigned char *out;
+    uLongf out_len;
+    apr_uint32_t raw_len;
+
+    if (length < sizeof(raw_len)) {
+        return JXTA_IOERR;
+    }
+
+    jxta_bytevector_get_bytes_at(body, (unsigned char *) &raw_len, 0, sizeof(raw_len));
+    out_len = ntohl(raw_len);
+    if (out_len > JXTA_MESSAGE_INFLATE_MAX) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Deflated element of %lu bytes exceeds %u bytes.\n",
+                        (unsigned long) out_len, (unsigned int) JXTA_MESSAGE_INFLATE_MAX);
+        return JXTA_IOERR;
+    }
+
+    in = malloc(length);
+    if (NULL == in) {
+        return JXTA_NOMEM;
+    }
+    jxta_bytevector_get_bytes_at(body, in, 0, length);
+
+    out = malloc(out_len ? out_len : 1);
+    if (NULL == out) {
+        free(in);
+        return JXTA_NOMEM;
+    }
+
+    if (Z_OK != uncompress(out, &out_len, in + sizeof(raw_len), length - sizeof(raw_len)) || out_len != ntohl(raw_len)) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Could not inflate element body.\n");
+        free(in);
+        free(out);
+        return JXTA_IOERR;
+    }
+    free(in);
+
+    *value = jxta_bytevector_new_3((char *) out, out_len, TRUE);
+    return (NULL == *value) ? JXTA_NOMEM : JXTA_SUCCESS;
+}
+#endif /* GUNZIP_ENABLED */
+
+static Jxta_status write_v2_element(Jxta_message_element * anElement, Msg_write_ctx const *ctx, WriteFunc write_func,
                                     void *stream, char const **names_table, int names_count)
 {
     Jxta_status res;
@@ -1534,6 +1659,7 @@ static Jxta_status write_v2_element(Jxta_message_element * anElement, WriteFunc
     size_t length;
     apr_uint32_t el_length;
     apr_uint16_t name;
+    Jxta_bytevector *body = NULL;
 
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_PARANOID, "Writing element [%pp] ns='%s' name='%s' len=%d sig=[%pp]\n", anElement,
                     anElement->usr.ns, anElement->usr.name, jxta_bytevector_size(anElement->usr.value), anElement->usr.sig);
@@ -1556,6 +1682,21 @@ static Jxta_status write_v2_element(Jxta_message_element * anElement, WriteFunc
         el_flags |= JXTAMSG2_ELMFLAG_SIGNATURE;
     }
 
+#ifdef GZIP_ENABLED
+    /* signed elements are sent as is, the signature covers the original value */
+    if (NULL != ctx && NULL == anElement->usr.sig
+        && jxta_bytevector_size(anElement->usr.value) >= ctx->compress_threshold) {
+        body = element_deflate(anElement->usr.value);
+        if (NULL != body) {
+            el_flags |= JXTAMSG2_ELMFLAG_ENCODINGS;
+        }
+        if (NULL != ctx->stats) {
+            ctx->stats->raw_bytes += jxta_bytevector_size(anElement->usr.value);
+            ctx->stats->encoded_bytes += jxta_bytevector_size(NULL != body ? body : anElement->usr.value);
+        }
+    }
+#endif /* GZIP_ENABLED */
+
     /* flags */
     res = write_func(stream, (char *) &el_flags, sizeof(el_flags));
     if (JXTA_SUCCESS != res)
@@ -1608,8 +1749,23 @@ static Jxta_status write_v2_element(Jxta_message_element * anElement, WriteFunc
         }
     }
 
+    /* encoding, always as a literal so the names table does not depend on compression */
+    if (NULL != body) {
+        name = htons((apr_uint16_t) JXTAMSG_NAMES_LITERAL_IDX);
+
+        res = write_func(stream, (char *) &name, sizeof(apr_uint16_t));
+        if (JXTA_SUCCESS != res) {
+            goto ELEMENT_IO_ERROR;
+        }
+
+        res = string_write(write_func, stream, MESSAGE_DEFLATE_ENCODING);
+        if (JXTA_SUCCESS != res) {
+            goto ELEMENT_IO_ERROR;
+        }
+    }
+
     /* body length */
-    length = jxta_bytevector_size(anElement->usr.value);
+    length = jxta_bytevector_size(NULL != body ? body : anElement->usr.value);
     el_length = htonl(length);
 
     res = write_func(stream, (char *) &el_length, sizeof(el_length));
@@ -1618,7 +1774,7 @@ static Jxta_status write_v2_element(Jxta_message_element * anElement, WriteFunc
 
     if (length > 0) {
         /* body */
-        res = jxta_bytevector_write(anElement->usr.value, write_func, stream, 0, length);
+        res = jxta_bytevector_write(NULL != body ? body : anElement->usr.value, write_func, stream, 0, length);
         if (JXTA_SUCCESS != res) {
             goto ELEMENT_IO_ERROR;
         }
@@ -1628,7 +1784,7 @@ static Jxta_status write_v2_element(Jxta_message_element * anElement, WriteFunc
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_PARANOID, "[%pp] writing signature element [%pp].\n", anElement,
                         anElement->usr.sig);
 
-        res = write_v2_element(anElement->usr.sig, write_func, stream, names_table, names_count);
+        res = write_v2_element(anElement->usr.sig, NULL, write_func, stream, names_table, names_count);
 
         if (res != JXTA_SUCCESS) {
             goto FINAL_EXIT;
@@ -1642,6 +1798,10 @@ static Jxta_status write_v2_element(Jxta_message_element * anElement, WriteFunc
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Error writing element [%pp].\n", anElement);
 
   FINAL_EXIT:
+    if (NULL != body)
+        JXTA_OBJECT_RELEASE(body);
+    body = NULL;
+
     return res;
 }
 
@@ -1768,6 +1928,7 @@ static Jxta_status read_v2_element(Jxta_message_element ** anElement, ReadFunc r
     char *el_namespace = NULL;
     char *el_name = NULL;
     char *el_mime_type = NULL;
+    char *el_encoding = NULL;
     Jxta_bytevector *el_value = NULL;
     Jxta_message_element *sigElement = NULL;
 
@@ -1791,8 +1952,9 @@ static Jxta_status read_v2_element(Jxta_message_element ** anElement, ReadFunc r
         goto FINAL_EXIT;
     }
 
-    if (element_flags & (JXTAMSG2_ELMFLAG_ENCODINGS | JXTAMSG2_ELMFLAG_ENCODED_SIGNED)) {
+    if (element_flags & JXTAMSG2_ELMFLAG_ENCODED_SIGNED) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "read_v2_element: Unsupported element flags\n");
+        res = JXTA_NOTIMP;
         goto FINAL_EXIT;
     }
 
@@ -1826,6 +1988,26 @@ static Jxta_status read_v2_element(Jxta_message_element ** anElement, ReadFunc r
         }
     }
 
+    if (0 != (element_flags & JXTAMSG2_ELMFLAG_ENCODINGS)) {
+        el_encoding = name_read(read_func, stream, names_table, names_count);
+
+        if (NULL == el_encoding) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "read_v2_element: Could not read element encoding\n");
+            res = JXTA_IOERR;
+            goto FINAL_EXIT;
+        }
+
+#ifdef GUNZIP_ENABLED
+        if (0 != strcmp(el_encoding, MESSAGE_DEFLATE_ENCODING)) {
+#endif
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "read_v2_element: Unsupported element encoding %s\n", el_encoding);
+            res = JXTA_NOTIMP;
+            goto FINAL_EXIT;
+#ifdef GUNZIP_ENABLED
+        }
+#endif
+    }
+
     if (0 != (JXTAMSG2_ELMFLAG_UINT64_LENS & element_flags)) {
         res = read_func(stream, (char *) &element_length, sizeof(element_length));
 
@@ -1869,6 +2051,19 @@ static Jxta_status read_v2_element(Jxta_message_element ** anElement, ReadFunc r
         goto FINAL_EXIT;
     }
 
+#ifdef GUNZIP_ENABLED
+    if (NULL != el_encoding) {
+        Jxta_bytevector *body = el_value;
+
+        el_value = NULL;
+        res = element_inflate(body, &el_value);
+        JXTA_OBJECT_RELEASE(body);
+        if (JXTA_SUCCESS != res) {
+            goto FINAL_EXIT;
+        }
+    }
+#endif /* GUNZIP_ENABLED */
+
     if (0 != (JXTAMSG2_ELMFLAG_SIGNATURE & element_flags)) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_PARANOID, "read_v2_element: Reading signature.\n");
 
@@ -1903,6 +2098,10 @@ static Jxta_status read_v2_element(Jxta_message_element ** anElement, ReadFunc r
         free(el_mime_type);
     el_mime_type = NULL;
 
+    if (NULL != el_encoding)
+        free(el_encoding);
+    el_encoding = NULL;
+
     if (NULL != sigElement)
         JXTA_OBJECT_RELEASE(sigElement);
     sigElement = NULL;
@@ -153,6 +153,42 @@ JXTA_DECLARE(Jxta_status) jxta_message_write(Jxta_message * msg, char const *mim
  **/
 JXTA_DECLARE(Jxta_status) jxta_message_write_1(Jxta_message * msg, char const *mime_type, int version, WriteFunc write_func, void *stream);
 
+/**
+ * The largest value of a deflated element, in bytes, once inflated. Deflated
+ * elements announcing a larger value are rejected when a message is read and
+ * larger values are not deflated when it is written.
+ **/
+#ifndef JXTA_MESSAGE_INFLATE_MAX
+#define JXTA_MESSAGE_INFLATE_MAX (16 * 1024 * 1024)
+#endif
+
+/**
+ * Byte counts of the elements considered for compression by jxta_message_write_2.
+ **/
+typedef struct _jxta_message_compress_stats {
+    apr_uint64_t raw_bytes;
+    apr_uint64_t encoded_bytes;
+} Jxta_message_compress_stats;
+
+/**
+ * Writes a Jxta message to a "stream", deflating the values of the elements
+ * larger than a threshold. Compression is only available with the version 2
+ * message format, the receiver must support the "deflate" element encoding.
+ *
+ * @param  msg The message to which will be written.
+ * @param  mime_type The mime-type which will be written to of the stream.
+ * @param  version The message format version which will be used to write the message. 
+ * @param  compress_threshold The minimum size of element values to compress, 0 to disable compression.
+ * @param  stats If not NULL, the byte counts of the elements considered for compression are added to it.
+ * @param  write_func The function to be called to write message bytes.
+ * @param  stream  The identifier which will be passed to write_func to identify
+ *  the stream.
+ * @return  JXTA_SUCCESS if the message was written successfully.
+ **/
+JXTA_DECLARE(Jxta_status) jxta_message_write_2(Jxta_message * msg, char const *mime_type, int version,
+                                               apr_size_t compress_threshold, Jxta_message_compress_stats * stats,
+                                               WriteFunc write_func, void *stream);
+
 JXTA_DECLARE(Jxta_endpoint_address *) jxta_message_get_source(Jxta_message * msg);
 
 JXTA_DECLARE(Jxta_status) jxta_message_set_source(Jxta_message * msg, Jxta_endpoint_address * src);
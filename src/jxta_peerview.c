@@ -68,6 +68,7 @@ static const char *__log_cat = "PV";
 #include "jxta_errno.h"
 #include "jxta_log.h"
 #include "jxta_hashtable.h"
+#include "jxta_objecthashtable.h"
 #include "jxta_listener.h"
 #include "jxta_rdv_service.h"
 #include "jxta_peer_private.h"
@@ -80,6 +81,10 @@ const char JXTA_PEERVIEW_RDVADV_ELEMENT_NAME[] = "PeerView.PeerAdv";
 const char JXTA_PEERVIEW_RDVRESP_ELEMENT_NAME[] = "PeerView.PeerAdv.Response";
 const char JXTA_PEERVIEW_FAILURE_ELEMENT_NAME[] = "PeerView.Failure";
 const char JXTA_PEERVIEW_CACHED_ELEMENT_NAME[] = "PeerView.Cached";
+const char JXTA_PEERVIEW_WALK_ELEMENT_NAME[] = "PeerView.WalkHeader";
+
+/* value of the walk header element of peers which accept the binary walk header */
+static const char PEERVIEW_WALK_BINARY[] = "binary";
 
 #define RDVA_REFRESH_INTERVAL 5 * 60 * JPR_INTERVAL_ONE_SECOND
 #define SEEDING_LOAD_INTERVAL 20 * 60 * JPR_INTERVAL_ONE_SECOND
@@ -99,6 +104,12 @@ struct _jxta_peer_peerview_entry {
     Jxta_time last_refresh;
 
     Jxta_RdvAdvertisement *rdva;
+
+    /* string form of the peer id, the order of the local view */
+    JString *pid_string;
+
+    /* the peer announced it accepts the binary walk header */
+    Jxta_boolean binary_walk;
 };
 
 typedef struct _jxta_peer_peerview_entry _jxta_peer_peerview_entry;
@@ -145,8 +156,14 @@ struct _jxta_peerview {
     Jxta_inputpipe *ip;
     Jxta_listener *listener_peerview;
 
-    Jxta_hashtable *localView;
-    Jxta_vector *localViewOrder;
+    /* PVEs keyed by peer id, compared by their binary UUID */
+    Jxta_objecthashtable *localView;
+    /* the same PVEs ordered by peer id string, the array holds a reference */
+    _jxta_peer_peerview_entry **localViewOrder;
+    unsigned int localViewSize;
+    unsigned int localViewCapacity;
+    /* no PVE of the local view expires before */
+    Jxta_time localViewExpires;
     _jxta_peer_peerview_entry *downPVE;
     _jxta_peer_peerview_entry *selfPVE;
     _jxta_peer_peerview_entry *upPVE;
@@ -159,6 +176,11 @@ struct _jxta_peerview {
 
     /** To generate peer view events */
     Jxta_hashtable *event_listener_table;
+
+    /* events waiting to be dispatched to the listeners by a pool task, in order */
+    apr_thread_mutex_t *event_mutex;
+    Jxta_vector *event_queue;
+    Jxta_boolean event_dispatching;
 };
 
 typedef struct _jxta_peerview _jxta_peerview_mutable;
@@ -169,7 +191,8 @@ static void peerview_delete(Jxta_object * addr);
 
 static void JXTA_STDCALL peerview_listener(Jxta_object * obj, void *arg);
 static Jxta_status process_peerview_message(_jxta_peerview_mutable * self, Jxta_RdvAdvertisement * rdva, Jxta_boolean edge,
-                                            Jxta_boolean response, Jxta_boolean failure, Jxta_boolean cached);
+                                            Jxta_boolean response, Jxta_boolean failure, Jxta_boolean cached,
+                                            Jxta_boolean binary_walk);
 static _jxta_peer_peerview_entry *peerview_entry_new(void);
 static _jxta_peer_peerview_entry *peerview_entry_construct(_jxta_peer_peerview_entry * self);
 static void peerview_entry_delete(Jxta_object * addr);
@@ -189,6 +212,7 @@ static Jxta_status jxta_peerview_send_pvm(_jxta_peerview_mutable * self, _jxta_p
 static Jxta_RdvAdvertisement *jxta_peerview_build_rdva(Jxta_PG * group, JString * serviceName);
 
 static void jxta_peerview_call_event_listeners(Jxta_peerview * pv, Jxta_Peerview_event_type event, Jxta_id * id);
+static void *APR_THREAD_FUNC peerview_event_dispatch(apr_thread_t * thread, void *arg);
 
 static void addjust_up_down_peers(_jxta_peerview_mutable * self);
 static void remove_expired_PVEs(_jxta_peerview_mutable * self);
@@ -219,6 +243,8 @@ static _jxta_peer_peerview_entry *peerview_entry_construct(_jxta_peer_peerview_e
         self->thisType = "_jxta_peer_peerview_entry";
 
         self->rdva = NULL;
+        self->pid_string = NULL;
+        self->binary_walk = FALSE;
     }
 
     return self;
@@ -242,6 +268,11 @@ static void peerview_entry_destruct(_jxta_peer_peerview_entry * self)
         self->rdva = NULL;
     }
 
+    if (NULL != self->pid_string) {
+        JXTA_OBJECT_RELEASE(self->pid_string);
+        self->pid_string = NULL;
+    }
+
     peer_entry_destruct((_jxta_peer_entry *) self);
 }
 
@@ -266,6 +297,10 @@ static _jxta_peerview_mutable *peerview_construct(_jxta_peerview_mutable * self)
 
     res = apr_thread_mutex_create(&self->periodicMutex, APR_THREAD_MUTEX_DEFAULT, self->pool);
 
+    if (APR_SUCCESS == res) {
+        res = apr_thread_mutex_create(&self->event_mutex, APR_THREAD_MUTEX_DEFAULT, self->pool);
+    }
+
     if (APR_SUCCESS == res) {
         self->running = FALSE;
         self->listener_busy_cnt = 1;
@@ -288,8 +323,12 @@ static _jxta_peerview_mutable *peerview_construct(_jxta_peerview_mutable * self)
         self->ip = NULL;
         self->listener_peerview = NULL;
 
-        self->localView = jxta_hashtable_new_0(20, TRUE);
-        self->localViewOrder = jxta_vector_new(20);
+        self->localView = jxta_objecthashtable_new(20, (Jxta_object_hash_func) jxta_id_hashcode,
+                                                   (Jxta_object_equals_func) jxta_id_equals);
+        self->localViewOrder = NULL;
+        self->localViewSize = 0;
+        self->localViewCapacity = 0;
+        self->localViewExpires = JPR_ABSOLUTE_TIME_MAX;
         self->downPVE = NULL;
         self->selfPVE = NULL;
         self->upPVE = NULL;
@@ -304,6 +343,8 @@ static _jxta_peerview_mutable *peerview_construct(_jxta_peerview_mutable * self)
         self->rdva_refresh = RDVA_REFRESH_INTERVAL;
 
         self->event_listener_table = jxta_hashtable_new(1);
+        self->event_queue = jxta_vector_new(4);
+        self->event_dispatching = FALSE;
     } else {
         self = NULL;
     }
@@ -319,6 +360,11 @@ static void peerview_destruct(_jxta_peerview_mutable * self)
         apr_sleep(100 * 1000L);
     }
 
+    /* wait for the event being dispatched, the ones still queued are dropped */
+    if (NULL != self->group) {
+        apr_thread_pool_tasks_cancel(jxta_PG_thread_pool_get(self->group), self);
+    }
+
     if (NULL != self->listener_peerview) {
         jxta_listener_stop(self->listener_peerview);
         JXTA_OBJECT_RELEASE(self->listener_peerview);
@@ -381,7 +427,10 @@ static void peerview_destruct(_jxta_peerview_mutable * self)
     }
 
     if (NULL != self->localViewOrder) {
-        JXTA_OBJECT_RELEASE(self->localViewOrder);
+        while (self->localViewSize > 0) {
+            JXTA_OBJECT_RELEASE(self->localViewOrder[--self->localViewSize]);
+        }
+        free(self->localViewOrder);
     }
 
     if (NULL != self->downPVE) {
@@ -413,9 +462,14 @@ static void peerview_destruct(_jxta_peerview_mutable * self)
         JXTA_OBJECT_RELEASE(self->event_listener_table);
     }
 
+    if (NULL != self->event_queue) {
+        JXTA_OBJECT_RELEASE(self->event_queue);
+    }
+
     /* Free the pool used to allocate the thread and mutex */
     apr_thread_cond_destroy(self->periodicCond);
     apr_thread_mutex_destroy(self->periodicMutex);
+    apr_thread_mutex_destroy(self->event_mutex);
     apr_thread_mutex_destroy(self->mutex);
 
     apr_pool_destroy(self->pool);
@@ -790,6 +844,11 @@ JXTA_DECLARE(Jxta_status) jxta_peerview_send_rdv_request(Jxta_peerview * pv, Jxt
         JXTA_OBJECT_RELEASE(el);
     }
 
+    el = jxta_message_element_new_2(JXTA_RDV_NS_NAME, JXTA_PEERVIEW_WALK_ELEMENT_NAME, "text/plain", PEERVIEW_WALK_BINARY,
+                                    strlen(PEERVIEW_WALK_BINARY), NULL);
+    jxta_message_add_element(msg, el);
+    JXTA_OBJECT_RELEASE(el);
+
     /*
      * Create the output wirepipe
      */
@@ -884,6 +943,11 @@ static Jxta_status jxta_peerview_send_pvm(_jxta_peerview_mutable * self, _jxta_p
                                         NULL);
         jxta_message_add_element(msg, el);
         JXTA_OBJECT_RELEASE(el);
+    } else {
+        el = jxta_message_element_new_2(JXTA_RDV_NS_NAME, JXTA_PEERVIEW_WALK_ELEMENT_NAME, "text/plain", PEERVIEW_WALK_BINARY,
+                                        strlen(PEERVIEW_WALK_BINARY), NULL);
+        jxta_message_add_element(msg, el);
+        JXTA_OBJECT_RELEASE(el);
     }
 
     if (failure) {
@@ -958,6 +1022,7 @@ static void JXTA_STDCALL peerview_listener(Jxta_object * obj, void *arg)
     Jxta_boolean edge = FALSE;
     Jxta_boolean cached = FALSE;
     Jxta_boolean failure = FALSE;
+    Jxta_boolean binary_walk = FALSE;
     Jxta_bytevector *bytes;
     JString *string;
     Jxta_RdvAdvertisement *rdva;
@@ -990,6 +1055,15 @@ static void JXTA_STDCALL peerview_listener(Jxta_object * obj, void *arg)
         JXTA_OBJECT_RELEASE(el);
     }
 
+    res = jxta_message_get_element_2(msg, JXTA_RDV_NS_NAME, JXTA_PEERVIEW_WALK_ELEMENT_NAME, &el);
+    if ((JXTA_SUCCESS == res) && (NULL != el)) {
+        bytes = jxta_message_element_get_value(el);
+        binary_walk = (jxta_bytevector_size(bytes) == strlen(PEERVIEW_WALK_BINARY)) &&
+            (0 == memcmp(jxta_bytevector_content_ptr(bytes), PEERVIEW_WALK_BINARY, strlen(PEERVIEW_WALK_BINARY)));
+        JXTA_OBJECT_RELEASE(bytes);
+        JXTA_OBJECT_RELEASE(el);
+    }
+
     res = jxta_message_get_element_2(msg, JXTA_RDV_NS_NAME, JXTA_PEERVIEW_RDVADV_ELEMENT_NAME, &el);
 
     if ((JXTA_SUCCESS != res) || (NULL == el)) {
@@ -1012,7 +1086,7 @@ static void JXTA_STDCALL peerview_listener(Jxta_object * obj, void *arg)
     res = jxta_RdvAdvertisement_parse_charbuffer(rdva, jstring_get_string(string), jstring_length(string));
     JXTA_OBJECT_RELEASE(string);
     if (JXTA_SUCCESS == res) {
-        res = process_peerview_message(self, rdva, edge, response, failure, cached);
+        res = process_peerview_message(self, rdva, edge, response, failure, cached, binary_walk);
     }
 
     JXTA_OBJECT_RELEASE(rdva);
@@ -1028,11 +1102,12 @@ JXTA_DECLARE(Jxta_status) jxta_peerview_probe_cached_rdvadv(Jxta_peerview * pv,
 {
     _jxta_peerview_mutable *self = PTValid(pv, _jxta_peerview_mutable);
 
-    return process_peerview_message(self, rdva, FALSE, FALSE, FALSE, TRUE);
+    return process_peerview_message(self, rdva, FALSE, FALSE, FALSE, TRUE, FALSE);
 }
 
 static Jxta_status process_peerview_message(_jxta_peerview_mutable * self, Jxta_RdvAdvertisement * rdva, Jxta_boolean edge,
-                                            Jxta_boolean response, Jxta_boolean failure, Jxta_boolean cached)
+                                            Jxta_boolean response, Jxta_boolean failure, Jxta_boolean cached,
+                                            Jxta_boolean binary_walk)
 {
     Jxta_status res = JXTA_SUCCESS;
     Jxta_RouteAdvertisement *route = jxta_RdvAdvertisement_get_Route(rdva);
@@ -1102,10 +1177,21 @@ static Jxta_status process_peerview_message(_jxta_peerview_mutable * self, Jxta_
     pve->rdva = JXTA_OBJECT_SHARE(rdva);
     pve->last_refresh = jpr_time_now();
 
+    /* a referral tells nothing about what the peer itself supports */
+    if (!cached) {
+        pve->binary_walk = binary_walk;
+    }
+
     /* Set the upward bound to time at which we will consider this PVE "alive" */
     jxta_peer_set_expires((Jxta_peer *) pve, pve->last_refresh + (jxta_peerview_get_pve_expires(self)));
     jxta_peer_unlock((Jxta_peer *) pve);
 
+    apr_thread_mutex_lock(self->mutex);
+    if (jxta_peer_get_expires((Jxta_peer *) pve) < self->localViewExpires) {
+        self->localViewExpires = jxta_peer_get_expires((Jxta_peer *) pve);
+    }
+    apr_thread_mutex_unlock(self->mutex);
+
     /*
      *   The (in)famous "Type 1" : We are being probed. Respond with our own PVE.
      */
@@ -1133,28 +1219,19 @@ static Jxta_status process_peerview_message(_jxta_peerview_mutable * self, Jxta_
         int i = 0;
         /* send our response */
         _jxta_peer_peerview_entry *aPVE = NULL;
-        i = jxta_vector_size(self->localViewOrder) * 2;
 
         apr_thread_mutex_lock(self->mutex);
+        i = self->localViewSize * 2;
         /* don't send it's own back to it and just try vector size * 2 */
         while (!found_good_referral && i--) {
-            Jxta_id *got_id;
-            if (jxta_vector_size(self->localViewOrder) > (unsigned int) (self->running ? 1 : 0)) {
-                unsigned int idx;
-                JString *jID = NULL;
-
-                idx = rand() % jxta_vector_size(self->localViewOrder);
-                jxta_vector_get_object_at(self->localViewOrder, JXTA_OBJECT_PPTR(&aPVE), idx);
-                jxta_peer_get_peerid((Jxta_peer *) aPVE, &got_id);
-                jxta_id_to_jstring(got_id, &jID);
-                JXTA_OBJECT_RELEASE(got_id);
-                if (0 != strcmp(jstring_get_string(pid), jstring_get_string(jID))) {
+            if (self->localViewSize > (unsigned int) (self->running ? 1 : 0)) {
+                aPVE = self->localViewOrder[rand() % self->localViewSize];
+                if (!jxta_id_equals(dest, jxta_peer_get_peerid_priv((Jxta_peer *) aPVE))) {
+                    JXTA_OBJECT_SHARE(aPVE);
                     found_good_referral = TRUE;
                 } else {
-                    JXTA_OBJECT_RELEASE(aPVE);
                     aPVE = NULL;
                 }
-                JXTA_OBJECT_RELEASE(jID);
             } else {
                 aPVE = JXTA_OBJECT_SHARE(self->selfPVE);
                 found_good_referral = TRUE;
@@ -1185,14 +1262,10 @@ static Jxta_status jxta_peerview_get_pve(_jxta_peerview_mutable * self, Jxta_PID
                                          Jxta_boolean addToLocalView)
 {
     Jxta_status res = JXTA_SUCCESS;
-    JString *pidString = NULL;
 
     apr_thread_mutex_lock(self->mutex);
 
-    jxta_id_to_jstring(pid, &pidString);
-
-    res = jxta_hashtable_get(self->localView, jstring_get_string(pidString), jstring_length(pidString) + 1, (Jxta_object **) pve);
-    JXTA_OBJECT_RELEASE(pidString);
+    res = jxta_objecthashtable_get(self->localView, (Jxta_object *) pid, (Jxta_object **) pve);
 
     if ((JXTA_SUCCESS != res) || (NULL == *pve)) {
         JString *uniq;
@@ -1208,6 +1281,7 @@ static Jxta_status jxta_peerview_get_pve(_jxta_peerview_mutable * self, Jxta_PID
         jxta_peer_set_peerid((Jxta_peer *) * pve, pid);
         jxta_peer_set_address((Jxta_peer *) * pve, ea);
         jxta_peer_set_expires((Jxta_peer *) * pve, JPR_ABSOLUTE_TIME_MAX);
+        jxta_id_to_jstring(pid, &(*pve)->pid_string);
         JXTA_OBJECT_RELEASE(ea);
 
         if (addToLocalView) {
@@ -1222,9 +1296,50 @@ static Jxta_status jxta_peerview_get_pve(_jxta_peerview_mutable * self, Jxta_PID
     return res;
 }
 
+/**
+ * Position of the PVE in the local view or, if it is not there, where it should be inserted. Must be called with mutex held.
+ **/
+static unsigned int local_view_search(_jxta_peerview_mutable * self, _jxta_peer_peerview_entry * pve, Jxta_boolean * found)
+{
+    unsigned int low = 0;
+    unsigned int high = self->localViewSize;
+    unsigned int mid;
+    int cmp;
+
+    *found = FALSE;
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        cmp = strcmp(jstring_get_string(self->localViewOrder[mid]->pid_string), jstring_get_string(pve->pid_string));
+        if (0 == cmp) {
+            *found = TRUE;
+            return mid;
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * Take the PVE at the given position out of the local view and out of the index, the reference of the view is returned. Must
+ * be called with mutex held.
+ **/
+static _jxta_peer_peerview_entry *local_view_remove_at(_jxta_peerview_mutable * self, unsigned int idx)
+{
+    _jxta_peer_peerview_entry *pve = self->localViewOrder[idx];
+
+    self->localViewSize--;
+    memmove(&self->localViewOrder[idx], &self->localViewOrder[idx + 1], (self->localViewSize - idx) * sizeof(*self->localViewOrder));
+    jxta_objecthashtable_del(self->localView, (Jxta_object *) jxta_peer_get_peerid_priv((Jxta_peer *) pve), NULL);
+
+    return pve;
+}
+
 static void addjust_up_down_peers(_jxta_peerview_mutable * self)
 {
-    _jxta_peer_peerview_entry *comparePVE;
     unsigned int i;
     unsigned int MyPos = INT_MAX ;
 
@@ -1238,15 +1353,13 @@ static void addjust_up_down_peers(_jxta_peerview_mutable * self)
         self->upPVE = NULL;
     }
 
-    for (i = 0; i < jxta_vector_size(self->localViewOrder); i++) {         
-        jxta_vector_get_object_at(self->localViewOrder, JXTA_OBJECT_PPTR(&comparePVE), i);        
-        if (self->selfPVE == comparePVE) {
-            MyPos = i ;
-        }
-        JXTA_OBJECT_RELEASE(comparePVE);
+    if (NULL != self->selfPVE && NULL != self->selfPVE->pid_string) {
+        Jxta_boolean found;
 
-        if(MyPos != INT_MAX)
-            break;
+        i = local_view_search(self, self->selfPVE, &found);
+        if (found && self->localViewOrder[i] == self->selfPVE) {
+            MyPos = i;
+        }
     }
 
     if( MyPos == INT_MAX){
@@ -1255,21 +1368,21 @@ static void addjust_up_down_peers(_jxta_peerview_mutable * self)
 
     // downPVE
     if( MyPos == 0)
-        i =  jxta_vector_size(self->localViewOrder) - 1 ;
+        i =  self->localViewSize - 1 ;
     else
         i= MyPos -1 ;
 
     if( i != MyPos)
-        jxta_vector_get_object_at(self->localViewOrder, JXTA_OBJECT_PPTR(&self->downPVE), i);
+        self->downPVE = JXTA_OBJECT_SHARE(self->localViewOrder[i]);
 
     // upPVE
-    if( MyPos < (jxta_vector_size(self->localViewOrder) - 1 )  )
+    if( MyPos < (self->localViewSize - 1 )  )
         i= MyPos + 1 ;        
     else
         i =  0 ;
 
     if( i != MyPos)
-        jxta_vector_get_object_at(self->localViewOrder, JXTA_OBJECT_PPTR(&self->upPVE), i);
+        self->upPVE = JXTA_OBJECT_SHARE(self->localViewOrder[i]);
 }
 
 static void remove_expired_PVEs(_jxta_peerview_mutable * self)
@@ -1278,29 +1391,33 @@ static void remove_expired_PVEs(_jxta_peerview_mutable * self)
     _jxta_peer_peerview_entry *checkPVE;
     Jxta_time expiresAt;
     Jxta_time currentTime;
-    Jxta_status res;
+    Jxta_time nextExpires = JPR_ABSOLUTE_TIME_MAX;
     Jxta_boolean removed = JXTA_FALSE;
 
     currentTime = (Jxta_time) jpr_time_now();
 
-    while(i < jxta_vector_size(self->localViewOrder) ){
-        res = jxta_vector_get_object_at(self->localViewOrder, JXTA_OBJECT_PPTR(&checkPVE), i);
+    /* nothing to do until the first PVE expires */
+    if (self->localViewExpires >= currentTime) {
+        return;
+    }
 
-        if ((JXTA_SUCCESS != res) || (NULL == checkPVE)) {
-            i++;
-            continue;
-        }
+    while(i < self->localViewSize ){
+        checkPVE = self->localViewOrder[i];
 
         expiresAt = jxta_peer_get_expires((Jxta_peer *) checkPVE);
         if (expiresAt < currentTime) {
-            res = jxta_vector_remove_object_at(self->localViewOrder, NULL, i);
+            local_view_remove_at(self, i);
+            jxta_peerview_call_event_listeners(self, JXTA_PEERVIEW_REMOVE, jxta_peer_get_peerid_priv((Jxta_peer *) checkPVE));
+            JXTA_OBJECT_RELEASE(checkPVE);
             removed = JXTA_TRUE;
         }else{
+            if (expiresAt < nextExpires) {
+                nextExpires = expiresAt;
+            }
             i++;
         }
-
-        JXTA_OBJECT_RELEASE(checkPVE);
     }
+    self->localViewExpires = nextExpires;
 
     if(removed){
         addjust_up_down_peers(self);
@@ -1310,42 +1427,42 @@ static void remove_expired_PVEs(_jxta_peerview_mutable * self)
 static Jxta_status jxta_peerview_add_pve(_jxta_peerview_mutable * self, _jxta_peer_peerview_entry * pve)
 {
     Jxta_status res = JXTA_SUCCESS;
-    JString *pidString = NULL;
+    _jxta_peer_peerview_entry *found_pve = NULL;
 
     apr_thread_mutex_lock(self->mutex);
 
-    jxta_id_to_jstring(jxta_peer_get_peerid_priv((Jxta_peer *) pve), &pidString);
-
-    res =
-        jxta_hashtable_get(self->localView, jstring_get_string(pidString), jstring_length(pidString) + 1, JXTA_OBJECT_PPTR(&pve));
+    res = jxta_objecthashtable_get(self->localView, (Jxta_object *) jxta_peer_get_peerid_priv((Jxta_peer *) pve),
+                                   JXTA_OBJECT_PPTR(&found_pve));
 
-    if ((JXTA_SUCCESS != res) || (NULL == pve)) {
-        unsigned int eachPVE;
-        Jxta_boolean added = FALSE;
+    if ((JXTA_SUCCESS != res) || (NULL == found_pve)) {
+        unsigned int idx;
+        Jxta_boolean found;
 
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Adding new PVE [%pp] for %s\n", pve, jstring_get_string(pidString));
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Adding new PVE [%pp] for %s\n", pve, jstring_get_string(pve->pid_string));
 
-        for (eachPVE = jxta_vector_size(self->localViewOrder); !added && eachPVE > 0; eachPVE--) {
-            _jxta_peer_peerview_entry *comparePVE;
-            JString *comparePVEpidString = NULL;
+        if (self->localViewSize == self->localViewCapacity) {
+            unsigned int capacity = self->localViewCapacity ? self->localViewCapacity * 2 : 20;
+            _jxta_peer_peerview_entry **order = realloc(self->localViewOrder, capacity * sizeof(*order));
 
-            jxta_vector_get_object_at(self->localViewOrder, JXTA_OBJECT_PPTR(&comparePVE), eachPVE - 1);
-
-            jxta_id_to_jstring(jxta_peer_get_peerid_priv((Jxta_peer *) comparePVE), &comparePVEpidString);
-
-            if (strcmp(jstring_get_string(pidString), jstring_get_string(comparePVEpidString)) > 0) {
-                jxta_vector_add_object_at(self->localViewOrder, (Jxta_object *) pve, eachPVE);
-                added = TRUE;
+            if (NULL == order) {
+                jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+                apr_thread_mutex_unlock(self->mutex);
+                return JXTA_NOMEM;
             }
-            JXTA_OBJECT_RELEASE(comparePVEpidString);
-            JXTA_OBJECT_RELEASE(comparePVE);
+            self->localViewOrder = order;
+            self->localViewCapacity = capacity;
         }
 
-        if (!added) {
-            jxta_vector_add_object_at(self->localViewOrder, (Jxta_object *) pve, 0);
-        }
+        idx = local_view_search(self, pve, &found);
+        memmove(&self->localViewOrder[idx + 1], &self->localViewOrder[idx], (self->localViewSize - idx) * sizeof(*self->localViewOrder));
+        self->localViewOrder[idx] = JXTA_OBJECT_SHARE(pve);
+        self->localViewSize++;
 
-        jxta_hashtable_put(self->localView, jstring_get_string(pidString), jstring_length(pidString) + 1, (Jxta_object *) pve);
+        jxta_objecthashtable_put(self->localView, (Jxta_object *) jxta_peer_get_peerid_priv((Jxta_peer *) pve), (Jxta_object *) pve);
+
+        if (jxta_peer_get_expires((Jxta_peer *) pve) < self->localViewExpires) {
+            self->localViewExpires = jxta_peer_get_expires((Jxta_peer *) pve);
+        }
 
         addjust_up_down_peers(self);
 
@@ -1355,13 +1472,12 @@ static Jxta_status jxta_peerview_add_pve(_jxta_peerview_mutable * self, _jxta_pe
         jxta_peerview_call_event_listeners(self, JXTA_PEERVIEW_ADD, jxta_peer_get_peerid_priv((Jxta_peer *) pve));
         res = JXTA_SUCCESS;
     } else {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "PVE [%pp] already recorded for %s\n", pve,
-                        jstring_get_string(pidString));
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "PVE [%pp] already recorded for %s\n", found_pve,
+                        jstring_get_string(found_pve->pid_string));
+        JXTA_OBJECT_RELEASE(found_pve);
         res = JXTA_FAILED;
     }
 
-    JXTA_OBJECT_RELEASE(pidString);
-
     apr_thread_mutex_unlock(self->mutex);
 
     return res;
@@ -1370,34 +1486,25 @@ static Jxta_status jxta_peerview_add_pve(_jxta_peerview_mutable * self, _jxta_pe
 static Jxta_status jxta_peerview_remove_pve(_jxta_peerview_mutable * self, Jxta_PID * pid)
 {
     Jxta_status res = JXTA_SUCCESS;
-    unsigned int eachPVE;
-    Jxta_boolean removed = FALSE;
+    _jxta_peer_peerview_entry *pve = NULL;
 
     apr_thread_mutex_lock(self->mutex);
 
-    for (eachPVE = 0; !removed && (eachPVE < jxta_vector_size(self->localViewOrder)); eachPVE++) {
-        _jxta_peer_peerview_entry *comparePVE;
+    res = jxta_objecthashtable_get(self->localView, (Jxta_object *) pid, JXTA_OBJECT_PPTR(&pve));
 
-        res = jxta_vector_get_object_at(self->localViewOrder, JXTA_OBJECT_PPTR(&comparePVE), eachPVE);
+    if (JXTA_SUCCESS == res && NULL != pve) {
+        unsigned int idx;
+        Jxta_boolean found;
 
-        if (jxta_id_equals(pid, jxta_peer_get_peerid_priv((Jxta_peer *) comparePVE))) {
-            res = jxta_vector_remove_object_at(self->localViewOrder, NULL, eachPVE);
-            removed = TRUE;
+        idx = local_view_search(self, pve, &found);
+        if (found) {
+            JXTA_OBJECT_RELEASE(local_view_remove_at(self, idx));
+        } else {
+            jxta_objecthashtable_del(self->localView, (Jxta_object *) pid, NULL);
         }
 
-        JXTA_OBJECT_RELEASE(comparePVE);
-    }
-
-    if (removed) {
-        JString *pidString = NULL;
-
-        jxta_id_to_jstring(pid, &pidString);
-
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Removed PVE for %s\n", jstring_get_string(pidString));
-
-        res = jxta_hashtable_del(self->localView, jstring_get_string(pidString), jstring_length(pidString) + 1, NULL);
-
-        JXTA_OBJECT_RELEASE(pidString);
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Removed PVE for %s\n", jstring_get_string(pve->pid_string));
+        JXTA_OBJECT_RELEASE(pve);
 
         addjust_up_down_peers(self);
 
@@ -1415,15 +1522,21 @@ static Jxta_status jxta_peerview_remove_pve(_jxta_peerview_mutable * self, Jxta_
 JXTA_DECLARE(Jxta_status) jxta_peerview_get_localview(Jxta_peerview * pv, Jxta_vector ** view)
 {
     _jxta_peerview_mutable *self = PTValid(pv, _jxta_peerview_mutable);
+    unsigned int i;
 
     apr_thread_mutex_lock(self->mutex);
 
     remove_expired_PVEs(self);
-    jxta_vector_clone(self->localViewOrder, view, 0, INT_MAX);
+    *view = jxta_vector_new(self->localViewSize);
+    if (NULL != *view) {
+        for (i = 0; i < self->localViewSize; i++) {
+            jxta_vector_add_object_last(*view, (Jxta_object *) self->localViewOrder[i]);
+        }
+    }
 
     apr_thread_mutex_unlock(self->mutex);
 
-    return JXTA_SUCCESS;
+    return NULL != *view ? JXTA_SUCCESS : JXTA_NOMEM;
 }
 
 JXTA_DECLARE(Jxta_status) jxta_peerview_get_up_peer(Jxta_peerview * pv, Jxta_peer ** peer)
@@ -1439,6 +1552,20 @@ JXTA_DECLARE(Jxta_status) jxta_peerview_get_up_peer(Jxta_peerview * pv, Jxta_pee
     return JXTA_SUCCESS;
 }
 
+JXTA_DECLARE(Jxta_boolean) jxta_peerview_peer_binary_walk(Jxta_peerview * pv, Jxta_peer * peer)
+{
+    _jxta_peer_peerview_entry *pve = PTValid(peer, _jxta_peer_peerview_entry);
+    Jxta_boolean result;
+
+    PTValid(pv, _jxta_peerview_mutable);
+
+    jxta_peer_lock(peer);
+    result = pve->binary_walk;
+    jxta_peer_unlock(peer);
+
+    return result;
+}
+
 JXTA_DECLARE(JString *) jxta_peerview_get_name(Jxta_peerview * pv)
 {
     _jxta_peerview_mutable *self = PTValid(pv, _jxta_peerview_mutable);
@@ -1479,7 +1606,7 @@ JXTA_DECLARE(unsigned int) jxta_peerview_get_localview_size(Jxta_peerview * pv)
 
     apr_thread_mutex_lock(self->mutex);
 
-    size = jxta_vector_size(self->localViewOrder);
+    size = self->localViewSize;
 
     apr_thread_mutex_unlock(self->mutex);
 
@@ -1620,7 +1747,7 @@ static void *APR_THREAD_FUNC periodic_thread_main(apr_thread_t * thread, void *a
             res =
                 jxta_peerview_send_pvm(self, self->selfPVE, jxta_peer_get_address_priv((Jxta_peer *) current_down),
                                        /* FALSE to ask for referral */
-                                       (jxta_vector_size(self->localViewOrder) >= self->happy_size) || (0 != (rand() %3)), 
+                                       (self->localViewSize >= self->happy_size) || (0 != (rand() %3)), 
                                        FALSE);
 
             if (JXTA_SUCCESS != res) {
@@ -1634,7 +1761,7 @@ static void *APR_THREAD_FUNC periodic_thread_main(apr_thread_t * thread, void *a
             res =
                 jxta_peerview_send_pvm(self, self->selfPVE, jxta_peer_get_address_priv((Jxta_peer *) current_up),
                                        /* FALSE to ask for referral */
-                                       (jxta_vector_size(self->localViewOrder) >= self->happy_size) || (0 != (rand() %3)), 
+                                       (self->localViewSize >= self->happy_size) || (0 != (rand() %3)), 
                                        FALSE);
 
             if (JXTA_SUCCESS != res) {
@@ -1650,7 +1777,7 @@ static void *APR_THREAD_FUNC periodic_thread_main(apr_thread_t * thread, void *a
         /* FIXME 20050417 bondolo Multicast announce ourself */
 
         /* get some seeds if necessary */
-        if ((jxta_vector_size(self->localViewOrder) < self->happy_size)) {
+        if ((self->localViewSize < self->happy_size)) {
             unsigned int probed = 0;
 
             if ((NULL == probe_seeds) || (0 == jxta_vector_size(probe_seeds))) {
@@ -1829,11 +1956,13 @@ static Jxta_peerview_event *jxta_peerview_event_new(Jxta_Peerview_event_type eve
     return pv_event;
 }
 
+/**
+ * Queue an event for the listeners. The events are dispatched in order by a pool task so that the listeners are never called
+ * with the peerview locked and a slow listener does not hold up the peerview.
+ **/
 static void jxta_peerview_call_event_listeners(Jxta_peerview * self, Jxta_Peerview_event_type event, Jxta_id * id)
 {
     Jxta_peerview_event *pv_event = jxta_peerview_event_new(event, id);
-    Jxta_status res = JXTA_SUCCESS;
-    Jxta_vector *lis = NULL;
 
     if (NULL == pv_event) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Could not create peerview event object.\n");
@@ -1842,27 +1971,60 @@ static void jxta_peerview_call_event_listeners(Jxta_peerview * self, Jxta_Peervi
 
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Rendezvous Event [%d] for [%pp]\n", event, id);
 
-    apr_thread_mutex_lock(self->mutex);
-    lis = jxta_hashtable_values_get(self->event_listener_table);
-    apr_thread_mutex_unlock(self->mutex);
+    apr_thread_mutex_lock(self->event_mutex);
+    jxta_vector_add_object_last(self->event_queue, (Jxta_object *) pv_event);
+    if (!self->event_dispatching) {
+        if (APR_SUCCESS == apr_thread_pool_push(jxta_PG_thread_pool_get(self->group), peerview_event_dispatch, self,
+                                                APR_THREAD_TASK_PRIORITY_NORMAL, self)) {
+            self->event_dispatching = TRUE;
+        } else {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Failed to start peerview event task\n");
+        }
+    }
+    apr_thread_mutex_unlock(self->event_mutex);
 
-    if (lis != NULL) {
-        unsigned int i = 0;
+    JXTA_OBJECT_RELEASE(pv_event);
+}
 
-        for (i = 0; i < jxta_vector_size(lis); i++) {
-            Jxta_listener *listener = NULL;
-            res = jxta_vector_get_object_at(lis, JXTA_OBJECT_PPTR(&listener), i);
-            if (res == JXTA_SUCCESS) {
-                jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, FILEANDLINE "Calling Peerview listener [%pp]\n", listener);
-                jxta_listener_process_object(listener, (Jxta_object *) pv_event);
-                JXTA_OBJECT_RELEASE(listener);
+static void *APR_THREAD_FUNC peerview_event_dispatch(apr_thread_t * thread, void *arg)
+{
+    _jxta_peerview_mutable *self = PTValid(arg, _jxta_peerview_mutable);
+    Jxta_peerview_event *pv_event;
+    Jxta_status res = JXTA_SUCCESS;
+    Jxta_vector *lis = NULL;
+
+    while (TRUE) {
+        apr_thread_mutex_lock(self->event_mutex);
+        if (0 == jxta_vector_size(self->event_queue)) {
+            self->event_dispatching = FALSE;
+            apr_thread_mutex_unlock(self->event_mutex);
+            break;
+        }
+        jxta_vector_remove_object_at(self->event_queue, JXTA_OBJECT_PPTR(&pv_event), 0);
+        apr_thread_mutex_unlock(self->event_mutex);
+
+        lis = jxta_hashtable_values_get(self->event_listener_table);
+
+        if (lis != NULL) {
+            unsigned int i = 0;
+
+            for (i = 0; i < jxta_vector_size(lis); i++) {
+                Jxta_listener *listener = NULL;
+                res = jxta_vector_get_object_at(lis, JXTA_OBJECT_PPTR(&listener), i);
+                if (res == JXTA_SUCCESS) {
+                    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, FILEANDLINE "Calling Peerview listener [%pp]\n", listener);
+                    jxta_listener_process_object(listener, (Jxta_object *) pv_event);
+                    JXTA_OBJECT_RELEASE(listener);
+                }
             }
+
+            JXTA_OBJECT_RELEASE(lis);
         }
 
-        JXTA_OBJECT_RELEASE(lis);
+        JXTA_OBJECT_RELEASE(pv_event);
     }
 
-    JXTA_OBJECT_RELEASE(pv_event);
+    return NULL;
 }
 
 /* vim: set ts=4 sw=4 et tw=130: */
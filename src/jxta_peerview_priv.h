@@ -80,6 +80,7 @@ extern const char JXTA_PEERVIEW_RDVRESP_ELEMENT_NAME[];
 extern const char JXTA_PEERVIEW_FAILURE_ELEMENT_NAME[];
 extern const char JXTA_PEERVIEW_CACHED_ELEMENT_NAME[];
 extern const char JXTA_PEERVIEW_EDGE_ELEMENT_NAME[];
+extern const char JXTA_PEERVIEW_WALK_ELEMENT_NAME[];
 extern const char JXTA_PEERVIEW_RESPONSE_ELEMENT_NAME[];
 
 JXTA_DECLARE(Jxta_peerview *) jxta_peerview_new(void);
@@ -108,6 +109,15 @@ JXTA_DECLARE(Jxta_status) jxta_peerview_get_down_peer(Jxta_peerview * pv, Jxta_p
 JXTA_DECLARE(Jxta_status) jxta_peerview_get_self_peer(Jxta_peerview * pv, Jxta_peer ** peer);
 JXTA_DECLARE(Jxta_status) jxta_peerview_get_up_peer(Jxta_peerview * pv, Jxta_peer ** peer);
 
+/**
+*   Tells whether a peer of the peerview announced it accepts the binary walk header.
+*
+*   @param pv    The peerview.
+*   @param peer  A peer returned by the peerview.
+*   @return TRUE if the binary walk header can be sent to the peer.
+**/
+JXTA_DECLARE(Jxta_boolean) jxta_peerview_peer_binary_walk(Jxta_peerview * pv, Jxta_peer * peer);
+
 JXTA_DECLARE(JString *) jxta_peerview_get_name(Jxta_peerview * pv);
 
 JXTA_DECLARE(Jxta_vector *) jxta_peerview_get_seeds(Jxta_peerview * self);
@@ -91,6 +91,7 @@ struct _jxta_RdvConfigAdvertisement {
     Jxta_time_diff connect_cycle_normal;
     Jxta_time_diff connect_cycle_fast;
     Jxta_time_diff lease_renewal_delay;
+    Jxta_time_diff lease_renewal_window;
     Jxta_time_diff interval_peerview;
     Jxta_time_diff pve_expires_peerview;
     Jxta_time_diff rdva_refresh;
@@ -316,6 +317,20 @@ JXTA_DECLARE(void) jxta_RdvConfig_set_lease_renewal_delay(Jxta_RdvConfigAdvertis
     ad->lease_renewal_delay = time;
 }
 
+JXTA_DECLARE(Jxta_time_diff) jxta_RdvConfig_get_lease_renewal_window(Jxta_RdvConfigAdvertisement * ad)
+{
+    JXTA_OBJECT_CHECK_VALID(ad);
+
+    return ad->lease_renewal_window;
+}
+
+JXTA_DECLARE(void) jxta_RdvConfig_set_lease_renewal_window(Jxta_RdvConfigAdvertisement * ad, Jxta_time_diff window)
+{
+    JXTA_OBJECT_CHECK_VALID(ad);
+
+    ad->lease_renewal_window = window;
+}
+
 JXTA_DECLARE(Jxta_time_diff) jxta_RdvConfig_get_lease_margin(Jxta_RdvConfigAdvertisement * ad)
 {
     JXTA_OBJECT_CHECK_VALID(ad);
@@ -447,6 +462,8 @@ void handleJxta_RdvConfigAdvertisement(void *userdata, const XML_Char * cd, int
             ad->lease_duration = atol(atts[1]);
         } else if (0 == strcmp(*atts, "leaseRenewalDelay")) {
             ad->lease_renewal_delay = atol(atts[1]);
+        } else if (0 == strcmp(*atts, "leaseRenewalWindow")) {
+            ad->lease_renewal_window = atol(atts[1]);
         } else if (0 == strcmp(*atts, "leaseMargin")) {
             ad->lease_margin = atol(atts[1]);
         }else if (0 == strcmp(*atts, "minConnectedRendezvous")) {
@@ -654,6 +671,14 @@ JXTA_DECLARE(Jxta_status) jxta_RdvConfigAdvertisement_get_xml(Jxta_RdvConfigAdve
         jstring_append_2(string, "\"");
     }
 
+    if (-1 != ad->lease_renewal_window) {
+        jstring_append_2(string, "\n    ");
+        jstring_append_2(string, "leaseRenewalWindow=\"");
+        apr_snprintf(tmpbuf, sizeof(tmpbuf), "%"APR_INT64_T_FMT, ad->lease_renewal_window);
+        jstring_append_2(string, tmpbuf);
+        jstring_append_2(string, "\"");
+    }
+
     if (-1 != ad->lease_margin) {
         jstring_append_2(string, "\n    ");
         jstring_append_2(string, " leaseMargin=\"");
@@ -789,6 +814,7 @@ Jxta_RdvConfigAdvertisement *jxta_RdvConfigAdvertisement_construct(Jxta_RdvConfi
         self->max_probed = -1;
         self->lease_duration = -1;
         self->lease_renewal_delay = -1;
+        self->lease_renewal_window = -1;
         self->min_retry_delay = -1;
         self->max_retry_delay = -1;
         self->lease_margin = -1;
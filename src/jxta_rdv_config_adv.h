@@ -130,6 +130,13 @@ JXTA_DECLARE(void) jxta_RdvConfig_set_lease_duration(Jxta_RdvConfigAdvertisement
 JXTA_DECLARE(Jxta_time_diff) jxta_RdvConfig_get_lease_renewal_delay(Jxta_RdvConfigAdvertisement *);
 JXTA_DECLARE(void) jxta_RdvConfig_set_lease_renewal_delay(Jxta_RdvConfigAdvertisement *, Jxta_time_diff);
 
+/**
+ * Lease renewals of the groups sharing a rendezvous which fall due within this window are coalesced in a single batched
+ * renewal request. 0 disables the batching.
+ **/
+JXTA_DECLARE(Jxta_time_diff) jxta_RdvConfig_get_lease_renewal_window(Jxta_RdvConfigAdvertisement *);
+JXTA_DECLARE(void) jxta_RdvConfig_set_lease_renewal_window(Jxta_RdvConfigAdvertisement *, Jxta_time_diff);
+
 JXTA_DECLARE(Jxta_time_diff) jxta_RdvConfig_get_lease_margin(Jxta_RdvConfigAdvertisement *);
 JXTA_DECLARE(void) jxta_RdvConfig_set_lease_margin(Jxta_RdvConfigAdvertisement *, Jxta_time_diff);
 
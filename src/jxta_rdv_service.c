@@ -94,6 +94,8 @@ const char JXTA_RDV_CONNECTED_REPLY_ELEMENT_NAME[] = "ConnectedPeer";
 const char JXTA_RDV_LEASE_REPLY_ELEMENT_NAME[] = "ConnectedLease";
 const char JXTA_RDV_RDVADV_REPLY_ELEMENT_NAME[] = "RdvAdvReply";
 const char JXTA_RDV_ADV_ELEMENT_NAME[] = "RdvAdv";
+const char JXTA_RDV_BATCH_CONNECT_REQUEST_ELEMENT_NAME[] = "BatchConnect";
+const char JXTA_RDV_BATCH_LEASE_REPLY_ELEMENT_NAME[] = "BatchConnectedLease";
 
 Jxta_rdv_service *jxta_rdv_service_new_instance(void);
 static void rdv_service_delete(Jxta_object * service);
@@ -474,6 +476,10 @@ JXTA_DECLARE(Jxta_status) jxta_rdv_service_propagate(Jxta_rdv_service * rdv, Jxt
     if (NULL != self->provider) {
         res = PROVIDER_VTBL(self->provider)->propagate((Jxta_rdv_service_provider *) self->provider,
                                                        msg, serviceName, serviceParam, ttl);
+        if (JXTA_ITEM_EXISTS == res) {
+            /* already propagated by this peer */
+            res = JXTA_SUCCESS;
+        }
     } else {
         res = JXTA_BUSY;
     }
@@ -507,6 +513,10 @@ JXTA_DECLARE(Jxta_status) jxta_rdv_service_walk(Jxta_rdv_service * rdv, Jxta_mes
     apr_thread_mutex_lock(self->mutex);
     if (NULL != self->provider) {
         res = PROVIDER_VTBL(self->provider)->walk((Jxta_rdv_service_provider *) self->provider, msg, serviceName, serviceParam);
+        if (JXTA_ITEM_EXISTS == res) {
+            /* already walked by this peer */
+            res = JXTA_SUCCESS;
+        }
     } else {
         res = JXTA_BUSY;
     }
@@ -965,6 +975,22 @@ JXTA_DECLARE(Jxta_peerview *) jxta_rdv_service_get_peerview_priv(_jxta_rdv_servi
     return self->peerview;
 }
 
+JXTA_DECLARE(Jxta_status) jxta_rdv_service_get_propagate_stats(Jxta_rdv_service * rdv, Jxta_rdv_propagate_stats * stats)
+{
+    _jxta_rdv_service *self = PTValid(rdv, _jxta_rdv_service);
+    Jxta_status res;
+
+    apr_thread_mutex_lock(self->mutex);
+    if (NULL != self->provider) {
+        res = jxta_rdv_service_provider_get_propagate_stats((Jxta_rdv_service_provider *) self->provider, stats);
+    } else {
+        res = JXTA_BUSY;
+    }
+    apr_thread_mutex_unlock(self->mutex);
+
+    return res;
+}
+
 JXTA_DECLARE(Jxta_peerview *) jxta_rdv_service_get_peerview(Jxta_rdv_service * rdv)
 {
     _jxta_rdv_service *self = PTValid(rdv, _jxta_rdv_service);
@@ -979,6 +1005,33 @@ Jxta_endpoint_service *jxta_rdv_service_endpoint_svc(_jxta_rdv_service * self)
     return self->endpoint;
 }
 
+Jxta_rdv_service_provider *jxta_rdv_service_group_provider_priv(Jxta_PG * group, RdvConfig_configuration config,
+                                                                Jxta_boolean wait)
+{
+    _jxta_rdv_service *self = NULL;
+    Jxta_rdv_service_provider *provider = NULL;
+
+    jxta_PG_get_rendezvous_service(group, (Jxta_rdv_service **) &self);
+    if (NULL == self) {
+        return NULL;
+    }
+
+    /* a service being reconfigured holds its lock while it stops the old provider and joins its threads */
+    if (wait) {
+        apr_thread_mutex_lock(self->mutex);
+    } else if (APR_SUCCESS != apr_thread_mutex_trylock(self->mutex)) {
+        JXTA_OBJECT_RELEASE(self);
+        return NULL;
+    }
+    if (NULL != self->provider && self->config == config) {
+        provider = JXTA_OBJECT_SHARE((Jxta_rdv_service_provider *) self->provider);
+    }
+    apr_thread_mutex_unlock(self->mutex);
+    JXTA_OBJECT_RELEASE(self);
+
+    return provider;
+}
+
 /**
 * Create a new rendezvous event and send it to all of the registered listeners.
 **/
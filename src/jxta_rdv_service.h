@@ -355,6 +355,23 @@ JXTA_DECLARE(void) jxta_rdv_service_set_auto_interval(Jxta_rdv_service * rdv, Jx
 */
 JXTA_DECLARE(Jxta_peerview *) jxta_rdv_service_get_peerview(Jxta_rdv_service * rdv);
 
+typedef struct jxta_rdv_propagate_stats {
+    apr_size_t tracked;         /* message ids in the seen set */
+    apr_uint32_t received;      /* propagated messages received */
+    apr_uint32_t duplicates;    /* received again and not delivered */
+    apr_uint32_t repropagations;        /* propagations of a message already propagated by this peer, not sent */
+    apr_uint32_t evicted;       /* message ids forgotten before the end of the window to stay within the set size */
+} Jxta_rdv_propagate_stats;
+
+/**
+* Get the counters of the duplicate suppression of propagated messages.
+*
+* @param rdv a pointer to the instance of the Rendezvous Service
+* @param stats the structure to fill.
+* @return JXTA_SUCCESS or JXTA_BUSY if the service has no provider.
+**/
+JXTA_DECLARE(Jxta_status) jxta_rdv_service_get_propagate_stats(Jxta_rdv_service * rdv, Jxta_rdv_propagate_stats * stats);
+
 #ifdef __cplusplus
 #if 0
 {
@@ -129,10 +129,57 @@ static const Jxta_time_diff CONNECT_DELAY = ((Jxta_time_diff) 15) * 1000;
  * time in order to set the time of renewal.
  **/
 static const Jxta_time_diff LEASE_RENEWAL_DELAY = ((Jxta_time_diff) 5) * 60 * 1000; /* 5 Minutes */
+/**
+ *  Renewals of other groups with the same rendezvous due within this window are
+ *  batched with a renewal. Matches the normal connect cycle so that every group
+ *  due before its next pass joins the batch.
+ **/
+static const Jxta_time_diff LEASE_RENEWAL_WINDOW = ((Jxta_time_diff) 60) * 1000;  /* 1 Minute */
 /**
  *  Need to delay the RDV connection in case we have a relay
  **/
 static const apr_interval_time_t RDV_RELAY_DELAY_CONNECTION = ((apr_interval_time_t) 100) * 1000;   /* 100 ms */
+/**
+ *  Weight of a new sample in the smoothed lease response latency and failure
+ *  rate of a rendezvous.
+ **/
+static const double RDV_SCORE_ALPHA = 0.25;
+/**
+ *  Penalty in milliseconds added to the score of a rendezvous which fails
+ *  every lease request.
+ **/
+static const double RDV_SCORE_FAILURE_PENALTY = 10000.0;
+/**
+ *  Number of lease responses measured before a rendezvous is trusted enough
+ *  to take a lease over.
+ **/
+static const unsigned int RDV_SCORE_MIN_SAMPLES = 3;
+/**
+ *  A rendezvous takes a lease over only when its score is under this
+ *  fraction of the score of the current one...
+ **/
+static const double RDV_MIGRATE_RATIO = 0.5;
+/**
+ *  ...and better by at least this many milliseconds.
+ **/
+static const double RDV_MIGRATE_MIN_GAIN = 100.0;
+/**
+ *  Minimum time connected to a rendezvous before its lease can be migrated.
+ **/
+static const Jxta_time_diff RDV_MIGRATE_MIN_DWELL = ((Jxta_time_diff) 10) * 60 * 1000;  /* 10 Minutes */
+
+/**
+ * Responsiveness measured for a rendezvous. The score is the smoothed lease
+ * response latency in milliseconds plus the failure penalty weighted by the
+ * smoothed failure rate, lower is better.
+ **/
+typedef struct {
+    Jxta_time pending;          /* time the outstanding lease request was sent, 0 if none */
+    double latency;
+    double failure;
+    unsigned int samples;
+} Rdv_score;
+
 /**
  * Internal structure of a peer used by this service.
  **/ struct _jxta_peer_rdv_entry {
@@ -150,6 +197,17 @@ static const apr_interval_time_t RDV_RELAY_DELAY_CONNECTION = ((apr_interval_tim
     * acheived before this happens.
  **/
     Jxta_time_diff connectInterval;
+
+/**
+    * A batched lease request was sent and not answered yet. The next request
+    * is a plain one in case the rendezvous does not understand batches.
+ **/
+    Jxta_boolean batchPending;
+
+/**
+    * Time the lease was first granted.
+ **/
+    Jxta_time connectTime;
 };
 
 typedef struct _jxta_peer_rdv_entry _jxta_peer_rdv_entry;
@@ -189,6 +247,7 @@ struct _jxta_rdv_service_client {
 
     /* state */
     Jxta_hashtable *rdvs;       /* connected rdv servers */
+    apr_hash_t *scores;         /* Rdv_score of the rdv servers we requested a lease from, by peer id, protected by mutex */
 };
 
 /**
@@ -219,6 +278,9 @@ static void *APR_THREAD_FUNC periodic_thread_main(apr_thread_t * thread, void *s
 static Jxta_status JXTA_STDCALL client_cb(Jxta_object * msg, void *arg);
 
 static _jxta_peer_rdv_entry *get_peer_entry(_jxta_rdv_service_client * self, Jxta_id * peerid, Jxta_boolean create);
+static Jxta_status lease_accept(_jxta_rdv_service_client * self, Jxta_id * rdv_peerid, Jxta_PA * rdv_PA, Jxta_time_diff lease);
+static void process_batch_lease(_jxta_rdv_service_client * self, Jxta_message_element * el, Jxta_id * rdv_peerid,
+                                Jxta_PA * rdv_PA);
 
 static _jxta_peer_rdv_entry *rdv_entry_new(void);
 static _jxta_peer_rdv_entry *rdv_entry_construct(_jxta_peer_rdv_entry * self);
@@ -244,6 +306,8 @@ static _jxta_peer_rdv_entry *rdv_entry_construct(_jxta_peer_rdv_entry * self )
         self->thisType = "_jxta_peer_rdv_entry";
 
         self->lastConnectTry = 0;
+        self->batchPending = FALSE;
+        self->connectTime = 0;
     }
 
     return self;
@@ -330,6 +394,7 @@ static _jxta_rdv_service_client *jxta_rdv_service_client_construct(_jxta_rdv_ser
 
         /** Allocate a vector for storing the list of peers (rendezvous) **/
         self->rdvs = jxta_hashtable_new_0(MIN_NB_OF_CONNECTED_RDVS * 2, TRUE);
+        self->scores = apr_hash_make(self->pool);
 
         self->running = FALSE;
     }
@@ -481,6 +546,9 @@ static Jxta_status init(Jxta_rdv_service_provider * provider, _jxta_rdv_service
     if (-1 == jxta_RdvConfig_get_lease_renewal_delay(self->rdvConfig)) {
         jxta_RdvConfig_set_lease_renewal_delay(rdvConfig, LEASE_RENEWAL_DELAY);
     }
+    if (-1 == jxta_RdvConfig_get_lease_renewal_window(self->rdvConfig)) {
+        jxta_RdvConfig_set_lease_renewal_window(rdvConfig, LEASE_RENEWAL_WINDOW);
+    }
     if (-1 == jxta_RdvConfig_get_min_retry_delay(self->rdvConfig)) {
         jxta_RdvConfig_set_min_retry_delay(rdvConfig, MIN_RETRY_DELAY);
     }
@@ -677,24 +745,207 @@ static Jxta_status walk(Jxta_rdv_service_provider * provider, Jxta_message * msg
 }
 
 /**
-*   Send a connect request message to the specified peer.
- *
+*   Get the score of a rendezvous, must be called with mutex held.
+*
+*   @param create If TRUE then create the score if the rendezvous was never measured.
+ **/
+static Rdv_score *score_get(_jxta_rdv_service_client * self, Jxta_id * peerid, Jxta_boolean create)
+{
+    Rdv_score *score;
+    JString *uniq;
+
+    jxta_id_get_uniqueportion(peerid, &uniq);
+    score = apr_hash_get(self->scores, jstring_get_string(uniq), APR_HASH_KEY_STRING);
+    if (NULL == score && create) {
+        score = apr_pcalloc(self->pool, sizeof(*score));
+        apr_hash_set(self->scores, apr_pstrdup(self->pool, jstring_get_string(uniq)), APR_HASH_KEY_STRING, score);
+    }
+    JXTA_OBJECT_RELEASE(uniq);
+
+    return score;
+}
+
+static void score_sample(Rdv_score * score, double latency, double failure)
+{
+    if (0 == score->samples) {
+        score->latency = latency;
+        score->failure = failure;
+    } else {
+        score->latency += RDV_SCORE_ALPHA * (latency - score->latency);
+        score->failure += RDV_SCORE_ALPHA * (failure - score->failure);
+    }
+    score->samples++;
+}
+
+static double score_value(const Rdv_score * score)
+{
+    return score->latency + score->failure * RDV_SCORE_FAILURE_PENALTY;
+}
+
+/**
+*   Record a lease request sent to a rendezvous. A previous request left unanswered for longer than the maximum retry
+*   delay counts as a failure.
+ **/
+static void score_request(_jxta_rdv_service_client * self, Jxta_id * peerid)
+{
+    Jxta_time currentTime = jpr_time_now();
+    Rdv_score *score;
+
+    apr_thread_mutex_lock(self->mutex);
+    score = score_get(self, peerid, TRUE);
+    if (0 != score->pending && (Jxta_time_diff) (currentTime - score->pending) > jxta_RdvConfig_get_max_retry_delay(self->rdvConfig)) {
+        score_sample(score, (double) (currentTime - score->pending), 1.0);
+    }
+    score->pending = currentTime;
+    apr_thread_mutex_unlock(self->mutex);
+}
+
+/**
+*   Record the lease response of a rendezvous. A declined lease counts as a failure.
+ **/
+static void score_response(_jxta_rdv_service_client * self, Jxta_id * peerid, Jxta_boolean granted)
+{
+    Jxta_time currentTime = jpr_time_now();
+    Rdv_score *score;
+
+    apr_thread_mutex_lock(self->mutex);
+    score = score_get(self, peerid, FALSE);
+    if (NULL != score && 0 != score->pending) {
+        score_sample(score, (double) (currentTime - score->pending), granted ? 0.0 : 1.0);
+        score->pending = 0;
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Rendezvous score %.0f after %u samples\n", score_value(score),
+                        score->samples);
+    }
+    apr_thread_mutex_unlock(self->mutex);
+}
+
+/**
+*   Rank the rendezvous candidates. The candidates never measured come first so that every candidate gets measured, then
+*   the candidates by score.
+*
+*   @return The index of the best candidate.
+ **/
+static unsigned int candidate_best(_jxta_rdv_service_client * self, Jxta_vector * candidates)
+{
+    unsigned int i;
+    unsigned int best = 0;
+    double best_value = 0.0;
+    double value;
+    Jxta_peer *peer;
+    Rdv_score *score;
+
+    apr_thread_mutex_lock(self->mutex);
+    for (i = 0; i < jxta_vector_size(candidates); i++) {
+        if (JXTA_SUCCESS != jxta_vector_get_object_at(candidates, JXTA_OBJECT_PPTR(&peer), i)) {
+            continue;
+        }
+        score = score_get(self, jxta_peer_get_peerid_priv(peer), FALSE);
+        JXTA_OBJECT_RELEASE(peer);
+        value = (NULL == score || 0 == score->samples) ? 0.0 : score_value(score);
+        if (0 == i || value < best_value) {
+            best = i;
+            best_value = value;
+        }
+    }
+    apr_thread_mutex_unlock(self->mutex);
+
+    return best;
+}
+
+/**
+*   Take a lease offered by a rendezvous we have no room for over from the connected rendezvous with the worst score, when
+*   the offering rendezvous is significantly better. To prevent flapping, the offering rendezvous needs RDV_SCORE_MIN_SAMPLES
+*   measures, must score under RDV_MIGRATE_RATIO of the current one and better by RDV_MIGRATE_MIN_GAIN, and the current
+*   rendezvous must have been connected for RDV_MIGRATE_MIN_DWELL.
+*
+*   @return The new entry for the offering rendezvous or NULL if the lease is not worth a migration.
+ **/
+static _jxta_peer_rdv_entry *lease_migrate(_jxta_rdv_service_client * self, Jxta_id * rdv_peerid)
+{
+    Jxta_time currentTime = jpr_time_now();
+    Jxta_vector *rdvs;
+    _jxta_peer_rdv_entry *worst = NULL;
+    double worst_value = 0.0;
+    double offer_value;
+    double value;
+    Jxta_time connectTime;
+    Rdv_score *score;
+    JString *uniq;
+    unsigned int i;
+
+    apr_thread_mutex_lock(self->mutex);
+
+    score = score_get(self, rdv_peerid, FALSE);
+    if (NULL == score || score->samples < RDV_SCORE_MIN_SAMPLES) {
+        apr_thread_mutex_unlock(self->mutex);
+        return NULL;
+    }
+    offer_value = score_value(score);
+
+    rdvs = jxta_hashtable_values_get(self->rdvs);
+    for (i = 0; i < jxta_vector_size(rdvs); i++) {
+        _jxta_peer_rdv_entry *peer;
+
+        if (JXTA_SUCCESS != jxta_vector_get_object_at(rdvs, JXTA_OBJECT_PPTR(&peer), i)) {
+            continue;
+        }
+        jxta_peer_lock((Jxta_peer *) peer);
+        connectTime = peer->connectTime;
+        jxta_peer_unlock((Jxta_peer *) peer);
+
+        score = score_get(self, jxta_peer_get_peerid_priv((Jxta_peer *) peer), FALSE);
+        if ((Jxta_time_diff) (currentTime - connectTime) >= RDV_MIGRATE_MIN_DWELL && NULL != score && score->samples > 0) {
+            value = score_value(score);
+            if (NULL == worst || value > worst_value) {
+                if (NULL != worst) {
+                    JXTA_OBJECT_RELEASE(worst);
+                }
+                worst = JXTA_OBJECT_SHARE(peer);
+                worst_value = value;
+            }
+        }
+        JXTA_OBJECT_RELEASE(peer);
+    }
+    JXTA_OBJECT_RELEASE(rdvs);
+
+    apr_thread_mutex_unlock(self->mutex);
+
+    if (NULL == worst) {
+        return NULL;
+    }
+
+    if (offer_value >= worst_value * RDV_MIGRATE_RATIO || worst_value - offer_value < RDV_MIGRATE_MIN_GAIN) {
+        JXTA_OBJECT_RELEASE(worst);
+        return NULL;
+    }
+
+    jxta_id_get_uniqueportion(jxta_peer_get_peerid_priv((Jxta_peer *) worst), &uniq);
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Migrating rendezvous lease from %s (score %.0f) in %s, offer scores %.0f\n",
+                    jstring_get_string(uniq), worst_value, self->groupiduniq, offer_value);
+
+    jxta_rdv_service_provider_lock_priv((Jxta_rdv_service_provider *) self);
+    jxta_hashtable_del(self->rdvs, jstring_get_string(uniq), jstring_length(uniq) + 1, NULL);
+    jxta_rdv_service_provider_unlock_priv((Jxta_rdv_service_provider *) self);
+    JXTA_OBJECT_RELEASE(uniq);
+
+    jxta_rdv_generate_event((_jxta_rdv_service *)
+                            jxta_rdv_service_provider_get_service_priv((_jxta_rdv_service_provider *) self),
+                            JXTA_RDV_DISCONNECTED, jxta_peer_get_peerid_priv((Jxta_peer *) worst));
+    JXTA_OBJECT_RELEASE(worst);
+
+    return get_peer_entry(self, rdv_peerid, TRUE);
+}
+
+/**
+*   Record a connection attempt to the peer unless the previous one is too recent.
+*
 *   @param self Our "this" pointer.
-*   @param peer The peer to which we will attemt to connect.
+*   @param peer The peer to which we will attempt to connect.
+*   @return TRUE if it is time for another attempt otherwise FALSE.
  **/
-static void connect_to_peer(_jxta_rdv_service_client * self, _jxta_peer_rdv_entry * peer)
+static Jxta_boolean connect_claim(_jxta_rdv_service_client * self, _jxta_peer_rdv_entry * peer)
 {
     Jxta_time currentTime = (Jxta_time) jpr_time_now();
-    Jxta_message *msg;
-    Jxta_message_element *msgElem;
-    Jxta_endpoint_address *destAddr;
-    JString *localPeerAdvStr = NULL;
-    Jxta_status res = JXTA_SUCCESS;
-    Jxta_endpoint_address *address;
-
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Requesting Rdv lease from %s://%s\n",
-                    jxta_endpoint_address_get_protocol_name(((_jxta_peer_entry *) peer)->address),
-                    jxta_endpoint_address_get_protocol_address(((_jxta_peer_entry *) peer)->address));
 
     jxta_peer_lock((Jxta_peer *) peer);
 
@@ -702,7 +953,7 @@ static void connect_to_peer(_jxta_rdv_service_client * self, _jxta_peer_rdv_entr
         /* Not time yet to try to connect */
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Too soon for another connect.\n");
         jxta_peer_unlock((Jxta_peer *) peer);
-        return;
+        return FALSE;
     }
 
     peer->lastConnectTry = currentTime;
@@ -712,23 +963,40 @@ static void connect_to_peer(_jxta_rdv_service_client * self, _jxta_peer_rdv_entr
     }
     jxta_peer_unlock((Jxta_peer *) peer);
 
-    /*
-     * Create a message with a connection request and build the request.
-     */
-    msg = jxta_message_new();
+    return TRUE;
+}
+
+/**
+*   Add a connection request for the group of the client to the message.
+*
+*   @param self The rendezvous client of the group.
+*   @param msg The request message.
+*   @param name The name of the request element.
+ **/
+static void connect_request_add(_jxta_rdv_service_client * self, Jxta_message * msg, const char *name)
+{
+    Jxta_message_element *msgElem;
+    JString *localPeerAdvStr = NULL;
 
     jxta_PA_get_xml(self->localPeerAdv, &localPeerAdvStr);
-    msgElem = jxta_message_element_new_2(JXTA_RDV_NS_NAME, JXTA_RDV_CONNECT_REQUEST_ELEMENT_NAME,
+    msgElem = jxta_message_element_new_2(JXTA_RDV_NS_NAME, name,
                                          "text/xml", jstring_get_string(localPeerAdvStr), jstring_length(localPeerAdvStr), NULL);
 
     JXTA_OBJECT_RELEASE(localPeerAdvStr);
     jxta_message_add_element(msg, msgElem);
     JXTA_OBJECT_RELEASE(msgElem);
+}
 
-    /*
-     * Send the message
-     *
-     */
+/**
+*   Send a connection request message to the rendezvous service of our group on the specified peer.
+ **/
+static void connect_send(_jxta_rdv_service_client * self, _jxta_peer_rdv_entry * peer, Jxta_message * msg)
+{
+    Jxta_endpoint_address *destAddr;
+    Jxta_endpoint_address *address;
+    Jxta_status res = JXTA_SUCCESS;
+
+    score_request(self, jxta_peer_get_peerid_priv((Jxta_peer *) peer));
 
     /*
      * Set the destination address of the message.
@@ -748,6 +1016,123 @@ static void connect_to_peer(_jxta_rdv_service_client * self, _jxta_peer_rdv_entr
     }
 
     JXTA_OBJECT_RELEASE(destAddr);
+}
+
+/**
+*   Send a connect request message to the specified peer.
+ *
+*   @param self Our "this" pointer.
+*   @param peer The peer to which we will attemt to connect.
+ **/
+static void connect_to_peer(_jxta_rdv_service_client * self, _jxta_peer_rdv_entry * peer)
+{
+    Jxta_message *msg;
+
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Requesting Rdv lease from %s://%s\n",
+                    jxta_endpoint_address_get_protocol_name(((_jxta_peer_entry *) peer)->address),
+                    jxta_endpoint_address_get_protocol_address(((_jxta_peer_entry *) peer)->address));
+
+    if (!connect_claim(self, peer)) {
+        return;
+    }
+
+    /*
+     * Create a message with a connection request and build the request.
+     */
+    msg = jxta_message_new();
+
+    connect_request_add(self, msg, JXTA_RDV_CONNECT_REQUEST_ELEMENT_NAME);
+
+    /*
+     * Send the message
+     *
+     */
+    connect_send(self, peer, msg);
+
+    JXTA_OBJECT_RELEASE(msg);
+}
+
+/**
+*   Renew the lease of the rendezvous along with the leases the other groups of this peer hold from the same rendezvous and
+*   which fall due within the renewal window. The renewals are sent in one batched request which the rendezvous answers with
+*   one batched reply, instead of a request and a reply per group. Falls back to a plain request when no other group is due
+*   or when the previous batch to this rendezvous was not answered.
+*
+*   @param self Our "this" pointer.
+*   @param peer The rendezvous whose lease is due.
+ **/
+static void lease_batch_renew(_jxta_rdv_service_client * self, _jxta_peer_rdv_entry * peer)
+{
+    Jxta_time currentTime = jpr_time_now();
+    Jxta_vector *groups;
+    Jxta_vector *batch;
+    Jxta_message *msg;
+    Jxta_id *rdv_peerid = jxta_peer_get_peerid_priv((Jxta_peer *) peer);
+    Jxta_boolean unanswered;
+    unsigned int i;
+
+    if (!connect_claim(self, peer)) {
+        return;
+    }
+
+    jxta_peer_lock((Jxta_peer *) peer);
+    unanswered = peer->batchPending;
+    jxta_peer_unlock((Jxta_peer *) peer);
+
+    batch = jxta_vector_new(0);
+    groups = unanswered ? NULL : jxta_get_registered_groups();
+    for (i = 0; NULL != groups && i < jxta_vector_size(groups); i++) {
+        Jxta_PG *group;
+        _jxta_rdv_service_client *other;
+        _jxta_peer_rdv_entry *other_peer;
+        Jxta_time_diff due;
+
+        jxta_vector_get_object_at(groups, JXTA_OBJECT_PPTR(&group), i);
+        other = (_jxta_rdv_service_client *) jxta_rdv_service_group_provider_priv(group, config_edge, FALSE);
+        JXTA_OBJECT_RELEASE(group);
+        if (NULL == other) {
+            continue;
+        }
+
+        other_peer = (other != self) ? get_peer_entry(other, rdv_peerid, FALSE) : NULL;
+        if (NULL != other_peer) {
+            jxta_peer_lock((Jxta_peer *) other_peer);
+            due = (Jxta_time_diff) (jxta_peer_get_expires((Jxta_peer *) other_peer) - currentTime)
+                - jxta_RdvConfig_get_lease_renewal_delay(other->rdvConfig);
+            jxta_peer_unlock((Jxta_peer *) other_peer);
+            if (due < jxta_RdvConfig_get_lease_renewal_window(self->rdvConfig) && connect_claim(other, other_peer)) {
+                jxta_vector_add_object_last(batch, (Jxta_object *) other);
+            }
+            JXTA_OBJECT_RELEASE(other_peer);
+        }
+        JXTA_OBJECT_RELEASE(other);
+    }
+    if (NULL != groups) {
+        JXTA_OBJECT_RELEASE(groups);
+    }
+
+    msg = jxta_message_new();
+    if (0 == jxta_vector_size(batch)) {
+        connect_request_add(self, msg, JXTA_RDV_CONNECT_REQUEST_ELEMENT_NAME);
+    } else {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Batching lease renewal of %u other groups with %s\n",
+                        jxta_vector_size(batch), self->groupiduniq);
+        connect_request_add(self, msg, JXTA_RDV_BATCH_CONNECT_REQUEST_ELEMENT_NAME);
+        for (i = 0; i < jxta_vector_size(batch); i++) {
+            _jxta_rdv_service_client *other;
+
+            jxta_vector_get_object_at(batch, JXTA_OBJECT_PPTR(&other), i);
+            connect_request_add(other, msg, JXTA_RDV_BATCH_CONNECT_REQUEST_ELEMENT_NAME);
+            JXTA_OBJECT_RELEASE(other);
+        }
+        jxta_peer_lock((Jxta_peer *) peer);
+        peer->batchPending = TRUE;
+        jxta_peer_unlock((Jxta_peer *) peer);
+    }
+    JXTA_OBJECT_RELEASE(batch);
+
+    connect_send(self, peer, msg);
+
     JXTA_OBJECT_RELEASE(msg);
 }
 
@@ -800,7 +1185,11 @@ static Jxta_boolean check_peer_connect(_jxta_rdv_service_client * self, _jxta_pe
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "peer->connectInterval= " JPR_DIFF_TIME_FMT " ms\n", connectInterval);
     if (((Jxta_time_diff) (expires - currentTime)) < jxta_RdvConfig_get_lease_renewal_delay(self->rdvConfig)) {
         /* Time to try a connection */
-        connect_to_peer(self, peer);
+        if (jxta_RdvConfig_get_lease_renewal_window(self->rdvConfig) > 0) {
+            lease_batch_renew(self, peer);
+        } else {
+            connect_to_peer(self, peer);
+        }
     }
 
     return TRUE;
@@ -816,6 +1205,9 @@ static Jxta_boolean check_peer_connect(_jxta_rdv_service_client * self, _jxta_pe
  **    -  "jxta:ConnectedLease": contains the granted lease in milliseconds
  **    -  "jxta:ConnectedPeer": peer id of the rendezvous peer that has granted
  **                             the lease.
+ **
+ ** The response to a batched request carries instead of "jxta:ConnectedLease"
+ ** one "jxta:BatchConnectedLease" element per group, "<group id> <lease>".
  **/
 static Jxta_status process_connected_reply(_jxta_rdv_service_client * self, Jxta_message * msg)
 {
@@ -824,10 +1216,10 @@ static Jxta_status process_connected_reply(_jxta_rdv_service_client * self, Jxta
     JString *rdv_peerid_str = NULL;
     Jxta_id *rdv_peerid = NULL;
     Jxta_PA *rdv_PA = NULL;
-    JString *rdv_PA_name = NULL;
+    Jxta_vector *elements = NULL;
     Jxta_time_diff lease = 0;
-    _jxta_peer_rdv_entry *peer;
-    Jxta_Rendezvous_event_type lease_event;
+    unsigned int i;
+    unsigned int batched = 0;
 
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Processing rdv message [%pp]\n", msg);
 
@@ -872,19 +1264,6 @@ static Jxta_status process_connected_reply(_jxta_rdv_service_client * self, Jxta
             jxta_PA_parse_charbuffer(rdv_PA, jstring_get_string(string), jstring_length(string));
             JXTA_OBJECT_RELEASE(string);
             string = NULL;
-
-            if (self->discovery == NULL) {
-                apr_thread_mutex_lock(self->mutex);
-
-                jxta_PG_get_discovery_service(jxta_service_get_peergroup_priv((Jxta_service *)
-                                                                              jxta_rdv_service_provider_get_service_priv((_jxta_rdv_service_provider *) self)), &(self->discovery));
-                apr_thread_mutex_unlock(self->mutex);
-            }
-
-            if (self->discovery != NULL) {
-                discovery_service_publish(self->discovery, (Jxta_advertisement *) rdv_PA, DISC_PEER, (Jxta_expiration_time)
-                                          DEFAULT_EXPIRATION, LOCAL_ONLY_EXPIRATION);
-            }
         }
         JXTA_OBJECT_RELEASE(value);
         JXTA_OBJECT_RELEASE(el);
@@ -895,7 +1274,23 @@ static Jxta_status process_connected_reply(_jxta_rdv_service_client * self, Jxta
         status = JXTA_FAILED;
         goto Common_exit;
     }
-    rdv_PA_name = jxta_PA_get_Name(rdv_PA);
+
+    elements = jxta_message_get_elements_of_namespace(msg, JXTA_RDV_NS_NAME);
+    for (i = 0; i < jxta_vector_size(elements); i++) {
+        jxta_vector_get_object_at(elements, JXTA_OBJECT_PPTR(&el), i);
+        if (0 == strcmp(jxta_message_element_get_name(el), JXTA_RDV_BATCH_LEASE_REPLY_ELEMENT_NAME)) {
+            process_batch_lease(self, el, rdv_peerid, rdv_PA);
+            batched++;
+        }
+        JXTA_OBJECT_RELEASE(el);
+    }
+    JXTA_OBJECT_RELEASE(elements);
+
+    if (batched > 0) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Processed %u batched leases from [%s]\n", batched,
+                        jstring_get_string(rdv_peerid_str));
+        goto Common_exit;
+    }
 
     el = NULL;
     status = jxta_message_get_element_2(msg, JXTA_RDV_NS_NAME, JXTA_RDV_LEASE_REPLY_ELEMENT_NAME, &el);
@@ -925,16 +1320,125 @@ static Jxta_status process_connected_reply(_jxta_rdv_service_client * self, Jxta
         JXTA_OBJECT_RELEASE(el);
     }
 
+    status = lease_accept(self, rdv_peerid, rdv_PA, lease);
+
+  Common_exit:
+    if (NULL != rdv_peerid) {
+        JXTA_OBJECT_RELEASE(rdv_peerid);
+    }
+
+    if (NULL != rdv_peerid_str) {
+        JXTA_OBJECT_RELEASE(rdv_peerid_str);
+    }
+
+    if (NULL != rdv_PA) {
+        JXTA_OBJECT_RELEASE(rdv_PA);
+    }
+
+    return status;
+}
+
+/**
+ ** Process the lease granted for one group in a batched response. The lease
+ ** is handed to the rendezvous client of that group.
+ **/
+static void process_batch_lease(_jxta_rdv_service_client * self, Jxta_message_element * el, Jxta_id * rdv_peerid,
+                                Jxta_PA * rdv_PA)
+{
+    Jxta_bytevector *value = jxta_message_element_get_value(el);
+    unsigned int length = jxta_bytevector_size(value);
+    char *bytes = calloc(length + 1, sizeof(char));
+    char *sep;
+    Jxta_time_diff lease = 0;
+    Jxta_id *gid = NULL;
+    Jxta_PG *group = NULL;
+    JString *uniq = NULL;
+    _jxta_rdv_service_client *client = NULL;
+
+    jxta_bytevector_get_bytes_at(value, (unsigned char *) bytes, 0, length);
+    JXTA_OBJECT_RELEASE(value);
+    bytes[length] = 0;
+
+    sep = strrchr(bytes, ' ');
+    if (NULL == sep || 1 != sscanf(sep + 1, JPR_DIFF_TIME_FMT, &lease)) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Invalid batched lease : %s\n", bytes);
+        free(bytes);
+        return;
+    }
+    *sep = 0;
+
+    if (JXTA_SUCCESS != jxta_id_from_cstr(&gid, bytes)) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Invalid group id in batched lease : %s\n", bytes);
+        free(bytes);
+        return;
+    }
+    free(bytes);
+
+    jxta_id_get_uniqueportion(gid, &uniq);
+    if (0 == strcmp(jstring_get_string(uniq), self->groupiduniq)) {
+        client = JXTA_OBJECT_SHARE(self);
+    } else if (JXTA_SUCCESS == jxta_lookup_group_instance(gid, &group)) {
+        client = (_jxta_rdv_service_client *) jxta_rdv_service_group_provider_priv(group, config_edge, TRUE);
+        JXTA_OBJECT_RELEASE(group);
+    }
+
+    if (NULL != client) {
+        lease_accept(client, rdv_peerid, rdv_PA, lease);
+        JXTA_OBJECT_RELEASE(client);
+    } else {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "No rendezvous client for batched lease in group %s\n",
+                        jstring_get_string(uniq));
+    }
+
+    JXTA_OBJECT_RELEASE(uniq);
+    JXTA_OBJECT_RELEASE(gid);
+}
+
+/**
+ ** Record the lease offered by a rendezvous and notify the RDV listeners.
+ ** A lease of 0 or less is a denial.
+ **/
+static Jxta_status lease_accept(_jxta_rdv_service_client * self, Jxta_id * rdv_peerid, Jxta_PA * rdv_PA, Jxta_time_diff lease)
+{
+    _jxta_peer_rdv_entry *peer;
+    Jxta_Rendezvous_event_type lease_event;
+    JString *rdv_PA_name = NULL;
+    JString *rdv_peerid_str = NULL;
+
+    if (self->discovery == NULL) {
+        apr_thread_mutex_lock(self->mutex);
+
+        jxta_PG_get_discovery_service(jxta_service_get_peergroup_priv((Jxta_service *)
+                                                                      jxta_rdv_service_provider_get_service_priv((_jxta_rdv_service_provider *) self)), &(self->discovery));
+        apr_thread_mutex_unlock(self->mutex);
+    }
+
+    if (self->discovery != NULL) {
+        discovery_service_publish(self->discovery, (Jxta_advertisement *) rdv_PA, DISC_PEER, (Jxta_expiration_time)
+                                  DEFAULT_EXPIRATION, LOCAL_ONLY_EXPIRATION);
+    }
+
+    rdv_PA_name = jxta_PA_get_Name(rdv_PA);
+    jxta_id_to_jstring(rdv_peerid, &rdv_peerid_str);
+
+    score_response(self, rdv_peerid, (lease > 0));
+
     if (lease <= 0) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Could not recover valid lease in lease offer\n");
     }
 
     peer = get_peer_entry(self, rdv_peerid, (lease > 0));
 
+    if (NULL == peer && lease > 0) {
+        peer = lease_migrate(self, rdv_peerid);
+    }
+
     if (NULL == peer) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Ignoring lease offer from \"%s\" [%s] \n",
                         jstring_get_string(rdv_PA_name), jstring_get_string(rdv_peerid_str));
-        goto Common_exit;
+        JXTA_OBJECT_RELEASE(rdv_PA_name);
+        JXTA_OBJECT_RELEASE(rdv_peerid_str);
+        return JXTA_SUCCESS;
     }
 
     JXTA_OBJECT_CHECK_VALID(peer);
@@ -947,10 +1451,14 @@ static Jxta_status process_connected_reply(_jxta_rdv_service_client * self, Jxta
         lease_event =
             jxta_peer_get_expires((Jxta_peer *) peer) != JPR_ABSOLUTE_TIME_MAX ? JXTA_RDV_RECONNECTED : JXTA_RDV_CONNECTED;
 
+        if (JXTA_RDV_CONNECTED == lease_event) {
+            peer->connectTime = currentTime;
+        }
         jxta_peer_set_expires((Jxta_peer *) peer, currentTime + lease);
         jxta_peer_set_adv((Jxta_peer *) peer, rdv_PA);
         peer->connectInterval = 0;
         peer->lastConnectTry = currentTime;
+        peer->batchPending = FALSE;
     } else {
         peer->connectInterval = jxta_RdvConfig_get_min_retry_delay(self->rdvConfig);
         jxta_peer_set_expires((Jxta_peer *) peer, 0);
@@ -968,27 +1476,13 @@ static Jxta_status process_connected_reply(_jxta_rdv_service_client * self, Jxta
 
     JXTA_OBJECT_RELEASE(peer);
 
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Rendezvous connection with \"%s\" [%s] for " JPR_DIFF_TIME_FMT " ms\n",
-                    jstring_get_string(rdv_PA_name), jstring_get_string(rdv_peerid_str), lease);
-
-  Common_exit:
-    if (NULL != rdv_peerid) {
-        JXTA_OBJECT_RELEASE(rdv_peerid);
-    }
-
-    if (NULL != rdv_peerid_str) {
-        JXTA_OBJECT_RELEASE(rdv_peerid_str);
-    }
-
-    if (NULL != rdv_PA_name) {
-        JXTA_OBJECT_RELEASE(rdv_PA_name);
-    }
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Rendezvous connection with \"%s\" [%s] in %s for " JPR_DIFF_TIME_FMT
+                    " ms\n", jstring_get_string(rdv_PA_name), jstring_get_string(rdv_peerid_str), self->groupiduniq, lease);
 
-    if (NULL != rdv_PA) {
-        JXTA_OBJECT_RELEASE(rdv_PA);
-    }
+    JXTA_OBJECT_RELEASE(rdv_PA_name);
+    JXTA_OBJECT_RELEASE(rdv_peerid_str);
 
-    return status;
+    return JXTA_SUCCESS;
 }
 
 /**
@@ -1241,7 +1735,7 @@ static void *APR_THREAD_FUNC periodic_thread_main(apr_thread_t * thread, void *a
             jxta_vector_clear(candidates);
         }
 
-        /* Final lap -- try to connect to a candidate rdv */
+        /* Final lap -- try to connect to the best ranked candidate rdv */
         if ((NULL == candidates) || jxta_vector_size(candidates) == 0) {
             if (NULL != candidates) {
                 JXTA_OBJECT_RELEASE(candidates);
@@ -1264,7 +1758,7 @@ static void *APR_THREAD_FUNC periodic_thread_main(apr_thread_t * thread, void *a
         if ((NULL == candidate) && (jxta_vector_size(candidates) > 0)) {
             _jxta_peer_entry *peer;
 
-            res = jxta_vector_remove_object_at(candidates, JXTA_OBJECT_PPTR(&peer), 0);
+            res = jxta_vector_remove_object_at(candidates, JXTA_OBJECT_PPTR(&peer), candidate_best(self, candidates));
 
             if (res == JXTA_SUCCESS) {
                 PTValid(peer, _jxta_peer_entry);
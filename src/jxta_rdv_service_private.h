@@ -93,6 +93,8 @@ extern const char JXTA_RDV_CONNECTED_REPLY_ELEMENT_NAME[];
 extern const char JXTA_RDV_LEASE_REPLY_ELEMENT_NAME[];
 extern const char JXTA_RDV_RDVADV_REPLY_ELEMENT_NAME[];
 extern const char JXTA_RDV_ADV_ELEMENT_NAME[];
+extern const char JXTA_RDV_BATCH_CONNECT_REQUEST_ELEMENT_NAME[];
+extern const char JXTA_RDV_BATCH_LEASE_REPLY_ELEMENT_NAME[];
 
 /**
 *    Method table for rendezvous services.
@@ -167,6 +169,19 @@ JXTA_DECLARE(void) jxta_rdv_generate_event(_jxta_rdv_service * rdv, Jxta_Rendezv
 
 Jxta_endpoint_service * jxta_rdv_service_endpoint_svc(_jxta_rdv_service * rdv);
 
+/**
+*    Get the provider of the rendezvous service of another group if that service is running with the given configuration.
+*    Used to answer the lease requests of several groups batched in one message.
+*    
+*    @param group The group.
+*    @param config The configuration the provider is expected to run.
+*    @param wait If TRUE wait for a service being reconfigured. Message callbacks may wait, a reconfiguration never waits
+*           for them. The provider threads must not, a reconfiguration joins them.
+*    @return A share of the provider or NULL if the service runs another configuration, or is busy and wait is FALSE.
+**/
+Jxta_rdv_service_provider *jxta_rdv_service_group_provider_priv(Jxta_PG * group, RdvConfig_configuration config,
+                                                                Jxta_boolean wait);
+
 JXTA_DECLARE(Jxta_peerview *) jxta_rdv_service_get_peerview_priv(_jxta_rdv_service * rdv);
 
 /**
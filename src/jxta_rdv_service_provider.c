@@ -64,6 +64,15 @@ static const char *__log_cat = "RdvProvider";
 #include "jxta_rdv_service_provider.h"
 #include "jxta_rdv_service_provider_private.h"
 
+typedef struct _rdv_seen_msg Rdv_seen_msg;
+
+struct _rdv_seen_msg {
+    APR_RING_ENTRY(_rdv_seen_msg) link;
+    char *msgid;
+    Jxta_time seen;
+    int flags;
+};
+
 _jxta_rdv_service_provider *jxta_rdv_service_provider_construct(_jxta_rdv_service_provider * self,
                                                                 const _jxta_rdv_service_provider_methods * methods)
 {
@@ -79,6 +88,11 @@ _jxta_rdv_service_provider *jxta_rdv_service_provider_construct(_jxta_rdv_servic
 
     self->service = NULL;
 
+    apr_thread_mutex_create(&self->seen_mutex, APR_THREAD_MUTEX_DEFAULT, self->pool);
+    self->seen = apr_hash_make(self->pool);
+    APR_RING_INIT(&self->seen_list, _rdv_seen_msg, link);
+    memset(&self->seen_stats, 0, sizeof(self->seen_stats));
+
     return self;
 }
 
@@ -99,7 +113,16 @@ void jxta_rdv_service_provider_destruct(_jxta_rdv_service_provider * self)
     }
     free(self->groupiduniq);
 
+    while (!APR_RING_EMPTY(&self->seen_list, _rdv_seen_msg, link)) {
+        Rdv_seen_msg *entry = APR_RING_FIRST(&self->seen_list);
+
+        APR_RING_REMOVE(entry, link);
+        free(entry->msgid);
+        free(entry);
+    }
+
     /* Free the pool used to allocate the thread and mutex */
+    apr_thread_mutex_destroy(self->seen_mutex);
     apr_thread_mutex_destroy(self->mutex);
     apr_pool_destroy(self->pool);
 
@@ -200,6 +223,89 @@ _jxta_rdv_service *jxta_rdv_service_provider_get_service_priv(Jxta_rdv_service_p
     return self->service;
 }
 
+/*
+ * Record the message id with the given flag and tell whether the flag was already set. Message ids older than the window
+ * and the oldest ones over the set size are forgotten.
+ */
+static Jxta_boolean seen_check_and_set_at(_jxta_rdv_service_provider * self, const char *msgid, int flag, Jxta_time now)
+{
+    Rdv_seen_msg *entry;
+    Jxta_boolean seen = FALSE;
+
+    apr_thread_mutex_lock(self->seen_mutex);
+    while (!APR_RING_EMPTY(&self->seen_list, _rdv_seen_msg, link)) {
+        entry = APR_RING_FIRST(&self->seen_list);
+        if (entry->seen + RDV_SEEN_WINDOW > now && self->seen_stats.tracked < RDV_SEEN_MAX) {
+            break;
+        }
+        if (entry->seen + RDV_SEEN_WINDOW > now) {
+            self->seen_stats.evicted++;
+        }
+        APR_RING_REMOVE(entry, link);
+        apr_hash_set(self->seen, entry->msgid, APR_HASH_KEY_STRING, NULL);
+        free(entry->msgid);
+        free(entry);
+        self->seen_stats.tracked--;
+    }
+
+    entry = apr_hash_get(self->seen, msgid, APR_HASH_KEY_STRING);
+    if (NULL != entry) {
+        seen = (entry->flags & flag) ? TRUE : FALSE;
+        entry->flags |= flag;
+    } else {
+        entry = calloc(1, sizeof(*entry));
+        if (NULL != entry) {
+            entry->msgid = strdup(msgid);
+        }
+        if (NULL == entry || NULL == entry->msgid) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+            free(entry);
+        } else {
+            entry->seen = now;
+            entry->flags = flag;
+            apr_hash_set(self->seen, entry->msgid, APR_HASH_KEY_STRING, entry);
+            APR_RING_INSERT_TAIL(&self->seen_list, entry, _rdv_seen_msg, link);
+            self->seen_stats.tracked++;
+        }
+    }
+
+    if (RDV_SEEN_DELIVERED == flag) {
+        self->seen_stats.received++;
+        if (seen) {
+            self->seen_stats.duplicates++;
+        }
+    } else if (seen) {
+        self->seen_stats.repropagations++;
+    }
+    apr_thread_mutex_unlock(self->seen_mutex);
+
+    return seen;
+}
+
+static Jxta_boolean seen_check_and_set(_jxta_rdv_service_provider * self, const char *msgid, int flag)
+{
+    return seen_check_and_set_at(self, msgid, flag, jpr_time_now());
+}
+
+Jxta_boolean jxta_rdv_service_provider_seen_check_and_set_priv(Jxta_rdv_service_provider * provider, const char *msgid, int flag,
+                                                              Jxta_time now)
+{
+    _jxta_rdv_service_provider *self = PTValid(provider, _jxta_rdv_service_provider);
+
+    return seen_check_and_set_at(self, msgid, flag, now);
+}
+
+Jxta_status jxta_rdv_service_provider_get_propagate_stats(Jxta_rdv_service_provider * provider, Jxta_rdv_propagate_stats * stats)
+{
+    _jxta_rdv_service_provider *self = PTValid(provider, _jxta_rdv_service_provider);
+
+    apr_thread_mutex_lock(self->seen_mutex);
+    *stats = self->seen_stats;
+    apr_thread_mutex_unlock(self->seen_mutex);
+
+    return JXTA_SUCCESS;
+}
+
 /**
  ** This listener is called when a propagated message is received.
  **/
@@ -247,8 +353,12 @@ void JXTA_STDCALL jxta_rdv_service_provider_prop_listener(Jxta_object * obj, voi
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Demux propagated message [%pp] MessageId [%s] -> %s/%s\n",
                         msg, jstring_get_string(msgid), jstring_get_string(svc_name), jstring_get_string(svc_param));
 
-        /* XXX 20050516 bondolo Do duplicate message removal based upon msgid here */
-
+        /* a message comes back through every rendezvous of a meshed peerview, deliver it once */
+        message_seen = seen_check_and_set(self, jstring_get_string(msgid), RDV_SEEN_DELIVERED);
+        if (message_seen) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Removing previously seen message [%pp] msgid [%s]\n", msg,
+                            jstring_get_string(msgid));
+        }
 
 #if 0
         /* Check if we are already in the path */
@@ -350,6 +460,14 @@ Jxta_status jxta_rdv_service_provider_update_prophdr(Jxta_rdv_service_provider *
         
         messageId = RendezVousPropagateMessage_get_MessageId(pmsg);
 
+        if (seen_check_and_set(self, jstring_get_string(messageId), RDV_SEEN_PROPAGATED)) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Message [%pp] ID [%s] was already propagated.\n", msg,
+                            jstring_get_string(messageId));
+            JXTA_OBJECT_RELEASE(messageId);
+            JXTA_OBJECT_RELEASE(pmsg);
+            return JXTA_ITEM_EXISTS;
+        }
+
         hdrTTL = RendezVousPropagateMessage_get_TTL(pmsg);
         hdrTTL--;
         hdrTTL = (hdrTTL < ttl) ? hdrTTL : ttl;
@@ -365,6 +483,7 @@ Jxta_status jxta_rdv_service_provider_update_prophdr(Jxta_rdv_service_provider *
         RendezVousPropagateMessage_set_DestSParam(pmsg, serviceParam);
         RendezVousPropagateMessage_set_MessageId(pmsg, jstring_get_string(messageId));
         RendezVousPropagateMessage_set_TTL(pmsg, ttl);
+        seen_check_and_set(self, jstring_get_string(messageId), RDV_SEEN_PROPAGATED);
     }
 
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Updating message [%pp] ID [%s] ttl=%d \n", msg,
@@ -70,6 +70,18 @@ extern "C" {
 #endif
 #endif
 
+/**
+ * Message ids of propagated messages are remembered for RDV_SEEN_WINDOW, which is longer than a message takes to go
+ * through the mesh, and at most RDV_SEEN_MAX of them are kept.
+ **/
+#define RDV_SEEN_WINDOW ((Jxta_time_diff) 5 * 60 * 1000)
+#define RDV_SEEN_MAX 4096
+
+/* the message was demuxed to the local listeners */
+#define RDV_SEEN_DELIVERED 0x01
+/* the message was propagated to the peers */
+#define RDV_SEEN_PROPAGATED 0x02
+
 /**
 * The set of methods that a rdv provider object must implement.
 **/
@@ -152,6 +164,12 @@ struct _jxta_rdv_service_provider {
     Jxta_listener *listener_propagate;
 
     _jxta_rdv_service *service;
+
+    /* message ids of the propagated messages seen recently, the oldest first */
+    apr_thread_mutex_t *seen_mutex;
+    apr_hash_t *seen;
+    APR_RING_HEAD(rdv_seen_list, _rdv_seen_msg) seen_list;
+    Jxta_rdv_propagate_stats seen_stats;
 };
 
 typedef struct _jxta_rdv_service_provider _jxta_rdv_service_provider;
@@ -192,6 +210,23 @@ extern _jxta_rdv_service *jxta_rdv_service_provider_get_service_priv(Jxta_rdv_se
 **/
 extern Jxta_peerview *jxta_rdv_service_provider_get_peerview_priv(Jxta_rdv_service_provider * provider);
 
+extern Jxta_status jxta_rdv_service_provider_get_propagate_stats(Jxta_rdv_service_provider * provider,
+                                                                 Jxta_rdv_propagate_stats * stats);
+
+/**
+*   Records a message id as seen at the given time with the flag RDV_SEEN_DELIVERED
+*   or RDV_SEEN_PROPAGATED, as received and propagated messages are, and tells
+*   whether it was already recorded with that flag. The times of the calls must
+*   not go backwards.
+**/
+extern Jxta_boolean jxta_rdv_service_provider_seen_check_and_set_priv(Jxta_rdv_service_provider * provider,
+                                                                     const char *msgid, int flag, Jxta_time now);
+
+/**
+*   Updates the propagate header of the message, adding it if the message has
+*   none. Returns JXTA_ITEM_EXISTS if the message was already propagated by
+*   this peer.
+**/
 extern Jxta_status jxta_rdv_service_provider_update_prophdr(Jxta_rdv_service_provider * provider, Jxta_message * msg,
                                                             const char *serviceName, const char *serviceParam, int ttl);
 
@@ -74,6 +74,7 @@ static const char *__log_cat = "RdvServer";
 #include "jxta_object_type.h"
 #include "jstring.h"
 #include "jxta_vector.h"
+#include "jxta_objecthashtable.h"
 #include "jxta_pa.h"
 #include "jxta_svc.h"
 #include "jxta_pm.h"
@@ -105,6 +106,13 @@ static const int DEFAULT_MAX_CLIENTS = 200;
 **/
 static const Jxta_time_diff DEFAULT_LEASE_DURATION = (((Jxta_time_diff) 20) * 60 * 1000L);  /* 20 Minutes */
 
+/**
+*    Timer wheel of the client leases, a tick of LEASE_WHEEL_TICK ms per slot. A lease longer than a turn of the wheel is
+*    visited once per turn until it is due.
+**/
+#define LEASE_WHEEL_SLOTS 256
+#define LEASE_WHEEL_TICK 1000
+
 /**
 *    Public typedef for the rdv server provider.
 **/
@@ -123,9 +131,6 @@ struct _jxta_rdv_service_server {
     apr_thread_mutex_t *mutex;
 
     volatile Jxta_boolean running;
-    apr_thread_cond_t *periodicCond;
-    apr_thread_mutex_t *periodicMutex;
-    volatile apr_thread_t *periodicThread;
     Jxta_PG *group;
     Jxta_discovery_service *discovery;
     Jxta_PG *parentgroup;
@@ -153,7 +158,13 @@ struct _jxta_rdv_service_server {
 
     /* state */
     Jxta_PA *localPeerAdv;
-    Jxta_hashtable *clients;
+
+    /* client leases keyed by peer id and their expiration on the timer wheel, protected by mutex */
+    Jxta_objecthashtable *clients;
+    unsigned int clients_count;
+    APR_RING_HEAD(lease_slot, _jxta_peer_client_entry) lease_wheel[LEASE_WHEEL_SLOTS];
+    apr_int64_t lease_tick;     /* last tick reviewed */
+    Jxta_boolean lease_timer_armed;
 };
 
 /**
@@ -169,6 +180,9 @@ struct _jxta_peer_client_entry {
     Extends(_jxta_peer_entry);
 
     Jxta_time connectTime;
+
+    /* timer wheel slot of the lease expiration, the next link is NULL when the lease is not scheduled */
+    APR_RING_ENTRY(_jxta_peer_client_entry) timer;
 };
 
 typedef struct _jxta_peer_client_entry _jxta_peer_client_entry;
@@ -192,13 +206,19 @@ static Jxta_status propagate(Jxta_rdv_service_provider * provider, Jxta_message
 static Jxta_status walk(Jxta_rdv_service_provider * provider, Jxta_message * msg, const char *serviceName,
                         const char *serviceParam);
 
-static void *APR_THREAD_FUNC periodic_thread_main(apr_thread_t * thread, void *self);
+static void *APR_THREAD_FUNC lease_timer(apr_thread_t * thread, void *arg);
 static Jxta_status JXTA_STDCALL server_cb(Jxta_object * msg, void *arg);
 static Jxta_status JXTA_STDCALL walker_cb(Jxta_object * obj, void *me);
 
 static Jxta_status send_connect_reply(_jxta_rdv_service_server * self, _jxta_peer_client_entry * client);
+static Jxta_message *connect_reply_new(_jxta_rdv_service_server * self);
+static Jxta_status connect_reply_send(_jxta_rdv_service_server * self, Jxta_message * msg, Jxta_endpoint_address * destAddr);
+static Jxta_status process_batch_request(_jxta_rdv_service_server * self, Jxta_message * msg);
+static Jxta_PA *element_PA(Jxta_message_element * el);
+static _jxta_peer_client_entry *lease_grant(_jxta_rdv_service_server * self, Jxta_PA * client_PA);
 static _jxta_peer_client_entry *get_peer_entry(_jxta_rdv_service_server * self, Jxta_id * peerid, Jxta_boolean create);
 static Jxta_boolean check_peer_lease(_jxta_peer_client_entry * peer);
+static void lease_renew(_jxta_rdv_service_server * self, _jxta_peer_client_entry * client);
 
 static _jxta_peer_client_entry *client_entry_new(void);
 static _jxta_peer_client_entry *client_entry_construct(_jxta_peer_client_entry * self );
@@ -239,6 +259,7 @@ static _jxta_peer_client_entry *client_entry_construct(_jxta_peer_client_entry *
         self->thisType = "_jxta_peer_client_entry";
 
         self->connectTime = 0;
+        APR_RING_NEXT(self, timer) = NULL;
     }
 
     return self;
@@ -284,6 +305,7 @@ static _jxta_rdv_service_server *jxta_rdv_service_server_construct(_jxta_rdv_ser
                                                                    const _jxta_rdv_service_provider_methods * methods)
 {
     apr_status_t res = APR_SUCCESS;
+    int i;
 
     self = (_jxta_rdv_service_server *) jxta_rdv_service_provider_construct((_jxta_rdv_service_provider *) self, methods);
 
@@ -299,18 +321,18 @@ static _jxta_rdv_service_server *jxta_rdv_service_server_construct(_jxta_rdv_ser
             return NULL;
         }
 
-        res = apr_thread_cond_create(&self->periodicCond, self->pool);
-
-        if (res != APR_SUCCESS) {
-            return NULL;
-        }
-
-        res = apr_thread_mutex_create(&self->periodicMutex, APR_THREAD_MUTEX_DEFAULT, self->pool);
         /** The following will be updated with initialized **/
         self->discovery = NULL;
 
         /** Allocate a table for storing the list of peers **/
-        self->clients = jxta_hashtable_new_0(DEFAULT_MAX_CLIENTS, TRUE);
+        self->clients = jxta_objecthashtable_new(DEFAULT_MAX_CLIENTS, (Jxta_object_hash_func) jxta_id_hashcode,
+                                                 (Jxta_object_equals_func) jxta_id_equals);
+        self->clients_count = 0;
+        for (i = 0; i < LEASE_WHEEL_SLOTS; i++) {
+            APR_RING_INIT(&self->lease_wheel[i], _jxta_peer_client_entry, timer);
+        }
+        self->lease_tick = jpr_time_now() / LEASE_WHEEL_TICK;
+        self->lease_timer_armed = FALSE;
         self->running = FALSE;
     }
 
@@ -350,8 +372,6 @@ static void Jxta_rdv_service_server_destruct(_jxta_rdv_service_server * rdv)
     free(self->groupiduniq);
 
     apr_thread_mutex_destroy(self->mutex);
-    apr_thread_mutex_destroy(self->periodicMutex);
-    apr_thread_cond_destroy(self->periodicCond);
 
     /* call the base classe's dtor. */
     jxta_rdv_service_provider_destruct((_jxta_rdv_service_provider *) self);
@@ -491,16 +511,13 @@ static Jxta_status start(Jxta_rdv_service_provider * provider)
 
     res = jxta_peerview_start(((Jxta_rdv_service_provider *) self)->peerview);
 
-    apr_thread_mutex_lock(self->periodicMutex);
+    apr_thread_mutex_lock(self->mutex);
 
     /* Mark the service as running now. */
     self->running = TRUE;
+    self->lease_tick = jpr_time_now() / LEASE_WHEEL_TICK;
 
-    apr_thread_create((apr_thread_t **) & self->periodicThread, NULL,   /* no attr */
-                      (apr_thread_start_t) periodic_thread_main, (void *) JXTA_OBJECT_SHARE(self),
-                      jxta_rdv_service_provider_get_pool_priv(provider));
-
-    apr_thread_mutex_unlock(self->periodicMutex);
+    apr_thread_mutex_unlock(self->mutex);
 
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, FILEANDLINE "Started for %s\n", self->groupiduniq);
 
@@ -525,7 +542,6 @@ static Jxta_status stop(Jxta_rdv_service_provider * provider)
 {
     _jxta_rdv_service_server *self = PTValid(provider, _jxta_rdv_service_server);
     Jxta_status res;
-    apr_status_t rv;
 
     jxta_rdv_service_provider_lock_priv(provider);
 
@@ -535,11 +551,13 @@ static Jxta_status stop(Jxta_rdv_service_provider * provider)
         return APR_SUCCESS;
     }
 
-    /* We need to tell the background thread that it has to die. */
-    apr_thread_mutex_lock(self->periodicMutex);
+    /* The lease timer must not run anymore. */
+    apr_thread_mutex_lock(self->mutex);
     self->running = FALSE;
-    apr_thread_cond_signal(self->periodicCond);
-    apr_thread_mutex_unlock(self->periodicMutex);
+    self->lease_timer_armed = FALSE;
+    apr_thread_mutex_unlock(self->mutex);
+    apr_thread_pool_tasks_cancel(jxta_PG_thread_pool_get(jxta_service_get_peergroup_priv((Jxta_service *) provider->service)),
+                                 self);
 
     jxta_rdv_service_provider_unlock_priv(provider);
 
@@ -555,9 +573,6 @@ static Jxta_status stop(Jxta_rdv_service_provider * provider)
 
     res = jxta_rdv_service_provider_stop(provider);
 
-    apr_thread_join(&rv, (apr_thread_t *) self->periodicThread);
-    res = rv;
-
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Stopped.\n");
 
     return res;
@@ -573,6 +588,9 @@ static Jxta_status stop(Jxta_rdv_service_provider * provider)
 static Jxta_status get_peers(Jxta_rdv_service_provider * provider, Jxta_vector ** peerlist)
 {
     _jxta_rdv_service_server *self = (_jxta_rdv_service_server *) PTValid(provider, _jxta_rdv_service_server);
+    Jxta_vector *clients;
+    _jxta_peer_client_entry *peer;
+    unsigned int i;
 
     /* Test arguments first */
     if (peerlist == NULL) {
@@ -580,16 +598,132 @@ static Jxta_status get_peers(Jxta_rdv_service_provider * provider, Jxta_vector *
         return JXTA_INVALID_ARGUMENT;
     }
 
-    *peerlist = jxta_hashtable_values_get(self->clients);
+    apr_thread_mutex_lock(self->mutex);
+    clients = jxta_objecthashtable_values_get(self->clients);
+    apr_thread_mutex_unlock(self->mutex);
 
-    if (NULL == *peerlist) {
+    if (NULL == clients) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Failed getting peers list\n");
         return JXTA_NOMEM;
     }
 
+    /* the clients whose lease ran out are not served until the timer gets rid of them */
+    for (i = 0; i < jxta_vector_size(clients);) {
+        if (JXTA_SUCCESS == jxta_vector_get_object_at(clients, JXTA_OBJECT_PPTR(&peer), i)) {
+            if (!check_peer_lease(peer)) {
+                jxta_vector_remove_object_at(clients, NULL, i);
+                JXTA_OBJECT_RELEASE(peer);
+                continue;
+            }
+            JXTA_OBJECT_RELEASE(peer);
+        }
+        i++;
+    }
+
+    *peerlist = clients;
+
     return JXTA_SUCCESS;
 }
 
+/**
+ * Build the walk header element for the next hop. The binary form is used when the peer accepts it, a binary header received
+ * from the previous hop is then copied with only its TTL and direction updated. The XML form is used otherwise, decoding the
+ * received binary header if needed.
+ *
+ * @param header The decoded walk header, created from binary on demand.
+ * @param binary The binary walk header received from the previous hop or NULL.
+ * @return the walk header element or NULL.
+ **/
+static Jxta_message_element *walk_header_element(Jxta_rdv_service_provider * provider, Jxta_peer * peer,
+                                                 LimitedRangeRdvMessage ** header, Jxta_bytevector * binary, int ttl,
+                                                 Walk_direction dir)
+{
+    Jxta_status res;
+    Jxta_message_element *el = NULL;
+    Jxta_bytevector *bytes = NULL;
+    JString *header_doc;
+
+    if (jxta_peerview_peer_binary_walk(provider->peerview, peer)) {
+        if (NULL != binary) {
+            size_t len = jxta_bytevector_size(binary);
+            char *copy = malloc(len);
+
+            if (NULL == copy) {
+                jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+                return NULL;
+            }
+            memcpy(copy, jxta_bytevector_content_ptr(binary), len);
+            LimitedRangeRdvMessage_binary_set_TTL_direction(copy, len, ttl, dir);
+            bytes = jxta_bytevector_new_3(copy, len, TRUE);
+            if (NULL == bytes) {
+                free(copy);
+            }
+        } else {
+            LimitedRangeRdvMessage_set_TTL(*header, ttl);
+            LimitedRangeRdvMessage_set_direction(*header, dir);
+            LimitedRangeRdvMessage_get_binary(*header, &bytes);
+        }
+
+        if (NULL != bytes) {
+            el = jxta_message_element_new_3(JXTA_RDV_NS_NAME, LIMITEDRANGEWALKELEMENT, LIMITEDRANGERDVMESSAGE_BINARY_MIME, bytes,
+                                            NULL);
+            JXTA_OBJECT_RELEASE(bytes);
+        }
+        return el;
+    }
+
+    if (NULL == *header) {
+        *header = LimitedRangeRdvMessage_new();
+        res = LimitedRangeRdvMessage_parse_binary(*header, jxta_bytevector_content_ptr(binary), jxta_bytevector_size(binary));
+        if (JXTA_SUCCESS != res) {
+            /* a half parsed header must not be reused for the other direction */
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Failed to parse the binary walk header\n");
+            JXTA_OBJECT_RELEASE(*header);
+            *header = NULL;
+            return NULL;
+        }
+    }
+
+    LimitedRangeRdvMessage_set_TTL(*header, ttl);
+    LimitedRangeRdvMessage_set_direction(*header, dir);
+    res = LimitedRangeRdvMessage_get_xml(*header, &header_doc);
+    if (res != JXTA_SUCCESS) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Failed to build LimitedRangeRdvMessage XML\n");
+        return NULL;
+    }
+
+    el = jxta_message_element_new_2(JXTA_RDV_NS_NAME, LIMITEDRANGEWALKELEMENT,
+                                    "text/xml", jstring_get_string(header_doc), jstring_length(header_doc), NULL);
+    JXTA_OBJECT_RELEASE(header_doc);
+
+    return el;
+}
+
+/**
+ * Send the walk message to the walker of the peer with the walk header element added.
+ **/
+static Jxta_status walk_send(Jxta_rdv_service_provider * provider, Jxta_message * msg, Jxta_peer * peer,
+                             Jxta_message_element * el)
+{
+    _jxta_rdv_service_server *self = PTValid(provider, _jxta_rdv_service_server);
+    Jxta_endpoint_address *destAddr;
+    Jxta_endpoint_address *peerAddr = ((_jxta_peer_entry *) peer)->address;
+    Jxta_status res;
+
+    jxta_message_add_element(msg, el);
+
+    destAddr = jxta_endpoint_address_new_2(jxta_endpoint_address_get_protocol_name(peerAddr),
+                                           jxta_endpoint_address_get_protocol_address(peerAddr),
+                                           jstring_get_string(self->walkerSvc), jstring_get_string(self->walkerParam));
+
+    /* Send the message */
+    res = jxta_endpoint_service_send(jxta_service_get_peergroup_priv((Jxta_service *) provider->service),
+                                     provider->service->endpoint, msg, destAddr);
+    JXTA_OBJECT_RELEASE(destAddr);
+
+    return res;
+}
+
 /**
  * Propagates a message within the PeerGroup for which the instance of the 
  * Rendezvous Service is running in.
@@ -638,9 +772,14 @@ static Jxta_status walk(Jxta_rdv_service_provider * provider, Jxta_message * msg
     _jxta_rdv_service_server *self = PTValid(provider, _jxta_rdv_service_server);
     unsigned int local_view_size = jxta_peerview_get_localview_size(provider->peerview);
     Jxta_message_element *el = NULL;
-    LimitedRangeRdvMessage *header = LimitedRangeRdvMessage_new();
+    LimitedRangeRdvMessage *header = NULL;
+    Jxta_bytevector *binary = NULL;
     Walk_direction direction;
     unsigned int useTTL;
+    int ttl;
+    Jxta_peer *up = NULL;
+    Jxta_peer *down = NULL;
+    Jxta_message *newmsg;
 
     JXTA_OBJECT_CHECK_VALID(msg);
 
@@ -650,11 +789,14 @@ static Jxta_status walk(Jxta_rdv_service_provider * provider, Jxta_message * msg
 
     if ((JXTA_SUCCESS != res) || (NULL == el)) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Initiate a walk for msg[%pp]\n", msg);
+        header = LimitedRangeRdvMessage_new();
         LimitedRangeRdvMessage_set_TTL(header, local_view_size);
         LimitedRangeRdvMessage_set_direction(header, WALK_BOTH);
         LimitedRangeRdvMessage_set_SrcPeerID(header, jstring_get_string(self->localPeerIdJString));
         LimitedRangeRdvMessage_set_SrcSvcName(header, serviceName);
         LimitedRangeRdvMessage_set_SrcSvcParams(header, serviceParam);
+        ttl = local_view_size;
+        direction = WALK_BOTH;
         el = jxta_message_element_new_2(JXTA_RDV_NS_NAME, "RdvWalkSvcName", "text/plain", serviceName, strlen(serviceName), NULL);
         jxta_message_add_element(msg, el);
         JXTA_OBJECT_RELEASE(el);
@@ -664,17 +806,29 @@ static Jxta_status walk(Jxta_rdv_service_provider * provider, Jxta_message * msg
         jxta_message_add_element(msg, el);
         JXTA_OBJECT_RELEASE(el);
     } else {
-        JString *string;
         Jxta_bytevector *bytes = jxta_message_element_get_value(el);
+        const char *mime = jxta_message_element_get_mime_type(el);
 
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Continue to walk for msg[%pp]\n", msg);
         jxta_message_remove_element(msg, el);
+
+        if (NULL != mime && 0 == strcmp(mime, LIMITEDRANGERDVMESSAGE_BINARY_MIME)) {
+            /* only the TTL and the direction are needed to forward it */
+            res = LimitedRangeRdvMessage_binary_get_TTL_direction(jxta_bytevector_content_ptr(bytes), jxta_bytevector_size(bytes),
+                                                                  &ttl, &direction);
+            binary = bytes;
+        } else {
+            JString *string = jstring_new_3(bytes);
+
+            JXTA_OBJECT_RELEASE(bytes);
+            header = LimitedRangeRdvMessage_new();
+            res = LimitedRangeRdvMessage_parse_charbuffer(header, jstring_get_string(string), jstring_length(string));
+            JXTA_OBJECT_RELEASE(string);
+            ttl = LimitedRangeRdvMessage_get_TTL(header);
+            direction = LimitedRangeRdvMessage_get_direction(header);
+        }
         JXTA_OBJECT_RELEASE(el);
-        string = jstring_new_3(bytes);
-        JXTA_OBJECT_RELEASE(bytes);
 
-        res = LimitedRangeRdvMessage_parse_charbuffer(header, jstring_get_string(string), jstring_length(string));
-        JXTA_OBJECT_RELEASE(string);
         if (JXTA_SUCCESS != res) {
             jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Could not parse walk header [%pp]\n", msg);
             goto Common_exit;
@@ -683,110 +837,72 @@ static Jxta_status walk(Jxta_rdv_service_provider * provider, Jxta_message * msg
 
     res = JXTA_SUCCESS;
     /* reduce the TTL */
-    useTTL = LimitedRangeRdvMessage_get_TTL(header) - 1;
+    useTTL = ttl - 1;
 
     /* limit it to *our* localview size */
     useTTL = ((local_view_size - 1) < useTTL) ? (local_view_size - 1) : useTTL;
 
-    LimitedRangeRdvMessage_set_TTL(header, useTTL);
-
     if (useTTL < 1) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Walk msg[%pp] stopped: TTL %d expired with local view size %d\n", msg,
                         useTTL, local_view_size);
         goto Common_exit;
     }
 
-    direction = LimitedRangeRdvMessage_get_direction(header);
-
     if ((WALK_BOTH == direction) || (WALK_UP == direction)) {
-        JString *header_doc;
-        Jxta_endpoint_address *destAddr;
-        Jxta_message *newmsg = jxta_message_clone(msg);
-        Jxta_peer *peer;
-
-        LimitedRangeRdvMessage_set_direction(header, WALK_UP);
-
-        res = LimitedRangeRdvMessage_get_xml(header, &header_doc);
-
-        if (res != JXTA_SUCCESS) {
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Failed to build LimitedRangeRdvMessage XML\n");
-            goto Common_exit;
-        }
-
-        el = jxta_message_element_new_2(JXTA_RDV_NS_NAME, LIMITEDRANGEWALKELEMENT,
-                                        "text/xml", jstring_get_string(header_doc), jstring_length(header_doc), NULL);
-        JXTA_OBJECT_RELEASE(header_doc);
-        jxta_message_add_element(newmsg, el);
-        JXTA_OBJECT_RELEASE(el);
-
-        res = jxta_peerview_get_up_peer(provider->peerview, &peer);
+        jxta_peerview_get_up_peer(provider->peerview, &up);
+    }
+    if ((WALK_BOTH == direction) || (WALK_DOWN == direction)) {
+        jxta_peerview_get_down_peer(provider->peerview, &down);
+    }
 
-        if (NULL != peer) {
+    if (NULL != up) {
+        el = walk_header_element(provider, up, &header, binary, useTTL, WALK_UP);
+        if (NULL != el) {
             JString *pidString;
-            jxta_id_to_jstring(jxta_peer_get_peerid_priv(peer), &pidString);
+
+            jxta_id_to_jstring(jxta_peer_get_peerid_priv(up), &pidString);
             jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Walk the query UP %s\n", jstring_get_string(pidString));
-            destAddr = jxta_endpoint_address_new_2(jxta_endpoint_address_get_protocol_name(((_jxta_peer_entry *) peer)->address),
-                                                   jxta_endpoint_address_get_protocol_address(((_jxta_peer_entry *) peer)->
-                                                                                              address),
-                                                   jstring_get_string(self->walkerSvc), jstring_get_string(self->walkerParam));
-            JXTA_OBJECT_RELEASE(peer);
             JXTA_OBJECT_RELEASE(pidString);
 
-            /* Send the message */
-            res =
-                jxta_endpoint_service_send(jxta_service_get_peergroup_priv
-                                           ((Jxta_service *) provider->service), provider->service->endpoint, newmsg, destAddr);
-            JXTA_OBJECT_RELEASE(destAddr);
+            /* the message is only copied when it goes both ways */
+            newmsg = (NULL != down) ? jxta_message_clone(msg) : JXTA_OBJECT_SHARE(msg);
+            res = walk_send(provider, newmsg, up, el);
+            JXTA_OBJECT_RELEASE(newmsg);
+            JXTA_OBJECT_RELEASE(el);
+        } else {
+            res = JXTA_FAILED;
         }
-
-        JXTA_OBJECT_RELEASE(newmsg);
     }
 
-    if ((WALK_BOTH == direction) || (WALK_DOWN == direction)) {
-        JString *header_doc;
-        Jxta_endpoint_address *destAddr;
-        Jxta_message *newmsg = jxta_message_clone(msg);
-        Jxta_peer *peer;
-
-        LimitedRangeRdvMessage_set_direction(header, WALK_DOWN);
-
-        res = LimitedRangeRdvMessage_get_xml(header, &header_doc);
-
-        if (res != JXTA_SUCCESS) {
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Failed to build LimitedRangeRdvMessage XML\n");
-            goto Common_exit;
-        }
-
-        el = jxta_message_element_new_2(JXTA_RDV_NS_NAME, LIMITEDRANGEWALKELEMENT,
-                                        "text/xml", jstring_get_string(header_doc), jstring_length(header_doc), NULL);
-        JXTA_OBJECT_RELEASE(header_doc);
-        jxta_message_add_element(newmsg, el);
-        JXTA_OBJECT_RELEASE(el);
-
-        res = jxta_peerview_get_down_peer(provider->peerview, &peer);
-
-        if (NULL != peer) {
+    if (NULL != down) {
+        el = walk_header_element(provider, down, &header, binary, useTTL, WALK_DOWN);
+        if (NULL != el) {
             JString *pidString;
-            jxta_id_to_jstring(jxta_peer_get_peerid_priv(peer), &pidString);
+
+            jxta_id_to_jstring(jxta_peer_get_peerid_priv(down), &pidString);
             jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Walk the query DOWN %s\n", jstring_get_string(pidString));
-            destAddr = jxta_endpoint_address_new_2(jxta_endpoint_address_get_protocol_name(((_jxta_peer_entry *) peer)->address),
-                                                   jxta_endpoint_address_get_protocol_address(((_jxta_peer_entry *) peer)->
-                                                                                              address),
-                                                   jstring_get_string(self->walkerSvc), jstring_get_string(self->walkerParam));
-            JXTA_OBJECT_RELEASE(peer);
             JXTA_OBJECT_RELEASE(pidString);
-            /* Send the message */
-            res =
-                jxta_endpoint_service_send(jxta_service_get_peergroup_priv
-                                           ((Jxta_service *) provider->service), provider->service->endpoint, newmsg, destAddr);
-            JXTA_OBJECT_RELEASE(destAddr);
-        }
 
-        JXTA_OBJECT_RELEASE(newmsg);
+            res = walk_send(provider, msg, down, el);
+            JXTA_OBJECT_RELEASE(el);
+        } else {
+            res = JXTA_FAILED;
+        }
     }
 
   Common_exit:
-    JXTA_OBJECT_RELEASE(header);
+    if (NULL != up) {
+        JXTA_OBJECT_RELEASE(up);
+    }
+    if (NULL != down) {
+        JXTA_OBJECT_RELEASE(down);
+    }
+    if (NULL != header) {
+        JXTA_OBJECT_RELEASE(header);
+    }
+    if (NULL != binary) {
+        JXTA_OBJECT_RELEASE(binary);
+    }
     JXTA_OBJECT_RELEASE(msg);
 
     return res;
@@ -806,7 +922,6 @@ static Jxta_status JXTA_STDCALL server_cb(Jxta_object * obj, void *arg)
 {
     Jxta_status res = JXTA_SUCCESS;
     Jxta_message *msg = (Jxta_message *) obj;
-    Jxta_rdv_service_provider *provider = PTValid(arg, _jxta_rdv_service_provider);
     _jxta_rdv_service_server *self = PTValid(arg, _jxta_rdv_service_server);
     Jxta_message_element *el = NULL;
 
@@ -817,82 +932,222 @@ static Jxta_status JXTA_STDCALL server_cb(Jxta_object * obj, void *arg)
     res = jxta_message_get_element_2(msg, JXTA_RDV_NS_NAME, JXTA_RDV_CONNECT_REQUEST_ELEMENT_NAME, &el);
 
     if ((JXTA_SUCCESS == res) && (NULL != el)) {
-        Jxta_id *client_peerid;
         _jxta_peer_client_entry *client;
-        Jxta_bytevector *bytes = jxta_message_element_get_value(el);
-        JString *string = jstring_new_3(bytes);
-        Jxta_PA *client_PA = jxta_PA_new();
+        Jxta_PA *client_PA = element_PA(el);
 
         /*
            This is a connect request
          */
         JXTA_OBJECT_RELEASE(el);
-        JXTA_OBJECT_RELEASE(bytes);
-        jxta_PA_parse_charbuffer(client_PA, jstring_get_string(string), jstring_length(string));
-        JXTA_OBJECT_RELEASE(string);
 
-        /*
-           Publish the client's peer advertisement
-         */
-        if (self->discovery == NULL) {
-            jxta_PG_get_discovery_service(jxta_service_get_peergroup_priv((Jxta_service *) provider->service),
-                                          &(self->discovery));
+        client = lease_grant(self, client_PA);
+
+        if (NULL != client) {
+            /*
+             * This is a response to a lease request.
+             */
+            res = send_connect_reply(self, client);
+
+            JXTA_OBJECT_RELEASE(client);
         }
 
-        if (self->discovery != NULL) {
-            discovery_service_publish(self->discovery, (Jxta_advertisement *) client_PA, DISC_PEER, (Jxta_expiration_time)
-                                      DEFAULT_EXPIRATION, LOCAL_ONLY_EXPIRATION);
+        JXTA_OBJECT_RELEASE(client_PA);
+    } else {
+        res = jxta_message_get_element_2(msg, JXTA_RDV_NS_NAME, JXTA_RDV_BATCH_CONNECT_REQUEST_ELEMENT_NAME, &el);
+
+        if ((JXTA_SUCCESS == res) && (NULL != el)) {
+            JXTA_OBJECT_RELEASE(el);
+            res = process_batch_request(self, msg);
         }
+    }
+    return res;
+}
 
-        client_peerid = jxta_PA_get_PID(client_PA);
+/**
+*   Parse the peer advertisement carried by a lease request element.
+**/
+static Jxta_PA *element_PA(Jxta_message_element * el)
+{
+    Jxta_bytevector *bytes = jxta_message_element_get_value(el);
+    JString *string = jstring_new_3(bytes);
+    Jxta_PA *pa = jxta_PA_new();
 
-        jxta_id_get_uniqueportion(client_peerid, &string);
+    JXTA_OBJECT_RELEASE(bytes);
+    jxta_PA_parse_charbuffer(pa, jstring_get_string(string), jstring_length(string));
+    JXTA_OBJECT_RELEASE(string);
 
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Lease Request from %s.\n", jstring_get_string(string));
-        JXTA_OBJECT_RELEASE(string);
+    return pa;
+}
 
-        client = get_peer_entry(self, client_peerid, TRUE);
+/**
+*   Grant or extend the lease of the peer described by the advertisement and notify the RDV listeners.
+*
+*   @param self The rendezvous server of the group the lease is requested for.
+*   @param client_PA The peer advertisement of the requesting peer in that group.
+*   @return The client entry or NULL if the lease was declined.
+**/
+static _jxta_peer_client_entry *lease_grant(_jxta_rdv_service_server * self, Jxta_PA * client_PA)
+{
+    Jxta_rdv_service_provider *provider = PTValid(self, _jxta_rdv_service_provider);
+    Jxta_id *client_peerid;
+    _jxta_peer_client_entry *client;
+    JString *string = NULL;
 
-        if (NULL != client) {
-            Jxta_Rendezvous_event_type lease_event =
-                jxta_peer_get_expires((Jxta_peer *) client) !=
-                JPR_ABSOLUTE_TIME_MAX ? JXTA_RDV_CLIENT_RECONNECTED : JXTA_RDV_CLIENT_CONNECTED;
-            jxta_peer_set_adv((Jxta_peer *) client, client_PA);
-            jxta_peer_set_expires((Jxta_peer *) client, jpr_time_now() + self->OFFERED_LEASE_DURATION);
+    /*
+       Publish the client's peer advertisement
+     */
+    if (self->discovery == NULL) {
+        jxta_PG_get_discovery_service(jxta_service_get_peergroup_priv((Jxta_service *) provider->service), &(self->discovery));
+    }
 
-            /*
-             * This is a response to a lease request.
-             */
-            res = send_connect_reply(self, client);
+    if (self->discovery != NULL) {
+        discovery_service_publish(self->discovery, (Jxta_advertisement *) client_PA, DISC_PEER, (Jxta_expiration_time)
+                                  DEFAULT_EXPIRATION, LOCAL_ONLY_EXPIRATION);
+    }
 
-            /*
-             *  notify the RDV listeners about the client activity
-             */
-            jxta_rdv_generate_event(provider->service, lease_event, client_peerid);
+    client_peerid = jxta_PA_get_PID(client_PA);
 
-            JXTA_OBJECT_RELEASE(client);
-        } else {
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Declining to offer lease to %s.\n", jstring_get_string(string));
-        }
+    jxta_id_get_uniqueportion(client_peerid, &string);
+
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Lease Request from %s.\n", jstring_get_string(string));
+
+    client = get_peer_entry(self, client_peerid, TRUE);
+
+    if (NULL != client) {
+        Jxta_Rendezvous_event_type lease_event =
+            jxta_peer_get_expires((Jxta_peer *) client) !=
+            JPR_ABSOLUTE_TIME_MAX ? JXTA_RDV_CLIENT_RECONNECTED : JXTA_RDV_CLIENT_CONNECTED;
+        jxta_peer_set_adv((Jxta_peer *) client, client_PA);
+        lease_renew(self, client);
 
         /*
-         * Release the message: we are done with it.
+         *  notify the RDV listeners about the client activity
          */
-        JXTA_OBJECT_RELEASE(client_peerid);
+        jxta_rdv_generate_event(provider->service, lease_event, client_peerid);
+    } else {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Declining to offer lease to %s.\n", jstring_get_string(string));
+    }
+
+    JXTA_OBJECT_RELEASE(string);
+    JXTA_OBJECT_RELEASE(client_peerid);
+
+    return client;
+}
+
+/**
+*   Answer the lease requests an edge peer batched for several groups with a single reply. Each request carries the peer
+*   advertisement of the edge in its group. The lease is granted by the rendezvous server of that group when this peer is a
+*   rendezvous of it and declined with a lease of 0 otherwise.
+*
+*   @param self The rendezvous server of the group the batch was addressed to.
+*   @param msg The batched lease request.
+**/
+static Jxta_status process_batch_request(_jxta_rdv_service_server * self, Jxta_message * msg)
+{
+    Jxta_status res = JXTA_SUCCESS;
+    Jxta_vector *elements;
+    Jxta_message *reply;
+    Jxta_message_element *el = NULL;
+    Jxta_PA *client_PA;
+    Jxta_id *client_peerid = NULL;
+    Jxta_id *peerid;
+    Jxta_id *gid;
+    Jxta_PG *group;
+    JString *string;
+    _jxta_rdv_service_server *server;
+    _jxta_peer_client_entry *client;
+    Jxta_endpoint_address *destAddr;
+    Jxta_time_diff lease;
+    char leaseStr[64];
+    unsigned int i;
+    unsigned int count = 0;
+
+    reply = connect_reply_new(self);
+    elements = jxta_message_get_elements_of_namespace(msg, JXTA_RDV_NS_NAME);
+
+    for (i = 0; i < jxta_vector_size(elements); i++) {
+        jxta_vector_get_object_at(elements, JXTA_OBJECT_PPTR(&el), i);
+        if (0 != strcmp(jxta_message_element_get_name(el), JXTA_RDV_BATCH_CONNECT_REQUEST_ELEMENT_NAME)) {
+            JXTA_OBJECT_RELEASE(el);
+            continue;
+        }
+        client_PA = element_PA(el);
+        JXTA_OBJECT_RELEASE(el);
+
+        /* all the requests of a batch come from the same peer */
+        peerid = jxta_PA_get_PID(client_PA);
+        if (NULL == client_peerid) {
+            client_peerid = JXTA_OBJECT_SHARE(peerid);
+        } else if (!jxta_id_equals(client_peerid, peerid)) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Ignoring batched lease request for another peer.\n");
+            JXTA_OBJECT_RELEASE(peerid);
+            JXTA_OBJECT_RELEASE(client_PA);
+            continue;
+        }
+        JXTA_OBJECT_RELEASE(peerid);
+
+        gid = jxta_PA_get_GID(client_PA);
+        jxta_id_get_uniqueportion(gid, &string);
+        if (0 == strcmp(jstring_get_string(string), self->groupiduniq)) {
+            server = JXTA_OBJECT_SHARE(self);
+        } else if (JXTA_SUCCESS == jxta_lookup_group_instance(gid, &group)) {
+            server = (_jxta_rdv_service_server *) jxta_rdv_service_group_provider_priv(group, config_rendezvous, TRUE);
+            JXTA_OBJECT_RELEASE(group);
+        } else {
+            server = NULL;
+        }
+        JXTA_OBJECT_RELEASE(string);
+
+        lease = 0;
+        if (NULL != server) {
+            client = lease_grant(server, client_PA);
+            if (NULL != client) {
+                lease = server->OFFERED_LEASE_DURATION;
+                JXTA_OBJECT_RELEASE(client);
+            }
+            JXTA_OBJECT_RELEASE(server);
+        }
+
+        /* "<group id> <lease>" */
+        jxta_id_to_jstring(gid, &string);
+        apr_snprintf(leaseStr, sizeof(leaseStr), " %" APR_INT64_T_FMT, lease);
+        jstring_append_2(string, leaseStr);
+        el = jxta_message_element_new_2(JXTA_RDV_NS_NAME, JXTA_RDV_BATCH_LEASE_REPLY_ELEMENT_NAME,
+                                        "text/plain", jstring_get_string(string), jstring_length(string), NULL);
+        jxta_message_add_element(reply, el);
+        JXTA_OBJECT_RELEASE(el);
+        JXTA_OBJECT_RELEASE(string);
+        JXTA_OBJECT_RELEASE(gid);
         JXTA_OBJECT_RELEASE(client_PA);
+        count++;
     }
+    JXTA_OBJECT_RELEASE(elements);
+
+    if (NULL != client_peerid) {
+        jxta_id_get_uniqueportion(client_peerid, &string);
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Batched lease request for %u groups from %s.\n", count,
+                        jstring_get_string(string));
+        destAddr = jxta_endpoint_address_new_2("jxta", jstring_get_string(string), JXTA_RDV_SERVICE_NAME, self->groupiduniq);
+        JXTA_OBJECT_RELEASE(string);
+
+        res = connect_reply_send(self, reply, destAddr);
+
+        JXTA_OBJECT_RELEASE(destAddr);
+        JXTA_OBJECT_RELEASE(client_peerid);
+    }
+    JXTA_OBJECT_RELEASE(reply);
+
     return res;
 }
 
-static Jxta_status send_connect_reply(_jxta_rdv_service_server * self, _jxta_peer_client_entry * client)
+/**
+*   Build a lease reply message with the rendezvous advertisement and peer id of this peer.
+**/
+static Jxta_message *connect_reply_new(_jxta_rdv_service_server * self)
 {
-    Jxta_rdv_service_provider *provider = PTValid(self, _jxta_rdv_service_provider);
-    Jxta_status res = JXTA_SUCCESS;
     Jxta_message *msg = jxta_message_new();
     Jxta_message_element *el = NULL;
     JString *peerAdv = NULL;
-    Jxta_endpoint_address *destAddr = NULL;
-    char leaseStr[64];
 
     jxta_PA_get_xml(self->localPeerAdv, &peerAdv);
 
@@ -908,6 +1163,33 @@ static Jxta_status send_connect_reply(_jxta_rdv_service_server * self, _jxta_pee
     jxta_message_add_element(msg, el);
     JXTA_OBJECT_RELEASE(el);
 
+    return msg;
+}
+
+static Jxta_status connect_reply_send(_jxta_rdv_service_server * self, Jxta_message * msg, Jxta_endpoint_address * destAddr)
+{
+    Jxta_rdv_service_provider *provider = PTValid(self, _jxta_rdv_service_provider);
+    Jxta_status res;
+
+    res = jxta_endpoint_service_send(jxta_service_get_peergroup_priv((Jxta_service *) provider->service),
+                                     provider->service->endpoint, msg, destAddr);
+
+    if (res != JXTA_SUCCESS) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING,
+                        "Failed to send lease offer message. (%s)\n", jxta_endpoint_address_get_protocol_address(destAddr));
+    }
+
+    return res;
+}
+
+static Jxta_status send_connect_reply(_jxta_rdv_service_server * self, _jxta_peer_client_entry * client)
+{
+    Jxta_status res = JXTA_SUCCESS;
+    Jxta_message *msg = connect_reply_new(self);
+    Jxta_message_element *el = NULL;
+    Jxta_endpoint_address *destAddr = NULL;
+    char leaseStr[64];
+
     apr_snprintf(leaseStr, sizeof(leaseStr), "%" APR_INT64_T_FMT, self->OFFERED_LEASE_DURATION);
 
     el = jxta_message_element_new_2(JXTA_RDV_NS_NAME, JXTA_RDV_LEASE_REPLY_ELEMENT_NAME,
@@ -919,14 +1201,7 @@ static Jxta_status send_connect_reply(_jxta_rdv_service_server * self, _jxta_pee
                                            jxta_endpoint_address_get_protocol_address(((_jxta_peer_entry *) client)->address),
                                            JXTA_RDV_SERVICE_NAME, self->groupiduniq);
 
-    res = jxta_endpoint_service_send(jxta_service_get_peergroup_priv((Jxta_service *) provider->service),
-                                     provider->service->endpoint, msg, destAddr);
-
-    if (res != JXTA_SUCCESS) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING,
-                        "Failed to send lease offer message. (%s)\n",
-                        jxta_endpoint_address_get_protocol_address(((_jxta_peer_entry *) client)->address));
-    }
+    res = connect_reply_send(self, msg, destAddr);
 
     JXTA_OBJECT_RELEASE(destAddr);
     JXTA_OBJECT_RELEASE(msg);
@@ -934,96 +1209,113 @@ static Jxta_status send_connect_reply(_jxta_rdv_service_server * self, _jxta_pee
     return res;
 }
 
-/**
- *  The entry point to the periodic thread which manages peer connections.
- **/
-static void *APR_THREAD_FUNC periodic_thread_main(apr_thread_t * thread, void *arg)
+/* put the lease in the timer wheel slot of its expiration, must be called with mutex held */
+static void lease_schedule(_jxta_rdv_service_server * self, _jxta_peer_client_entry * client)
 {
-    Jxta_rdv_service_provider *provider = PTValid(arg, _jxta_rdv_service_provider);
-    _jxta_rdv_service_server *self = PTValid(arg, _jxta_rdv_service_server);
-    Jxta_status res;
-    Jxta_transport *transport = NULL;
-    int delay_count = 0;
+    int slot = (int) ((jxta_peer_get_expires((Jxta_peer *) client) / LEASE_WHEEL_TICK) & (LEASE_WHEEL_SLOTS - 1));
 
-    apr_thread_mutex_lock(self->periodicMutex);
+    APR_RING_INSERT_TAIL(&self->lease_wheel[slot], client, _jxta_peer_client_entry, timer);
+}
 
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Rendezvous Server periodic thread [TID %pp] started.\n",
-                    apr_os_thread_current());
+/* take the lease off the timer wheel, must be called with mutex held */
+static void lease_unschedule(_jxta_peer_client_entry * client)
+{
+    if (NULL != APR_RING_NEXT(client, timer)) {
+        APR_RING_REMOVE(client, timer);
+        APR_RING_NEXT(client, timer) = NULL;
+    }
+}
 
-    /*
-     * FIXME 20040607  tra
-     * We need to artificially delay the RDV service in case
-     * we do have a relay transport. The relay transport should be the
-     * first service to initiate the connection so the Relay server
-     * can catch the incoming connection and keep it as a relay
-     * connection
-     */
+/* run the lease review on the next tick while there are clients, must be called with mutex held */
+static void lease_timer_arm(_jxta_rdv_service_server * self)
+{
+    Jxta_rdv_service_provider *provider = (Jxta_rdv_service_provider *) self;
 
-    transport = jxta_endpoint_service_lookup_transport(provider->service->endpoint, "jxta");
-    if (transport != NULL) {
-        res = apr_thread_cond_timedwait(self->periodicCond, self->periodicMutex,
-                                        jxta_RdvConfig_get_connect_cycle_normal(self->rdvConfig) * 1000);
-        JXTA_OBJECT_RELEASE(transport);
+    if (self->lease_timer_armed || 0 == self->clients_count || !self->running) {
+        return;
+    }
+    if (APR_SUCCESS == apr_thread_pool_schedule(jxta_PG_thread_pool_get(jxta_service_get_peergroup_priv
+                                                                        ((Jxta_service *) provider->service)), lease_timer,
+                                                self, (apr_interval_time_t) LEASE_WHEEL_TICK * 1000, self)) {
+        self->lease_timer_armed = TRUE;
     }
+}
 
-    /*
-     * exponential backoff delay to avoid constant
-     * retry to RDV seed.
-     */
-    delay_count = 1;
-    /* Main loop */
-    while (self->running) {
-        Jxta_vector *clients = jxta_hashtable_values_get(self->clients);
-        unsigned int sz = jxta_vector_size(clients);
-        unsigned int i;
-
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Rendezvous Server periodic thread [TID %pp] RUN.\n",
-                        apr_os_thread_current());
-
-        for (i = 0; i < sz; i++) {
-            _jxta_peer_client_entry *peer;
-
-            res = jxta_vector_get_object_at(clients, JXTA_OBJECT_PPTR(&peer), i);
-            if (res != JXTA_SUCCESS) {
-                /* We should print a LOG here. Just continue for the time being */
-                continue;
-            }
+/**
+*   Grant or extend the lease of a client and move it to the timer wheel slot of its new expiration.
+**/
+static void lease_renew(_jxta_rdv_service_server * self, _jxta_peer_client_entry * client)
+{
+    apr_thread_mutex_lock(self->mutex);
+    jxta_peer_set_expires((Jxta_peer *) client, jpr_time_now() + self->OFFERED_LEASE_DURATION);
+    lease_unschedule(client);
+    lease_schedule(self, client);
+    lease_timer_arm(self);
+    apr_thread_mutex_unlock(self->mutex);
+}
 
-            if (!check_peer_lease(peer)) {
-                /** No lease left. Get rid of this peer **/
-                JString *uniq;
-
-                jxta_id_get_uniqueportion(jxta_peer_get_peerid_priv((Jxta_peer *) peer), &uniq);
-                res = jxta_hashtable_del(self->clients, jstring_get_string(uniq), jstring_length(uniq) + 1, NULL);
-                JXTA_OBJECT_RELEASE(uniq);
-                jxta_rdv_generate_event((_jxta_rdv_service *)
-                                        jxta_rdv_service_provider_get_service_priv((_jxta_rdv_service_provider *) self),
-                                        JXTA_RDV_CLIENT_DISCONNECTED, jxta_peer_get_peerid_priv((Jxta_peer *) peer));
-            }
+/**
+ * Get rid of the clients whose lease expired since the last review. Only the timer wheel slots of the ticks elapsed since then
+ * are visited and only the due leases are touched. The disconnect events are generated outside of the lock.
+ **/
+static void *APR_THREAD_FUNC lease_timer(apr_thread_t * thread, void *arg)
+{
+    _jxta_rdv_service_server *self = PTValid(arg, _jxta_rdv_service_server);
+    APR_RING_HEAD(lease_due, _jxta_peer_client_entry) due;
+    _jxta_peer_client_entry *client;
+    _jxta_peer_client_entry *next;
+    Jxta_time now;
+    apr_int64_t tick;
+    apr_int64_t tick_now;
+    int slot;
+
+    APR_RING_INIT(&due, _jxta_peer_client_entry, timer);
+
+    apr_thread_mutex_lock(self->mutex);
+    self->lease_timer_armed = FALSE;
+    if (!self->running) {
+        apr_thread_mutex_unlock(self->mutex);
+        return NULL;
+    }
 
-            JXTA_OBJECT_RELEASE(peer);
+    now = jpr_time_now();
+    tick_now = now / LEASE_WHEEL_TICK;
+    tick = self->lease_tick;
+    if (tick_now - tick >= LEASE_WHEEL_SLOTS) {
+        tick = tick_now - LEASE_WHEEL_SLOTS + 1;
+    }
+    for (; tick <= tick_now; tick++) {
+        slot = (int) (tick & (LEASE_WHEEL_SLOTS - 1));
+        for (client = APR_RING_FIRST(&self->lease_wheel[slot]);
+             client != APR_RING_SENTINEL(&self->lease_wheel[slot], _jxta_peer_client_entry, timer); client = next) {
+            next = APR_RING_NEXT(client, timer);
+            if (jxta_peer_get_expires((Jxta_peer *) client) <= now) {
+                APR_RING_REMOVE(client, timer);
+                /* the reference of the table moves to the due list */
+                jxta_objecthashtable_del(self->clients, (Jxta_object *) jxta_peer_get_peerid_priv((Jxta_peer *) client),
+                                         JXTA_OBJECT_PPTR(&client));
+                self->clients_count--;
+                APR_RING_INSERT_TAIL(&due, client, _jxta_peer_client_entry, timer);
+            }
         }
-
-        JXTA_OBJECT_RELEASE(clients);
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Rendezvous Server periodic thread [TID %pp] RUN DONE.\n",
-                        apr_os_thread_current());
-
-        /*
-         * Wait for a while until the next iteration.
-         */
-        res = apr_thread_cond_timedwait(self->periodicCond, self->periodicMutex,
-                                        jxta_RdvConfig_get_connect_cycle_normal(self->rdvConfig) * 1000);
+    }
+    /* the current tick is visited again by the next review for the leases expiring later in the tick */
+    self->lease_tick = tick_now;
+    lease_timer_arm(self);
+    apr_thread_mutex_unlock(self->mutex);
+
+    while (!APR_RING_EMPTY(&due, _jxta_peer_client_entry, timer)) {
+        client = APR_RING_FIRST(&due);
+        APR_RING_REMOVE(client, timer);
+        APR_RING_NEXT(client, timer) = NULL;
+
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Lease of client [%pp] expired.\n", client);
+        jxta_rdv_generate_event((_jxta_rdv_service *)
+                                jxta_rdv_service_provider_get_service_priv((_jxta_rdv_service_provider *) self),
+                                JXTA_RDV_CLIENT_DISCONNECTED, jxta_peer_get_peerid_priv((Jxta_peer *) client));
+        JXTA_OBJECT_RELEASE(client);
     }
 
-    apr_thread_mutex_unlock(self->periodicMutex);
-
-    JXTA_OBJECT_RELEASE(self);
-
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Rendezvous Server periodic thread [TID %pp] stopping.\n", thread);
-
-    apr_thread_exit(thread, JXTA_SUCCESS);
-
-    /* NOTREACHED */
     return NULL;
 }
 
@@ -1066,6 +1358,12 @@ static Jxta_status get_peer(Jxta_rdv_service_provider * provider, Jxta_id * peer
     if( NULL == *peer ) {
         return JXTA_ITEM_NOTFOUND;
     }
+
+    if( !check_peer_lease((_jxta_peer_client_entry *) *peer) ) {
+        JXTA_OBJECT_RELEASE(*peer);
+        *peer = NULL;
+        return JXTA_ITEM_NOTFOUND;
+    }
     
     return JXTA_SUCCESS;
 }
@@ -1082,39 +1380,38 @@ static _jxta_peer_client_entry *get_peer_entry(_jxta_rdv_service_server * self,
     _jxta_peer_client_entry *peer = NULL;
     Jxta_status res = 0;
     Jxta_boolean found = FALSE;
-    JString *uniq;
-    size_t currentPeers;
-
-    jxta_id_get_uniqueportion(peerid, &uniq);
 
-    jxta_rdv_service_provider_lock_priv((Jxta_rdv_service_provider *) self);
+    apr_thread_mutex_lock(self->mutex);
 
-    res = jxta_hashtable_get(self->clients, jstring_get_string(uniq), jstring_length(uniq) + 1, JXTA_OBJECT_PPTR(&peer));
+    res = jxta_objecthashtable_get(self->clients, (Jxta_object *) peerid, JXTA_OBJECT_PPTR(&peer));
 
     found = res == JXTA_SUCCESS;
 
-    jxta_hashtable_stats(self->clients, NULL, &currentPeers, NULL, NULL, NULL);
-
-    if (!found && create && (self->MAX_CLIENTS > currentPeers)) {
+    if (!found && create && (self->MAX_CLIENTS > self->clients_count)) {
         /* We need to create a new _jxta_peer_rdv_entry */
         peer = client_entry_new();
         if (peer == NULL) {
             jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "Cannot create a _jxta_peer_rdv_entry\n");
         } else {
-            Jxta_endpoint_address *clientAddr = jxta_endpoint_address_new_2("jxta", jstring_get_string(uniq), NULL, NULL);
+            JString *uniq;
+            Jxta_endpoint_address *clientAddr;
+
+            jxta_id_get_uniqueportion(peerid, &uniq);
+            clientAddr = jxta_endpoint_address_new_2("jxta", jstring_get_string(uniq), NULL, NULL);
+            JXTA_OBJECT_RELEASE(uniq);
 
             jxta_peer_set_address((Jxta_peer *) peer, clientAddr);
             jxta_peer_set_peerid((Jxta_peer *) peer, peerid);
             jxta_peer_set_expires((Jxta_peer *) peer, JPR_ABSOLUTE_TIME_MAX);
 
-            jxta_hashtable_put(self->clients, jstring_get_string(uniq), jstring_length(uniq) + 1, (Jxta_object *) peer);
+            jxta_objecthashtable_put(self->clients, (Jxta_object *) jxta_peer_get_peerid_priv((Jxta_peer *) peer),
+                                     (Jxta_object *) peer);
+            self->clients_count++;
             JXTA_OBJECT_RELEASE(clientAddr);
         }
     }
 
-    jxta_rdv_service_provider_unlock_priv((Jxta_rdv_service_provider *) self);
-
-    JXTA_OBJECT_RELEASE(uniq);
+    apr_thread_mutex_unlock(self->mutex);
 
     return peer;
 }
@@ -1144,6 +1441,7 @@ static Jxta_status JXTA_STDCALL walker_cb(Jxta_object * obj, void *me)
     int ttl;
     Jxta_endpoint_address *realDest = NULL;
     const char *svc_name = NULL;
+    const char *mime;
 
     assert(NULL != msg);
     JXTA_OBJECT_CHECK_VALID(msg);
@@ -1157,13 +1455,18 @@ static Jxta_status JXTA_STDCALL walker_cb(Jxta_object * obj, void *me)
     }
 
     bytes = jxta_message_element_get_value(el);
-    JXTA_OBJECT_RELEASE(el);
-    string = jstring_new_3(bytes);
-    JXTA_OBJECT_RELEASE(bytes);
     header = LimitedRangeRdvMessage_new();
-
-    res = LimitedRangeRdvMessage_parse_charbuffer(header, jstring_get_string(string), jstring_length(string));
-    JXTA_OBJECT_RELEASE(string);
+    mime = jxta_message_element_get_mime_type(el);
+    if (NULL != mime && 0 == strcmp(mime, LIMITEDRANGERDVMESSAGE_BINARY_MIME)) {
+        res = LimitedRangeRdvMessage_parse_binary(header, jxta_bytevector_content_ptr(bytes), jxta_bytevector_size(bytes));
+        JXTA_OBJECT_RELEASE(bytes);
+    } else {
+        string = jstring_new_3(bytes);
+        JXTA_OBJECT_RELEASE(bytes);
+        res = LimitedRangeRdvMessage_parse_charbuffer(header, jstring_get_string(string), jstring_length(string));
+        JXTA_OBJECT_RELEASE(string);
+    }
+    JXTA_OBJECT_RELEASE(el);
     if (JXTA_SUCCESS != res) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Failed parsing walker message[%pp] %d\n", msg, res);
         goto FINAL_EXIT;
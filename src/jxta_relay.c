@@ -71,10 +71,12 @@
 #include "jxta_svc.h"
 #include "jxta_relaya.h"
 #include "jxta_relay.h"
+#include "jxta_relay_private.h"
 #include "jxta_rdv.h"
 #include "jxta_routea.h"
 #include "jxta_apa.h"
 #include "jxta_vector.h"
+#include "jxta_hashtable.h"
 #include "jxta_object_type.h"
 #include "jxta_peer.h"
 #include "jxta_peer_private.h"
@@ -135,10 +137,26 @@ static const char *__log_cat = "RELAY";
  **/
 #define DEFAULT_MESSAGE_STORAGE_INTERVAL (ONE_SECOND_MILLI*60*10) /* 10 minutes */
 
-/* define the sleep time for the send messages thread to be related to the
- * message storage interval
- */
-#define SEND_MESSAGES_THREAD_SLEEP_TIME (MILLI_TO_MICRO*DEFAULT_MESSAGE_STORAGE_INTERVAL/5)
+/**
+ ** Number of pool tasks delivering stored messages at the same time, and
+ ** number of messages sent to a client before moving to the next one.
+ **/
+#define RELAY_DELIVERY_WORKERS 4
+#define RELAY_DELIVERY_BATCH 16
+
+/**
+ ** Delay before trying again to deliver to a client which could not be
+ ** reached, doubled on each failure.
+ **/
+#define RELAY_DELIVERY_RETRY_MIN (1 * ONE_SECOND_MILLI)
+#define RELAY_DELIVERY_RETRY_MAX (60 * ONE_SECOND_MILLI)
+
+/**
+ ** A delivery timer task running this close to timer_at is the current
+ ** one. Tasks scheduled for a time which was since moved earlier are stale
+ ** and end without running or scheduling the timer again.
+ **/
+#define RELAY_DELIVERY_TIMER_SLACK (ONE_SECOND_MILLI / 10)
 
 #define MESSAGE_CHECK_EXPIRY_INTERVAL (DEFAULT_MESSAGE_STORAGE_INTERVAL*2)
 
@@ -148,6 +166,17 @@ static const char *__log_cat = "RELAY";
 
 #define MAX_NUMBER_MESSAGES_PER_CLIENT 100
 
+/**
+ ** Bytes of messages the relay keeps in memory for all clients and for a
+ ** single client. Messages over budget are spilled to a file per client, up
+ ** to DEFAULT_LEASE_SPILL_MAX_BYTES, then dropped.
+ **/
+#define DEFAULT_ARCHIVE_MAX_BYTES (64 * 1024 * 1024)
+#define DEFAULT_LEASE_ARCHIVE_MAX_BYTES (256 * 1024)
+#define DEFAULT_LEASE_SPILL_MAX_BYTES (16 * 1024 * 1024)
+/* spill directory when the relay configuration has no spillDirectory */
+#define DEFAULT_ARCHIVE_SPILL_DIR ".relay"
+
 #define RELAY_NS "relay"
 
 #define DEFAULT_MAX_ALLOWED_LEASES 5000
@@ -196,13 +225,36 @@ struct _jxta_transport_relay {
     void *ep_cookie;
 
 	/*server entries*/
-	apr_thread_t *messages_thread;
-	apr_thread_cond_t *messages_cond;
+	apr_thread_pool_t *thread_pool;
+	/* protects the delivery queue and the retry times of the leases */
     apr_thread_mutex_t *messages_mutex;
-	volatile Jxta_boolean messages_thread_running;
-	Jxta_vector* leases;
+	volatile Jxta_boolean delivery_running;
+	/* leases with messages to deliver, served in turn */
+	APR_RING_HEAD(relay_ready_list, _relay_lease) ready_leases;
+	/* leases waiting for their retry time, in no particular order */
+	APR_RING_HEAD(relay_retry_list, _relay_lease) retry_leases;
+	int delivery_workers;
+	/* time the delivery timer is scheduled for, 0 if none */
+	Jxta_time timer_at;
+	Jxta_time message_expiry_checked;
+	Jxta_time lease_expiry_checked;
+	/* protects the lease table and the expiry order */
+	apr_thread_mutex_t *leases_mutex;
+	/* leases keyed by the peer id of the client */
+	Jxta_hashtable* leases;
+	/* the same leases, the first one to expire first */
+	APR_RING_HEAD(relay_expiry_list, _relay_lease) expiry_leases;
+	unsigned long leases_count;
 	unsigned long max_leases_allowed;
-	Jxta_boolean messages_new_arrivals;
+
+	/* message archive budget, protected by archive_mutex */
+	apr_thread_mutex_t *archive_mutex;
+	apr_size_t archive_max_bytes;
+	apr_size_t lease_archive_max_bytes;
+	apr_off_t lease_spill_max_bytes;
+	const char *spill_dir;
+	apr_uint32_t spill_seq;
+	Jxta_relay_archive_stats archive_stats;
 };
 
 typedef struct _jxta_transport_relay _jxta_transport_relay;
@@ -235,6 +287,28 @@ struct _relay_lease {
 	apr_thread_mutex_t *mutex;
 	Jxta_boolean messages_new_additions;
     int number_failed_sends;
+	/* a delivery task is sending the first stored message without the lease mutex */
+	Jxta_boolean sending;
+	/* in the lease table of the relay, ordered by expiry time */
+	APR_RING_ENTRY(_relay_lease) expiry_link;
+	/* in the delivery queue of the relay when ready, in the retry list when
+	 * retry_at is set. Either list holds a reference */
+	APR_RING_ENTRY(_relay_lease) ready_link;
+	Jxta_boolean ready;
+	/* time of the next delivery attempt after a failure, 0 if none */
+	Jxta_time retry_at;
+	Jxta_time_diff retry_delay;
+	/* the relay accounting for the archive, not shared */
+	_jxta_transport_relay *relay;
+	/* bytes of the messages in stored_messages */
+	apr_size_t stored_bytes;
+	/* messages over budget, appended to the file and replayed from spill_read once stored_messages is empty */
+	apr_file_t *spill;
+	char *spill_path;
+	apr_off_t spill_read;
+	apr_off_t spill_write;
+	/* messages between spill_read and spill_write */
+	apr_uint32_t spill_msgs;
 };
 
 struct _jxta_linked_list_node {
@@ -253,8 +327,16 @@ struct _stored_message {
 	Jxta_message * msg;
 	Jxta_time time_stored;
 	Jxta_time_diff storage_interval_length; 
+	apr_size_t size;
 };
 
+/* header of a message in a spill file, followed by the message in application/x-jxta-msg format */
+typedef struct _spill_record {
+	apr_int64_t time_stored;
+	apr_uint32_t size;
+	apr_uint32_t reserved;
+} _spill_record;
+
 
 
 /*********************************************************************
@@ -300,24 +382,32 @@ static _jxta_peer_relay_entry *relay_entry_construct(_jxta_peer_relay_entry * se
 static void relay_entry_destruct(_jxta_peer_relay_entry * self);
 static void check_for_lease_request(Jxta_message *msg, _jxta_transport_relay *self);
 static Jxta_status send_relay_lease(_jxta_transport_relay *self, Jxta_endpoint_address *client_address);
-static _relay_lease* relay_lease_new();
+static _relay_lease* relay_lease_new(_jxta_transport_relay* self);
 static void relay_lease_delete(Jxta_object * obj);
 static JxtaEndpointMessenger *get_messenger(Jxta_transport * t, Jxta_endpoint_address * dest);
 static void relay_messenger_delete(Jxta_object* obj);
 static _stored_message* stored_message_new(Jxta_message * msg,
-										   Jxta_time_diff storage_interval_length);
+										   Jxta_time_diff storage_interval_length, apr_size_t size);
 static void stored_message_delete(Jxta_object * obj);
 static Jxta_boolean message_has_expired(const _stored_message* stored_message);
 static Jxta_status archive_check_timeout(_jxta_transport_relay* self);
 static Jxta_vector* archive_get_all_messages(_jxta_transport_relay* self, JString* dest_pid);
-static Jxta_status archive_put_message_1(_relay_lease* jxta_lease_object, Jxta_message * msg);
+static Jxta_status archive_put_message_1(_jxta_transport_relay* self, _relay_lease* jxta_lease_object, Jxta_message * msg);
+static void archive_remove_message(_relay_lease* relay_lease, _stored_message* stored_message);
+static int archive_load_spill(_relay_lease* relay_lease);
+static void archive_close_spill(_relay_lease* relay_lease);
 static Jxta_status archive_put_message(_jxta_transport_relay* self, Jxta_message * msg, JString* dest_pid);
 static _relay_lease* find_relay_lease(_jxta_transport_relay* self, JString* dest_pid);
 static Jxta_status relay_send_all_messages(_jxta_transport_relay* self, JString* dest_pid);
-static void *APR_THREAD_FUNC send_messages_thread(apr_thread_t * thread, void *arg);
-static Jxta_status relay_send_all_messages_1(_jxta_transport_relay* self, _relay_lease* relay_lease);
+static void relay_delivery_schedule(_jxta_transport_relay* self, _relay_lease* relay_lease, Jxta_boolean now);
+static void *APR_THREAD_FUNC relay_delivery_task(apr_thread_t * thread, void *arg);
+static void *APR_THREAD_FUNC relay_delivery_timer(apr_thread_t * thread, void *arg);
+static Jxta_status relay_send_all_messages_1(_jxta_transport_relay* self, _relay_lease* relay_lease, int max);
 static Jxta_boolean lease_is_valid(_relay_lease* relay_lease);
+static Jxta_status lease_add(_jxta_transport_relay* self, _relay_lease* relay_lease);
+static void lease_renew(_jxta_transport_relay* self, _relay_lease* relay_lease);
 static Jxta_status lease_delete(_jxta_transport_relay* self, JString* lease_uid);
+static Jxta_vector* leases_get(_jxta_transport_relay* self);
 static Jxta_status leases_remove_expired(_jxta_transport_relay* self);
 static Jxta_RdvAdvertisement *jxta_relay_build_rdva(Jxta_PG * group, JString * serviceName);
 Jxta_Linked_List_Node* linked_list_init_single_item(Jxta_Linked_List_Node *node);
@@ -399,6 +489,7 @@ static Jxta_status relay_messenger_send(JxtaEndpointMessenger * mes, Jxta_messag
 	cloned_message=jxta_message_clone(msg);
 	if (!cloned_message) {
 		jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "Failed to create a copy of the message\n");
+		JXTA_OBJECT_RELEASE(dest_relay);
 		return JXTA_FAILED;
 	}
 
@@ -407,17 +498,12 @@ static Jxta_status relay_messenger_send(JxtaEndpointMessenger * mes, Jxta_messag
 							relay_messenger->dest_pid)!=JXTA_SUCCESS) {
 		jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Failed to add message to relay message vector in messenger\n");
 		JXTA_OBJECT_RELEASE(cloned_message);
+		JXTA_OBJECT_RELEASE(dest_relay);
 		return JXTA_FAILED;
 	}
 
-	apr_thread_mutex_lock(relay_messenger->jxta_transport_relay->messages_mutex);
-	relay_messenger->jxta_transport_relay->messages_new_arrivals=TRUE;
-	apr_thread_mutex_unlock(relay_messenger->jxta_transport_relay->messages_mutex);
-
 	JXTA_OBJECT_RELEASE(cloned_message);
 
-	apr_thread_cond_signal(relay_messenger->jxta_transport_relay->messages_cond);
-
 	JXTA_OBJECT_RELEASE(dest_relay);
 				
 	return JXTA_SUCCESS;
@@ -427,25 +513,46 @@ static Jxta_status relay_send_all_messages(_jxta_transport_relay* self, JString*
 {
 	_relay_lease* relay_lease = NULL;
 
+	Jxta_status status;
+
 	/*get the lease for the given pid*/
 	relay_lease=find_relay_lease(self,dest_pid);
 
-	return relay_send_all_messages_1(self,relay_lease);
+	status=relay_send_all_messages_1(self,relay_lease,0);
+	if (relay_lease) {
+		JXTA_OBJECT_RELEASE(relay_lease);
+	}
+	return status;
 }
 
 
-static Jxta_status relay_send_all_messages_1(_jxta_transport_relay* self, _relay_lease* relay_lease)
+/************************************************************************
+ * Send the messages stored for a client, in order. The lease mutex is
+ * not held while getting a messenger and sending, which may block on a
+ * client that cannot be reached: messages are stored for the client
+ * meanwhile. The first stored message is only removed once sent, a task
+ * finding another one sending for the lease leaves the messages to it.
+ *
+ *
+ * @param  self the relay
+ * @param  relay_lease the lease of the client
+ * @param  max the maximum number of messages to send, 0 for all
+ * @return JXTA_SUCCESS if all messages were sent, JXTA_BUSY if there are
+ *         more messages to send, JXTA_UNREACHABLE_DEST if the client could
+ *         not be reached
+ *************************************************************************/
+static Jxta_status relay_send_all_messages_1(_jxta_transport_relay* self, _relay_lease* relay_lease, int max)
 {
 	Jxta_transport *transport = NULL;
 	/* the new transport over which to send the message */
 	JxtaEndpointMessenger* endpoint_messenger=NULL;
-	/*_stored_message* stored_message=NULL;*/
 	Jxta_endpoint_address *src_addr = NULL;
 	Jxta_endpoint_address *dest_addr = NULL;
-    Jxta_boolean keep_sending=TRUE;
-	Jxta_boolean delete_message=FALSE;
-	_stored_message* head=NULL;
-	_stored_message* next=NULL;
+	Jxta_boolean keep_sending=TRUE;
+	_stored_message* current=NULL;
+	Jxta_message* msg=NULL;
+	Jxta_status status=JXTA_SUCCESS;
+	int sent=0;
 
 	if (!relay_lease) {
 		jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Failed to find a lease for the given pid\n");
@@ -454,82 +561,101 @@ static Jxta_status relay_send_all_messages_1(_jxta_transport_relay* self, _relay
 
 	apr_thread_mutex_lock(relay_lease->mutex);
 
-	head=relay_lease->stored_messages;
-
-	/* if there are no messages */
-	if (head==NULL) {
+	if (relay_lease->sending) {
 		apr_thread_mutex_unlock(relay_lease->mutex);
 		return JXTA_SUCCESS;
 	}
+	relay_lease->sending=TRUE;
 
-	next=(_stored_message*)linked_list_right(JXTA_LINKED_LIST_NODE(relay_lease->stored_messages));
+	/* send the messages in the order they were stored, the spilled ones after the ones in memory */
+	while (keep_sending) {
+		if (max > 0 && sent >= max) {
+			status=JXTA_BUSY;
+			break;
+		}
+		current=relay_lease->stored_messages;
+		if (NULL == current) {
+			if (0 == archive_load_spill(relay_lease)) {
+				break;
+			}
+			continue;
+		}
 
-	do {
-		_stored_message* current=next;
-		next=(_stored_message*)linked_list_right(JXTA_LINKED_LIST_NODE(current));
+		if (message_has_expired(current)) {
+			archive_remove_message(relay_lease, current);
+			continue;
+		}
 
-		if (!message_has_expired(current)) {
+		/* the message stays first in the list while it is sent, the expiry check may still remove it */
+		JXTA_OBJECT_SHARE(current);
+		msg=JXTA_OBJECT_SHARE(current->msg);
+		apr_thread_mutex_unlock(relay_lease->mutex);
 
-			dest_addr=jxta_message_get_destination(current->msg);
+		dest_addr=jxta_message_get_destination(msg);
 
-			/* get the transport based on the destination address */
-			transport = jxta_endpoint_service_lookup_transport(self->endpoint, jxta_endpoint_address_get_protocol_name(dest_addr));
-			/* get the end point messenger which will take care of sending the message */
-			endpoint_messenger = jxta_transport_messenger_get(transport, dest_addr);
-            
-			if (endpoint_messenger) {
-				JXTA_OBJECT_CHECK_VALID(endpoint_messenger);
-				
-				src_addr = jxta_transport_publicaddr_get(transport);
-
-				jxta_message_set_source(current->msg, src_addr);
-		        
-				/* try to send the message */
-				if (endpoint_messenger->jxta_send(endpoint_messenger, current->msg)==JXTA_SUCCESS) {
-					jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Relay message sent over alternative transport\n");
-					delete_message=TRUE;
-                    /* since was able to send the message, reset the number of failures */
-                    relay_lease->number_failed_sends=0;
-				}
-				else
-				{
-                    relay_lease->number_failed_sends++;
-					jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "The transport picked by the relay was not able to send the message\n");
-				} /* if (endpoint_messenger->jxta_send(endpoint_messenger, stored_message->msg)==JXTA_SUCCESS) */
+		/* get the transport based on the destination address */
+		transport = jxta_endpoint_service_lookup_transport(self->endpoint, jxta_endpoint_address_get_protocol_name(dest_addr));
+		/* get the end point messenger which will take care of sending the message */
+		endpoint_messenger = (NULL == transport) ? NULL : jxta_transport_messenger_get(transport, dest_addr);
 
-				JXTA_OBJECT_RELEASE(src_addr);
-				
-			} else {
-                /* if could not create a messenger for this message, not likely
-                 * will be able to create it for next message, stop sending to
-                 * this client */
-                keep_sending=FALSE;
-                relay_lease->number_failed_sends++;
-				jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Could not create a messenger\n");
-			} /* if (endpoint_messenger) */
+		if (endpoint_messenger) {
+			JXTA_OBJECT_CHECK_VALID(endpoint_messenger);
 
+			src_addr = jxta_transport_publicaddr_get(transport);
 
-			JXTA_OBJECT_RELEASE(dest_addr);
+			jxta_message_set_source(msg, src_addr);
 
-		} /* if (!message_has_expired(stored_message) */
-		else {
-			delete_message=TRUE;
-		}
+			/* try to send the message */
+			if (endpoint_messenger->jxta_send(endpoint_messenger, msg)==JXTA_SUCCESS) {
+				jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Relay message sent over alternative transport\n");
+			}
+			else
+			{
+				/* keep the message and the ones after it for the next attempt */
+				keep_sending=FALSE;
+				jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "The transport picked by the relay was not able to send the message\n");
+			} /* if (endpoint_messenger->jxta_send(endpoint_messenger, msg)==JXTA_SUCCESS) */
 
-		if (delete_message) {
-			linked_list_remove(JXTA_LINKED_LIST_NODE(current),JXTA_LINKED_LIST_NODE_PPTR(&relay_lease->stored_messages));
-            relay_lease->total_stored--;
+			JXTA_OBJECT_RELEASE(src_addr);
+			JXTA_OBJECT_RELEASE(endpoint_messenger);
 
-			JXTA_OBJECT_RELEASE(current);
+		} else {
+			/* if could not create a messenger for this message, not likely
+			 * will be able to create it for next message, stop sending to
+			 * this client */
+			keep_sending=FALSE;
+			jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Could not create a messenger\n");
+		} /* if (endpoint_messenger) */
+
+		if (NULL != transport) {
+			JXTA_OBJECT_RELEASE(transport);
 		}
+		JXTA_OBJECT_RELEASE(dest_addr);
+		JXTA_OBJECT_RELEASE(msg);
+
+		apr_thread_mutex_lock(relay_lease->mutex);
+		if (keep_sending) {
+			/* since was able to send the message, reset the number of failures */
+			relay_lease->number_failed_sends=0;
+			if (relay_lease->stored_messages == current) {
+				archive_remove_message(relay_lease, current);
+			}
+			sent++;
+		} else {
+			relay_lease->number_failed_sends++;
+			status=JXTA_UNREACHABLE_DEST;
+		}
+		JXTA_OBJECT_RELEASE(current);
+	}
 
-	} while (keep_sending && head!=next);
-
-	relay_lease->messages_new_additions=FALSE;
+	if (JXTA_BUSY != status) {
+		relay_lease->messages_new_additions=FALSE;
+	}
+	relay_lease->sending=FALSE;
 
 	apr_thread_mutex_unlock(relay_lease->mutex);
 
-	return JXTA_SUCCESS;
+	return status;
 }
 
 /************************************************************************
@@ -624,10 +750,16 @@ static JxtaEndpointMessenger *get_messenger(Jxta_transport * t, Jxta_endpoint_ad
 	if (tmp_relay_lease) {
 		/* make sure the lease is not expired */
 		if (lease_is_valid(tmp_relay_lease)) {
-			return (JxtaEndpointMessenger*)relay_messenger_new(self,tmp_relay_lease->lease_requestor_id,tmp_relay_lease->lease_requestor_address);
+			JxtaEndpointMessenger* messenger;
+
+			messenger=(JxtaEndpointMessenger*)relay_messenger_new(self,tmp_relay_lease->lease_requestor_id,tmp_relay_lease->lease_requestor_address);
+			JXTA_OBJECT_RELEASE(tmp_relay_lease);
+			JXTA_OBJECT_RELEASE(local_jstring);
+			return messenger;
 		} else {
 			lease_delete(self,local_jstring);
 		}
+		JXTA_OBJECT_RELEASE(tmp_relay_lease);
 	}
 
 	JXTA_OBJECT_RELEASE(local_jstring);
@@ -680,6 +812,50 @@ static _jxta_peer_relay_entry *relay_entry_new(void)
     return relay_entry_construct(self);
 }
 
+/*
+ * Create the pool, locks and conditions of the relay
+ */
+static apr_status_t relay_locks_create(_jxta_transport_relay * self)
+{
+    apr_status_t res;
+
+    /* Allocate a pool for our apr needs */
+    res = apr_pool_create(&self->pool, NULL);
+    if (res != APR_SUCCESS)
+        return res;
+
+    /*
+     * Create our mutex.
+     */
+    res = apr_thread_mutex_create(&(self->stop_mutex), APR_THREAD_MUTEX_DEFAULT, self->pool);
+    if (res != APR_SUCCESS)
+        return res;
+
+    res = apr_thread_cond_create(&(self->stop_cond), self->pool);
+    if (res != APR_SUCCESS) {
+        return res;
+    }
+
+    res = apr_thread_mutex_create(&(self->messages_mutex), APR_THREAD_MUTEX_DEFAULT, self->pool);
+    if (res != APR_SUCCESS)
+        return res;
+
+    /*res = apr_thread_mutex_create(&(self->messages_access_mutex), APR_THREAD_MUTEX_DEFAULT, self->pool);
+    if (res != APR_SUCCESS)
+        return res;*/
+
+    res = apr_thread_mutex_create(&(self->leases_mutex), APR_THREAD_MUTEX_DEFAULT, self->pool);
+    if (res != APR_SUCCESS) {
+        return res;
+    }
+
+    res = apr_thread_mutex_create(&(self->archive_mutex), APR_THREAD_MUTEX_DEFAULT, self->pool);
+    if (res != APR_SUCCESS)
+        return res;
+
+    return APR_SUCCESS;
+}
+
 /*
  * Init the Relay service
  */
@@ -715,37 +891,10 @@ static Jxta_status init(Jxta_module * module, Jxta_PG * group, Jxta_id * assigne
 
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Initializing ...\n");
 
-    /* Allocate a pool for our apr needs */
-    res = apr_pool_create(&self->pool, NULL);
+    res = relay_locks_create(self);
     if (res != APR_SUCCESS)
         return res;
 
-    /*
-     * Create our mutex.
-     */
-    res = apr_thread_mutex_create(&(self->stop_mutex), APR_THREAD_MUTEX_DEFAULT, self->pool);
-    if (res != APR_SUCCESS)
-        return res;
-
-    res = apr_thread_cond_create(&(self->stop_cond), self->pool);
-    if (res != APR_SUCCESS) {
-        return res;
-    }
-
-    res = apr_thread_mutex_create(&(self->messages_mutex), APR_THREAD_MUTEX_DEFAULT, self->pool);
-    if (res != APR_SUCCESS)
-        return res;
-
-    /*res = apr_thread_mutex_create(&(self->messages_access_mutex), APR_THREAD_MUTEX_DEFAULT, self->pool);
-    if (res != APR_SUCCESS)
-        return res;*/
-
-    res = apr_thread_cond_create(&(self->messages_cond), self->pool);
-    if (res != APR_SUCCESS) {
-        return res;
-    }
-
-
     /*
      * following falls-back on backdoor config if needed only.
      * So it can be just be removed when nolonger usefull.
@@ -786,6 +935,11 @@ static Jxta_status init(Jxta_module * module, Jxta_PG * group, Jxta_id * assigne
 
 	/* set the default values */
 	self->max_leases_allowed=DEFAULT_MAX_ALLOWED_LEASES;
+	self->archive_max_bytes=DEFAULT_ARCHIVE_MAX_BYTES;
+	self->lease_archive_max_bytes=DEFAULT_LEASE_ARCHIVE_MAX_BYTES;
+	self->lease_spill_max_bytes=DEFAULT_LEASE_SPILL_MAX_BYTES;
+	self->spill_dir=DEFAULT_ARCHIVE_SPILL_DIR;
+	memset(&self->archive_stats, 0, sizeof(self->archive_stats));
 
     val = jxta_RelayAdvertisement_get_IsServer(rla);
     if (strcmp(jstring_get_string(val), "true") == 0) {
@@ -810,6 +964,12 @@ static Jxta_status init(Jxta_module * module, Jxta_PG * group, Jxta_id * assigne
     }
     JXTA_OBJECT_RELEASE(relays);
 
+    val = jxta_RelayAdvertisement_get_SpillDirectory(rla);
+    if (jstring_length(val) > 0) {
+        self->spill_dir = apr_pstrdup(self->pool, jstring_get_string(val));
+    }
+    JXTA_OBJECT_RELEASE(val);
+
     relays = jxta_RelayAdvertisement_get_TcpRelay(rla);
     JXTA_OBJECT_RELEASE(rla);
     if (jxta_vector_clone(relays, &(self->TcpRelays), 0, 20) != JXTA_SUCCESS) {
@@ -898,7 +1058,12 @@ static Jxta_status init(Jxta_module * module, Jxta_PG * group, Jxta_id * assigne
         JXTA_OBJECT_RELEASE(relay);
     }
 
-	self->messages_new_arrivals=FALSE;
+	APR_RING_INIT(&self->ready_leases, _relay_lease, ready_link);
+	APR_RING_INIT(&self->retry_leases, _relay_lease, ready_link);
+	APR_RING_INIT(&self->expiry_leases, _relay_lease, expiry_link);
+	self->leases_count=0;
+	self->delivery_workers=0;
+	self->timer_at=0;
 
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Initialized\n");
     return JXTA_SUCCESS;
@@ -945,10 +1110,23 @@ static Jxta_status start(Jxta_module * module, const char *argv[])
 		Jxta_discovery_service *discovery = NULL;
 		Jxta_RdvAdvertisement* rdv_advertisement = NULL;
 
-		self->leases=jxta_vector_new(10);
+		self->leases=jxta_hashtable_new_0(DEFAULT_MAX_ALLOWED_LEASES, FALSE);
+
+		/* messages over the archive budget are spilled in this directory */
+		if (APR_SUCCESS != apr_dir_make_recursive(self->spill_dir, APR_OS_DEFAULT, self->pool)) {
+			jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Unable to create relay spill directory %s\n", self->spill_dir);
+		}
 
-		apr_thread_create(&self->messages_thread, NULL,  /* no attr */
-						send_messages_thread, (void *) self, (apr_pool_t *) self->pool);
+		/* stored messages are delivered by pool tasks when they are archived or the client reconnects */
+		self->thread_pool=jxta_PG_thread_pool_get(self->group);
+		self->message_expiry_checked=jpr_time_now();
+		self->lease_expiry_checked=jpr_time_now();
+		self->delivery_running=TRUE;
+		apr_thread_mutex_lock(self->messages_mutex);
+		self->timer_at=jpr_time_now()+LEASE_CHECK_EXPIRY_INTERVAL;
+		apr_thread_mutex_unlock(self->messages_mutex);
+		apr_thread_pool_schedule(self->thread_pool, relay_delivery_timer, self,
+								 (apr_interval_time_t) LEASE_CHECK_EXPIRY_INTERVAL * MILLI_TO_MICRO, self);
 
 		/* publish the relay service advertisement */
 		jxta_PG_get_discovery_service(self->group, &discovery);
@@ -1011,16 +1189,28 @@ static void stop(Jxta_module * module)
     apr_thread_join(&status, self->thread);
 	}
 
-	/* if messages thread is running stop it */
-	if (self->messages_thread_running == TRUE) {
-		jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Signal messages thread to exit...\n");
+	/* stop delivering stored messages */
+	if (self->delivery_running == TRUE) {
+		jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Cancel message delivery tasks...\n");
+		self->delivery_running = FALSE;
+		apr_thread_pool_tasks_cancel(self->thread_pool, self);
+
 		apr_thread_mutex_lock(self->messages_mutex);
-		self->messages_thread_running = FALSE;
-		apr_thread_cond_signal(self->messages_cond);
+		while (!APR_RING_EMPTY(&self->ready_leases, _relay_lease, ready_link)) {
+			_relay_lease* relay_lease = APR_RING_FIRST(&self->ready_leases);
+			APR_RING_REMOVE(relay_lease, ready_link);
+			relay_lease->ready = FALSE;
+			JXTA_OBJECT_RELEASE(relay_lease);
+		}
+		while (!APR_RING_EMPTY(&self->retry_leases, _relay_lease, ready_link)) {
+			_relay_lease* relay_lease = APR_RING_FIRST(&self->retry_leases);
+			APR_RING_REMOVE(relay_lease, ready_link);
+			relay_lease->retry_at = 0;
+			JXTA_OBJECT_RELEASE(relay_lease);
+		}
+		self->delivery_workers = 0;
+		self->timer_at = 0;
 		apr_thread_mutex_unlock(self->messages_mutex);
-
-		jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Waiting thread to exit...\n");
-		apr_thread_join(&status, self->messages_thread);
 	}
 
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Relay stopped.\n");
@@ -1125,11 +1315,12 @@ _jxta_transport_relay *jxta_transport_relay_construct(Jxta_transport * relay, Jx
         self->TcpRelays = NULL;
 		/* server variables */
 		self->leases=NULL;
-		self->messages_cond=NULL;
+		self->leases_mutex=NULL;
 		self->messages_mutex=NULL;
 		/*self->messages_access_mutex;*/
-		self->messages_thread=NULL;
-		self->messages_thread_running=FALSE;
+		self->thread_pool=NULL;
+		self->delivery_running=FALSE;
+		self->archive_mutex=NULL;
         self->peers = jxta_vector_new(1);
         if (self->peers == NULL) {
             return NULL;
@@ -1178,6 +1369,7 @@ void jxta_transport_relay_destruct(_jxta_transport_relay * self)
 	/* Relay server */
 
 	if (self->leases!= NULL) {
+		APR_RING_INIT(&self->expiry_leases, _relay_lease, expiry_link);
 		JXTA_OBJECT_RELEASE(self->leases);
     }
 	/*****************/
@@ -1185,8 +1377,13 @@ void jxta_transport_relay_destruct(_jxta_transport_relay * self)
     apr_thread_cond_destroy(self->stop_cond);
     apr_thread_mutex_destroy(self->stop_mutex);
 
-	apr_thread_cond_destroy(self->messages_cond);
     apr_thread_mutex_destroy(self->messages_mutex);
+	if (self->leases_mutex) {
+		apr_thread_mutex_destroy(self->leases_mutex);
+	}
+	if (self->archive_mutex) {
+		apr_thread_mutex_destroy(self->archive_mutex);
+	}
 	/*apr_thread_mutex_destroy(self->messages_access_mutex);*/
 
     if (self->pool) {
@@ -1939,105 +2136,208 @@ static void *APR_THREAD_FUNC connect_relay_thread(apr_thread_t * thread, void *a
 
 
 /************************************************************************
- * Entry point for a thread responsible for periodically trying to send
- * out all the stored messages
+ * Start delivery tasks while there are leases waiting and fewer than
+ * RELAY_DELIVERY_WORKERS tasks are running. Must be called with
+ * messages_mutex held.
+ *
+ *
+ * @param  self the relay
+ *************************************************************************/
+static void relay_delivery_kick_locked(_jxta_transport_relay* self)
+{
+	while (self->delivery_running && self->delivery_workers < RELAY_DELIVERY_WORKERS
+		   && !APR_RING_EMPTY(&self->ready_leases, _relay_lease, ready_link)) {
+		if (APR_SUCCESS != apr_thread_pool_push(self->thread_pool, relay_delivery_task, self,
+												APR_THREAD_TASK_PRIORITY_NORMAL, self)) {
+			jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Failed to start message delivery task\n");
+			break;
+		}
+		self->delivery_workers++;
+	}
+}
+
+/************************************************************************
+ * Make sure the delivery timer runs no later than the given time. The
+ * task scheduled for a later time, if any, stays in the pool and ends
+ * without doing anything when it runs. Must be called with
+ * messages_mutex held.
  *
  *
- * @param  thread the thread to start
+ * @param  self the relay
+ * @param  when the time the timer should run
+ *************************************************************************/
+static void relay_delivery_timer_arm_locked(_jxta_transport_relay* self, Jxta_time when)
+{
+	Jxta_time now = jpr_time_now();
+
+	if (!self->delivery_running || (0 != self->timer_at && self->timer_at <= when)) {
+		return;
+	}
+	self->timer_at = when;
+	apr_thread_pool_schedule(self->thread_pool, relay_delivery_timer, self,
+							 (apr_interval_time_t) (when > now ? when - now : 0) * MILLI_TO_MICRO, self);
+}
+
+/************************************************************************
+ * Queue a lease for the delivery of its stored messages
+ *
+ *
+ * @param  self the relay
+ * @param  relay_lease the lease
+ * @param  now deliver even if the client could not be reached recently,
+ *         as when it reconnects
+ *************************************************************************/
+static void relay_delivery_schedule(_jxta_transport_relay* self, _relay_lease* relay_lease, Jxta_boolean now)
+{
+	apr_thread_mutex_lock(self->messages_mutex);
+	if (now) {
+		if (0 != relay_lease->retry_at) {
+			/* the reference of the retry list moves to the delivery queue */
+			APR_RING_REMOVE(relay_lease, ready_link);
+			relay_lease->retry_at=0;
+			relay_lease->ready=TRUE;
+			APR_RING_INSERT_TAIL(&self->ready_leases, relay_lease, _relay_lease, ready_link);
+		}
+		relay_lease->retry_delay=0;
+	}
+	/* a client which could not be reached is tried again by the timer */
+	if (self->delivery_running && !relay_lease->ready && 0 == relay_lease->retry_at) {
+		relay_lease->ready=TRUE;
+		APR_RING_INSERT_TAIL(&self->ready_leases, (_relay_lease*) JXTA_OBJECT_SHARE(relay_lease), _relay_lease, ready_link);
+	}
+	relay_delivery_kick_locked(self);
+	apr_thread_mutex_unlock(self->messages_mutex);
+}
+
+/************************************************************************
+ * Pool task delivering stored messages. A batch of messages is sent to
+ * each waiting client in turn, a client with more messages goes back to
+ * the end of the queue. A client which cannot be reached is tried again
+ * after a delay.
+ *
+ *
+ * @param  thread the thread running the task
  * @param  arg the relay transport
  * @return  
  *************************************************************************/
-static void *APR_THREAD_FUNC send_messages_thread(apr_thread_t * thread, void *arg)
+static void *APR_THREAD_FUNC relay_delivery_task(apr_thread_t * thread, void *arg)
 {
-	Jxta_status res;
-	Jxta_time message_expiry_last_time_checked = jpr_time_now();
-	Jxta_time lease_expiry_last_time_checked = jpr_time_now();
-	Jxta_time last_time_awake = jpr_time_now();
     _jxta_transport_relay *self = PTValid(arg, _jxta_transport_relay);
-	unsigned int i;
 	_relay_lease* relay_lease=NULL;
-	Jxta_boolean send_all_messages=TRUE;
-
-	/*mark the thread as running*/
-	self->messages_thread_running=TRUE;
+	Jxta_status status;
 
-	while (self->messages_thread_running) {
-		 
-		/* why were we woken up, if the timeout was reached try to send out
-		 * all messages, if we were woken up because new messages arrived
-		 * send only these messages */
+	while (self->delivery_running) {
 		apr_thread_mutex_lock(self->messages_mutex);
-		send_all_messages=!self->messages_new_arrivals;
-		self->messages_new_arrivals=FALSE;
+		if (APR_RING_EMPTY(&self->ready_leases, _relay_lease, ready_link)) {
+			apr_thread_mutex_unlock(self->messages_mutex);
+			break;
+		}
+		relay_lease=APR_RING_FIRST(&self->ready_leases);
+		APR_RING_REMOVE(relay_lease, ready_link);
+		relay_lease->ready=FALSE;
 		apr_thread_mutex_unlock(self->messages_mutex);
 
-		/* make sure its not yet time to send all messages out */
-		send_all_messages=send_all_messages || ((last_time_awake+(SEND_MESSAGES_THREAD_SLEEP_TIME/MILLI_TO_MICRO))<jpr_time_now());
-
-		/*go through all leases*/
-		for (i=0; i<jxta_vector_size(self->leases); i++) {
-			Jxta_boolean send_messages=TRUE;
-			jxta_vector_get_object_at(self->leases,JXTA_OBJECT_PPTR(&relay_lease),i);
-
-			if (!send_all_messages) {
-				apr_thread_mutex_lock(relay_lease->mutex);
-				if (!relay_lease->messages_new_additions) {
-					send_messages=FALSE;
-				}
-				apr_thread_mutex_unlock(relay_lease->mutex);
-			}
+		status = lease_is_valid(relay_lease) ? relay_send_all_messages_1(self, relay_lease, RELAY_DELIVERY_BATCH) : JXTA_SUCCESS;
 
-			/* send the messages stored in the current lease */
-			if (send_messages) {
-				if (relay_send_all_messages_1(self,relay_lease)!=JXTA_SUCCESS) {
-					jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Problem sending out messages to the relay client %s\n",relay_lease->lease_requestor_id);
-				}
+		if (JXTA_BUSY == status) {
+			relay_delivery_schedule(self, relay_lease, FALSE);
+		} else if (JXTA_UNREACHABLE_DEST == status) {
+			jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Problem sending out messages to the relay client %s\n",
+							jstring_get_string(relay_lease->lease_requestor_id));
+			apr_thread_mutex_lock(self->messages_mutex);
+			relay_lease->retry_delay = (0 == relay_lease->retry_delay) ? RELAY_DELIVERY_RETRY_MIN :
+				(relay_lease->retry_delay * 2 > RELAY_DELIVERY_RETRY_MAX ? RELAY_DELIVERY_RETRY_MAX : relay_lease->retry_delay * 2);
+			relay_lease->retry_at = jpr_time_now() + relay_lease->retry_delay;
+			if (relay_lease->ready || !self->delivery_running) {
+				/* queued again meanwhile, or stopped */
+				relay_lease->retry_at = 0;
+			} else {
+				APR_RING_INSERT_TAIL(&self->retry_leases, (_relay_lease*) JXTA_OBJECT_SHARE(relay_lease), _relay_lease, ready_link);
+				relay_delivery_timer_arm_locked(self, relay_lease->retry_at);
 			}
+			apr_thread_mutex_unlock(self->messages_mutex);
+		} else {
+			apr_thread_mutex_lock(self->messages_mutex);
+			relay_lease->retry_delay=0;
+			apr_thread_mutex_unlock(self->messages_mutex);
 		}
 
-		/* make sure new messages were not added on while the processing
-		 * was going
-		 */
-		{
-			Jxta_boolean need_to_sleep=TRUE;
+		JXTA_OBJECT_RELEASE(relay_lease);
+	}
 
-			apr_thread_mutex_lock(self->messages_mutex);
-			need_to_sleep=!self->messages_new_arrivals;
-			apr_thread_mutex_unlock(self->messages_mutex);
+	/* give the thread back to the pool, a new task is pushed if more leases are waiting */
+	apr_thread_mutex_lock(self->messages_mutex);
+	if (self->delivery_workers > 0) {
+		self->delivery_workers--;
+	}
+	relay_delivery_kick_locked(self);
+	apr_thread_mutex_unlock(self->messages_mutex);
 
-			if (need_to_sleep)
-			{
-				Jxta_time previous_time_awake=last_time_awake;
-				/* sleep for a while */
-				last_time_awake = jpr_time_now();
-				apr_thread_mutex_lock(self->messages_mutex);
-				if (send_all_messages) {
-					res = apr_thread_cond_timedwait(self->messages_cond, self->messages_mutex, SEND_MESSAGES_THREAD_SLEEP_TIME);
-				} else {
-					res = apr_thread_cond_timedwait(self->messages_cond, self->messages_mutex, SEND_MESSAGES_THREAD_SLEEP_TIME-(last_time_awake-previous_time_awake)*MILLI_TO_MICRO);
-				}
-				apr_thread_mutex_unlock(self->messages_mutex);
-			}
-		}
+    return NULL;
+}
 
+/************************************************************************
+ * Pool task trying again the clients which could not be reached, and
+ * removing the expired messages and leases.
+ *
+ *
+ * @param  thread the thread running the task
+ * @param  arg the relay transport
+ * @return  
+ *************************************************************************/
+static void *APR_THREAD_FUNC relay_delivery_timer(apr_thread_t * thread, void *arg)
+{
+    _jxta_transport_relay *self = PTValid(arg, _jxta_transport_relay);
+	_relay_lease* relay_lease=NULL;
+	_relay_lease* next_lease=NULL;
+	Jxta_time now = jpr_time_now();
+	Jxta_time next = now + LEASE_CHECK_EXPIRY_INTERVAL;
 
-		/* is it is time to check for expired messages */
-		if (message_expiry_last_time_checked+MESSAGE_CHECK_EXPIRY_INTERVAL<jpr_time_now()) {
-			archive_check_timeout(self);
-			message_expiry_last_time_checked=jpr_time_now();
-		}
+	if (!self->delivery_running) {
+		return NULL;
+	}
 
-		/* is it is time to check for expired leases */
-		if (lease_expiry_last_time_checked+LEASE_CHECK_EXPIRY_INTERVAL<jpr_time_now()) {
-			leases_remove_expired(self);
-			lease_expiry_last_time_checked=jpr_time_now();
-		}
+	/* only the task for the current timer_at runs, it schedules the next one */
+	apr_thread_mutex_lock(self->messages_mutex);
+	if (0 == self->timer_at || self->timer_at > now + RELAY_DELIVERY_TIMER_SLACK) {
+		apr_thread_mutex_unlock(self->messages_mutex);
+		return NULL;
+	}
+	self->timer_at=0;
+	apr_thread_mutex_unlock(self->messages_mutex);
 
-    }
+	/* is it is time to check for expired messages */
+	if (self->message_expiry_checked+MESSAGE_CHECK_EXPIRY_INTERVAL<now) {
+		archive_check_timeout(self);
+		self->message_expiry_checked=now;
+	}
 
-    apr_thread_exit(thread, JXTA_SUCCESS);
-    return NULL;
+	/* is it is time to check for expired leases */
+	if (self->lease_expiry_checked+LEASE_CHECK_EXPIRY_INTERVAL<now) {
+		leases_remove_expired(self);
+		self->lease_expiry_checked=now;
+	}
+
+	apr_thread_mutex_lock(self->messages_mutex);
+	for (relay_lease=APR_RING_FIRST(&self->retry_leases);
+		 relay_lease != APR_RING_SENTINEL(&self->retry_leases, _relay_lease, ready_link);
+		 relay_lease=next_lease) {
+		next_lease=APR_RING_NEXT(relay_lease, ready_link);
+		if (relay_lease->retry_at <= now) {
+			/* the reference of the retry list moves to the delivery queue */
+			APR_RING_REMOVE(relay_lease, ready_link);
+			relay_lease->retry_at=0;
+			relay_lease->ready=TRUE;
+			APR_RING_INSERT_TAIL(&self->ready_leases, relay_lease, _relay_lease, ready_link);
+		} else if (relay_lease->retry_at < next) {
+			next=relay_lease->retry_at;
+		}
+	}
+	relay_delivery_kick_locked(self);
+	relay_delivery_timer_arm_locked(self, next);
+	apr_thread_mutex_unlock(self->messages_mutex);
 
+    return NULL;
 }
 
 static void check_relay_lease(_jxta_transport_relay * self, _jxta_peer_relay_entry * peer)
@@ -2479,35 +2779,25 @@ static void reconnect_to_relay(_jxta_transport_relay * self, _jxta_peer_relay_en
 
 
 /************************************************************************
- * Retrieve a lease from the list of relay leases
+ * Retrieve a lease from the table of relay leases
  *
  *
  * @param  self the relay
  * @param  dest_pid the pid on which to search for lease
- * @return  the lease, if the lease does not exist returns NULL, not shared
+ * @return  the lease, if the lease does not exist returns NULL, shared
  *************************************************************************/
 static _relay_lease* find_relay_lease(_jxta_transport_relay* self, JString* dest_pid)
 {
-	unsigned int i;
-	_relay_lease* relay_lease;
-
-	/* find the lease for the pid */
-	for (i=0; i<jxta_vector_size(self->leases); i++) {
-		jxta_vector_get_object_at(self->leases,JXTA_OBJECT_PPTR(&relay_lease),i);
-
-		if (!strcmp(jstring_get_string(relay_lease->lease_requestor_id),jstring_get_string(dest_pid))) {
-			JXTA_OBJECT_RELEASE(relay_lease);
-			break;
-		}
+	_relay_lease* relay_lease=NULL;
+	const char* pid=jstring_get_string(dest_pid);
 
-		JXTA_OBJECT_RELEASE(relay_lease);
+	apr_thread_mutex_lock(self->leases_mutex);
+	if (NULL != self->leases) {
+		jxta_hashtable_get(self->leases, pid, strlen(pid), JXTA_OBJECT_PPTR(&relay_lease));
 	}
+	apr_thread_mutex_unlock(self->leases_mutex);
 
-	if (jxta_vector_size(self->leases)>i) {
-		return relay_lease;
-	} else {
-		return NULL;
-	}
+	return relay_lease;
 }
 
 static Jxta_boolean lease_is_valid(_relay_lease* relay_lease)
@@ -2520,33 +2810,121 @@ static Jxta_boolean lease_is_valid(_relay_lease* relay_lease)
 	}
 }
 
-static Jxta_status lease_delete(_jxta_transport_relay* self, JString* lease_uid)
+/************************************************************************
+ * Insert a lease in the expiry order, must be called with leases_mutex held.
+ * Leases are renewed for the same duration so the lease usually goes last.
+ *
+ *
+ * @param  self the relay
+ * @param  relay_lease the lease
+ *************************************************************************/
+static void lease_insert_expiry_locked(_jxta_transport_relay* self, _relay_lease* relay_lease)
 {
-	unsigned int i;
-	_relay_lease* relay_lease;
+	Jxta_time expires=relay_lease->issue_time+relay_lease->lease_duration;
+	_relay_lease* prev=APR_RING_LAST(&self->expiry_leases);
 
-	/* find the lease for the pid */
-	for (i=0; i<jxta_vector_size(self->leases); i++) {
-		jxta_vector_get_object_at(self->leases,JXTA_OBJECT_PPTR(&relay_lease),i);
+	while (prev != APR_RING_SENTINEL(&self->expiry_leases, _relay_lease, expiry_link)
+		   && prev->issue_time+prev->lease_duration > expires) {
+		prev=APR_RING_PREV(prev, expiry_link);
+	}
+	if (prev == APR_RING_SENTINEL(&self->expiry_leases, _relay_lease, expiry_link)) {
+		APR_RING_INSERT_HEAD(&self->expiry_leases, relay_lease, _relay_lease, expiry_link);
+	} else {
+		APR_RING_INSERT_AFTER(prev, relay_lease, expiry_link);
+	}
+}
 
-		if (!strcmp(jstring_get_string(relay_lease->lease_requestor_id),jstring_get_string(lease_uid))) {
-			break;
-		}
+/************************************************************************
+ * Add a new lease to the table of relay leases
+ *
+ *
+ * @param  self the relay
+ * @param  relay_lease the lease
+ * @return JXTA_SUCCESS if the lease was added, JXTA_BUSY if the relay
+ *         already has the maximum number of leases, JXTA_FAILED if there is
+ *         already a lease for the peer
+ *************************************************************************/
+static Jxta_status lease_add(_jxta_transport_relay* self, _relay_lease* relay_lease)
+{
+	const char* pid=jstring_get_string(relay_lease->lease_requestor_id);
+	Jxta_status status=JXTA_SUCCESS;
+
+	apr_thread_mutex_lock(self->leases_mutex);
+	if (self->leases_count >= self->max_leases_allowed) {
+		status=JXTA_BUSY;
+	} else if (!jxta_hashtable_putnoreplace(self->leases, pid, strlen(pid), JXTA_OBJECT(relay_lease))) {
+		status=JXTA_FAILED;
+	} else {
+		lease_insert_expiry_locked(self, relay_lease);
+		self->leases_count++;
+	}
+	apr_thread_mutex_unlock(self->leases_mutex);
 
-		JXTA_OBJECT_RELEASE(relay_lease);
+	return status;
+}
+
+/************************************************************************
+ * Extend a lease for another lease duration
+ *
+ *
+ * @param  self the relay
+ * @param  relay_lease the lease, in the table of relay leases
+ *************************************************************************/
+static void lease_renew(_jxta_transport_relay* self, _relay_lease* relay_lease)
+{
+	apr_thread_mutex_lock(self->leases_mutex);
+	relay_lease->issue_time=jpr_time_now();
+	if (NULL != APR_RING_NEXT(relay_lease, expiry_link)) {
+		APR_RING_REMOVE(relay_lease, expiry_link);
+		lease_insert_expiry_locked(self, relay_lease);
 	}
+	apr_thread_mutex_unlock(self->leases_mutex);
+}
 
-	if (jxta_vector_size(self->leases)>i) {
-		JXTA_OBJECT_RELEASE(relay_lease);
-		return jxta_vector_remove_object_at(self->leases,NULL,i);
-	} else {
+static Jxta_status lease_delete(_jxta_transport_relay* self, JString* lease_uid)
+{
+	_relay_lease* relay_lease=NULL;
+	const char* pid=jstring_get_string(lease_uid);
+	Jxta_status status;
+
+	apr_thread_mutex_lock(self->leases_mutex);
+	status=jxta_hashtable_del(self->leases, pid, strlen(pid), JXTA_OBJECT_PPTR(&relay_lease));
+	if (JXTA_SUCCESS == status) {
+		APR_RING_REMOVE(relay_lease, expiry_link);
+		APR_RING_NEXT(relay_lease, expiry_link)=NULL;
+		self->leases_count--;
+	}
+	apr_thread_mutex_unlock(self->leases_mutex);
+
+	if (JXTA_SUCCESS != status) {
 		return JXTA_ITEM_NOTFOUND;
 	}
 
+	JXTA_OBJECT_RELEASE(relay_lease);
+	return JXTA_SUCCESS;
 }
 
 /************************************************************************
-* Goes through all current leases and removes the ones that have expired
+ * Get all current leases
+ *
+ *
+ * @param  self the relay
+ * @return  a vector with the leases
+ *************************************************************************/
+static Jxta_vector* leases_get(_jxta_transport_relay* self)
+{
+	Jxta_vector* leases;
+
+	apr_thread_mutex_lock(self->leases_mutex);
+	leases=jxta_hashtable_values_get(self->leases);
+	apr_thread_mutex_unlock(self->leases_mutex);
+
+	return leases;
+}
+
+/************************************************************************
+* Removes the leases that have expired, from the first one to expire on
+* until a lease is still valid
 *
 *
 * @param   self the relay
@@ -2554,29 +2932,199 @@ static Jxta_status lease_delete(_jxta_transport_relay* self, JString* lease_uid)
 *************************************************************************/
 static Jxta_status leases_remove_expired(_jxta_transport_relay* self)
 {
-	unsigned int i;
+	Jxta_vector* expired;
 	_relay_lease* relay_lease;
-	Jxta_vector *current_leases;
-
-	current_leases=self->leases;
-	self->leases=jxta_vector_new(jxta_vector_size(current_leases));
+	_relay_lease* found=NULL;
+	const char* pid;
+	unsigned int i;
 
-	/* go through all leases and only keep the ones that have not expired */
-	for (i=0; i<jxta_vector_size(current_leases); i++) {
-		jxta_vector_get_object_at(current_leases,JXTA_OBJECT_PPTR(&relay_lease),i);
+	expired=jxta_vector_new(0);
+	if (NULL == expired) {
+		return JXTA_NOMEM;
+	}
 
+	apr_thread_mutex_lock(self->leases_mutex);
+	while (!APR_RING_EMPTY(&self->expiry_leases, _relay_lease, expiry_link)) {
+		relay_lease=APR_RING_FIRST(&self->expiry_leases);
 		if (lease_is_valid(relay_lease)) {
-			jxta_vector_add_object_last(self->leases,JXTA_OBJECT(relay_lease));
+			break;
 		}
+		APR_RING_REMOVE(relay_lease, expiry_link);
+		/* out of the table, lease_renew must not put it back in the expiry order */
+		APR_RING_NEXT(relay_lease, expiry_link)=NULL;
+		pid=jstring_get_string(relay_lease->lease_requestor_id);
+		jxta_hashtable_del(self->leases, pid, strlen(pid), JXTA_OBJECT_PPTR(&found));
+		self->leases_count--;
+		/* the reference of the table goes to the vector */
+		jxta_vector_add_object_last(expired, JXTA_OBJECT(relay_lease));
+		JXTA_OBJECT_RELEASE(relay_lease);
+	}
+	apr_thread_mutex_unlock(self->leases_mutex);
 
+	for (i = 0; i < jxta_vector_size(expired); i++) {
+		jxta_vector_get_object_at(expired, JXTA_OBJECT_PPTR(&relay_lease), i);
+		jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Lease of %s expired\n", jstring_get_string(relay_lease->lease_requestor_id));
 		JXTA_OBJECT_RELEASE(relay_lease);
 	}
+	JXTA_OBJECT_RELEASE(expired);
 
-	JXTA_OBJECT_RELEASE(current_leases);
+	return JXTA_SUCCESS;
+}
+
+Jxta_status relay_leases_setup(Jxta_transport_relay_public* jxta_transport_relay, unsigned long max_leases)
+{
+	_jxta_transport_relay* self=(_jxta_transport_relay*) jxta_transport_relay;
+
+	if (NULL == self || NULL != self->pool) {
+		return JXTA_INVALID_ARGUMENT;
+	}
+	if (APR_SUCCESS != relay_locks_create(self)) {
+		return JXTA_NOMEM;
+	}
+	self->leases=jxta_hashtable_new_0(max_leases, FALSE);
+	if (NULL == self->leases) {
+		return JXTA_NOMEM;
+	}
+	APR_RING_INIT(&self->expiry_leases, _relay_lease, expiry_link);
+	self->leases_count=0;
+	self->max_leases_allowed=max_leases;
 
 	return JXTA_SUCCESS;
 }
 
+Jxta_status relay_lease_grant(Jxta_transport_relay_public* jxta_transport_relay, const char* pid, Jxta_time_diff duration)
+{
+	_jxta_transport_relay* self=(_jxta_transport_relay*) jxta_transport_relay;
+	_relay_lease* relay_lease;
+	JString* lease_requestor_id;
+	Jxta_status status=JXTA_SUCCESS;
+
+	lease_requestor_id=jstring_new_2(pid);
+	relay_lease=find_relay_lease(self, lease_requestor_id);
+	if (NULL == relay_lease) {
+		relay_lease=relay_lease_new(self);
+		if (NULL == relay_lease) {
+			JXTA_OBJECT_RELEASE(lease_requestor_id);
+			return JXTA_NOMEM;
+		}
+		relay_lease->lease_requestor_id=JXTA_OBJECT_SHARE(lease_requestor_id);
+		relay_lease->lease_duration=duration;
+		status=lease_add(self, relay_lease);
+	} else {
+		lease_renew(self, relay_lease);
+	}
+	JXTA_OBJECT_RELEASE(relay_lease);
+	JXTA_OBJECT_RELEASE(lease_requestor_id);
+
+	return status;
+}
+
+Jxta_boolean relay_lease_exists(Jxta_transport_relay_public* jxta_transport_relay, const char* pid)
+{
+	_jxta_transport_relay* self=(_jxta_transport_relay*) jxta_transport_relay;
+	_relay_lease* relay_lease;
+	JString* lease_requestor_id;
+
+	lease_requestor_id=jstring_new_2(pid);
+	relay_lease=find_relay_lease(self, lease_requestor_id);
+	JXTA_OBJECT_RELEASE(lease_requestor_id);
+	if (NULL == relay_lease) {
+		return FALSE;
+	}
+	JXTA_OBJECT_RELEASE(relay_lease);
+	return TRUE;
+}
+
+unsigned long relay_leases_expire(Jxta_transport_relay_public* jxta_transport_relay)
+{
+	_jxta_transport_relay* self=(_jxta_transport_relay*) jxta_transport_relay;
+	unsigned long count;
+
+	leases_remove_expired(self);
+	apr_thread_mutex_lock(self->leases_mutex);
+	count=self->leases_count;
+	apr_thread_mutex_unlock(self->leases_mutex);
+
+	return count;
+}
+
+Jxta_status relay_archive_setup(Jxta_transport_relay_public* jxta_transport_relay, const char* spill_dir,
+								apr_size_t lease_archive_max_bytes, apr_off_t lease_spill_max_bytes)
+{
+	_jxta_transport_relay* self=(_jxta_transport_relay*) jxta_transport_relay;
+
+	if (NULL == self || NULL == self->pool || NULL != self->peerid) {
+		return JXTA_INVALID_ARGUMENT;
+	}
+	/* names the spill files */
+	self->peerid=malloc(sizeof("archive"));
+	if (NULL == self->peerid) {
+		return JXTA_NOMEM;
+	}
+	strcpy(self->peerid, "archive");
+	self->archive_max_bytes=DEFAULT_ARCHIVE_MAX_BYTES;
+	self->lease_archive_max_bytes=lease_archive_max_bytes;
+	self->lease_spill_max_bytes=lease_spill_max_bytes;
+	self->spill_dir=apr_pstrdup(self->pool, spill_dir);
+	memset(&self->archive_stats, 0, sizeof(self->archive_stats));
+	if (APR_SUCCESS != apr_dir_make_recursive(self->spill_dir, APR_OS_DEFAULT, self->pool)) {
+		return JXTA_IOERR;
+	}
+
+	return JXTA_SUCCESS;
+}
+
+Jxta_status relay_archive_put(Jxta_transport_relay_public* jxta_transport_relay, const char* pid, Jxta_message* msg)
+{
+	_jxta_transport_relay* self=(_jxta_transport_relay*) jxta_transport_relay;
+	_relay_lease* relay_lease;
+	JString* lease_requestor_id;
+	Jxta_status status;
+
+	lease_requestor_id=jstring_new_2(pid);
+	relay_lease=find_relay_lease(self, lease_requestor_id);
+	JXTA_OBJECT_RELEASE(lease_requestor_id);
+	if (NULL == relay_lease) {
+		return JXTA_ITEM_NOTFOUND;
+	}
+	status=archive_put_message_1(self, relay_lease, msg);
+	JXTA_OBJECT_RELEASE(relay_lease);
+
+	return status;
+}
+
+Jxta_status relay_archive_take(Jxta_transport_relay_public* jxta_transport_relay, const char* pid, Jxta_message** msg)
+{
+	_jxta_transport_relay* self=(_jxta_transport_relay*) jxta_transport_relay;
+	_relay_lease* relay_lease;
+	_stored_message* current;
+	JString* lease_requestor_id;
+	Jxta_status status=JXTA_ITEM_NOTFOUND;
+
+	*msg=NULL;
+	lease_requestor_id=jstring_new_2(pid);
+	relay_lease=find_relay_lease(self, lease_requestor_id);
+	JXTA_OBJECT_RELEASE(lease_requestor_id);
+	if (NULL == relay_lease) {
+		return JXTA_ITEM_NOTFOUND;
+	}
+
+	apr_thread_mutex_lock(relay_lease->mutex);
+	if (NULL == relay_lease->stored_messages) {
+		archive_load_spill(relay_lease);
+	}
+	current=relay_lease->stored_messages;
+	if (NULL != current) {
+		*msg=JXTA_OBJECT_SHARE(current->msg);
+		archive_remove_message(relay_lease, current);
+		status=JXTA_SUCCESS;
+	}
+	apr_thread_mutex_unlock(relay_lease->mutex);
+	JXTA_OBJECT_RELEASE(relay_lease);
+
+	return status;
+}
+
 /* Code to manage messages stored by relay
  *
  */
@@ -2602,51 +3150,333 @@ static Jxta_status archive_put_message(_jxta_transport_relay* self, Jxta_message
 		return JXTA_ITEM_NOTFOUND;
 	}
 
-	return archive_put_message_1(relay_lease, msg);	
+	if (archive_put_message_1(self, relay_lease, msg) != JXTA_SUCCESS) {
+		JXTA_OBJECT_RELEASE(relay_lease);
+		return JXTA_FAILED;
+	}
+
+	relay_delivery_schedule(self, relay_lease, FALSE);
+	JXTA_OBJECT_RELEASE(relay_lease);
+	return JXTA_SUCCESS;
+}
+
+static Jxta_status JXTA_STDCALL archive_count_bytes(void *stream, const char *buf, size_t len)
+{
+	*(apr_size_t *) stream += len;
+	return JXTA_SUCCESS;
 }
 
 /************************************************************************
- * Add message to the relay message archive
+ * Reserve room for a message in the memory budget of the relay
+ *
+ *
+ * @param  self the relay
+ * @param  size the size of the message
+ * @param  force reserve even if over budget
+ * @return TRUE if the message fits in the budget
+ *************************************************************************/
+static Jxta_boolean archive_reserve(_jxta_transport_relay* self, apr_size_t size, Jxta_boolean force)
+{
+	Jxta_boolean fits;
+
+	apr_thread_mutex_lock(self->archive_mutex);
+	fits = force || self->archive_stats.archived_bytes + size <= self->archive_max_bytes;
+	if (fits) {
+		self->archive_stats.archived_bytes += size;
+		self->archive_stats.archived_msgs++;
+	}
+	apr_thread_mutex_unlock(self->archive_mutex);
+
+	return fits;
+}
+
+/************************************************************************
+ * Remove a message from the list of stored messages of a lease, and
+ * release it. Must be called with the lease mutex held.
+ *
+ *
+ * @param  relay_lease the lease which keeps the message
+ * @param  stored_message the message to remove
+ *************************************************************************/
+static void archive_remove_message(_relay_lease* relay_lease, _stored_message* stored_message)
+{
+	_jxta_transport_relay* self = relay_lease->relay;
+
+	linked_list_remove(JXTA_LINKED_LIST_NODE(stored_message),JXTA_LINKED_LIST_NODE_PPTR(&relay_lease->stored_messages));
+	relay_lease->total_stored--;
+	relay_lease->stored_bytes -= stored_message->size;
+
+	apr_thread_mutex_lock(self->archive_mutex);
+	self->archive_stats.archived_bytes -= stored_message->size;
+	self->archive_stats.archived_msgs--;
+	apr_thread_mutex_unlock(self->archive_mutex);
+
+	JXTA_OBJECT_RELEASE(stored_message);
+}
+
+/************************************************************************
+ * Append a message to the spill file of a lease, the file is created on
+ * the first message. Must be called with the lease mutex held. Messages
+ * are refused once the file reaches the spill budget of a lease, until it
+ * has been replayed to its end and removed.
+ *
+ *
+ * @param  relay_lease the lease
+ * @param  msg the message to spill
+ * @return JXTA_SUCCESS, JXTA_BUSY if the file is full or
+ *         JXTA_IOERR
+ *************************************************************************/
+static Jxta_status archive_spill_message(_relay_lease* relay_lease, Jxta_message* msg)
+{
+	_jxta_transport_relay* self = relay_lease->relay;
+	_spill_record record;
+	JString* wire = NULL;
+	apr_status_t status;
+	apr_size_t size;
+
+	wire = jstring_new_0();
+	if (NULL == wire) {
+		return JXTA_NOMEM;
+	}
+	if (JXTA_SUCCESS != jxta_message_to_jstring(msg, APP_MSG, wire)) {
+		JXTA_OBJECT_RELEASE(wire);
+		return JXTA_FAILED;
+	}
+	size = jstring_length(wire);
+
+	/* the file is only removed once replayed to its end, the budget bounds its size and not only the unread part */
+	if (relay_lease->spill_write + (apr_off_t) (sizeof(record) + size) > self->lease_spill_max_bytes) {
+		JXTA_OBJECT_RELEASE(wire);
+		return JXTA_BUSY;
+	}
+
+	if (NULL == relay_lease->spill) {
+		/* the file is removed when closed, the lease reuses its name */
+		if (NULL == relay_lease->spill_path) {
+			relay_lease->spill_path = apr_psprintf(relay_lease->pool, "%s/%s-%u.spill", self->spill_dir, self->peerid,
+												   (unsigned int) apr_atomic_inc32(&self->spill_seq));
+		}
+		status = apr_file_open(&relay_lease->spill, relay_lease->spill_path,
+							   APR_READ | APR_WRITE | APR_CREATE | APR_TRUNCATE | APR_APPEND | APR_BINARY,
+							   APR_OS_DEFAULT, relay_lease->pool);
+		if (APR_SUCCESS != status) {
+			jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Unable to create spill file %s : %d\n",
+							relay_lease->spill_path, status);
+			relay_lease->spill = NULL;
+			JXTA_OBJECT_RELEASE(wire);
+			return JXTA_IOERR;
+		}
+		relay_lease->spill_read = 0;
+		relay_lease->spill_write = 0;
+		relay_lease->spill_msgs = 0;
+	}
+
+	record.time_stored = jpr_time_now();
+	record.size = (apr_uint32_t) size;
+	record.reserved = 0;
+	status = apr_file_write_full(relay_lease->spill, &record, sizeof(record), NULL);
+	if (APR_SUCCESS == status) {
+		status = apr_file_write_full(relay_lease->spill, jstring_get_string(wire), size, NULL);
+	}
+	JXTA_OBJECT_RELEASE(wire);
+	if (APR_SUCCESS != status) {
+		jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Unable to write to spill file %s : %d\n",
+						relay_lease->spill_path, status);
+		/* drop the partial record */
+		apr_file_trunc(relay_lease->spill, relay_lease->spill_write);
+		return JXTA_IOERR;
+	}
+	relay_lease->spill_write += sizeof(record) + size;
+	relay_lease->spill_msgs++;
+
+	apr_thread_mutex_lock(self->archive_mutex);
+	self->archive_stats.spilled_bytes += sizeof(record) + size;
+	self->archive_stats.spilled_msgs++;
+	self->archive_stats.spilled_total_bytes += sizeof(record) + size;
+	apr_thread_mutex_unlock(self->archive_mutex);
+
+	return JXTA_SUCCESS;
+}
+
+/************************************************************************
+ * Close and remove the spill file of a lease. Must be called with the
+ * lease mutex held or when the lease is deleted. The messages left in
+ * the file are counted as dropped.
+ *
+ *
+ * @param  relay_lease the lease
+ *************************************************************************/
+static void archive_close_spill(_relay_lease* relay_lease)
+{
+	_jxta_transport_relay* self = relay_lease->relay;
+	apr_off_t left;
+
+	if (NULL == relay_lease->spill) {
+		return;
+	}
+
+	left = relay_lease->spill_write - relay_lease->spill_read;
+	apr_thread_mutex_lock(self->archive_mutex);
+	self->archive_stats.spilled_bytes -= left;
+	self->archive_stats.spilled_msgs -= relay_lease->spill_msgs;
+	self->archive_stats.dropped_msgs += relay_lease->spill_msgs;
+	self->archive_stats.dropped_bytes += left - (apr_off_t) (relay_lease->spill_msgs * sizeof(_spill_record));
+	apr_thread_mutex_unlock(self->archive_mutex);
+
+	apr_file_close(relay_lease->spill);
+	apr_file_remove(relay_lease->spill_path, relay_lease->pool);
+	relay_lease->spill = NULL;
+	relay_lease->spill_read = 0;
+	relay_lease->spill_write = 0;
+	relay_lease->spill_msgs = 0;
+}
+
+static Jxta_status JXTA_STDCALL archive_read_spill(void *stream, char *buf, size_t len)
+{
+	return (APR_SUCCESS == apr_file_read_full((apr_file_t *) stream, buf, len, NULL)) ? JXTA_SUCCESS : JXTA_IOERR;
+}
+
+/************************************************************************
+ * Move the oldest messages of the spill file of a lease to its list of
+ * stored messages, as long as they fit in the memory budget. At least one
+ * message is loaded if the list is empty. The file is removed once all
+ * its messages are loaded. Must be called with the lease mutex held.
  *
  *
+ * @param  relay_lease the lease
+ * @return the number of messages loaded
+ *************************************************************************/
+static int archive_load_spill(_relay_lease* relay_lease)
+{
+	_jxta_transport_relay* self = relay_lease->relay;
+	_stored_message* stored_message;
+	_spill_record record;
+	Jxta_message* msg;
+	apr_off_t offset;
+	apr_size_t record_size;
+	Jxta_boolean force;
+	int loaded = 0;
+
+	while (NULL != relay_lease->spill && relay_lease->spill_read < relay_lease->spill_write) {
+		offset = relay_lease->spill_read;
+		if (APR_SUCCESS != apr_file_seek(relay_lease->spill, APR_SET, &offset)
+			|| APR_SUCCESS != apr_file_read_full(relay_lease->spill, &record, sizeof(record), NULL)) {
+			jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Unable to read spill file %s\n", relay_lease->spill_path);
+			archive_close_spill(relay_lease);
+			break;
+		}
+		record_size = sizeof(record) + record.size;
+
+		force = (NULL == relay_lease->stored_messages);
+		if (!force && relay_lease->stored_bytes + record.size > self->lease_archive_max_bytes) {
+			break;
+		}
+		if (record.time_stored + DEFAULT_MESSAGE_STORAGE_INTERVAL >= jpr_time_now()) {
+			if (!archive_reserve(self, record.size, force)) {
+				break;
+			}
+			msg = jxta_message_new();
+			if (NULL == msg || JXTA_SUCCESS != jxta_message_read(msg, APP_MSG, archive_read_spill, relay_lease->spill)) {
+				jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Unable to read message from spill file %s\n",
+								relay_lease->spill_path);
+				if (NULL != msg) {
+					JXTA_OBJECT_RELEASE(msg);
+				}
+				apr_thread_mutex_lock(self->archive_mutex);
+				self->archive_stats.archived_bytes -= record.size;
+				self->archive_stats.archived_msgs--;
+				self->archive_stats.dropped_msgs++;
+				self->archive_stats.dropped_bytes += record.size;
+				apr_thread_mutex_unlock(self->archive_mutex);
+			} else {
+				stored_message = stored_message_new(msg, DEFAULT_MESSAGE_STORAGE_INTERVAL, record.size);
+				JXTA_OBJECT_RELEASE(msg);
+				stored_message->time_stored = (Jxta_time) record.time_stored;
+				linked_list_add_last(JXTA_LINKED_LIST_NODE(stored_message),
+									 JXTA_LINKED_LIST_NODE_PPTR(&relay_lease->stored_messages));
+				relay_lease->total_stored++;
+				relay_lease->stored_bytes += record.size;
+				loaded++;
+			}
+		}
+
+		relay_lease->spill_read += record_size;
+		relay_lease->spill_msgs--;
+		apr_thread_mutex_lock(self->archive_mutex);
+		self->archive_stats.spilled_bytes -= record_size;
+		self->archive_stats.spilled_msgs--;
+		apr_thread_mutex_unlock(self->archive_mutex);
+	}
+
+	if (NULL != relay_lease->spill && relay_lease->spill_read >= relay_lease->spill_write) {
+		archive_close_spill(relay_lease);
+	}
+
+	return loaded;
+}
+
+/************************************************************************
+ * Add message to the relay message archive. The message is kept in
+ * memory if it fits in the budget of the lease and of the relay, else it
+ * is appended to the spill file of the lease. Once a lease has spilled,
+ * its new messages are spilled as well until the file is replayed so
+ * they are delivered in order.
+ *
+ *
+ * @param  self the relay
  * @param  jxta_lease_object the lease object which keeps the messages
  * @param  msg the message to add
  * @return  the new object
  *************************************************************************/
-static Jxta_status archive_put_message_1(_relay_lease* jxta_lease_object, Jxta_message * msg)
+static Jxta_status archive_put_message_1(_jxta_transport_relay* self, _relay_lease* jxta_lease_object, Jxta_message * msg)
 {
 	_stored_message* stored_message=NULL;
+	apr_size_t size = 0;
+	Jxta_status status;
 
-	/*make sure that the vector is allocated*/
-	/*if (!jxta_lease_object->stored_messages) {
-		jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Message storage does not exist in the lease object\n");
-		return JXTA_ITEM_NOTFOUND;
-	}*/
-	apr_thread_mutex_lock(jxta_lease_object->mutex);
+	if (JXTA_SUCCESS != jxta_message_write(msg, APP_MSG, archive_count_bytes, &size)) {
+		jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Cannot compute the size of the message\n");
+		return JXTA_FAILED;
+	}
 
-    if (jxta_lease_object->total_stored>MAX_NUMBER_MESSAGES_PER_CLIENT) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Number of messages for this client it greater than the allowed maximum\n");
-        apr_thread_mutex_unlock(jxta_lease_object->mutex);
-        return JXTA_FAILED;
-    }
+	apr_thread_mutex_lock(jxta_lease_object->mutex);
 
-	/*try to add the message to the storage*/
-	stored_message=stored_message_new(msg,DEFAULT_MESSAGE_STORAGE_INTERVAL);
-	
-	if (linked_list_add_last(JXTA_LINKED_LIST_NODE(stored_message),
-		JXTA_LINKED_LIST_NODE_PPTR(&jxta_lease_object->stored_messages))==NULL) {
-			jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Cannot to add message to the list\n");
-			JXTA_OBJECT_RELEASE(stored_message);
+	if (NULL == jxta_lease_object->spill
+		&& jxta_lease_object->total_stored < MAX_NUMBER_MESSAGES_PER_CLIENT
+		&& jxta_lease_object->stored_bytes + size <= self->lease_archive_max_bytes
+		&& archive_reserve(self, size, FALSE)) {
+
+		/*try to add the message to the storage*/
+		stored_message=stored_message_new(msg,DEFAULT_MESSAGE_STORAGE_INTERVAL,size);
+		if (NULL == stored_message) {
+			apr_thread_mutex_lock(self->archive_mutex);
+			self->archive_stats.archived_bytes -= size;
+			self->archive_stats.archived_msgs--;
+			apr_thread_mutex_unlock(self->archive_mutex);
+			apr_thread_mutex_unlock(jxta_lease_object->mutex);
+			return JXTA_NOMEM;
+		}
+		linked_list_add_last(JXTA_LINKED_LIST_NODE(stored_message),
+							 JXTA_LINKED_LIST_NODE_PPTR(&jxta_lease_object->stored_messages));
+		jxta_lease_object->total_stored++;
+		jxta_lease_object->stored_bytes += size;
+	} else {
+		status = archive_spill_message(jxta_lease_object, msg);
+		if (JXTA_SUCCESS != status) {
+			jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Message archive for this client is full, dropping message : %d\n",
+							status);
+			apr_thread_mutex_lock(self->archive_mutex);
+			self->archive_stats.dropped_msgs++;
+			self->archive_stats.dropped_bytes += size;
+			apr_thread_mutex_unlock(self->archive_mutex);
 			apr_thread_mutex_unlock(jxta_lease_object->mutex);
 			return JXTA_FAILED;
-    } else {
-        jxta_lease_object->total_stored++;
-    }
+		}
+	}
 
 	jxta_lease_object->messages_new_additions=TRUE;
 
 	apr_thread_mutex_unlock(jxta_lease_object->mutex);
-	/*JXTA_OBJECT_RELEASE(stored_message);*/
 	return JXTA_SUCCESS;
 }
 
@@ -2684,6 +3514,7 @@ static Jxta_vector* archive_get_all_messages(_jxta_transport_relay* self, JStrin
 
 	} while (relay_lease->stored_messages!=next);
 
+	JXTA_OBJECT_RELEASE(relay_lease);
 	return messages;
 }
 
@@ -2700,53 +3531,35 @@ static Jxta_status archive_check_timeout(_jxta_transport_relay* self)
 {
 	unsigned int i;/*,k;*/
 	_relay_lease* relay_lease;
-	/*Jxta_vector* new_message_storage;
-	_stored_message* stored_message;*/
 	_stored_message* next=NULL;
-	_stored_message* head=NULL;
+	Jxta_vector* leases=leases_get(self);
 
 	/* go through all leases */
-	for (i=0; i<jxta_vector_size(self->leases); i++) {
-		jxta_vector_get_object_at(self->leases,JXTA_OBJECT_PPTR(&relay_lease),i);
+	for (i=0; i<jxta_vector_size(leases); i++) {
+		jxta_vector_get_object_at(leases,JXTA_OBJECT_PPTR(&relay_lease),i);
 
+		apr_thread_mutex_lock(relay_lease->mutex);
 		if (relay_lease->stored_messages) {
+			int count = relay_lease->total_stored;
 
-			apr_thread_mutex_lock(relay_lease->mutex);
-			/* allocate a new vector where the non expired messages will be placed */
-			/*new_message_storage=jxta_vector_new(10);
-
-			if (!new_message_storage) {
-				jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "Unable to create new vector\n");
-				apr_thread_mutex_unlock(relay_lease->mutex);
-				return JXTA_FAILED;
-			}*/
-
-			/*for (k=0; k<jxta_vector_size(relay_lease->stored_messages); k++) {*/
-
-			head=relay_lease->stored_messages;
-			next=(_stored_message*)linked_list_right(JXTA_LINKED_LIST_NODE(head));
-			do {
+			next=relay_lease->stored_messages;
+			while (count-- > 0 && NULL != next) {
 				_stored_message* current=next;
 				next=(_stored_message*)linked_list_right(JXTA_LINKED_LIST_NODE(current));
-				/*jxta_vector_get_object_at(relay_lease->stored_messages,JXTA_OBJECT_PPTR(&stored_message),k);*/
 
 				if (message_has_expired(current)) {
-					linked_list_remove(JXTA_LINKED_LIST_NODE(current),JXTA_LINKED_LIST_NODE_PPTR(&relay_lease->stored_messages));
-					relay_lease->total_stored--;
-                    JXTA_OBJECT_RELEASE(current);
+					if (next == current) {
+						next = NULL;
+					}
+					archive_remove_message(relay_lease, current);
 				}	
-			} while (next!=head);
-
-			/*JXTA_OBJECT_RELEASE(relay_lease->stored_messages);
-
-			relay_lease->stored_messages=new_message_storage;*/
-
-			apr_thread_mutex_unlock(relay_lease->mutex);
+			}
 		}
+		apr_thread_mutex_unlock(relay_lease->mutex);
 
 		JXTA_OBJECT_RELEASE(relay_lease);
 	}
-
+	JXTA_OBJECT_RELEASE(leases);
 
 	return JXTA_SUCCESS;
 }
@@ -2781,7 +3594,7 @@ static Jxta_boolean message_has_expired(const _stored_message* stored_message)
  * @return  the new object
  *************************************************************************/
 static _stored_message* stored_message_new(Jxta_message * msg,
-										   Jxta_time_diff storage_interval_length)
+										   Jxta_time_diff storage_interval_length, apr_size_t size)
 {
 	_stored_message* stored_message_obj;
 
@@ -2794,6 +3607,7 @@ static _stored_message* stored_message_new(Jxta_message * msg,
 
 	stored_message_obj->storage_interval_length=storage_interval_length;
 	stored_message_obj->time_stored=jpr_time_now();
+	stored_message_obj->size=size;
 	JXTA_LINKED_LIST_NODE(stored_message_obj)->left=NULL;
 	JXTA_LINKED_LIST_NODE(stored_message_obj)->right=NULL;
 
@@ -2831,7 +3645,7 @@ static void stored_message_delete(Jxta_object * obj)
  * @param  
  * @return  the new object
  *************************************************************************/
-static _relay_lease* relay_lease_new()
+static _relay_lease* relay_lease_new(_jxta_transport_relay* self)
 {
 	_relay_lease* relay_lease_obj;
 	Jxta_status status;
@@ -2868,6 +3682,19 @@ static _relay_lease* relay_lease_new()
 	relay_lease_obj->messages_new_additions=FALSE;
 
     relay_lease_obj->total_stored=0;
+	relay_lease_obj->relay=self;
+	relay_lease_obj->stored_bytes=0;
+	relay_lease_obj->spill=NULL;
+	relay_lease_obj->spill_path=NULL;
+	relay_lease_obj->spill_read=0;
+	relay_lease_obj->spill_write=0;
+	relay_lease_obj->spill_msgs=0;
+	/* not in the lease table yet */
+	APR_RING_NEXT(relay_lease_obj, expiry_link)=NULL;
+	relay_lease_obj->ready=FALSE;
+	relay_lease_obj->retry_at=0;
+	relay_lease_obj->retry_delay=0;
+	relay_lease_obj->sending=FALSE;
 
     JXTA_OBJECT_INIT(relay_lease_obj, relay_lease_delete, 0);
 
@@ -2898,9 +3725,10 @@ static void relay_lease_delete(Jxta_object * obj)
 		JXTA_OBJECT_RELEASE(relay_lease_obj->stored_messages);*/
 
 	/* if the linked list of messages is not empty, release it */
-	if (relay_lease_obj->stored_messages!=NULL) {
-		linked_list_clear_and_free(JXTA_LINKED_LIST_NODE(relay_lease_obj->stored_messages));
+	while (relay_lease_obj->stored_messages!=NULL) {
+		archive_remove_message(relay_lease_obj, relay_lease_obj->stored_messages);
 	}
+	archive_close_spill(relay_lease_obj);
 
 	apr_thread_mutex_destroy(relay_lease_obj->mutex);
 	apr_pool_destroy(relay_lease_obj->pool);
@@ -3118,23 +3946,23 @@ static void check_for_lease_request(Jxta_message *msg, _jxta_transport_relay *se
 		JXTA_OBJECT_RELEASE(bytes);
 		JXTA_OBJECT_RELEASE(response);
 
+		/* try to retrieve existing relay lease */
+		relay_lease=find_relay_lease(self,lease_requestor_id);
+
 		/* if reached the limit on the number of leases, ignore the request */
-		if (jxta_vector_size(self->leases)>=self->max_leases_allowed) {
+		if (!relay_lease && self->leases_count>=self->max_leases_allowed) {
 			jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Max number of leases reached, ignoring request\n");
 		}
 		/* try to send a lease */
 		else if (send_relay_lease(self,relay_client_address)==JXTA_SUCCESS) {
 
-			/* try to retrieve existing relay lease */
-			relay_lease=find_relay_lease(self,lease_requestor_id);
-
 			/* if the lease has not already been issued */
 			if (!relay_lease) {
-				relay_lease=relay_lease_new();
+				relay_lease=relay_lease_new(self);
 				relay_lease->lease_requestor_id=JXTA_OBJECT_SHARE(lease_requestor_id);
 				relay_lease->lease_requestor_address=JXTA_OBJECT_SHARE(relay_client_address);
-				/* lease issued add to the list of leases */
-				if (jxta_vector_add_object_last(self->leases,JXTA_OBJECT(relay_lease))!=JXTA_SUCCESS) {
+				/* lease issued add to the table of leases */
+				if (lease_add(self,relay_lease)!=JXTA_SUCCESS) {
 					JXTA_OBJECT_RELEASE(lease_requestor_id);
 					JXTA_OBJECT_RELEASE(lease_request_params);
 					JXTA_OBJECT_RELEASE(relay_client_address);
@@ -3142,10 +3970,11 @@ static void check_for_lease_request(Jxta_message *msg, _jxta_transport_relay *se
 					jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Unable to add lease to storage\n");
 					return;
 				}
-				JXTA_OBJECT_RELEASE(relay_lease);
 			} else {
 				/* this is a subsequent lease request */
-				relay_lease->issue_time=jpr_time_now();
+				lease_renew(self,relay_lease);
+				/* the client is back, deliver what was stored while it was away */
+				relay_delivery_schedule(self, relay_lease, TRUE);
 			}
 		}
 		else
@@ -3154,6 +3983,9 @@ static void check_for_lease_request(Jxta_message *msg, _jxta_transport_relay *se
 		}
 
 		
+		if (relay_lease) {
+			JXTA_OBJECT_RELEASE(relay_lease);
+		}
 		JXTA_OBJECT_RELEASE(relay_client_address);
 		JXTA_OBJECT_RELEASE(lease_request_params);
 	} /*if (lease_request_params && lease_requestor_id)*/
@@ -3236,10 +4068,6 @@ static Jxta_status send_relay_lease(_jxta_transport_relay *self, Jxta_endpoint_a
 	JXTA_OBJECT_RELEASE(rdv_advertisement);
 	JXTA_OBJECT_RELEASE(rdv_advertisement_string);
 
-	/* THIS NEEDS TO BE REMOVED WHEN THE BUG IN THE INITIALIZATION CODE IS FIXED */
-	/* sleep before sending in case the client is not fully initialized*/
-	apr_sleep(ONE_SECOND_MICRO*10);
-
 	status=send_message_to_peer(self, destAddr, msg_response);
 
 	JXTA_OBJECT_RELEASE(destAddr);
@@ -3260,6 +4088,19 @@ Jxta_boolean jxta_relay_is_server(Jxta_transport_relay_public* jxta_transport_re
 
 }
 
+Jxta_status jxta_relay_get_archive_stats(Jxta_transport_relay_public* jxta_transport_relay, Jxta_relay_archive_stats* stats)
+{
+	if (!jxta_transport_relay || !stats || !jxta_transport_relay->archive_mutex) {
+		return JXTA_INVALID_ARGUMENT;
+	}
+
+	apr_thread_mutex_lock(jxta_transport_relay->archive_mutex);
+	*stats = jxta_transport_relay->archive_stats;
+	apr_thread_mutex_unlock(jxta_transport_relay->archive_mutex);
+
+	return JXTA_SUCCESS;
+}
+
 /* Functions for managing doubly linked list
  * Since there is not linked list objects, only nodes
  * connected to each other, the linked list functions
@@ -91,6 +91,34 @@ typedef struct _jxta_transport_relay Jxta_transport_relay_public;
  *************************************************************************/
 Jxta_boolean jxta_relay_is_server(Jxta_transport_relay_public* jxta_transport_relay);
 
+/**
+ * Statistics of the messages kept by a relay server for its clients.
+ */
+typedef struct _jxta_relay_archive_stats {
+    /* messages and bytes kept in memory */
+    apr_uint32_t archived_msgs;
+    apr_uint64_t archived_bytes;
+    /* messages and bytes waiting in spill files */
+    apr_uint32_t spilled_msgs;
+    apr_uint64_t spilled_bytes;
+    /* bytes written to spill files since the relay started */
+    apr_uint64_t spilled_total_bytes;
+    /* messages dropped because the archive of the client was full */
+    apr_uint32_t dropped_msgs;
+    apr_uint64_t dropped_bytes;
+} Jxta_relay_archive_stats;
+
+/************************************************************************
+ * Get the statistics of the message archive of a relay server
+ *
+ *
+ * @param  jxta_transport_relay relay transport
+ * @param  stats receives the statistics
+ * @return  JXTA_SUCCESS or JXTA_INVALID_ARGUMENT if the relay is not
+ *          initialized
+ *************************************************************************/
+Jxta_status jxta_relay_get_archive_stats(Jxta_transport_relay_public* jxta_transport_relay, Jxta_relay_archive_stats* stats);
+
 
 #ifdef __cplusplus
 #if 0
@@ -0,0 +1,160 @@
+/* 
+ * Copyright (c) 2002 Sun Microsystems, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+#ifndef JXTA_RELAY_PRIVATE_H
+#define JXTA_RELAY_PRIVATE_H
+
+#include "jxta_types.h"
+#include "jxta_relay.h"
+#include "jxta_message.h"
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+};
+#endif
+#endif
+
+/*
+ * Lease table of a relay server, for tests which exercise the lease
+ * management without a peer group. The relay is a new instance which is
+ * neither initialized nor started.
+ */
+
+/**
+ * Creates the lease table of a relay.
+ *
+ * @param jxta_transport_relay a relay which is not initialized
+ * @param max_leases the maximum number of leases the relay grants
+ * @return JXTA_SUCCESS, JXTA_INVALID_ARGUMENT if the relay is initialized
+ *         or JXTA_NOMEM
+ */
+extern Jxta_status relay_leases_setup(Jxta_transport_relay_public* jxta_transport_relay, unsigned long max_leases);
+
+/**
+ * Grants a lease to a client as for a lease request: a client without a
+ * lease gets a new one, the lease of a known client is renewed.
+ *
+ * @param jxta_transport_relay the relay
+ * @param pid the peer id of the client
+ * @param duration the duration of a new lease in milliseconds
+ * @return JXTA_SUCCESS or JXTA_BUSY if the relay has the maximum number of
+ *         leases
+ */
+extern Jxta_status relay_lease_grant(Jxta_transport_relay_public* jxta_transport_relay, const char* pid, Jxta_time_diff duration);
+
+/**
+ * Tells if a client has a lease.
+ *
+ * @param jxta_transport_relay the relay
+ * @param pid the peer id of the client
+ * @return TRUE if the client has a lease, expired or not
+ */
+extern Jxta_boolean relay_lease_exists(Jxta_transport_relay_public* jxta_transport_relay, const char* pid);
+
+/**
+ * Removes the expired leases, as the delivery timer of the relay does.
+ *
+ * @param jxta_transport_relay the relay
+ * @return the number of leases left
+ */
+extern unsigned long relay_leases_expire(Jxta_transport_relay_public* jxta_transport_relay);
+
+/**
+ * Sets the message archive budgets of a relay whose lease table was
+ * created with relay_leases_setup.
+ *
+ * @param jxta_transport_relay the relay
+ * @param spill_dir the directory of the spill files, created if needed
+ * @param lease_archive_max_bytes the bytes of messages kept in memory for a client
+ * @param lease_spill_max_bytes the size of the spill file of a client
+ * @return JXTA_SUCCESS, JXTA_INVALID_ARGUMENT, JXTA_NOMEM or JXTA_IOERR
+ */
+extern Jxta_status relay_archive_setup(Jxta_transport_relay_public* jxta_transport_relay, const char* spill_dir,
+                                       apr_size_t lease_archive_max_bytes, apr_off_t lease_spill_max_bytes);
+
+/**
+ * Stores a message for a client, as for a message the client cannot
+ * receive right away.
+ *
+ * @param jxta_transport_relay the relay
+ * @param pid the peer id of the client
+ * @param msg the message
+ * @return JXTA_SUCCESS, JXTA_ITEM_NOTFOUND if the client has no lease or
+ *         JXTA_FAILED if the message was dropped
+ */
+extern Jxta_status relay_archive_put(Jxta_transport_relay_public* jxta_transport_relay, const char* pid, Jxta_message* msg);
+
+/**
+ * Removes the oldest message stored for a client, as delivery does,
+ * replaying the spill file once the messages in memory are gone.
+ *
+ * @param jxta_transport_relay the relay
+ * @param pid the peer id of the client
+ * @param msg receives the message
+ * @return JXTA_SUCCESS or JXTA_ITEM_NOTFOUND if no message is stored
+ */
+extern Jxta_status relay_archive_take(Jxta_transport_relay_public* jxta_transport_relay, const char* pid, Jxta_message** msg);
+
+#ifdef __cplusplus
+#if 0
+{
+#endif
+}
+#endif
+
+#endif /* JXTA_RELAY_PRIVATE_H */
+
+/* vi: set ts=4 sw=4 tw=130 et: */
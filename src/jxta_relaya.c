@@ -85,7 +85,8 @@ enum tokentype {
     IsClient_,
     IsServer_,
     HttpRelay_,
-    TcpRelay_
+    TcpRelay_,
+    SpillDirectory_
 };
 
 /** This is the representation of the 
@@ -101,6 +102,7 @@ struct _jxta_RelayAdvertisement {
     JString *IsServer;
     Jxta_vector *Httplist;
     Jxta_vector *Tcplist;
+    JString *SpillDirectory;
 
 };
 
@@ -201,6 +203,22 @@ static void handleIsServer(void *userdata, const XML_Char * cd, int len)
     ad->IsServer = isServer;
 }
 
+static void handleSpillDirectory(void *userdata, const XML_Char * cd, int len)
+{
+
+    JString *spillDirectory;
+
+    Jxta_RelayAdvertisement *ad = (Jxta_RelayAdvertisement *) userdata;
+    if (len == 0)
+        return;
+
+    spillDirectory = jstring_new_1(len);
+    jstring_append_0(spillDirectory, cd, len);
+    jstring_trim(spillDirectory);
+    JXTA_OBJECT_RELEASE(ad->SpillDirectory);
+    ad->SpillDirectory = spillDirectory;
+}
+
 /** The get/set functions represent the public
  * interface to the ad class, that is, the API.
  */
@@ -226,6 +244,28 @@ JXTA_DECLARE(void)
 }
 
 
+JXTA_DECLARE(JString *)
+    jxta_RelayAdvertisement_get_SpillDirectory(Jxta_RelayAdvertisement * ad)
+{
+    JXTA_OBJECT_SHARE(ad->SpillDirectory);
+    return ad->SpillDirectory;
+}
+
+
+char *JXTA_STDCALL jxta_RelayAdvertisement_get_SpillDirectory_string(Jxta_advertisement * ad)
+{
+    return strdup(jstring_get_string(((Jxta_RelayAdvertisement *) ad)->SpillDirectory));
+}
+
+JXTA_DECLARE(void)
+    jxta_RelayAdvertisement_set_SpillDirectory(Jxta_RelayAdvertisement * ad, JString * directory)
+{
+    JXTA_OBJECT_SHARE(directory);
+    JXTA_OBJECT_RELEASE(ad->SpillDirectory);
+    ad->SpillDirectory = directory;
+}
+
+
 JXTA_DECLARE(JString *)
     jxta_RelayAdvertisement_get_IsClient(Jxta_RelayAdvertisement * ad)
 {
@@ -292,6 +332,7 @@ JXTA_DECLARE(void)
 {
     JXTA_OBJECT_SHARE(relays);
     JXTA_OBJECT_RELEASE(ad->Tcplist);
+    JXTA_OBJECT_RELEASE(ad->SpillDirectory);
     ad->Tcplist = relays;
 }
 
@@ -318,6 +359,7 @@ static const Kwdtab Jxta_RelayAdvertisement_tags[] = {
     {"tcpaddress", TcpRelay_, *handleTcpRelay, *jxta_RelayAdvertisement_get_TcpRelay_string, NULL},
     {"httpaddr", HttpRelay_, *handleHttpRelay, *jxta_RelayAdvertisement_get_HttpRelay_string, NULL},
     {"tcpaddr", TcpRelay_, *handleTcpRelay, *jxta_RelayAdvertisement_get_TcpRelay_string, NULL},
+    {"spillDirectory", SpillDirectory_, *handleSpillDirectory, *jxta_RelayAdvertisement_get_SpillDirectory_string, NULL},
     {NULL, 0, 0, NULL, NULL}
 };
 
@@ -387,6 +429,12 @@ JXTA_DECLARE(Jxta_status)
     httpRelay_printer(ad, string);
     tcpRelay_printer(ad, string);
 
+    if (jstring_length(ad->SpillDirectory) > 0) {
+        jstring_append_2(string, "<spillDirectory>");
+        jstring_append_1(string, ad->SpillDirectory);
+        jstring_append_2(string, "</spillDirectory>\n");
+    }
+
     jstring_append_2(string, "</jxta:RelayAdvertisement>\n");
 
     *result = string;
@@ -421,6 +469,7 @@ JXTA_DECLARE(Jxta_RelayAdvertisement *)
     ad->IsClient = jstring_new_0();
     ad->Httplist = jxta_vector_new(2);
     ad->Tcplist = jxta_vector_new(2);
+    ad->SpillDirectory = jstring_new_0();
 
     return ad;
 }
@@ -87,6 +87,14 @@ JXTA_DECLARE(Jxta_vector *) jxta_RelayAdvertisement_get_TcpRelay(Jxta_RelayAdver
 JXTA_DECLARE(void) jxta_RelayAdvertisement_set_TcpRelay(Jxta_RelayAdvertisement *, Jxta_vector *);
 JXTA_DECLARE(void) jxta_RelayAdvertisement_add_TcpRelay(Jxta_RelayAdvertisement *, JString *);
 
+/**
+ * The directory where a relay server spills the messages it cannot keep in
+ * memory for its clients. Empty to use the default, ".relay" in the current
+ * directory.
+ */
+JXTA_DECLARE(JString *) jxta_RelayAdvertisement_get_SpillDirectory(Jxta_RelayAdvertisement *);
+JXTA_DECLARE(void) jxta_RelayAdvertisement_set_SpillDirectory(Jxta_RelayAdvertisement *, JString *);
+
 JXTA_DECLARE(void) httpRelay_printer(Jxta_RelayAdvertisement *, JString *);
 JXTA_DECLARE(void) tcpRelay_printer(Jxta_RelayAdvertisement *, JString *);
 
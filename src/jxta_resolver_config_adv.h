@@ -0,0 +1,113 @@
+/* 
+ * Copyright (c) 2006 Sun Microsystems, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+
+
+#ifndef JXTA_RESOLVERCONFIGADVERTISEMENT_H__
+#define JXTA_RESOLVERCONFIGADVERTISEMENT_H__
+
+#include "jxta_types.h"
+#include "jxta_advertisement.h"
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+};
+#endif
+#endif
+typedef struct _jxta_ResolverConfigAdvertisement Jxta_ResolverConfigAdvertisement;
+
+JXTA_DECLARE(Jxta_ResolverConfigAdvertisement *) jxta_ResolverConfigAdvertisement_new(void);
+JXTA_DECLARE(Jxta_status) jxta_ResolverConfigAdvertisement_get_xml(Jxta_ResolverConfigAdvertisement *, JString **);
+JXTA_DECLARE(void) jxta_ResolverConfigAdvertisement_parse_charbuffer(Jxta_ResolverConfigAdvertisement *, const char *,
+                                                                     size_t len);
+JXTA_DECLARE(void) jxta_ResolverConfigAdvertisement_parse_file(Jxta_ResolverConfigAdvertisement *, FILE * stream);
+
+/**
+ * Number of peers remembered as having received our route advertisement with a query. 0 disables the cache and the route
+ * is sent with every query.
+ **/
+JXTA_DECLARE(void) jxta_resolver_config_set_mru_size(Jxta_ResolverConfigAdvertisement * adv, int size);
+JXTA_DECLARE(int) jxta_resolver_config_get_mru_size(Jxta_ResolverConfigAdvertisement * adv);
+
+/**
+ * Time in milliseconds after which our route advertisement is sent again to a peer of the cache. 0 means the entries never
+ * expire and are only evicted by newer ones.
+ **/
+JXTA_DECLARE(void) jxta_resolver_config_set_mru_window(Jxta_ResolverConfigAdvertisement * adv, Jxta_time_diff window);
+JXTA_DECLARE(Jxta_time_diff) jxta_resolver_config_get_mru_window(Jxta_ResolverConfigAdvertisement * adv);
+
+/**
+ * Whether SRDI messages are compressed with the preset SRDI dictionary for the peers which announced they share it. The
+ * dictionary is announced only when enabled, messages compressed with it are always accepted.
+ **/
+JXTA_DECLARE(void) jxta_resolver_config_set_srdi_dictionary(Jxta_ResolverConfigAdvertisement * adv, Jxta_boolean enable);
+JXTA_DECLARE(Jxta_boolean) jxta_resolver_config_get_srdi_dictionary(Jxta_ResolverConfigAdvertisement * adv);
+
+/**
+*   For other advertisement types which want to parse ResolverConfig as a sub-section.    
+**/
+void handleJxta_ResolverConfigAdvertisement(void *userdata, const XML_Char * cd, int len);
+
+#ifdef __cplusplus
+#if 0
+{
+#endif
+}
+#endif
+
+#endif /* JXTA_RESOLVERCONFIGADVERTISEMENT_H__  */
+
+/* vim: set ts=4 sw=4 et tw=130: */
@@ -59,6 +59,7 @@
 
 #include "jxta_resolver_service.h"
 #include "jxta_service_private.h"
+#include "jxta_message.h"
 
 
 /****************************************************************
@@ -121,6 +122,57 @@ extern void jxta_resolver_service_construct(Jxta_resolver_service * service, Jxt
 extern void jxta_resolver_service_destruct(Jxta_resolver_service * service);
 
 Jxta_status resolver_query_create(JString * handlername, JString * qdoc, Jxta_id * src_peerid, Jxta_resolver_query ** rq);
+
+/**
+ * The preset deflate dictionary of SRDI messages, made of the tokens common to the ResolverSRDI and GenSRDI documents. Both
+ * ends must use the very same bytes, any change makes a new dictionary which is negotiated by its adler32 checksum.
+ *
+ * @param len receives the length of the dictionary.
+ * @return the dictionary.
+ */
+const char *resolver_srdi_dictionary_get(size_t * len);
+
+/**
+ * The largest SRDI document a peer accepts to inflate, a few kilobytes of deflated data must not take the peer memory.
+ */
+#define RESOLVER_SRDI_INFLATE_MAX (4 * 1024 * 1024)
+
+/*
+ * Unit test hooks on the SRDI compression of a resolver instance which was not initialized with a group.
+ */
+
+/**
+ * Prepare the compression state of a new resolver instance.
+ *
+ * @param pool the pool of the locks, it must outlive the instance.
+ * @param peerid the local peer id announced with the dictionary.
+ * @param srdi_dict whether the preset dictionary is announced and used.
+ */
+Jxta_status resolver_zip_setup(Jxta_resolver_service * resolver, apr_pool_t * pool, Jxta_id * peerid, Jxta_boolean srdi_dict);
+
+/**
+ * Deflate an SRDI document for a peer as sendSrdi does.
+ *
+ * @param out receives the deflated bytes in a buffer to be freed by the caller.
+ * @param dict receives TRUE if the preset dictionary was used.
+ * @return 0 on success.
+ */
+int resolver_zip_compress(Jxta_resolver_service * resolver, Jxta_id * peerid, unsigned char **out, size_t * out_len,
+                          const char *in, size_t in_len, Jxta_boolean * dict);
+
+/**
+ * Inflate an SRDI message element as the SRDI callback does.
+ *
+ * @param out receives the inflated bytes in a buffer to be freed by the caller.
+ * @return Z_OK on success or the zlib error.
+ */
+int resolver_zip_uncompress(Jxta_resolver_service * resolver, unsigned char **out, size_t * out_len, const unsigned char *in,
+                            size_t in_len);
+
+/**
+ * Learn the dictionary announcement of a received SRDI message.
+ */
+void resolver_srdi_dict_learn(Jxta_resolver_service * resolver, Jxta_message * msg);
                                                         
 
 #ifdef __cplusplus
@@ -72,6 +72,8 @@ static const char *__log_cat = "RSLVR";
 #include "jxta_hashtable.h"
 #include "jxta_peergroup.h"
 #include "jxta_message.h"
+#include "jxta_pa.h"
+#include "jxta_svc.h"
 
 #include "jxta_private.h"
 #include "jxta_resolver_service_private.h"
@@ -81,6 +83,39 @@ static const char *__log_cat = "RSLVR";
 #include "jxta_endpoint_service_priv.h"
 #include "jxta_peergroup_private.h"
 
+#ifdef GZIP_ENABLED
+#ifndef GUNZIP_ENABLED
+#define GUNZIP_ENABLED
+#endif /* ndef GUNZIP_ENABLED */
+#endif /* GZIP_ENABLED */
+
+/*
+ * A peer we sent our route advertisement to. The entries are kept in a FIFO ring of mru_capacity slots and indexed by the
+ * unique portion of the peer id.
+ */
+typedef struct {
+    Jxta_PID *peer;
+    JString *key;
+    Jxta_time added;
+} Mru_entry;
+
+#ifdef GUNZIP_ENABLED
+/* kinds of reusable zlib streams, each kind has its own free list */
+enum zip_kind {
+    ZIP_DEFLATE_GZIP,           /* gzip wrapper, understood by every peer */
+    ZIP_DEFLATE_DICT,           /* zlib wrapper with the preset SRDI dictionary */
+    ZIP_INFLATE,                /* accepts both wrappers */
+    ZIP_KINDS
+};
+
+typedef struct _zip_stream Zip_stream;
+
+struct _zip_stream {
+    Zip_stream *next;
+    z_stream strm;
+};
+#endif /* GUNZIP_ENABLED */
+
 typedef struct {
     Extends(Jxta_resolver_service);
     Jxta_boolean running;
@@ -103,15 +138,20 @@ typedef struct {
     size_t mru_capacity;
     size_t mru_size;
     size_t mru_pos;
-    Jxta_PID **mru;
+    Jxta_time_diff mru_window;
+    Mru_entry *mru;
+    apr_hash_t *mru_index;
+#ifdef GUNZIP_ENABLED
+    apr_thread_mutex_t *zip_mutex;
+    Zip_stream *zip_idle[ZIP_KINDS];
+    int zip_idle_cnt[ZIP_KINDS];
+    Jxta_boolean srdi_dict;
+    uLong dict_id;
+    char *dict_announce;
+    Jxta_hashtable *dict_peers;
+#endif
 } Jxta_resolver_service_ref;
 
-#ifdef GZIP_ENABLED
-#ifndef GUNZIP_ENABLED
-#define GUNZIP_ENABLED
-#endif /* ndef GUNZIP_ENABLED */
-#endif /* GZIP_ENABLED */
-
 /* used to make an address out of a peerid */
 static Jxta_status JXTA_STDCALL resolver_service_query_cb(Jxta_object * obj, void *arg);
 static Jxta_status JXTA_STDCALL resolver_service_response_cb(Jxta_object * obj, void *arg);
@@ -119,19 +159,37 @@ static Jxta_status JXTA_STDCALL resolver_service_srdi_cb(Jxta_object * obj, void
 static long getid(Jxta_resolver_service_ref * resolver);
 static Jxta_status learn_route_from_query(Jxta_resolver_service_ref * me, ResolverQuery * rq);
 
+static const char *SRDI_DICT_MIME_TYPE = "application/x-jxta-srdi-zdict";
+static const char *SRDI_DICT_ELEMENT_NAME = "SrdiDict";
+
 #ifdef GUNZIP_ENABLED
-static int zip_uncompress(Byte * dest, uLong * destLen, Byte * source, uLong sourceLen);
+/* number of idle streams kept per kind */
+#define ZIP_IDLE_MAX 4
+
+static Jxta_status zip_setup(Jxta_resolver_service_ref * me, apr_pool_t * pool, Jxta_boolean srdi_dict);
+#ifdef GZIP_ENABLED
+static int zip_kind_get(Jxta_resolver_service_ref * me, JString * jpeerid);
+#endif /* GZIP_ENABLED */
+static Zip_stream *zip_stream_get(Jxta_resolver_service_ref * me, int kind);
+static void zip_stream_put(Jxta_resolver_service_ref * me, int kind, Zip_stream * zs);
+static void zip_streams_destroy(Jxta_resolver_service_ref * me);
+static void srdi_dict_learn(Jxta_resolver_service_ref * me, Jxta_message * msg);
+static int zip_uncompress(Jxta_resolver_service_ref * me, unsigned char **out, size_t * out_len, const unsigned char *in,
+                          size_t in_len);
 #ifdef GZIP_ENABLED
-static int zip_compress(unsigned char **out, size_t * out_len, const char *in, size_t in_len);
+static int zip_compress(Jxta_resolver_service_ref * me, int kind, unsigned char **out, size_t * out_len, const char *in,
+                        size_t in_len);
 #endif /* GZIP_ENABLED */
 #endif /* GUNZIP_ENABLED */
 static const char *INQUENAMESHORT = "IRes";
 static const char *OUTQUENAMESHORT = "ORes";
 static const char *SRDIQUENAMESHORT = "Srdi";
 static const char *JXTA_NAMESPACE = "jxta:";
+static const char *JXTA_NS = "jxta";
 
 /* Most recently used cache for peers we sent RouteAdv */
 static void mru_reset(Jxta_resolver_service_ref * me);
+static void mru_entry_clear(Jxta_resolver_service_ref * me, Mru_entry * entry);
 static Jxta_status mru_capacity_set(Jxta_resolver_service_ref * me, size_t capacity);
 static void mru_check(Jxta_resolver_service_ref * me, ResolverQuery * query, Jxta_id * peerid);
 
@@ -174,6 +232,9 @@ jxta_resolver_service_ref_init(Jxta_module * resolver, Jxta_PG * group, Jxta_id
     Jxta_status status = JXTA_SUCCESS;
     Jxta_resolver_service_ref *self = (Jxta_resolver_service_ref *) resolver;
     apr_pool_t *pool;
+    Jxta_PA *conf_adv = NULL;
+    Jxta_svc *svc = NULL;
+    Jxta_ResolverConfigAdvertisement *config = NULL;
 
     /* Test arguments first */
     if ((resolver == NULL) || (group == NULL)) {
@@ -234,12 +295,45 @@ jxta_resolver_service_ref_init(Jxta_module * resolver, Jxta_PG * group, Jxta_id
         }
     }
 
-    self->mru_capacity = 20;
-    self->mru = calloc(self->mru_capacity, sizeof(*self->mru));
-    if (!self->mru) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Failed to allocate memory for MRU, disable the feature\n");
+    jxta_PG_get_configadv(group, &conf_adv);
+    if (!conf_adv) {
+        Jxta_PG *parentgroup;
+
+        jxta_PG_get_parentgroup(group, &parentgroup);
+        if (parentgroup) {
+            jxta_PG_get_configadv(parentgroup, &conf_adv);
+            JXTA_OBJECT_RELEASE(parentgroup);
+        }
+    }
+    if (conf_adv != NULL) {
+        jxta_PA_get_Svc_with_id(conf_adv, jxta_resolver_classid, &svc);
+        if (NULL != svc) {
+            config = jxta_svc_get_ResolverConfig(svc);
+            JXTA_OBJECT_RELEASE(svc);
+        }
+        JXTA_OBJECT_RELEASE(conf_adv);
     }
+    if (NULL == config) {
+        config = jxta_ResolverConfigAdvertisement_new();
+    }
+
+    self->mru_index = apr_hash_make(pool);
+    self->mru_window = jxta_resolver_config_get_mru_window(config);
+    self->mru_capacity = 0;
+    self->mru = NULL;
     self->mru_pos = self->mru_size = 0;
+    if (JXTA_SUCCESS != mru_capacity_set(self, jxta_resolver_config_get_mru_size(config))) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Failed to allocate memory for MRU, disable the feature\n");
+    }
+
+#ifdef GUNZIP_ENABLED
+    if (JXTA_SUCCESS != zip_setup(self, pool, jxta_resolver_config_get_srdi_dictionary(config))) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
+        JXTA_OBJECT_RELEASE(config);
+        return JXTA_NOMEM;
+    }
+#endif
+    JXTA_OBJECT_RELEASE(config);
     return status;
 }
 
@@ -491,28 +585,39 @@ static Jxta_status unregisterResponseHandler(Jxta_resolver_service * resolver, J
     return status;
 }
 
+/*
+ * Build a text/xml element named jxta:<queue> which takes over the buffer of doc instead of copying it. doc is left empty.
+ */
+static Jxta_message_element *doc_element_new(const char *queue, JString * doc)
+{
+    Jxta_message_element *el;
+    Jxta_bytevector *value;
+    size_t len;
+    char *buf = NULL;
+
+    len = jstring_length(doc);
+    jstring_reset(doc, &buf);
+    value = jxta_bytevector_new_3(buf, len, TRUE);
+    if (NULL == value) {
+        free(buf);
+        return NULL;
+    }
+    el = jxta_message_element_new_3(JXTA_NS, queue, "text/xml", value, NULL);
+    JXTA_OBJECT_RELEASE(value);
+    return el;
+}
+
 static Jxta_status do_send(Jxta_resolver_service_ref * me, Jxta_id * peerid, JString * doc, const char *queue, 
                            const Jxta_qos * qos)
 {
     Jxta_message *msg = NULL;
     Jxta_message_element *msgElem;
     Jxta_endpoint_address *address;
-    char *tmp;
     Jxta_status status;
-    JString *el_name;
-
-    tmp = malloc(jstring_length(doc) + 1);
-    if (tmp == NULL) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
-        return JXTA_NOMEM;
-    }
-    tmp[jstring_length(doc)] = 0;
-    memcpy(tmp, jstring_get_string(doc), jstring_length(doc));
 
     msg = jxta_message_new();
     if (msg == NULL) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
-        free(tmp);
         return JXTA_NOMEM;
     }
 
@@ -520,17 +625,7 @@ static Jxta_status do_send(Jxta_resolver_service_ref * me, Jxta_id * peerid, JSt
         jxta_message_attach_qos(msg, qos);
     }
 
-    el_name = jstring_new_2(JXTA_NAMESPACE);
-    if (el_name == NULL) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
-        JXTA_OBJECT_RELEASE(msg);
-        free(tmp);
-        return JXTA_NOMEM;
-    }
-    jstring_append_2(el_name, queue);
-    msgElem = jxta_message_element_new_1(jstring_get_string(el_name), "text/xml", tmp, strlen(tmp), NULL);
-    JXTA_OBJECT_RELEASE(el_name);
-    free(tmp);
+    msgElem = doc_element_new(queue, doc);
     if (msgElem == NULL) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "failed to create message element.\n");
         JXTA_OBJECT_RELEASE(msg);
@@ -572,28 +667,35 @@ static Jxta_status do_send(Jxta_resolver_service_ref * me, Jxta_id * peerid, JSt
     return status;
 }
 
+static void mru_entry_clear(Jxta_resolver_service_ref * me, Mru_entry * entry)
+{
+    apr_hash_set(me->mru_index, jstring_get_string(entry->key), APR_HASH_KEY_STRING, NULL);
+    JXTA_OBJECT_RELEASE(entry->key);
+    JXTA_OBJECT_RELEASE(entry->peer);
+    entry->key = NULL;
+    entry->peer = NULL;
+}
+
 static void mru_reset(Jxta_resolver_service_ref * me)
 {
     size_t i;
 
-    if (!me->mru) {
-        return;
-    }
-
     apr_thread_mutex_lock(me->mutex);
-    for (i = 0; i < me->mru_size; i++) {
-        JXTA_OBJECT_RELEASE(me->mru[i]);
+    if (me->mru) {
+        for (i = 0; i < me->mru_size; i++) {
+            mru_entry_clear(me, &me->mru[i]);
+        }
     }
     me->mru_size = me->mru_pos = 0;
     apr_thread_mutex_unlock(me->mutex);
 }
 
+/*
+ * Resize the MRU, the cached peers are dropped and will receive our route advertisement with the next query.
+ */
 static Jxta_status mru_capacity_set(Jxta_resolver_service_ref * me, size_t capacity)
 {
-    Jxta_PID **new_mru = NULL;
-    size_t pos;
-    size_t i;
-    size_t cnt;
+    Mru_entry *new_mru = NULL;
     Jxta_status rv = JXTA_SUCCESS;
 
     apr_thread_mutex_lock(me->mutex);
@@ -602,55 +704,18 @@ static Jxta_status mru_capacity_set(Jxta_resolver_service_ref * me, size_t capac
         goto FINAL_EXIT;
     }
 
-    /* mru_capacity could be non-0 while mru is NULL when system is out of memory */
-    if (0 == capacity) {
-        if (me->mru) {
-            mru_reset(me);
-            free(me->mru);
-            me->mru = NULL;
-            me->mru_size = me->mru_pos = 0;
-        }
-        goto FINAL_EXIT;
-    }
-
-    new_mru = calloc(capacity, sizeof(*new_mru));
-    if (!new_mru) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Failed to allocate memory for MRU, keep original MRU\n");
-        rv = JXTA_NOMEM;
-        goto FINAL_EXIT;
-    }
-
-    if (!me->mru) {
-        assert(0 == me->mru_size);
-        assert(0 == me->mru_pos);
-        me->mru_capacity = capacity;
-        me->mru = new_mru;
-        goto FINAL_EXIT;
-    }
-
-    pos = (me->mru_size < me->mru_capacity) ? 0 : me->mru_pos;
-    cnt = (me->mru_size < capacity) ? me->mru_size : capacity;
-    /* remove extra entries over the new capacity */
-    if (capacity < me->mru_size) {
-        for (i = capacity; i < me->mru_size; ++i) {
-            JXTA_OBJECT_RELEASE(me->mru[pos++]);
-            if (pos >= me->mru_capacity) {
-                pos = 0;
-            }
-        }
-    }
-
-    for (i = 0; i < cnt; i++) {
-        new_mru[i] = me->mru[pos++];
-        if (pos >= me->mru_capacity) {
-            pos = 0;
+    if (capacity > 0) {
+        new_mru = calloc(capacity, sizeof(*new_mru));
+        if (!new_mru) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Failed to allocate memory for MRU, keep original MRU\n");
+            rv = JXTA_NOMEM;
+            goto FINAL_EXIT;
         }
     }
 
+    mru_reset(me);
     free(me->mru);
     me->mru = new_mru;
-    me->mru_pos = (i == capacity) ? 0 : i;
-    me->mru_size = i;
     me->mru_capacity = capacity;
 
   FINAL_EXIT:
@@ -661,11 +726,14 @@ static Jxta_status mru_capacity_set(Jxta_resolver_service_ref * me, size_t capac
 /*
  * check if the peerid is in MRU cache, if it is not, add SrcPeerRoute tag to include RA
  * if the query already has a SrcPeerRoute tag, this is a forwarded query, don't modify the tag
+ * An entry older than mru_window is treated as a miss and refreshed in place, the peer may have dropped our route since.
  */
 static void mru_check(Jxta_resolver_service_ref * me, ResolverQuery * query, Jxta_id * peerid)
 {
-    size_t i;
     Jxta_RouteAdvertisement *route;
+    Mru_entry *entry;
+    JString *key = NULL;
+    Jxta_time now;
 
     route = jxta_resolver_query_get_src_peer_route(query);
     if (route) {
@@ -673,26 +741,37 @@ static void mru_check(Jxta_resolver_service_ref * me, ResolverQuery * query, Jxt
         return;
     }
 
-    if (me->mru) {
+    if (NULL != peerid && JXTA_SUCCESS == jxta_id_get_uniqueportion(peerid, &key)) {
+        now = jpr_time_now();
         apr_thread_mutex_lock(me->mutex);
-        for (i = 0; i < me->mru_size; i++) {
-            if (jxta_id_equals(me->mru[i], peerid)) {
+        entry = me->mru ? apr_hash_get(me->mru_index, jstring_get_string(key), APR_HASH_KEY_STRING) : NULL;
+        if (NULL != entry) {
+            if (0 == me->mru_window || now - entry->added < me->mru_window) {
                 apr_thread_mutex_unlock(me->mutex);
+                JXTA_OBJECT_RELEASE(key);
                 return;
             }
-        }
+            entry->added = now;
+        } else if (me->mru) {
+            /* the slot at mru_pos holds the oldest entry once the ring is full */
+            entry = &me->mru[me->mru_pos];
+            if (NULL != entry->peer) {
+                mru_entry_clear(me, entry);
+            }
+            entry->peer = JXTA_OBJECT_SHARE(peerid);
+            entry->key = JXTA_OBJECT_SHARE(key);
+            entry->added = now;
+            apr_hash_set(me->mru_index, jstring_get_string(entry->key), APR_HASH_KEY_STRING, entry);
 
-        JXTA_OBJECT_RELEASE(me->mru[me->mru_pos]);
-        me->mru[me->mru_pos++] = JXTA_OBJECT_SHARE(peerid);
-        if (me->mru_pos >= me->mru_capacity) {
-            me->mru_pos = 0;
-        } 
-        
-        if (me->mru_size < me->mru_capacity) {
-            me->mru_size++;
+            if (++me->mru_pos >= me->mru_capacity) {
+                me->mru_pos = 0;
+            }
+            if (me->mru_size < me->mru_capacity) {
+                me->mru_size++;
+            }
         }
-
         apr_thread_mutex_unlock(me->mutex);
+        JXTA_OBJECT_RELEASE(key);
     }
 
     route = jxta_endpoint_service_get_local_route(me->endpoint);
@@ -771,17 +850,16 @@ static Jxta_status sendSrdi(Jxta_resolver_service * resolver, ResolverSrdi * mes
     Jxta_message *msg = NULL;
     Jxta_message_element *msgElem = NULL;
     Jxta_endpoint_address *address = NULL;
-    unsigned char *tmp = NULL;
     unsigned char *zipped = NULL;
-    unsigned char *bytes = NULL;
     size_t zipped_len = 0;
     int ret = 0;
-    size_t byte_len = 0;
     JString *doc = NULL;
     Jxta_bytevector *jSend_buf = NULL;
     Jxta_status status;
     JString *jpeerid = NULL;
-    JString *el_name = NULL;
+#ifdef GZIP_ENABLED
+    int kind;
+#endif
 
     Jxta_resolver_service_ref *self = PTValid(resolver, Jxta_resolver_service_ref);
     if (NULL != peerid) {
@@ -789,28 +867,18 @@ static Jxta_status sendSrdi(Jxta_resolver_service * resolver, ResolverSrdi * mes
     }
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Send SRDI resolver message to %s\n",
                          jpeerid == NULL? "all(through propagate)" : jstring_get_string(jpeerid));
-    if (jpeerid) {
-        JXTA_OBJECT_RELEASE(jpeerid);
-    }
     
     /* Test arguments first */
     if ((self == NULL) || (message == NULL)) {
         /* Invalid args. */
-        return JXTA_INVALID_ARGUMENT;
+        status = JXTA_INVALID_ARGUMENT;
+        goto FINAL_EXIT;
     }
 
     status = jxta_resolver_srdi_get_xml(message, &doc);
     if (status != JXTA_SUCCESS) {
-        return status;
-    }
-
-    tmp = (unsigned char *) calloc(1, jstring_length(doc) + 1);
-    if (NULL == tmp) {
-        status = JXTA_NOMEM;
         goto FINAL_EXIT;
     }
-    tmp[jstring_length(doc)] = 0;
-    memcpy(tmp, jstring_get_string(doc), jstring_length(doc));
 
     msg = jxta_message_new();
     if (msg == NULL) {
@@ -818,40 +886,28 @@ static Jxta_status sendSrdi(Jxta_resolver_service * resolver, ResolverSrdi * mes
         status = JXTA_NOMEM;
         goto FINAL_EXIT;
     }
-    el_name = jstring_new_2(JXTA_NAMESPACE);
-    if (el_name == NULL) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
-        status = JXTA_NOMEM;
-        goto FINAL_EXIT;
-    }
-    jstring_append_2(el_name, self->srdique);
 
 #ifndef GZIP_ENABLED
-    msgElem = jxta_message_element_new_1(jstring_get_string(el_name), "text/xml", (char *) tmp, strlen((char *) tmp), NULL);
+    msgElem = doc_element_new(self->srdique, doc);
 #else
-    ret = zip_compress(&zipped, &zipped_len, (const char *) tmp, (size_t) strlen((char *) tmp));
+    kind = zip_kind_get(self, jpeerid);
+    ret = zip_compress(self, kind, &zipped, &zipped_len, jstring_get_string(doc), jstring_length(doc));
 
     if (Z_OK == ret) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "length:%d zipped_len:%d \n", strlen((char *) tmp), zipped_len);
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "length:%d zipped_len:%d \n", jstring_length(doc), zipped_len);
+        /* the bytevector takes over the compressed buffer */
         jSend_buf = jxta_bytevector_new_2(zipped, zipped_len, zipped_len);
         if (jSend_buf == NULL) {
             jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
+            free(zipped);
             status = JXTA_NOMEM;
             goto FINAL_EXIT;
         }
-        byte_len = jxta_bytevector_size(jSend_buf);
-        bytes = calloc(1, byte_len);
-        if (NULL == bytes) {
-            status = JXTA_NOMEM;
-            goto FINAL_EXIT;
-        }
-        jxta_bytevector_get_bytes_at(jSend_buf, bytes, 0, byte_len);
-        msgElem =
-            jxta_message_element_new_1(jstring_get_string(el_name), "application/gzip", (char *) bytes,
-                                       jxta_bytevector_size(jSend_buf), NULL);
+        msgElem = jxta_message_element_new_3(JXTA_NS, self->srdique,
+                                             ZIP_DEFLATE_DICT == kind ? SRDI_DICT_MIME_TYPE : "application/gzip", jSend_buf, NULL);
     } else {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "GZip comression error %d \n", ret);
-        msgElem = jxta_message_element_new_1(jstring_get_string(el_name), "text/xml", (char *) tmp, strlen((char *) tmp), NULL);
+        msgElem = doc_element_new(self->srdique, doc);
     }
 #endif
     if (msgElem == NULL) {
@@ -861,6 +917,19 @@ static Jxta_status sendSrdi(Jxta_resolver_service * resolver, ResolverSrdi * mes
     }
     jxta_message_add_element(msg, msgElem);
 
+#ifdef GUNZIP_ENABLED
+    if (self->srdi_dict) {
+        Jxta_message_element *dictElem;
+
+        dictElem = jxta_message_element_new_2(JXTA_NS, SRDI_DICT_ELEMENT_NAME, "text/plain", self->dict_announce,
+                                              strlen(self->dict_announce), NULL);
+        if (NULL != dictElem) {
+            jxta_message_add_element(msg, dictElem);
+            JXTA_OBJECT_RELEASE(dictElem);
+        }
+    }
+#endif
+
     if (peerid == NULL) {
         jxta_rdv_service_walk(self->rendezvous, msg, self->instanceName, self->srdique);
     } else {
@@ -879,8 +948,6 @@ static Jxta_status sendSrdi(Jxta_resolver_service * resolver, ResolverSrdi * mes
   FINAL_EXIT:
     if (jSend_buf)
         JXTA_OBJECT_RELEASE(jSend_buf);
-    if (el_name)
-        JXTA_OBJECT_RELEASE(el_name);
     if (msgElem)
         JXTA_OBJECT_RELEASE(msgElem);
     if (msg)
@@ -889,10 +956,8 @@ static Jxta_status sendSrdi(Jxta_resolver_service * resolver, ResolverSrdi * mes
         JXTA_OBJECT_RELEASE(doc);
     if (address)
         JXTA_OBJECT_RELEASE(address);
-    if (tmp)
-        free(tmp);
-    if (bytes)
-        free(bytes);
+    if (jpeerid)
+        JXTA_OBJECT_RELEASE(jpeerid);
     return status;
 }
 
@@ -967,6 +1032,12 @@ void jxta_resolver_service_ref_destruct(Jxta_resolver_service_ref * self)
 
     /* release/free/destroy our own stuff */
     mru_capacity_set(self, 0);
+#ifdef GUNZIP_ENABLED
+    zip_streams_destroy(self);
+    if (self->dict_peers != NULL) {
+        JXTA_OBJECT_RELEASE(self->dict_peers);
+    }
+#endif
     if (self->rendezvous != 0) {
         JXTA_OBJECT_RELEASE(self->rendezvous);
     }
@@ -996,6 +1067,9 @@ void jxta_resolver_service_ref_destruct(Jxta_resolver_service_ref * self)
     }
 
     apr_thread_mutex_destroy(self->mutex);
+#ifdef GUNZIP_ENABLED
+    apr_thread_mutex_destroy(self->zip_mutex);
+#endif
     /* call the base classe's dtor. */
     jxta_resolver_service_destruct((Jxta_resolver_service *) self);
 
@@ -1334,6 +1408,10 @@ static Jxta_status JXTA_STDCALL resolver_service_srdi_cb(Jxta_object * obj, void
     /*jxta_message_print(msg); */
     JXTA_OBJECT_CHECK_VALID(msg);
 
+#ifdef GUNZIP_ENABLED
+    srdi_dict_learn(resolver, msg);
+#endif
+
     el_name = jstring_new_2(JXTA_NAMESPACE);
     if (el_name == NULL) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
@@ -1348,7 +1426,7 @@ static Jxta_status JXTA_STDCALL resolver_service_srdi_cb(Jxta_object * obj, void
         if (mime_type != NULL) {
             unsigned char *bytes = NULL;
             unsigned char *uncompr = NULL;
-            unsigned long uncomprLen = 0;
+            size_t uncomprLen = 0;
             int size, err;
             Jxta_bytevector *jb = jxta_message_element_get_value(element);
             size = jxta_bytevector_size(jb);
@@ -1361,17 +1439,9 @@ static Jxta_status JXTA_STDCALL resolver_service_srdi_cb(Jxta_object * obj, void
             }
             jxta_bytevector_get_bytes_at(jb, bytes, 0, size);
             JXTA_OBJECT_RELEASE(jb);
-            if (!strcmp(mime_type, "application/gzip")) {
+            if (!strcmp(mime_type, "application/gzip") || !strcmp(mime_type, SRDI_DICT_MIME_TYPE)) {
 #ifdef GUNZIP_ENABLED
-                uncomprLen = 40 * size;
-                uncompr = calloc(1, uncomprLen);
-                if (uncompr == NULL) {
-                    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
-                    free(bytes);
-                    JXTA_OBJECT_RELEASE(element);
-                    return JXTA_NOMEM;
-                }
-                err = zip_uncompress((Byte *)uncompr, &uncomprLen, (Byte *)bytes, size);
+                err = zip_uncompress(resolver, &uncompr, &uncomprLen, bytes, size);
                 free(bytes);
                 if (err != Z_OK) {
                     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Error %d from zlib\n", err);
@@ -1439,111 +1509,419 @@ static long getid(Jxta_resolver_service_ref * resolver)
     return resolver->query_id;
 }
 
+/*
+ * The most frequent strings come last, they are the cheapest to reference from the start of a message.
+ */
+static const char SRDI_DICTIONARY[] =
+    "jxta:PipeAdvertisement jxta:PGA jxta:MIA jxta:MCA jxta:MSA jxta:RA JxtaUnicastSecure JxtaPropagate JxtaUnicast "
+    "Desc GID MSID Type Peers Groups DstPID resend=\"yes\" Range=\" sN=\" &lt;delta /&gt;\n"
+    "<?xml version=\"1.0\"?>\n<!DOCTYPE jxta:ResolverSRDI><jxta:ResolverSRDI>\n"
+    "<HandlerName>urn:jxta:uuid-DEADBEEFDEAFBABAFEEDBABE000000</HandlerName>\n<Payload>"
+    "&lt;?xml version=\"1.0\"?&gt;\n&lt;!DOCTYPE jxta:GenSRDI&gt;\n&lt;jxta:GenSRDI&gt;\n&lt;ttl&gt;1&lt;/ttl&gt;\n"
+    "&lt;PID&gt;urn:jxta:uuid-59616261646162614A78746150325033&lt;/PID&gt;\n&lt;PKey&gt;Adv&lt;/PKey&gt;\n"
+    "</Payload>\n</jxta:ResolverSRDI>\n"
+    "&lt;Entry  Expiration=\"9223372036854775807\" SKey=\"Name\" nSpace=\"jxta:PA\" AdvId=\"urn:jxta:uuid-"
+    "\"&gt;\n&lt;/Entry&gt;\n";
+
+const char *resolver_srdi_dictionary_get(size_t * len)
+{
+    *len = sizeof(SRDI_DICTIONARY) - 1;
+    return SRDI_DICTIONARY;
+}
+
 #ifdef GUNZIP_ENABLED
-static int zip_uncompress(Byte * dest, uLong * destLen, Byte * source, uLong sourceLen)
+/*
+ * Create the compression state. The local peer id must be known, it goes into the dictionary announcement.
+ */
+static Jxta_status zip_setup(Jxta_resolver_service_ref * me, apr_pool_t * pool, Jxta_boolean srdi_dict)
 {
-    z_stream stream;
-    int err;
-    stream.next_in = (Bytef *) source;
-    stream.avail_in = sourceLen;
-    stream.next_out = dest;
-    stream.avail_out = *destLen;
-    stream.zalloc = 0;
-    stream.zfree = 0;
-
-    err = inflateInit2(&stream, MAX_WBITS + 16);
-    if (err != Z_OK)
-        return err;
-
-    err = inflate(&stream, Z_FINISH);
-    if (err != Z_STREAM_END) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "error zlib %s avail_in:%i avail_out:%i\n", stream.msg,
-                        stream.avail_in, stream.avail_out);
-        inflateEnd(&stream);
-        return err;
-    }
-    *destLen = stream.total_out;
-    err = inflateEnd(&stream);
-    return err;
+    const char *dict;
+    size_t dict_len;
+    JString *jpid = NULL;
+
+    if (APR_SUCCESS != apr_thread_mutex_create(&me->zip_mutex, APR_THREAD_MUTEX_DEFAULT, pool)) {
+        return JXTA_NOMEM;
+    }
+    me->srdi_dict = srdi_dict;
+    /* learnt from the SRDI callbacks and read by the senders */
+    me->dict_peers = jxta_hashtable_new_0(0, TRUE);
+    if (NULL == me->dict_peers) {
+        return JXTA_NOMEM;
+    }
+
+    dict = resolver_srdi_dictionary_get(&dict_len);
+    me->dict_id = adler32(adler32(0L, Z_NULL, 0), (const Bytef *) dict, dict_len);
+    jxta_id_to_jstring(me->localPeerId, &jpid);
+    me->dict_announce = apr_psprintf(pool, "%lu %s", (unsigned long) me->dict_id, jstring_get_string(jpid));
+    JXTA_OBJECT_RELEASE(jpid);
+
+    return JXTA_SUCCESS;
 }
 
 #ifdef GZIP_ENABLED
-static int zip_compress(unsigned char **out, size_t * out_len, const char *in, size_t in_len)
+/*
+ * The preset dictionary is only used for the peers which announced they share it.
+ */
+static int zip_kind_get(Jxta_resolver_service_ref * me, JString * jpeerid)
+{
+    if (NULL != jpeerid && me->srdi_dict
+        && JXTA_SUCCESS == jxta_hashtable_contains(me->dict_peers, jstring_get_string(jpeerid), jstring_length(jpeerid))) {
+        return ZIP_DEFLATE_DICT;
+    }
+    return ZIP_DEFLATE_GZIP;
+}
+#endif /* GZIP_ENABLED */
+
+static void zip_stream_free(int kind, Zip_stream * zs)
+{
+    if (ZIP_INFLATE == kind) {
+        inflateEnd(&zs->strm);
+    } else {
+        deflateEnd(&zs->strm);
+    }
+    free(zs);
+}
+
+/*
+ * Take an idle stream of the kind or make a new one. A recycled stream is reset and keeps the memory of its previous use, a
+ * dictionary stream gets the dictionary loaded again as a reset forgets it.
+ */
+static Zip_stream *zip_stream_get(Jxta_resolver_service_ref * me, int kind)
+{
+    Zip_stream *zs;
+    const char *dict;
+    size_t dict_len;
+    int err;
+
+    dict = resolver_srdi_dictionary_get(&dict_len);
+
+    apr_thread_mutex_lock(me->zip_mutex);
+    zs = me->zip_idle[kind];
+    if (NULL != zs) {
+        me->zip_idle[kind] = zs->next;
+        me->zip_idle_cnt[kind]--;
+    }
+    apr_thread_mutex_unlock(me->zip_mutex);
+
+    if (NULL != zs) {
+        zs->next = NULL;
+        err = (ZIP_INFLATE == kind) ? inflateReset(&zs->strm) : deflateReset(&zs->strm);
+        if (Z_OK == err && ZIP_DEFLATE_DICT == kind) {
+            err = deflateSetDictionary(&zs->strm, (const Bytef *) dict, dict_len);
+        }
+        if (Z_OK == err) {
+            return zs;
+        }
+        zip_stream_free(kind, zs);
+    }
+
+    zs = calloc(1, sizeof(*zs));
+    if (NULL == zs) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
+        return NULL;
+    }
+    zs->strm.zalloc = Z_NULL;
+    zs->strm.zfree = Z_NULL;
+    zs->strm.opaque = Z_NULL;
+
+    switch (kind) {
+    case ZIP_DEFLATE_GZIP:
+        err = deflateInit2(&zs->strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY);
+        break;
+    case ZIP_DEFLATE_DICT:
+        err = deflateInit2(&zs->strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        if (Z_OK == err) {
+            err = deflateSetDictionary(&zs->strm, (const Bytef *) dict, dict_len);
+        }
+        break;
+    default:
+        /* detect either a gzip or a zlib header */
+        err = inflateInit2(&zs->strm, MAX_WBITS + 32);
+        break;
+    }
+    if (Z_OK != err) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Error %d initializing zlib stream: %s version: %s\n", err,
+                        zs->strm.msg ? zs->strm.msg : "<no message>", ZLIB_VERSION);
+        zip_stream_free(kind, zs);
+        return NULL;
+    }
+    return zs;
+}
+
+static void zip_stream_put(Jxta_resolver_service_ref * me, int kind, Zip_stream * zs)
+{
+    apr_thread_mutex_lock(me->zip_mutex);
+    if (me->zip_idle_cnt[kind] < ZIP_IDLE_MAX) {
+        zs->next = me->zip_idle[kind];
+        me->zip_idle[kind] = zs;
+        me->zip_idle_cnt[kind]++;
+        zs = NULL;
+    }
+    apr_thread_mutex_unlock(me->zip_mutex);
+
+    if (NULL != zs) {
+        zip_stream_free(kind, zs);
+    }
+}
+
+static void zip_streams_destroy(Jxta_resolver_service_ref * me)
+{
+    Zip_stream *zs;
+    int kind;
+
+    for (kind = 0; kind < ZIP_KINDS; kind++) {
+        while (NULL != (zs = me->zip_idle[kind])) {
+            me->zip_idle[kind] = zs->next;
+            zip_stream_free(kind, zs);
+        }
+        me->zip_idle_cnt[kind] = 0;
+    }
+}
+
+/*
+ * Remember whether the peer which issued the SRDI message shares our preset dictionary. The announcement carries the peer id
+ * of the issuer as the message may have been walked by rendezvous peers.
+ */
+static void srdi_dict_learn(Jxta_resolver_service_ref * me, Jxta_message * msg)
+{
+    Jxta_message_element *el = NULL;
+    Jxta_bytevector *value;
+    JString *id_str;
+    char buf[256];
+    char pid[200];
+    unsigned long id;
+    size_t len;
+
+    jxta_message_get_element_2(msg, JXTA_NS, SRDI_DICT_ELEMENT_NAME, &el);
+    if (NULL == el) {
+        return;
+    }
+    value = jxta_message_element_get_value(el);
+    len = jxta_bytevector_size(value);
+    if (len >= sizeof(buf)) {
+        len = sizeof(buf) - 1;
+    }
+    jxta_bytevector_get_bytes_at(value, (unsigned char *) buf, 0, len);
+    buf[len] = 0;
+    JXTA_OBJECT_RELEASE(value);
+    JXTA_OBJECT_RELEASE(el);
+
+    if (2 != sscanf(buf, "%lu %199s", &id, pid)) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Invalid SRDI dictionary announcement: %s\n", buf);
+        return;
+    }
+    if ((uLong) id == me->dict_id) {
+        if (JXTA_SUCCESS != jxta_hashtable_contains(me->dict_peers, pid, strlen(pid))) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Peer %s shares the SRDI dictionary %lu\n", pid, id);
+            id_str = jstring_new_2(buf);
+            jxta_hashtable_put(me->dict_peers, pid, strlen(pid), (Jxta_object *) id_str);
+            JXTA_OBJECT_RELEASE(id_str);
+        }
+    } else {
+        jxta_hashtable_del(me->dict_peers, pid, strlen(pid), NULL);
+    }
+}
+
+/*
+ * Inflate a gzip stream or a zlib stream made with the preset SRDI dictionary.
+ *
+ * @param out receives the inflated bytes in a buffer to be freed by the caller.
+ */
+static int zip_uncompress(Jxta_resolver_service_ref * me, unsigned char **out, size_t * out_len, const unsigned char *in,
+                          size_t in_len)
 {
-    struct z_stream_s *stream = NULL;
+    Zip_stream *zs;
+    const char *dict;
+    size_t dict_len;
     size_t out_size;
-    off_t offset;
+    size_t new_size;
+    unsigned char *tmp;
     int err;
+
     *out = NULL;
-    stream = calloc(1, sizeof(struct z_stream_s));
-    if (stream == NULL) {
-        return -1;
+    zs = zip_stream_get(me, ZIP_INFLATE);
+    if (NULL == zs) {
+        return Z_MEM_ERROR;
     }
-    stream->zalloc = Z_NULL;
-    stream->zfree = Z_NULL;
-    stream->opaque = NULL;
-    stream->next_in = (unsigned char *) in;
-    stream->avail_in = in_len;
 
-    out_size = in_len / 2;
+    out_size = in_len * 8;
     if (out_size < 1024)
         out_size = 1024;
-    *out = calloc(1, out_size);
-    if (out == NULL) {
-        free(stream);
-        return -1;
-    }
-    stream->next_out = *out;
-    stream->avail_out = out_size;
-    err = deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY);
-    if (err != Z_OK) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Error from deflateInit2: %d  %s version: %s\n", err,
-                        stream->msg ? stream->msg : "<no message>", ZLIB_VERSION);
-        goto errExit;
-    }
+    if (out_size > RESOLVER_SRDI_INFLATE_MAX)
+        out_size = RESOLVER_SRDI_INFLATE_MAX;
+    *out = malloc(out_size);
+    if (NULL == *out) {
+        zip_stream_put(me, ZIP_INFLATE, zs);
+        return Z_MEM_ERROR;
+    }
+    zs->strm.next_in = (Bytef *) in;
+    zs->strm.avail_in = in_len;
+    zs->strm.next_out = *out;
+    zs->strm.avail_out = out_size;
 
     while (1) {
-        switch (deflate(stream, Z_FINISH)) {
-        case Z_STREAM_END:
-            goto done;
-        case Z_OK:
-            if (stream->avail_out >= stream->avail_in + 16) {
+        err = inflate(&zs->strm, Z_FINISH);
+        if (Z_STREAM_END == err) {
+            err = Z_OK;
+            break;
+        }
+        if (Z_NEED_DICT == err) {
+            if (zs->strm.adler != me->dict_id) {
+                jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Unknown SRDI dictionary %lu\n", zs->strm.adler);
+                err = Z_DATA_ERROR;
                 break;
-            } else {
             }
-        case Z_BUF_ERROR:
-            offset = stream->next_out - ((unsigned char *) *out);
-            out_size *= 2;
-            *out = realloc(*out, out_size);
-            stream->next_out = *out + offset;
-            stream->avail_out = out_size - offset;
+            dict = resolver_srdi_dictionary_get(&dict_len);
+            err = inflateSetDictionary(&zs->strm, (const Bytef *) dict, dict_len);
+            if (Z_OK != err) {
+                break;
+            }
+            continue;
+        }
+        if ((Z_OK == err || Z_BUF_ERROR == err) && 0 == zs->strm.avail_out) {
+            if (out_size >= RESOLVER_SRDI_INFLATE_MAX) {
+                jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Inflated SRDI message exceeds %u bytes\n",
+                                (unsigned int) RESOLVER_SRDI_INFLATE_MAX);
+                err = Z_DATA_ERROR;
+                break;
+            }
+            new_size = (out_size * 2 > RESOLVER_SRDI_INFLATE_MAX) ? RESOLVER_SRDI_INFLATE_MAX : out_size * 2;
+            tmp = realloc(*out, new_size);
+            if (NULL == tmp) {
+                err = Z_MEM_ERROR;
+                break;
+            }
+            *out = tmp;
+            zs->strm.next_out = *out + out_size;
+            zs->strm.avail_out = new_size - out_size;
+            out_size = new_size;
+            continue;
+        }
+        if (Z_OK != err) {
             break;
-        default:
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Gzip compression didn't finish: %s",
-                            stream->msg ? stream->msg : "<no message>");
-            goto errExit;
         }
     }
-  done:
-    *out_len = stream->total_out;
-    if (deflateEnd(stream) != Z_OK) {
-        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Error freeing gzip structures");
-        goto errExit;
+
+    if (Z_OK == err) {
+        *out_len = zs->strm.total_out;
+    } else {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "error zlib %s avail_in:%i avail_out:%i\n",
+                        zs->strm.msg ? zs->strm.msg : "<no message>", zs->strm.avail_in, zs->strm.avail_out);
+        free(*out);
+        *out = NULL;
+    }
+    zip_stream_put(me, ZIP_INFLATE, zs);
+    return err;
+}
+
+#ifdef GZIP_ENABLED
+/*
+ * Deflate in with a recycled stream of the kind, straight into the buffer returned in out.
+ *
+ * @param out receives the deflated bytes in a buffer to be freed by the caller.
+ */
+static int zip_compress(Jxta_resolver_service_ref * me, int kind, unsigned char **out, size_t * out_len, const char *in,
+                        size_t in_len)
+{
+    Zip_stream *zs;
+    size_t out_size;
+    unsigned char *tmp;
+    int err;
+
+    *out = NULL;
+    zs = zip_stream_get(me, kind);
+    if (NULL == zs) {
+        return -1;
+    }
+
+    /* deflateBound of older zlib does not count the gzip header and trailer */
+    out_size = deflateBound(&zs->strm, in_len) + 18;
+    *out = malloc(out_size);
+    if (NULL == *out) {
+        zip_stream_put(me, kind, zs);
+        return -1;
     }
-    free(stream);
+    zs->strm.next_in = (Bytef *) in;
+    zs->strm.avail_in = in_len;
+    zs->strm.next_out = *out;
+    zs->strm.avail_out = out_size;
 
+    while (Z_STREAM_END != (err = deflate(&zs->strm, Z_FINISH))) {
+        if ((Z_OK != err && Z_BUF_ERROR != err) || 0 != zs->strm.avail_out) {
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Gzip compression didn't finish: %s\n",
+                            zs->strm.msg ? zs->strm.msg : "<no message>");
+            goto errExit;
+        }
+        tmp = realloc(*out, out_size * 2);
+        if (NULL == tmp) {
+            goto errExit;
+        }
+        *out = tmp;
+        zs->strm.next_out = *out + out_size;
+        zs->strm.avail_out = out_size;
+        out_size *= 2;
+    }
+    *out_len = zs->strm.total_out;
+    zip_stream_put(me, kind, zs);
     return 0;
+
   errExit:
-    if (stream) {
-        deflateEnd(stream);
-        free(stream);
+    zip_stream_put(me, kind, zs);
+    free(*out);
+    *out = NULL;
+    return -1;
+}
+
+int resolver_zip_compress(Jxta_resolver_service * resolver, Jxta_id * peerid, unsigned char **out, size_t * out_len,
+                          const char *in, size_t in_len, Jxta_boolean * dict)
+{
+    Jxta_resolver_service_ref *me = PTValid(resolver, Jxta_resolver_service_ref);
+    JString *jpeerid = NULL;
+    int kind;
+
+    if (NULL != peerid) {
+        jxta_id_to_jstring(peerid, &jpeerid);
     }
-    if (*out) {
-        free(*out);
+    kind = zip_kind_get(me, jpeerid);
+    if (NULL != jpeerid) {
+        JXTA_OBJECT_RELEASE(jpeerid);
     }
-    return -1;
+    *dict = (ZIP_DEFLATE_DICT == kind);
+
+    return zip_compress(me, kind, out, out_len, in, in_len);
 }
 #endif /* GZIP_ENABLED */
+
+Jxta_status resolver_zip_setup(Jxta_resolver_service * resolver, apr_pool_t * pool, Jxta_id * peerid, Jxta_boolean srdi_dict)
+{
+    Jxta_resolver_service_ref *me = PTValid(resolver, Jxta_resolver_service_ref);
+
+    if (NULL != me->zip_mutex) {
+        return JXTA_INVALID_ARGUMENT;
+    }
+    /* the dtor expects the service mutex */
+    if (APR_SUCCESS != apr_thread_mutex_create(&me->mutex, APR_THREAD_MUTEX_NESTED, pool)) {
+        return JXTA_NOMEM;
+    }
+    me->localPeerId = JXTA_OBJECT_SHARE(peerid);
+
+    return zip_setup(me, pool, srdi_dict);
+}
+
+int resolver_zip_uncompress(Jxta_resolver_service * resolver, unsigned char **out, size_t * out_len, const unsigned char *in,
+                            size_t in_len)
+{
+    Jxta_resolver_service_ref *me = PTValid(resolver, Jxta_resolver_service_ref);
+
+    return zip_uncompress(me, out, out_len, in, in_len);
+}
+
+void resolver_srdi_dict_learn(Jxta_resolver_service * resolver, Jxta_message * msg)
+{
+    Jxta_resolver_service_ref *me = PTValid(resolver, Jxta_resolver_service_ref);
+
+    srdi_dict_learn(me, msg);
+}
 #endif /* GUNZIP_ENABLED */
 
 /* vim: set ts=4 sw=4 et tw=130: */
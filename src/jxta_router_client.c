@@ -68,9 +68,12 @@ static const char *__log_cat = "ROUTER";
 #include "jxta_endpoint_service.h"
 #include "jxta_discovery_service.h"
 #include "jxta_router_service.h"
+#include "jxta_router_client_private.h"
 #include "jxta_peergroup.h"
 #include "jxta_rm.h"
 #include "jxta_vector.h"
+#include "jxta_objecthashtable.h"
+#include "jxta_listener.h"
 #include "jxta_apa.h"
 #include "jxta_routea.h"
 #include "jxta_log.h"
@@ -84,7 +87,8 @@ struct _jxta_router_client {
     apr_thread_mutex_t *mutex;
 
     Jxta_PG *group;
-    Jxta_vector *peers;
+    /* Peer_entry by peer id, jxta_objecthashtable_values_get() to walk them */
+    Jxta_objecthashtable *peers;
     char *localPeerIdString;
     char *router_name;
     Jxta_id *localPeerId;
@@ -98,6 +102,20 @@ struct _jxta_router_client {
     /* needed to optimize open connection performance, records the addresses
      * to which there is a consistent connection failure */
     Jxta_hashtable *failed_connections_table;
+
+    /* routes found in the cm by peer id, including the peers without route */
+    apr_thread_mutex_t *cache_mutex;
+    Jxta_objecthashtable *route_cache;
+    APR_RING_HEAD(route_cache_list, _route_cache_entry) route_cache_fifo;
+    unsigned int route_cache_cnt;
+    /* incremented on every invalidation, a lookup started before is not cached */
+    apr_uint32_t route_cache_generation;
+    Jxta_listener *publish_listener;
+
+    /* Route_quality by transport address of the next hop */
+    apr_thread_mutex_t *quality_mutex;
+    apr_hash_t *quality;
+    unsigned int quality_cnt;
 };
 
 typedef struct {
@@ -114,6 +132,30 @@ typedef struct {
     apr_pool_t *pool;
 } Peer_entry;
 
+typedef struct _route_cache_entry Route_cache_entry;
+
+struct _route_cache_entry {
+    JXTA_OBJECT_HANDLE;
+    /* insertion order, the table holds the reference */
+    APR_RING_ENTRY(_route_cache_entry) link;
+    Jxta_id *peerid;
+    /* NULL if no route is known for the peer */
+    Jxta_RouteAdvertisement *route;
+    Jxta_time expiration;
+};
+
+/* Send statistics of a next hop address */
+typedef struct _route_quality {
+    char *ta;
+    /* smoothed time taken by sends */
+    apr_interval_time_t srtt;
+    /* smoothed failure ratio of sends and connections, in 1/65536 */
+    apr_int32_t loss;
+    apr_uint32_t sends;
+    apr_uint32_t failures;
+    Jxta_time last_used;
+} Route_quality;
+
 typedef struct _failed_address _failed_address;
 
 struct _failed_address {
@@ -131,17 +173,40 @@ static const char JXTA_ENDPOINT_ROUTER_ELEMENT_NAME[] = "EndpointRouterMsg";
 /* failed connections table change */
 #define ROUTING_IGNORE_ADDRESS_PERIOD (60*1000)
 
+/* route cache size and lifetimes of found and missing routes */
+#define ROUTE_CACHE_MAX 1024
+#define ROUTE_CACHE_TTL (5*60*1000)
+#define ROUTE_CACHE_NEGATIVE_TTL (30*1000)
+
+/* number of next hop addresses with statistics */
+#define ROUTE_QUALITY_MAX 512
+/* weight of the last sample in the smoothed values, as a shift */
+#define ROUTE_QUALITY_SHIFT 3
+/* cost of a send which always fails */
+#define ROUTE_FAILURE_COST APR_USEC_PER_SEC
+/* cost of one point of transport metric */
+#define ROUTE_METRIC_COST (100 * 1000)
+/* the relay hop is preferred to the direct address when it is cheaper by this much */
+#define ROUTE_SWITCH_MARGIN (20 * 1000)
+/* the statistics of an address not used for this long count half, in milliseconds, so a losing address gets retried */
+#define ROUTE_QUALITY_HALF_LIFE (60 * 1000)
+
 static Jxta_status JXTA_STDCALL router_client_cb(Jxta_object * msg, void *arg);
 static Peer_entry *get_peer_entry(Jxta_router_client * self, Jxta_id * peerid, Jxta_boolean create);
 static void peer_entry_set_forward_gateways(Peer_entry * peer, Jxta_vector * vector);
 static Jxta_vector *peer_entry_get_forward_gateways(Peer_entry * peer);
 static Jxta_id *get_peerid_from_endpoint_address(Jxta_endpoint_address * addr);
 static Jxta_RouteAdvertisement *search_in_local_cm(Jxta_router_client * t, Jxta_id * dest);
+static void route_cache_clear(Jxta_router_client * self);
+static void JXTA_STDCALL route_cache_publish_listener(Jxta_object * obj, void *arg);
 static Jxta_endpoint_address *jxta_router_select_best_address(Jxta_router_client * router, Jxta_AccessPointAdvertisement * ap);
 static Jxta_endpoint_address *jxta_router_select_best_route(Jxta_router_client * router,
                                                             Jxta_AccessPointAdvertisement * ap,
                                                             Jxta_AccessPointAdvertisement * hop);
 static int reachable_address(Jxta_router_client * router, Jxta_endpoint_address * addr);
+static void route_quality_update(Jxta_router_client * self, const char *ta, Jxta_boolean success,
+                                 apr_interval_time_t elapsed);
+static apr_interval_time_t route_quality_cost(Jxta_router_client * self, Jxta_endpoint_address * addr);
 static _failed_address *failed_address_new(Jxta_time ignore_until_time);
 static Jxta_status failed_address_exists(Jxta_hashtable * failed_addresses_list, JString * address_key);
 static void failed_address_delete(Jxta_object * obj);
@@ -235,6 +300,13 @@ static Jxta_status start(Jxta_module * module, const char *argv[])
     jxta_endpoint_service_add_transport(self->endpoint, (Jxta_transport *) self);
 
     jxta_PG_get_discovery_service(self->group, &(self->discovery));
+    if (NULL != self->discovery) {
+        self->publish_listener = jxta_listener_new(route_cache_publish_listener, self, 1, 1);
+        if (NULL != self->publish_listener) {
+            jxta_listener_start(self->publish_listener);
+            discovery_service_add_publish_listener(self->discovery, self->publish_listener);
+        }
+    }
 
     self->started = TRUE;
     apr_thread_mutex_unlock(self->mutex);
@@ -267,11 +339,22 @@ static void stop(Jxta_module * module)
     JXTA_OBJECT_RELEASE(self->endpoint);
     self->endpoint = NULL;
 
+    if (NULL != self->publish_listener) {
+        if (NULL != self->discovery) {
+            discovery_service_remove_publish_listener(self->discovery, self->publish_listener);
+        }
+        jxta_listener_stop(self->publish_listener);
+        JXTA_OBJECT_RELEASE(self->publish_listener);
+        self->publish_listener = NULL;
+    }
+
     if (NULL != self->discovery) {
         JXTA_OBJECT_RELEASE(self->discovery);
         self->discovery = NULL;
     }
 
+    route_cache_clear(self);
+
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Stopped.\n");
 }
 
@@ -697,6 +780,8 @@ static Jxta_status messenger_send(JxtaEndpointMessenger * m, Jxta_message * msg)
     JxtaEndpointMessenger *endpoint_messenger = NULL;
     Jxta_endpoint_address *addr = NULL;
     Jxta_boolean relay_tried = TRUE;
+    char *ta = NULL;
+    apr_time_t begin;
 
     JXTA_OBJECT_CHECK_VALID(msg);
     JXTA_OBJECT_CHECK_VALID(messenger);
@@ -779,9 +864,12 @@ static Jxta_status messenger_send(JxtaEndpointMessenger * m, Jxta_message * msg)
         return JXTA_FAILED;
     }
 
+    ta = jxta_endpoint_address_get_transport_addr(dest_addr);
     endpoint_messenger = jxta_transport_messenger_get(transport, dest_addr);
     if (NULL == endpoint_messenger) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Could not obtain a messenger for : %s\n", caddress);
+        route_quality_update(messenger->router, ta, FALSE, 0);
+        free(ta);
         free(caddress);
         JXTA_OBJECT_RELEASE(dest_addr);
         JXTA_OBJECT_RELEASE(transport);
@@ -793,7 +881,11 @@ static Jxta_status messenger_send(JxtaEndpointMessenger * m, Jxta_message * msg)
     JXTA_OBJECT_CHECK_VALID(endpoint_messenger);
     addr = jxta_transport_publicaddr_get(transport);
     jxta_message_set_source(msg, addr);
+    /* the send completes once the message is written, tcp included, its duration measures the hop */
+    begin = apr_time_now();
     status = endpoint_messenger->jxta_send(endpoint_messenger, msg);
+    route_quality_update(messenger->router, ta, JXTA_SUCCESS == status, apr_time_now() - begin);
+    free(ta);
     JXTA_OBJECT_RELEASE(endpoint_messenger);
     JXTA_OBJECT_RELEASE(addr);
     JXTA_OBJECT_RELEASE(transport);
@@ -805,19 +897,24 @@ static int reachable_address(Jxta_router_client * router, Jxta_endpoint_address
 {
     Jxta_transport *transport = NULL;
     JxtaEndpointMessenger *messenger = NULL;
+    char *ta;
+    int metric = INT_MIN;
 
     transport = jxta_endpoint_service_lookup_transport(router->endpoint, jxta_endpoint_address_get_protocol_name(addr));
     if (transport) {
         messenger = jxta_transport_messenger_get(transport, addr);
+        ta = jxta_endpoint_address_get_transport_addr(addr);
         if (messenger) {
-            JXTA_OBJECT_RELEASE(transport);
+            metric = jxta_transport_metric_get(transport);
             JXTA_OBJECT_RELEASE(messenger);
-            return jxta_transport_metric_get(transport);
         }
+        /* a messenger may be cached, connecting does not time the hop */
+        route_quality_update(router, ta, NULL != messenger, -1);
+        free(ta);
         JXTA_OBJECT_RELEASE(transport);
     }
 
-    return INT_MIN;
+    return metric;
 }
 
 /************************************************************************
@@ -873,11 +970,168 @@ static Jxta_status failed_address_exists(Jxta_hashtable * failed_addresses_list,
     return JXTA_ITEM_NOTFOUND;
 }
 
+/*
+ * Number of half lives the statistics of an address have aged since it was last used, capped once they count for nothing.
+ */
+static int route_quality_age(Route_quality * q, Jxta_time now)
+{
+    Jxta_time age = (now > q->last_used) ? now - q->last_used : 0;
+
+    return (age >= 16 * ROUTE_QUALITY_HALF_LIFE) ? 16 : (int) (age / ROUTE_QUALITY_HALF_LIFE);
+}
+
+/*
+ * Account for a send or a connection attempt to a next hop address. The time taken by successful sends and the failure
+ * ratio are smoothed, so recent samples matter most, and decay with the time the address was not used. elapsed is
+ * negative for a connection, which only counts in the failure ratio.
+ */
+static void route_quality_update(Jxta_router_client * self, const char *ta, Jxta_boolean success,
+                                 apr_interval_time_t elapsed)
+{
+    Route_quality *q;
+    Route_quality *oldest;
+    apr_hash_index_t *hi;
+    Jxta_time now;
+    int age;
+
+    if (NULL == ta) {
+        return;
+    }
+
+    apr_thread_mutex_lock(self->quality_mutex);
+    q = apr_hash_get(self->quality, ta, APR_HASH_KEY_STRING);
+    if (NULL == q) {
+        if (self->quality_cnt >= ROUTE_QUALITY_MAX) {
+            /* forget the address used the longest time ago */
+            oldest = NULL;
+            for (hi = apr_hash_first(NULL, self->quality); hi; hi = apr_hash_next(hi)) {
+                apr_hash_this(hi, NULL, NULL, (void **) &q);
+                if (NULL == oldest || q->last_used < oldest->last_used) {
+                    oldest = q;
+                }
+            }
+            apr_hash_set(self->quality, oldest->ta, APR_HASH_KEY_STRING, NULL);
+            self->quality_cnt--;
+            free(oldest->ta);
+            free(oldest);
+        }
+        q = calloc(1, sizeof(*q));
+        if (NULL != q) {
+            q->ta = strdup(ta);
+        }
+        if (NULL == q || NULL == q->ta) {
+            apr_thread_mutex_unlock(self->quality_mutex);
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
+            free(q);
+            return;
+        }
+        apr_hash_set(self->quality, q->ta, APR_HASH_KEY_STRING, q);
+        self->quality_cnt++;
+    }
+
+    now = jpr_time_now();
+    age = route_quality_age(q, now);
+    q->srtt >>= age;
+    q->loss >>= age;
+    if (success) {
+        if (elapsed >= 0) {
+            q->srtt = (0 == q->sends) ? elapsed : q->srtt + ((elapsed - q->srtt) >> ROUTE_QUALITY_SHIFT);
+            q->sends++;
+        }
+        q->loss -= q->loss >> ROUTE_QUALITY_SHIFT;
+    } else {
+        q->failures++;
+        q->loss += (65536 - q->loss) >> ROUTE_QUALITY_SHIFT;
+    }
+    q->last_used = now;
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_PARANOID, "Route quality of %s: srtt %" APR_INT64_T_FMT "us, loss %d/65536\n",
+                    ta, (apr_int64_t) q->srtt, q->loss);
+    apr_thread_mutex_unlock(self->quality_mutex);
+}
+
+/*
+ * Expected cost of sending to the address, 0 if nothing is known about it yet so new addresses get a chance. The cost
+ * halves every ROUTE_QUALITY_HALF_LIFE the address is not used, so an address which lost to another one is tried again.
+ */
+static apr_interval_time_t route_quality_cost(Jxta_router_client * self, Jxta_endpoint_address * addr)
+{
+    Route_quality *q;
+    apr_interval_time_t cost = 0;
+    char *ta;
+
+    ta = jxta_endpoint_address_get_transport_addr(addr);
+    if (NULL == ta) {
+        return 0;
+    }
+    apr_thread_mutex_lock(self->quality_mutex);
+    q = apr_hash_get(self->quality, ta, APR_HASH_KEY_STRING);
+    if (NULL != q) {
+        cost = q->srtt + ((apr_interval_time_t) q->loss * ROUTE_FAILURE_COST >> 16);
+        cost >>= route_quality_age(q, jpr_time_now());
+    }
+    apr_thread_mutex_unlock(self->quality_mutex);
+    free(ta);
+    return cost;
+}
+
+/*
+ * Cost of the best address of an access point, without trying to connect to any.
+ */
+static apr_interval_time_t route_quality_ap_cost(Jxta_router_client * self, Jxta_AccessPointAdvertisement * ap)
+{
+    Jxta_vector *addresses;
+    JString *addr = NULL;
+    Jxta_endpoint_address *eaddr;
+    apr_interval_time_t cost;
+    apr_interval_time_t best = 0;
+    Jxta_boolean found = FALSE;
+    unsigned int i;
+
+    addresses = jxta_AccessPointAdvertisement_get_EndpointAddresses(ap);
+    if (NULL == addresses) {
+        return 0;
+    }
+    for (i = 0; i < jxta_vector_size(addresses); i++) {
+        if (JXTA_SUCCESS != jxta_vector_get_object_at(addresses, JXTA_OBJECT_PPTR(&addr), i)) {
+            continue;
+        }
+        eaddr = jxta_endpoint_address_new(jstring_get_string(addr));
+        JXTA_OBJECT_RELEASE(addr);
+        if (NULL == eaddr) {
+            continue;
+        }
+        cost = route_quality_cost(self, eaddr);
+        JXTA_OBJECT_RELEASE(eaddr);
+        if (!found || cost < best) {
+            best = cost;
+            found = TRUE;
+        }
+    }
+    JXTA_OBJECT_RELEASE(addresses);
+    return best;
+}
+
+static void route_quality_destroy(Jxta_router_client * self)
+{
+    apr_hash_index_t *hi;
+    Route_quality *q;
+
+    for (hi = apr_hash_first(NULL, self->quality); hi; hi = apr_hash_next(hi)) {
+        apr_hash_this(hi, NULL, NULL, (void **) &q);
+        free(q->ta);
+        free(q);
+    }
+    self->quality = NULL;
+    self->quality_cnt = 0;
+}
+
 static Jxta_endpoint_address *jxta_router_select_best_route(Jxta_router_client * router, Jxta_AccessPointAdvertisement * ap,
                                                             Jxta_AccessPointAdvertisement * hop)
 {
     Jxta_endpoint_address *addr = NULL;
     JString *xml_key = NULL;
+    apr_interval_time_t direct_cost;
+    apr_interval_time_t hop_cost;
 
     apr_thread_mutex_lock(router->mutex);
     if (!router->started) {
@@ -888,8 +1142,17 @@ static Jxta_endpoint_address *jxta_router_select_best_route(Jxta_router_client *
     /* failed connections table change */
     jxta_AccessPointAdvertisement_get_xml(ap, &xml_key);
 
+    /* the relay is tried first when it performed better than the direct addresses so far */
+    if (NULL != hop) {
+        direct_cost = route_quality_ap_cost(router, ap);
+        hop_cost = route_quality_ap_cost(router, hop);
+    } else {
+        direct_cost = hop_cost = 0;
+    }
+
     /* if address is marked as failed first try the relay and then direct, if not then first try direct */
-    if (failed_address_exists(router->failed_connections_table, xml_key) == JXTA_SUCCESS) {
+    if (failed_address_exists(router->failed_connections_table, xml_key) == JXTA_SUCCESS
+        || hop_cost + ROUTE_SWITCH_MARGIN < direct_cost) {
 
         /* first try the relay */
         if (hop != NULL) {
@@ -969,7 +1232,9 @@ static Jxta_endpoint_address *jxta_router_select_best_address(Jxta_router_client
     unsigned int i;
     Jxta_boolean found_http = FALSE;
     char *caddress = NULL;
-    int metric, best = INT_MIN;
+    int metric;
+    apr_interval_time_t score;
+    apr_interval_time_t best = 0;
 
     addresses = jxta_AccessPointAdvertisement_get_EndpointAddresses(ap);
 
@@ -985,11 +1250,17 @@ static Jxta_endpoint_address *jxta_router_select_best_address(Jxta_router_client
         }
 
         metric = reachable_address(router, eaddr);
-        if (metric > best) {
+        if (INT_MIN == metric) {
+            JXTA_OBJECT_RELEASE(eaddr);
+            continue;
+        }
+        /* a higher metric is better unless the address has been slower or failing more by more than the difference */
+        score = (apr_interval_time_t) metric * ROUTE_METRIC_COST - route_quality_cost(router, eaddr);
+        if (best_addr == NULL || score > best) {
             if (best_addr != NULL)
                 JXTA_OBJECT_RELEASE(best_addr);
             best_addr = eaddr;
-            best = metric;
+            best = score;
         } else {
             JXTA_OBJECT_RELEASE(eaddr);
         }
@@ -1027,13 +1298,172 @@ static void messenger_delete(Jxta_object * obj)
     free(self);
 }
 
+static void route_cache_entry_delete(Jxta_object * obj)
+{
+    Route_cache_entry *self = (Route_cache_entry *) obj;
+
+    JXTA_OBJECT_RELEASE(self->peerid);
+    if (self->route != NULL) {
+        JXTA_OBJECT_RELEASE(self->route);
+    }
+
+    free(self);
+}
+
+static Route_cache_entry *route_cache_entry_new(Jxta_id * peerid, Jxta_RouteAdvertisement * route)
+{
+    Route_cache_entry *self = (Route_cache_entry *) calloc(1, sizeof(Route_cache_entry));
+    if (self == NULL) {
+        return NULL;
+    }
+
+    JXTA_OBJECT_INIT(self, route_cache_entry_delete, 0);
+    self->peerid = JXTA_OBJECT_SHARE(peerid);
+    self->route = (route != NULL) ? JXTA_OBJECT_SHARE(route) : NULL;
+    self->expiration = jpr_time_now() + ((route != NULL) ? ROUTE_CACHE_TTL : ROUTE_CACHE_NEGATIVE_TTL);
+
+    return self;
+}
+
+/* must be called with cache_mutex held */
+static void route_cache_remove(Jxta_router_client * self, Route_cache_entry * entry)
+{
+    APR_RING_REMOVE(entry, link);
+    self->route_cache_cnt--;
+    /* releases the entry */
+    jxta_objecthashtable_delcheck(self->route_cache, (Jxta_object *) entry->peerid, (Jxta_object *) entry);
+}
+
+static void route_cache_clear(Jxta_router_client * self)
+{
+    apr_thread_mutex_lock(self->cache_mutex);
+    while (!APR_RING_EMPTY(&self->route_cache_fifo, _route_cache_entry, link)) {
+        route_cache_remove(self, APR_RING_FIRST(&self->route_cache_fifo));
+    }
+    self->route_cache_generation++;
+    apr_thread_mutex_unlock(self->cache_mutex);
+}
+
+/**
+ * Look for the route of a peer in the cache.
+ *
+ * @param route receives a shared route or NULL if the peer is known to have no route.
+ * @param generation receives the generation of the cache to give to route_cache_put on a miss.
+ * @return TRUE if the cache had an entry for the peer.
+ */
+static Jxta_boolean route_cache_get(Jxta_router_client * self, Jxta_id * peerid, Jxta_RouteAdvertisement ** route,
+                                    apr_uint32_t * generation)
+{
+    Route_cache_entry *entry = NULL;
+    Jxta_boolean found = FALSE;
+
+    apr_thread_mutex_lock(self->cache_mutex);
+    *generation = self->route_cache_generation;
+    if (JXTA_SUCCESS == jxta_objecthashtable_get(self->route_cache, (Jxta_object *) peerid, JXTA_OBJECT_PPTR(&entry))) {
+        if (entry->expiration < jpr_time_now()) {
+            route_cache_remove(self, entry);
+        } else {
+            *route = (entry->route != NULL) ? JXTA_OBJECT_SHARE(entry->route) : NULL;
+            found = TRUE;
+        }
+        JXTA_OBJECT_RELEASE(entry);
+    }
+    apr_thread_mutex_unlock(self->cache_mutex);
+    return found;
+}
+
+/*
+ * Cache the result of a cm lookup unless the cache was invalidated since the lookup started. The oldest entries are
+ * evicted when the cache is full.
+ */
+static void route_cache_put(Jxta_router_client * self, Jxta_id * peerid, Jxta_RouteAdvertisement * route,
+                            apr_uint32_t generation)
+{
+    Route_cache_entry *entry;
+
+    entry = route_cache_entry_new(peerid, route);
+    if (entry == NULL) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
+        return;
+    }
+
+    apr_thread_mutex_lock(self->cache_mutex);
+    if (generation == self->route_cache_generation) {
+        Route_cache_entry *old = NULL;
+
+        if (JXTA_SUCCESS == jxta_objecthashtable_get(self->route_cache, (Jxta_object *) peerid, JXTA_OBJECT_PPTR(&old))) {
+            route_cache_remove(self, old);
+            JXTA_OBJECT_RELEASE(old);
+        }
+        while (self->route_cache_cnt >= ROUTE_CACHE_MAX) {
+            route_cache_remove(self, APR_RING_FIRST(&self->route_cache_fifo));
+        }
+        if (JXTA_SUCCESS == jxta_objecthashtable_put(self->route_cache, (Jxta_object *) peerid, (Jxta_object *) entry)) {
+            APR_RING_INSERT_TAIL(&self->route_cache_fifo, entry, _route_cache_entry, link);
+            self->route_cache_cnt++;
+        }
+    }
+    apr_thread_mutex_unlock(self->cache_mutex);
+    JXTA_OBJECT_RELEASE(entry);
+}
+
+static void route_cache_invalidate(Jxta_router_client * self, Jxta_id * peerid)
+{
+    Route_cache_entry *entry = NULL;
+
+    apr_thread_mutex_lock(self->cache_mutex);
+    self->route_cache_generation++;
+    if (JXTA_SUCCESS == jxta_objecthashtable_get(self->route_cache, (Jxta_object *) peerid, JXTA_OBJECT_PPTR(&entry))) {
+        route_cache_remove(self, entry);
+        JXTA_OBJECT_RELEASE(entry);
+    }
+    apr_thread_mutex_unlock(self->cache_mutex);
+}
+
+/*
+ * Drop the cached route of a peer when a route or a peer advertisement is saved for it in the cm.
+ */
+static void JXTA_STDCALL route_cache_publish_listener(Jxta_object * obj, void *arg)
+{
+    Jxta_router_client *self = PTValid(arg, Jxta_router_client);
+    Jxta_advertisement *adv = (Jxta_advertisement *) obj;
+    const char *doc_name;
+    Jxta_id *peerid = NULL;
+
+    doc_name = jxta_advertisement_get_document_name(adv);
+    if (NULL == doc_name) {
+        return;
+    }
+    if (0 == strcmp(doc_name, "jxta:RA")) {
+        peerid = jxta_RouteAdvertisement_get_DestPID((Jxta_RouteAdvertisement *) adv);
+    } else if (0 == strcmp(doc_name, "jxta:PA")) {
+        peerid = jxta_PA_get_PID((Jxta_PA *) adv);
+    }
+
+    if (NULL != peerid) {
+        route_cache_invalidate(self, peerid);
+        JXTA_OBJECT_RELEASE(peerid);
+    }
+}
+
+/*
+ * Find the route of a peer in the cm. The results, including the absence of route, are cached so repeated sends to a peer
+ * do not query the cm every time. The cm is queried without holding the router lock.
+ */
 static Jxta_RouteAdvertisement *search_in_local_cm(Jxta_router_client * self, Jxta_id * dest)
 {
     JString *pid;
-    Jxta_PA *padv;
+    Jxta_PA *padv = NULL;
     Jxta_vector *res = NULL;
     unsigned int i;
     Jxta_RouteAdvertisement *route = NULL;
+    Jxta_discovery_service *discovery = NULL;
+    apr_uint32_t generation;
+
+    if (route_cache_get(self, dest, &route, &generation)) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Route cache hit, route %s\n", (NULL == route) ? "unknown" : "found");
+        return route;
+    }
 
     apr_thread_mutex_lock(self->mutex);
     if (FALSE == self->started) {
@@ -1052,6 +1482,8 @@ static Jxta_RouteAdvertisement *search_in_local_cm(Jxta_router_client * self, Jx
         apr_thread_mutex_unlock(self->mutex);
         return NULL;
     }
+    discovery = JXTA_OBJECT_SHARE(self->discovery);
+    apr_thread_mutex_unlock(self->mutex);
 
     /*
      * check if we have a route advertisement for that
@@ -1060,7 +1492,7 @@ static Jxta_RouteAdvertisement *search_in_local_cm(Jxta_router_client * self, Jx
      * advertisement we have to extract the route.
      */
     jxta_id_to_jstring(dest, &pid);
-    discovery_service_get_local_advertisements(self->discovery, DISC_ADV, "DstPID", jstring_get_string(pid), &res);
+    discovery_service_get_local_advertisements(discovery, DISC_ADV, "DstPID", jstring_get_string(pid), &res);
     if (res != NULL) {
         for (i = 0; i < jxta_vector_size(res); i++) {
             jxta_vector_get_object_at(res, JXTA_OBJECT_PPTR(&route), i);
@@ -1068,10 +1500,11 @@ static Jxta_RouteAdvertisement *search_in_local_cm(Jxta_router_client * self, Jx
                 break;
         }
         JXTA_OBJECT_RELEASE(res);
+        res = NULL;
     }
 
     if (NULL == route) {
-        discovery_service_get_local_advertisements(self->discovery, DISC_PEER, "PID", jstring_get_string(pid), &res);
+        discovery_service_get_local_advertisements(discovery, DISC_PEER, "PID", jstring_get_string(pid), &res);
         if (res != NULL) {
             for (i = 0; i < jxta_vector_size(res); i++) {
                 jxta_vector_get_object_at(res, JXTA_OBJECT_PPTR(&padv), i);
@@ -1088,7 +1521,9 @@ static Jxta_RouteAdvertisement *search_in_local_cm(Jxta_router_client * self, Jx
     }
 
     JXTA_OBJECT_RELEASE(pid);
-    apr_thread_mutex_unlock(self->mutex);
+    JXTA_OBJECT_RELEASE(discovery);
+
+    route_cache_put(self, dest, route, generation);
     return route;
 }
 
@@ -1238,13 +1673,39 @@ Jxta_router_client *jxta_router_client_construct(Jxta_router_client * self, Jxta
 
     self->endpoint = NULL;
     self->discovery = NULL;
-    self->peers = jxta_vector_new(0);
+    self->peers = jxta_objecthashtable_new(0, (Jxta_object_hash_func) jxta_id_hashcode,
+                                           (Jxta_object_equals_func) jxta_id_equals);
     if (self->peers == NULL) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
         JXTA_OBJECT_RELEASE(self);
         return NULL;
     }
 
+    res = apr_thread_mutex_create(&self->cache_mutex, APR_THREAD_MUTEX_DEFAULT, self->pool);
+    if (res != APR_SUCCESS) {
+        JXTA_OBJECT_RELEASE(self);
+        return NULL;
+    }
+    self->route_cache = jxta_objecthashtable_new(0, (Jxta_object_hash_func) jxta_id_hashcode,
+                                                 (Jxta_object_equals_func) jxta_id_equals);
+    if (self->route_cache == NULL) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
+        JXTA_OBJECT_RELEASE(self);
+        return NULL;
+    }
+    APR_RING_INIT(&self->route_cache_fifo, _route_cache_entry, link);
+    self->route_cache_cnt = 0;
+    self->route_cache_generation = 0;
+    self->publish_listener = NULL;
+
+    res = apr_thread_mutex_create(&self->quality_mutex, APR_THREAD_MUTEX_DEFAULT, self->pool);
+    if (res != APR_SUCCESS) {
+        JXTA_OBJECT_RELEASE(self);
+        return NULL;
+    }
+    self->quality = apr_hash_make(self->pool);
+    self->quality_cnt = 0;
+
     /* failed connections table change */
     self->failed_connections_table = NULL;
     self->failed_connections_table = jxta_hashtable_new(10);
@@ -1281,6 +1742,26 @@ void jxta_router_client_destruct(Jxta_router_client * self)
         self->peers = NULL;
     }
 
+    if (self->route_cache) {
+        route_cache_clear(self);
+        JXTA_OBJECT_RELEASE(self->route_cache);
+        self->route_cache = NULL;
+    }
+
+    if (self->cache_mutex) {
+        apr_thread_mutex_destroy(self->cache_mutex);
+        self->cache_mutex = NULL;
+    }
+
+    if (self->quality) {
+        route_quality_destroy(self);
+    }
+
+    if (self->quality_mutex) {
+        apr_thread_mutex_destroy(self->quality_mutex);
+        self->quality_mutex = NULL;
+    }
+
     if (self->localPeerIdString) {
         free(self->localPeerIdString);
         self->localPeerIdString = NULL;
@@ -1752,50 +2233,27 @@ static void peer_entry_set_forward_gateways(Peer_entry * peer, Jxta_vector * vec
 static Peer_entry *get_peer_entry(Jxta_router_client * self, Jxta_id * peerid, Jxta_boolean create)
 {
     Peer_entry *peer = NULL;
-    Jxta_status res = 0;
-    unsigned int i;
-    Jxta_boolean found = FALSE;
+    Jxta_status res;
 
     JXTA_OBJECT_CHECK_VALID(self);
     JXTA_OBJECT_CHECK_VALID(peerid);
 
     apr_thread_mutex_lock(self->mutex);
 
-    for (i = 0; i < jxta_vector_size(self->peers); ++i) {
-
-        res = jxta_vector_get_object_at(self->peers, JXTA_OBJECT_PPTR(&peer), i);
-
-        JXTA_OBJECT_CHECK_VALID(peer);
-
-        if (res != JXTA_SUCCESS) {
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Cannot get Peer_entry\n");
-            continue;
-        }
-
-        if (jxta_id_equals(peerid, peer->peerid)) {
-            found = TRUE;
-            break;
-        }
-
-        /* We are done with this peer. Let release it */
-        JXTA_OBJECT_RELEASE(peer);
-    }
-
-    if (!found) {
+    res = jxta_objecthashtable_get(self->peers, (Jxta_object *) peerid, JXTA_OBJECT_PPTR(&peer));
+    if (res != JXTA_SUCCESS) {
+        peer = NULL;
         if (create) {
             /* We need to create a new Peer_entry */
             peer = peer_entry_new(peerid);
             if (peer == NULL) {
                 jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Cannot create a Peer_entry\n");
             } else {
-                /* Add it into the vector */
-                res = jxta_vector_add_object_last(self->peers, (Jxta_object *) peer);
+                res = jxta_objecthashtable_putnoreplace(self->peers, (Jxta_object *) peerid, (Jxta_object *) peer);
                 if (res != JXTA_SUCCESS) {
-                    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Cannot insert Peer_entry into vector peers\n");
+                    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Cannot insert Peer_entry into peers table\n");
                 }
             }
-        } else {
-            peer = NULL;
         }
     }
     apr_thread_mutex_unlock(self->mutex);
@@ -1803,4 +2261,29 @@ static Peer_entry *get_peer_entry(Jxta_router_client * self, Jxta_id * peerid, J
     return peer;
 }
 
+void router_client_update_route(Jxta_router_client * me, Jxta_endpoint_address * dest, Jxta_vector * gateways)
+{
+    updateRouteTable(me, dest, gateways);
+}
+
+Jxta_boolean router_client_has_route(Jxta_router_client * me, Jxta_id * peerid)
+{
+    Peer_entry *peer = NULL;
+    Jxta_vector *gateways = NULL;
+
+    peer = get_peer_entry(me, peerid, JXTA_FALSE);
+    if (peer == NULL) {
+        return JXTA_FALSE;
+    }
+
+    gateways = peer_entry_get_forward_gateways(peer);
+    JXTA_OBJECT_RELEASE(peer);
+    if (gateways == NULL) {
+        return JXTA_FALSE;
+    }
+
+    JXTA_OBJECT_RELEASE(gateways);
+    return JXTA_TRUE;
+}
+
 /* vim: set ts=4 sw=4 tw=130 et: */
@@ -0,0 +1,100 @@
+/* 
+ * Copyright (c) 2002 Sun Microsystems, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+#ifndef JXTA_ROUTER_CLIENT_PRIVATE_H
+#define JXTA_ROUTER_CLIENT_PRIVATE_H
+
+#include "jxta_id.h"
+#include "jxta_vector.h"
+#include "jxta_endpoint_address.h"
+#include "jxta_router_service.h"
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+};
+#endif
+#endif
+
+/**
+ * Records the gateways to reach the peer named by a router address, as the router does for the source of
+ * an incoming routed message. Only meant for tests and benchmarks of the router table.
+ *
+ * @param me The router.
+ * @param dest The router address ("jxta://<peer unique id>") of the peer.
+ * @param gateways The gateways to reach the peer.
+ */
+extern void router_client_update_route(Jxta_router_client * me, Jxta_endpoint_address * dest, Jxta_vector * gateways);
+
+/**
+ * Looks up the gateways the router knows for a peer, the same way a message to the peer is routed. Only
+ * meant for tests and benchmarks of the router table.
+ *
+ * @param me The router.
+ * @param peerid The id of the peer.
+ * @return TRUE if the router has gateways for the peer, FALSE otherwise.
+ */
+extern Jxta_boolean router_client_has_route(Jxta_router_client * me, Jxta_id * peerid);
+
+#ifdef __cplusplus
+#if 0
+{
+#endif
+}
+#endif
+
+#endif /* JXTA_ROUTER_CLIENT_PRIVATE_H */
+
+/* vi: set ts=4 sw=4 tw=130 et: */
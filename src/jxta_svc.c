@@ -88,6 +88,7 @@ enum tokentype {
     CacheConfigAdvertisement_,
     DiscoveryConfigAdvertisement_,
     RdvConfigAdvertisement_,
+    ResolverConfigAdvertisement_,
     SrdiConfigAdvertisement_,
     TlsConfigAdvertisement_,
     EndPointConfigAdvertisement_,
@@ -120,6 +121,7 @@ static void svc_delete(Jxta_object *);
 static void handleCacheConfigAdv(void *me, const XML_Char *cd, int len);
 static void handleDiscoveryConfigAdv(void *me, const XML_Char * cd, int len);
 static void handleRdvConfigAdv(void *me, const XML_Char * cd, int len);
+static void handleResolverConfigAdv(void *me, const XML_Char * cd, int len);
 static void handleSrdiConfigAdv(void *me, const XML_Char * cd, int len);
 static void handleEndPointConfigAdv(void *me, const XML_Char * cd, int len);
 static void handleRelayConfig(void *me, const XML_Char * cd, int len);
@@ -295,6 +297,26 @@ static void handleDiscoveryConfigAdv(void *me, const XML_Char * cd, int len)
     }
 }
 
+static void handleResolverConfigAdv(void *me, const XML_Char * cd, int len)
+{
+    Jxta_svc *ad = (Jxta_svc *) me;
+
+    JXTA_OBJECT_CHECK_VALID(ad);
+
+    if (len == 0) {
+        Jxta_ResolverConfigAdvertisement *resolverConfig = jxta_ResolverConfigAdvertisement_new();
+
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_PARANOID, "START <jxta:ResolverConfig> Element [%pp]\n", ad );
+
+        jxta_svc_set_ResolverConfig(ad, resolverConfig);
+
+        jxta_advertisement_set_handlers((Jxta_advertisement *) resolverConfig, ((Jxta_advertisement *) ad)->parser, (void *) ad);
+        JXTA_OBJECT_RELEASE(resolverConfig);
+    } else {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_PARANOID, "FINISH <jxta:ResolverConfig> Element [%pp]\n", ad );
+    }
+}
+
 static void handleRdvConfigAdv(void *me, const XML_Char * cd, int len)
 {
     Jxta_svc *ad = (Jxta_svc *) me;
@@ -649,6 +671,16 @@ JXTA_DECLARE(void) jxta_svc_set_RdvConfig(Jxta_svc * ad, Jxta_RdvConfigAdvertise
     jxta_svc_set_Parm( ad, (Jxta_advertisement *) rdvConfig );
 }
 
+JXTA_DECLARE(Jxta_ResolverConfigAdvertisement *) jxta_svc_get_ResolverConfig(Jxta_svc * ad)
+{
+    return (Jxta_ResolverConfigAdvertisement*) jxta_svc_get_Parm_type( ad, "jxta:ResolverConfig" );
+}
+
+JXTA_DECLARE(void) jxta_svc_set_ResolverConfig(Jxta_svc * ad, Jxta_ResolverConfigAdvertisement * resolverConfig)
+{
+    jxta_svc_set_Parm( ad, (Jxta_advertisement *) resolverConfig );
+}
+
 JXTA_DECLARE(Jxta_CacheConfigAdvertisement *) jxta_svc_get_CacheConfig(Jxta_svc * ad)
 {
     return (Jxta_CacheConfigAdvertisement*) jxta_svc_get_Parm_type( ad, "jxta:CacheConfig" );
@@ -717,6 +749,7 @@ static const Kwdtab Svc_tags[] = {
     {"jxta:DiscoveryConfig", DiscoveryConfigAdvertisement_, *handleDiscoveryConfigAdv, NULL, NULL},
     {"jxta:EndPointConfig", EndPointConfigAdvertisement_, *handleEndPointConfigAdv, NULL, NULL},
     {"jxta:RdvConfig", RdvConfigAdvertisement_, *handleRdvConfigAdv, NULL, NULL},
+    {"jxta:ResolverConfig", ResolverConfigAdvertisement_, *handleResolverConfigAdv, NULL, NULL},
     {"jxta:SrdiConfig", SrdiConfigAdvertisement_, *handleSrdiConfigAdv, NULL, NULL},
     {"jxta:TlsConfig", TlsConfigAdvertisement_, *handleTlsConfigAdv, NULL, NULL},
     {"jxta:TCPTransportAdvertisement", TCPTransportAdvertisement_, *handleTCPTransportAdvertisement, NULL, NULL},
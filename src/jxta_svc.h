@@ -64,6 +64,7 @@
 #include "jxta_discovery_config_adv.h"
 #include "jxta_endpoint_config_adv.h"
 #include "jxta_rdv_config_adv.h"
+#include "jxta_resolver_config_adv.h"
 #include "jxta_tls_config_adv.h"
 #include "jxta_srdi_config_adv.h"
 #include "jxta_relaya.h"
@@ -173,6 +174,18 @@ JXTA_DECLARE(Jxta_RdvConfigAdvertisement *) jxta_svc_get_RdvConfig(Jxta_svc *);
  */
 JXTA_DECLARE(void) jxta_svc_set_RdvConfig(Jxta_svc *, Jxta_RdvConfigAdvertisement *);
 
+/*
+ * Unlike similar accessors in other advs, this one may return NULL if
+ * there is no such element.
+ */
+JXTA_DECLARE(Jxta_ResolverConfigAdvertisement *) jxta_svc_get_ResolverConfig(Jxta_svc *);
+
+/*
+ * Unlike similar mutators in other advs, it is valid to pass NULL as a means
+ * to remove the element.
+ */
+JXTA_DECLARE(void) jxta_svc_set_ResolverConfig(Jxta_svc *, Jxta_ResolverConfigAdvertisement *);
+
 /*
  * Unlike similar accessors in other advs, this one may return NULL if
  * there is no such element.
@@ -0,0 +1,1014 @@
+/*
+ * Copyright (c) 2002-2004 Sun Microsystems, Inc.  All rights
+ * reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+static const char *__log_cat = "LOOPBACK_TRANSPORT";
+
+#include <assert.h>
+
+#include "jstring.h"
+#include "jxta_types.h"
+#include "jxta_errno.h"
+#include "jxta_log.h"
+#include "jxta_peergroup.h"
+#include "jxta_apr.h"
+
+#include "jxta_module_private.h"
+#include "jxta_transport_private.h"
+#include "jxta_transport_loopback.h"
+#include "jxta_tcp_message_packet_header.h"
+#include "jxta_endpoint_service_priv.h"
+
+#define LOOPBACK_PROTOCOL "loopback"
+
+/* address used as destination of propagated messages */
+#define LOOPBACK_PROPAGATE_ADDRESS "propagate"
+
+/* a loss rate is in parts per million */
+#define LOOPBACK_LOSS_SCALE 1000000
+
+/********************************************************************************/
+/*                                                                              */
+/********************************************************************************/
+typedef struct lb_delivery {
+    APR_RING_ENTRY(lb_delivery) link;
+    /* time the message reaches the destination */
+    apr_time_t due;
+    /* serialized message, shared by all the destinations of a propagated message */
+    JString *wire;
+} Lb_delivery;
+
+typedef APR_RING_HEAD(lb_queue, lb_delivery) Lb_queue;
+
+struct _jxta_transport_loopback {
+    Extends(Jxta_transport);
+
+    apr_pool_t *pool;
+    apr_thread_mutex_t *mutex;
+
+    Jxta_PG *group;
+    Jxta_endpoint_service *endpoint;
+    char *protocol_address;
+    Jxta_endpoint_address *public_addr;
+    Jxta_boolean running;
+
+    /* outgoing link */
+    apr_interval_time_t latency;
+    apr_size_t bandwidth;
+    apr_uint32_t loss_rate;
+    apr_uint32_t seed;
+    Jxta_boolean seeded;
+    /* time the link is done transmitting the messages already sent */
+    apr_time_t tx_free;
+
+    /* incoming messages, ordered by delivery time */
+    Lb_queue queue;
+    /* time of the next scheduled delivery task, 0 if there is none */
+    apr_time_t drain_at;
+    Jxta_boolean draining;
+
+    Jxta_transport_loopback_stats stats;
+};
+
+typedef struct _jxta_transport_loopback _jxta_transport_loopback;
+
+typedef Jxta_transport_methods Jxta_transport_loopback_methods;
+
+typedef struct _loopback_messenger {
+    JxtaEndpointMessenger _super;
+    _jxta_transport_loopback *tp;
+} Loopback_messenger;
+
+/********************************************************************************/
+/*                                                                              */
+/********************************************************************************/
+static Jxta_status init(Jxta_module * module, Jxta_PG * group, Jxta_id * assigned_id, Jxta_advertisement * impl_adv);
+static Jxta_status start(Jxta_module * module, const char *argv[]);
+static void stop(Jxta_module * module);
+
+static JString *name_get(Jxta_transport * _self);
+static Jxta_endpoint_address *publicaddr_get(Jxta_transport * _self);
+static JxtaEndpointMessenger *messenger_get(Jxta_transport * t, Jxta_endpoint_address * dest);
+static Jxta_boolean ping(Jxta_transport * t, Jxta_endpoint_address * addr);
+static void propagate(Jxta_transport * t, Jxta_message * msg, const char *service_name, const char *service_params);
+static Jxta_boolean allow_overload_p(Jxta_transport * t);
+static Jxta_boolean allow_routing_p(Jxta_transport * t);
+static Jxta_boolean connection_oriented_p(Jxta_transport * t);
+
+static void *APR_THREAD_FUNC loopback_drain(apr_thread_t * thread, void *arg);
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+const Jxta_transport_loopback_methods jxta_transport_loopback_methods = {
+    {
+     "Jxta_module_methods",
+     init,
+     start,
+     stop},
+    "Jxta_transport_methods",
+    name_get,
+    publicaddr_get,
+    messenger_get,
+    ping,
+    propagate,
+    allow_overload_p,
+    allow_routing_p,
+    connection_oriented_p
+};
+
+/*************************************************************************
+ * Process wide registry of the running loopback transports, by protocol address.
+ *************************************************************************/
+#define REGISTRY_NONE 0
+#define REGISTRY_CREATING 1
+#define REGISTRY_READY 2
+
+static volatile apr_uint32_t registry_state = REGISTRY_NONE;
+static apr_pool_t *registry_pool = NULL;
+static apr_thread_mutex_t *registry_mutex = NULL;
+static apr_hash_t *registry = NULL;
+
+/*
+ * The registry lives as long as the process, it is created by the first transport started.
+ */
+static Jxta_status registry_init(void)
+{
+    apr_status_t rv;
+
+    for (;;) {
+        switch (apr_atomic_cas32(&registry_state, REGISTRY_CREATING, REGISTRY_NONE)) {
+            case REGISTRY_READY:
+                return JXTA_SUCCESS;
+            case REGISTRY_CREATING:
+                apr_thread_yield();
+                break;
+            case REGISTRY_NONE:
+            default:
+                rv = apr_pool_create(&registry_pool, NULL);
+                if (APR_SUCCESS == rv) {
+                    rv = apr_thread_mutex_create(&registry_mutex, APR_THREAD_MUTEX_DEFAULT, registry_pool);
+                }
+                if (APR_SUCCESS != rv) {
+                    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Failed to create registry: %d\n", rv);
+                    if (registry_pool) {
+                        apr_pool_destroy(registry_pool);
+                        registry_pool = NULL;
+                    }
+                    apr_atomic_set32(&registry_state, REGISTRY_NONE);
+                    return JXTA_FAILED;
+                }
+                registry = apr_hash_make(registry_pool);
+                apr_atomic_set32(&registry_state, REGISTRY_READY);
+                return JXTA_SUCCESS;
+        }
+    }
+}
+
+static Jxta_status registry_add(_jxta_transport_loopback * tp)
+{
+    Jxta_status rv;
+
+    rv = registry_init();
+    if (JXTA_SUCCESS != rv) {
+        return rv;
+    }
+
+    apr_thread_mutex_lock(registry_mutex);
+    if (NULL != apr_hash_get(registry, tp->protocol_address, APR_HASH_KEY_STRING)) {
+        apr_thread_mutex_unlock(registry_mutex);
+        return JXTA_ITEM_EXISTS;
+    }
+    apr_hash_set(registry, tp->protocol_address, APR_HASH_KEY_STRING, tp);
+    apr_thread_mutex_unlock(registry_mutex);
+    return JXTA_SUCCESS;
+}
+
+static void registry_remove(_jxta_transport_loopback * tp)
+{
+    if (REGISTRY_READY != apr_atomic_read32(&registry_state)) {
+        return;
+    }
+
+    apr_thread_mutex_lock(registry_mutex);
+    if (tp == apr_hash_get(registry, tp->protocol_address, APR_HASH_KEY_STRING)) {
+        apr_hash_set(registry, tp->protocol_address, APR_HASH_KEY_STRING, NULL);
+    }
+    apr_thread_mutex_unlock(registry_mutex);
+}
+
+/**
+ * Get the running transport for a protocol address.
+ *
+ * @return a shared reference to the transport or NULL if there is none.
+ */
+static _jxta_transport_loopback *registry_get(const char *protocol_address)
+{
+    _jxta_transport_loopback *tp;
+
+    if (REGISTRY_READY != apr_atomic_read32(&registry_state)) {
+        return NULL;
+    }
+
+    apr_thread_mutex_lock(registry_mutex);
+    tp = apr_hash_get(registry, protocol_address, APR_HASH_KEY_STRING);
+    if (NULL != tp) {
+        JXTA_OBJECT_SHARE(tp);
+    }
+    apr_thread_mutex_unlock(registry_mutex);
+    return tp;
+}
+
+/**
+ * Get all the running transports but one.
+ *
+ * @return a NULL terminated array of shared references to be freed by the caller.
+ */
+static _jxta_transport_loopback **registry_get_all(_jxta_transport_loopback * except)
+{
+    _jxta_transport_loopback **all;
+    _jxta_transport_loopback *tp;
+    apr_hash_index_t *hi;
+    int i = 0;
+
+    if (REGISTRY_READY != apr_atomic_read32(&registry_state)) {
+        return NULL;
+    }
+
+    apr_thread_mutex_lock(registry_mutex);
+    all = calloc(apr_hash_count(registry) + 1, sizeof(*all));
+    if (NULL != all) {
+        for (hi = apr_hash_first(NULL, registry); hi; hi = apr_hash_next(hi)) {
+            apr_hash_this(hi, NULL, NULL, (void **) &tp);
+            if (tp != except) {
+                all[i++] = JXTA_OBJECT_SHARE(tp);
+            }
+        }
+    }
+    apr_thread_mutex_unlock(registry_mutex);
+    return all;
+}
+
+/*************************************************************************
+ * Simulated link
+ *************************************************************************/
+
+/* xorshift, a seed always gives the same sequence */
+static apr_uint32_t loopback_random(apr_uint32_t * seed)
+{
+    apr_uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+/*
+ * Decide if the next message is lost, must be called with mutex held.
+ */
+static Jxta_boolean loopback_lost(_jxta_transport_loopback * me)
+{
+    if (0 == me->loss_rate) {
+        return FALSE;
+    }
+    return (loopback_random(&me->seed) % LOOPBACK_LOSS_SCALE) < me->loss_rate;
+}
+
+/*
+ * Transmit size bytes on the outgoing link and return the time they reach the destination, must be called with mutex held.
+ */
+static apr_time_t loopback_transmit(_jxta_transport_loopback * me, apr_size_t size)
+{
+    apr_time_t now = apr_time_now();
+
+    if (me->tx_free < now) {
+        me->tx_free = now;
+    }
+    if (me->bandwidth > 0) {
+        me->tx_free += (apr_time_t) size * APR_USEC_PER_SEC / me->bandwidth;
+    }
+    me->stats.msgs_sent++;
+    me->stats.bytes_sent += size;
+    return me->tx_free + me->latency;
+}
+
+/*
+ * Schedule the delivery task for the first queued message if there is no task scheduled early enough.
+ * Must be called with mutex held.
+ */
+static void loopback_schedule(_jxta_transport_loopback * me, apr_time_t now)
+{
+    Lb_delivery *first;
+
+    if (!me->running || APR_RING_EMPTY(&me->queue, lb_delivery, link)) {
+        if (me->drain_at <= now) {
+            me->drain_at = 0;
+        }
+        return;
+    }
+
+    first = APR_RING_FIRST(&me->queue);
+    if (0 != me->drain_at && me->drain_at > now && me->drain_at <= first->due) {
+        return;
+    }
+    if (APR_SUCCESS != apr_thread_pool_schedule(jxta_PG_thread_pool_get(me->group), loopback_drain, me,
+                                                (first->due > now) ? first->due - now : 0, me)) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Failed to schedule delivery task\n");
+        return;
+    }
+    me->drain_at = first->due;
+}
+
+/*
+ * Queue a serialized message for delivery to the endpoint service of the transport.
+ */
+static void loopback_enqueue(_jxta_transport_loopback * me, JString * wire, apr_time_t due)
+{
+    Lb_delivery *d;
+    Lb_delivery *prev;
+
+    d = calloc(1, sizeof(*d));
+    if (NULL == d) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+        return;
+    }
+    d->due = due;
+    d->wire = JXTA_OBJECT_SHARE(wire);
+
+    apr_thread_mutex_lock(me->mutex);
+    if (!me->running) {
+        apr_thread_mutex_unlock(me->mutex);
+        JXTA_OBJECT_RELEASE(d->wire);
+        free(d);
+        return;
+    }
+    /* messages mostly arrive in order, look for the place from the end */
+    prev = APR_RING_LAST(&me->queue);
+    while (prev != APR_RING_SENTINEL(&me->queue, lb_delivery, link) && prev->due > due) {
+        prev = APR_RING_PREV(prev, link);
+    }
+    APR_RING_INSERT_AFTER(prev, d, link);
+    loopback_schedule(me, apr_time_now());
+    apr_thread_mutex_unlock(me->mutex);
+}
+
+static void loopback_queue_destroy(Lb_queue * queue)
+{
+    Lb_delivery *d;
+
+    while (!APR_RING_EMPTY(queue, lb_delivery, link)) {
+        d = APR_RING_FIRST(queue);
+        APR_RING_REMOVE(d, link);
+        JXTA_OBJECT_RELEASE(d->wire);
+        free(d);
+    }
+}
+
+typedef struct {
+    const char *buf;
+    apr_size_t len;
+    apr_size_t pos;
+} Lb_reader;
+
+static Jxta_status JXTA_STDCALL loopback_read(void *stream, char *buf, size_t len)
+{
+    Lb_reader *reader = (Lb_reader *) stream;
+
+    if (reader->len - reader->pos < len) {
+        return JXTA_IOERR;
+    }
+    memcpy(buf, reader->buf + reader->pos, len);
+    reader->pos += len;
+    return JXTA_SUCCESS;
+}
+
+static void loopback_deliver(_jxta_transport_loopback * me, JString * wire)
+{
+    Jxta_message *msg;
+    Lb_reader reader;
+    Jxta_status rv;
+
+    msg = jxta_message_new();
+    if (NULL == msg) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+        return;
+    }
+
+    reader.buf = jstring_get_string(wire);
+    reader.len = jstring_length(wire);
+    reader.pos = 0;
+    rv = jxta_message_read(msg, APP_MSG, loopback_read, &reader);
+    if (JXTA_SUCCESS != rv) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Failed to read message[%pp] with status %d\n", msg, rv);
+        JXTA_OBJECT_RELEASE(msg);
+        return;
+    }
+
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Received a new message[%pp] of %" APR_SIZE_T_FMT " bytes\n", msg,
+                    reader.len);
+    jxta_endpoint_service_demux(me->endpoint, msg);
+    JXTA_OBJECT_RELEASE(msg);
+}
+
+/*
+ * Deliver the messages which are due. Only one task delivers at a time so messages are delivered in order.
+ */
+static void *APR_THREAD_FUNC loopback_drain(apr_thread_t * thread, void *arg)
+{
+    _jxta_transport_loopback *me = PTValid(arg, _jxta_transport_loopback);
+    Lb_queue due;
+    Lb_delivery *d;
+    apr_time_t now;
+    apr_uint32_t cnt;
+    apr_uint64_t bytes;
+
+    apr_thread_mutex_lock(me->mutex);
+    if (!me->running || me->draining) {
+        apr_thread_mutex_unlock(me->mutex);
+        return NULL;
+    }
+    me->draining = TRUE;
+
+    APR_RING_INIT(&due, lb_delivery, link);
+    for (;;) {
+        now = apr_time_now();
+        while (!APR_RING_EMPTY(&me->queue, lb_delivery, link) && APR_RING_FIRST(&me->queue)->due <= now) {
+            d = APR_RING_FIRST(&me->queue);
+            APR_RING_REMOVE(d, link);
+            APR_RING_INSERT_TAIL(&due, d, lb_delivery, link);
+        }
+        if (APR_RING_EMPTY(&due, lb_delivery, link) || !me->running) {
+            break;
+        }
+        apr_thread_mutex_unlock(me->mutex);
+
+        cnt = 0;
+        bytes = 0;
+        while (!APR_RING_EMPTY(&due, lb_delivery, link)) {
+            d = APR_RING_FIRST(&due);
+            APR_RING_REMOVE(d, link);
+            cnt++;
+            bytes += jstring_length(d->wire);
+            loopback_deliver(me, d->wire);
+            JXTA_OBJECT_RELEASE(d->wire);
+            free(d);
+        }
+
+        apr_thread_mutex_lock(me->mutex);
+        me->stats.msgs_received += cnt;
+        me->stats.bytes_received += bytes;
+    }
+    loopback_queue_destroy(&due);
+    me->draining = FALSE;
+    loopback_schedule(me, now);
+    apr_thread_mutex_unlock(me->mutex);
+    return NULL;
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static Jxta_status init(Jxta_module * module, Jxta_PG * group, Jxta_id * assigned_id, Jxta_advertisement * impl_adv)
+{
+    _jxta_transport_loopback *_self = PTValid(module, _jxta_transport_loopback);
+    apr_status_t status;
+    Jxta_id *id;
+    JString *unique = NULL;
+    apr_ssize_t len;
+
+    status = apr_pool_create(&_self->pool, NULL);
+    if (APR_SUCCESS != status) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Failed to create pool: %d\n", status);
+        return JXTA_NOMEM;
+    }
+
+    status = apr_thread_mutex_create(&_self->mutex, APR_THREAD_MUTEX_DEFAULT, _self->pool);
+    if (APR_SUCCESS != status) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Failed to create mutex: %d\n", status);
+        return JXTA_FAILED;
+    }
+
+    jxta_PG_get_endpoint_service(group, &_self->endpoint);
+    jxta_PG_get_PID(group, &id);
+    jxta_id_get_uniqueportion(id, &unique);
+    JXTA_OBJECT_RELEASE(id);
+    if (NULL == unique) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, "Failed to get peer id string.\n");
+        return JXTA_NOMEM;
+    }
+
+    _self->protocol_address = strdup(jstring_get_string(unique));
+    JXTA_OBJECT_RELEASE(unique);
+    if (NULL == _self->protocol_address) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+        return JXTA_NOMEM;
+    }
+
+    _self->public_addr = jxta_endpoint_address_new_2(LOOPBACK_PROTOCOL, _self->protocol_address, NULL, NULL);
+    if (NULL == _self->public_addr) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+        return JXTA_NOMEM;
+    }
+
+    /* a different default sequence for each peer */
+    if (!_self->seeded) {
+        len = APR_HASH_KEY_STRING;
+        _self->seed = apr_hashfunc_default(_self->protocol_address, &len) | 1;
+    }
+
+    _self->group = group;
+
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Loopback transport public addr = %s://%s\n", LOOPBACK_PROTOCOL,
+                    _self->protocol_address);
+    return JXTA_SUCCESS;
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static Jxta_status start(Jxta_module * module, const char *argv[])
+{
+    _jxta_transport_loopback *_self = PTValid(module, _jxta_transport_loopback);
+    Jxta_status rv;
+
+    _self->running = TRUE;
+    rv = registry_add(_self);
+    if (JXTA_SUCCESS != rv) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Failed to register loopback address %s: %d\n",
+                        _self->protocol_address, rv);
+        _self->running = FALSE;
+        return rv;
+    }
+
+    jxta_endpoint_service_add_transport(_self->endpoint, (Jxta_transport *) _self);
+
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Loopback transport started\n");
+    return JXTA_SUCCESS;
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static void stop(Jxta_module * module)
+{
+    _jxta_transport_loopback *_self = PTValid(module, _jxta_transport_loopback);
+
+    registry_remove(_self);
+
+    apr_thread_mutex_lock(_self->mutex);
+    _self->running = FALSE;
+    apr_thread_mutex_unlock(_self->mutex);
+
+    apr_thread_pool_tasks_cancel(jxta_PG_thread_pool_get(_self->group), (void *) _self);
+
+    apr_thread_mutex_lock(_self->mutex);
+    loopback_queue_destroy(&_self->queue);
+    _self->drain_at = 0;
+    apr_thread_mutex_unlock(_self->mutex);
+
+    jxta_endpoint_service_remove_transport(_self->endpoint, (Jxta_transport *) _self);
+
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Stopped.\n");
+}
+
+/*******************************
+ * Loopback Messenger methods *
+ ******************************/
+
+static void loopback_messenger_free(Jxta_object * obj)
+{
+    Loopback_messenger *me = (Loopback_messenger *) obj;
+
+    JXTA_OBJECT_RELEASE(me->_super.address);
+    JXTA_OBJECT_RELEASE(me->tp);
+
+    memset(me, 0xDD, sizeof(Loopback_messenger));
+    free(me);
+}
+
+static Jxta_status loopback_messenger_send(JxtaEndpointMessenger * mes, Jxta_message * msg)
+{
+    Loopback_messenger *myself = (Loopback_messenger *) mes;
+    _jxta_transport_loopback *me = myself->tp;
+    _jxta_transport_loopback *peer;
+    JString *wire;
+    Jxta_status rv;
+    apr_time_t due;
+    Jxta_boolean lost;
+
+    JXTA_OBJECT_CHECK_VALID(myself);
+    JXTA_OBJECT_CHECK_VALID(msg);
+
+    peer = registry_get(jxta_endpoint_address_get_protocol_address(mes->address));
+    if (NULL == peer) {
+        apr_thread_mutex_lock(me->mutex);
+        me->stats.msgs_unreachable++;
+        apr_thread_mutex_unlock(me->mutex);
+        return JXTA_UNREACHABLE_DEST;
+    }
+
+    wire = jstring_new_0();
+    if (NULL == wire) {
+        JXTA_OBJECT_RELEASE(peer);
+        return JXTA_NOMEM;
+    }
+    rv = jxta_message_to_jstring(msg, APP_MSG, wire);
+    if (JXTA_SUCCESS != rv) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Failed to serialize message[%pp]: %d\n", msg, rv);
+        JXTA_OBJECT_RELEASE(wire);
+        JXTA_OBJECT_RELEASE(peer);
+        return rv;
+    }
+
+    apr_thread_mutex_lock(me->mutex);
+    due = loopback_transmit(me, jstring_length(wire));
+    lost = loopback_lost(me);
+    if (lost) {
+        me->stats.msgs_lost++;
+    }
+    apr_thread_mutex_unlock(me->mutex);
+
+    if (lost) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Message[%pp] for %s is lost\n", msg, peer->protocol_address);
+    } else {
+        loopback_enqueue(peer, wire, due);
+    }
+
+    JXTA_OBJECT_RELEASE(wire);
+    JXTA_OBJECT_RELEASE(peer);
+    return JXTA_SUCCESS;
+}
+
+static Loopback_messenger *loopback_messenger_new(_jxta_transport_loopback * tp, Jxta_endpoint_address * dest)
+{
+    Loopback_messenger *me;
+
+    me = calloc(1, sizeof(Loopback_messenger));
+    if (NULL == me) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+        return NULL;
+    }
+
+    me->_super.address = jxta_endpoint_address_new_2(LOOPBACK_PROTOCOL, jxta_endpoint_address_get_protocol_address(dest),
+                                                     NULL, NULL);
+    if (NULL == me->_super.address) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+        free(me);
+        return NULL;
+    }
+    me->_super.jxta_send = loopback_messenger_send;
+    me->tp = JXTA_OBJECT_SHARE(tp);
+
+    JXTA_OBJECT_INIT(me, loopback_messenger_free, NULL);
+
+    return me;
+}
+
+/*******************************
+ * Loopback Transport methods *
+ ******************************/
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static JString *name_get(Jxta_transport * t)
+{
+    PTValid(t, _jxta_transport_loopback);
+
+    return jstring_new_2(LOOPBACK_PROTOCOL);
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static Jxta_endpoint_address *publicaddr_get(Jxta_transport * t)
+{
+    _jxta_transport_loopback *_self = PTValid(t, _jxta_transport_loopback);
+
+    return JXTA_OBJECT_SHARE(_self->public_addr);
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static JxtaEndpointMessenger *messenger_get(Jxta_transport * t, Jxta_endpoint_address * dest)
+{
+    _jxta_transport_loopback *_self = PTValid(t, _jxta_transport_loopback);
+
+    if (0 != strcmp(LOOPBACK_PROTOCOL, jxta_endpoint_address_get_protocol_name(dest))) {
+        return NULL;
+    }
+
+    /* like a connection refused, no messenger to a peer which is not running */
+    if (!ping(t, dest)) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "No loopback transport for %s\n",
+                        jxta_endpoint_address_get_protocol_address(dest));
+        return NULL;
+    }
+
+    return (JxtaEndpointMessenger *) loopback_messenger_new(_self, dest);
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static Jxta_boolean ping(Jxta_transport * t, Jxta_endpoint_address * addr)
+{
+    _jxta_transport_loopback *peer;
+
+    PTValid(t, _jxta_transport_loopback);
+
+    peer = registry_get(jxta_endpoint_address_get_protocol_address(addr));
+    if (NULL == peer) {
+        return FALSE;
+    }
+    JXTA_OBJECT_RELEASE(peer);
+    return TRUE;
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static void propagate(Jxta_transport * t, Jxta_message * msg, const char *service_name, const char *service_params)
+{
+    _jxta_transport_loopback *_self = PTValid(t, _jxta_transport_loopback);
+    _jxta_transport_loopback **peers;
+    Jxta_endpoint_address *m_addr;
+    JString *wire;
+    apr_time_t due;
+    Jxta_boolean lost;
+    int i;
+
+    m_addr = jxta_endpoint_address_new_2(LOOPBACK_PROTOCOL, LOOPBACK_PROPAGATE_ADDRESS, service_name, service_params);
+    wire = jstring_new_0();
+    if (NULL == m_addr || NULL == wire) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory\n");
+        if (m_addr) {
+            JXTA_OBJECT_RELEASE(m_addr);
+        }
+        if (wire) {
+            JXTA_OBJECT_RELEASE(wire);
+        }
+        return;
+    }
+
+    jxta_message_set_source(msg, _self->public_addr);
+    jxta_message_set_destination(msg, m_addr);
+    JXTA_OBJECT_RELEASE(m_addr);
+    if (JXTA_SUCCESS != jxta_message_to_jstring(msg, APP_MSG, wire)) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Propagate failed\n");
+        JXTA_OBJECT_RELEASE(wire);
+        return;
+    }
+
+    peers = registry_get_all(_self);
+    if (NULL == peers) {
+        JXTA_OBJECT_RELEASE(wire);
+        return;
+    }
+
+    /* the message is transmitted once as with multicast, each receiver may lose it */
+    apr_thread_mutex_lock(_self->mutex);
+    due = loopback_transmit(_self, jstring_length(wire));
+    apr_thread_mutex_unlock(_self->mutex);
+
+    for (i = 0; NULL != peers[i]; i++) {
+        apr_thread_mutex_lock(_self->mutex);
+        lost = loopback_lost(_self);
+        if (lost) {
+            _self->stats.msgs_lost++;
+        }
+        apr_thread_mutex_unlock(_self->mutex);
+
+        if (!lost) {
+            loopback_enqueue(peers[i], wire, due);
+        }
+        JXTA_OBJECT_RELEASE(peers[i]);
+    }
+    free(peers);
+    JXTA_OBJECT_RELEASE(wire);
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static Jxta_boolean allow_overload_p(Jxta_transport * t)
+{
+    return FALSE;
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static Jxta_boolean allow_routing_p(Jxta_transport * t)
+{
+    return TRUE;
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static Jxta_boolean connection_oriented_p(Jxta_transport * t)
+{
+    return FALSE;
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static Jxta_transport_loopback *jxta_transport_loopback_construct(_jxta_transport_loopback * _self,
+                                                                  Jxta_transport_loopback_methods const *methods)
+{
+    PTValid(methods, Jxta_transport_methods);
+    jxta_transport_construct((Jxta_transport *) _self, (Jxta_transport_methods const *) methods);
+
+    _self->thisType = "_jxta_transport_loopback";
+
+    /* in-process delivery is preferred over any real transport */
+    _self->_super.metric = 8;
+    _self->_super.direction = JXTA_BIDIRECTION;
+
+    _self->pool = NULL;
+    _self->mutex = NULL;
+    _self->group = NULL;
+    _self->endpoint = NULL;
+    _self->protocol_address = NULL;
+    _self->public_addr = NULL;
+    _self->running = FALSE;
+
+    _self->latency = 0;
+    _self->bandwidth = 0;
+    _self->loss_rate = 0;
+    _self->seed = 1;
+    _self->seeded = FALSE;
+    _self->tx_free = 0;
+
+    APR_RING_INIT(&_self->queue, lb_delivery, link);
+    _self->drain_at = 0;
+    _self->draining = FALSE;
+    memset(&_self->stats, 0, sizeof(_self->stats));
+
+    return _self;
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static void jxta_transport_loopback_destruct(_jxta_transport_loopback * _self)
+{
+    loopback_queue_destroy(&_self->queue);
+
+    if (_self->public_addr != NULL) {
+        JXTA_OBJECT_RELEASE(_self->public_addr);
+    }
+
+    if (_self->protocol_address != NULL) {
+        free(_self->protocol_address);
+    }
+
+    if (_self->endpoint != NULL) {
+        JXTA_OBJECT_RELEASE(_self->endpoint);
+    }
+
+    if (_self->pool) {
+        apr_pool_destroy(_self->pool);
+    }
+
+    _self->thisType = NULL;
+
+    jxta_transport_destruct((Jxta_transport *) _self);
+
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "Destruction of [%pp] finished\n", _self);
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+static void loopback_free(Jxta_object * obj)
+{
+    jxta_transport_loopback_destruct((_jxta_transport_loopback *) obj);
+
+    memset(obj, 0xdd, sizeof(_jxta_transport_loopback));
+    free(obj);
+}
+
+/******************************************************************************/
+/*                                                                            */
+/******************************************************************************/
+JXTA_DECLARE(Jxta_transport_loopback *) jxta_transport_loopback_new_instance(void)
+{
+    _jxta_transport_loopback *_self = (_jxta_transport_loopback *) calloc(1, sizeof(_jxta_transport_loopback));
+    if (_self == NULL) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "out of memory\n");
+        return NULL;
+    }
+
+    JXTA_OBJECT_INIT(_self, loopback_free, NULL);
+
+    return jxta_transport_loopback_construct(_self, &jxta_transport_loopback_methods);
+}
+
+JXTA_DECLARE(Jxta_status) jxta_transport_loopback_set_link(Jxta_transport_loopback * me, apr_interval_time_t latency,
+                                                           apr_size_t bandwidth, apr_uint32_t loss_rate)
+{
+    _jxta_transport_loopback *_self = PTValid(me, _jxta_transport_loopback);
+
+    if (latency < 0 || loss_rate > LOOPBACK_LOSS_SCALE) {
+        return JXTA_INVALID_ARGUMENT;
+    }
+
+    if (_self->mutex) {
+        apr_thread_mutex_lock(_self->mutex);
+    }
+    _self->latency = latency;
+    _self->bandwidth = bandwidth;
+    _self->loss_rate = loss_rate;
+    if (_self->mutex) {
+        apr_thread_mutex_unlock(_self->mutex);
+    }
+    return JXTA_SUCCESS;
+}
+
+JXTA_DECLARE(void) jxta_transport_loopback_set_seed(Jxta_transport_loopback * me, apr_uint32_t seed)
+{
+    _jxta_transport_loopback *_self = PTValid(me, _jxta_transport_loopback);
+
+    if (_self->mutex) {
+        apr_thread_mutex_lock(_self->mutex);
+    }
+    /* xorshift never leaves 0 */
+    _self->seed = (0 == seed) ? 1 : seed;
+    _self->seeded = TRUE;
+    if (_self->mutex) {
+        apr_thread_mutex_unlock(_self->mutex);
+    }
+}
+
+JXTA_DECLARE(void) jxta_transport_loopback_get_stats(Jxta_transport_loopback * me, Jxta_transport_loopback_stats * stats)
+{
+    _jxta_transport_loopback *_self = PTValid(me, _jxta_transport_loopback);
+
+    if (_self->mutex) {
+        apr_thread_mutex_lock(_self->mutex);
+    }
+    *stats = _self->stats;
+    if (_self->mutex) {
+        apr_thread_mutex_unlock(_self->mutex);
+    }
+}
+
+/* vi: set ts=4 sw=4 tw=130 et: */
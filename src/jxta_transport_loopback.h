@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2002-2004 Sun Microsystems, Inc.  All rights
+ * reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+#ifndef __JXTA_TRANSPORT_LOOPBACK_H__
+#define __JXTA_TRANSPORT_LOOPBACK_H__
+
+#include "jxta_apr.h"
+#include "jxta_types.h"
+#include "jxta_transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+};
+#endif
+#endif
+
+/*
+ * The loopback transport delivers messages between the peers running in the same process through in-memory queues, using
+ * addresses of the form loopback://<unique portion of the peer id>. It is meant for tests and benchmarks of the protocol
+ * layers which need several peers without the noise of the network stack.
+ *
+ * The transport is not loaded by the net peer group, it is created with jxta_transport_loopback_new_instance and
+ * initialized and started on the net peer group of each peer like any other module.
+ *
+ * Each transport simulates its outgoing link: a message is delivered after it has been transmitted at the configured
+ * bandwidth, once the messages sent before it are, plus the configured latency. Messages are lost at the configured rate
+ * with a pseudo random sequence, a given seed always produces the same losses.
+ */
+typedef struct _jxta_transport_loopback Jxta_transport_loopback;
+
+/* Statistics of the loopback transport */
+typedef struct _jxta_transport_loopback_stats {
+    /* number of messages sent, including the lost ones */
+    apr_uint32_t msgs_sent;
+    apr_uint64_t bytes_sent;
+    /* number of messages delivered to the endpoint service of this peer */
+    apr_uint32_t msgs_received;
+    apr_uint64_t bytes_received;
+    /* number of messages dropped to simulate the loss rate */
+    apr_uint32_t msgs_lost;
+    /* number of messages sent to a peer not running a loopback transport */
+    apr_uint32_t msgs_unreachable;
+} Jxta_transport_loopback_stats;
+
+JXTA_DECLARE(Jxta_transport_loopback *) jxta_transport_loopback_new_instance(void);
+
+/**
+ * Set the characteristics of the outgoing link of the transport. Can be changed while the transport is running, messages
+ * already sent are not affected.
+ *
+ * @param me the loopback transport
+ * @param latency time in microseconds between the end of the transmission of a message and its delivery
+ * @param bandwidth number of bytes transmitted per second, 0 for unlimited
+ * @param loss_rate rate of messages lost in parts per million, up to 1000000
+ * @return JXTA_SUCCESS or JXTA_INVALID_ARGUMENT
+ */
+JXTA_DECLARE(Jxta_status) jxta_transport_loopback_set_link(Jxta_transport_loopback * me, apr_interval_time_t latency,
+                                                           apr_size_t bandwidth, apr_uint32_t loss_rate);
+
+/**
+ * Reset the pseudo random sequence used to decide the lost messages.
+ */
+JXTA_DECLARE(void) jxta_transport_loopback_set_seed(Jxta_transport_loopback * me, apr_uint32_t seed);
+
+JXTA_DECLARE(void) jxta_transport_loopback_get_stats(Jxta_transport_loopback * me, Jxta_transport_loopback_stats * stats);
+
+#ifdef __cplusplus
+#if 0
+{
+#endif
+}
+#endif
+
+#endif /* __JXTA_TRANSPORT_LOOPBACK_H__ */
+
+/* vi: set ts=4 sw=4 tw=130 et: */
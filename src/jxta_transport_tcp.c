@@ -84,12 +84,13 @@ static const char *__log_cat = "TCP_TRANSPORT";
  * and connection closed */
 /* 5 minutes */
 #define MESSENGER_TIMEOUT (5*60)
-#define CLOSE_CONNECTION_AFTER_TIMEOUT_JPR (5*60*1000)
-#define CONSERVATIVE_MESSENGER_REMOVAL
 
 /* 1 minute */
 #define INTERVAL_CHECK_FOR_UNUSED_MESSENGERS_APR (60*1000000L)
 
+/* A connection must have been unused for 10 seconds before it can be evicted to make room for a new one */
+#define MIN_IDLE_BEFORE_EVICTION_JPR (10*1000)
+
 /*************************************************************************
  **
  *************************************************************************/
@@ -104,10 +105,15 @@ static const char *MESSAGE_DESTINATION_NAME = "EndpointDestinationAddress";
 typedef struct tcp_conn_elt
 {
     APR_RING_ENTRY(tcp_conn_elt) link;
+    /* idle order, least recently used first */
+    APR_RING_ENTRY(tcp_conn_elt) lru;
+    /* last time the connection was used when it was queued in the idle order */
+    Jxta_time stamp;
     Jxta_transport_tcp_connection * conn;
 } Tcp_conn_elt;
 
 typedef APR_RING_HEAD(tcp_conn_list, tcp_conn_elt) Tcp_connections;
+typedef APR_RING_HEAD(tcp_conn_lru, tcp_conn_elt) Tcp_conn_lru;
 
 struct _jxta_transport_tcp {
     Extends(Jxta_transport);
@@ -130,6 +136,15 @@ struct _jxta_transport_tcp {
 
     Tcp_connections * inbounds;
     Tcp_connections * outbounds;
+    Tcp_conn_lru lru;
+    apr_uint32_t conn_cnt;
+    apr_uint32_t conn_reserved;
+    apr_uint32_t max_connections;
+    Jxta_time_diff idle_timeout;
+
+    apr_size_t recv_buffer_limit;
+    apr_size_t compress_threshold;
+    Jxta_transport_tcp_stats stats;
 
     Jxta_PG *group;
 };
@@ -160,6 +175,9 @@ static void tcp_free(Jxta_object * obj);
 
 static Jxta_status create_outbound_connection(Jxta_transport_tcp * me, Jxta_endpoint_address * dest,
                                               Jxta_transport_tcp_connection ** tc);
+static apr_uint32_t check_unused_connections(Jxta_transport_tcp * me, apr_uint32_t evict);
+static Jxta_status reserve_connection(Jxta_transport_tcp * me);
+static void unreserve_connection(Jxta_transport_tcp * me);
 
 static Tcp_conn_elt * tcp_conn_new(Jxta_transport_tcp_connection * conn)
 {
@@ -209,7 +227,10 @@ static Jxta_status tcp_connections_destroy(Tcp_connections * me)
     return JXTA_SUCCESS;
 }
 
-static Jxta_status tcp_connections_add(Tcp_connections *me, Jxta_transport_tcp_connection * conn)
+/*
+ * Keep track of a connection, must be called with the transport mutex held.
+ */
+static Jxta_status tcp_connections_add(Jxta_transport_tcp * tp, Tcp_connections *me, Jxta_transport_tcp_connection * conn)
 {
     Tcp_conn_elt *elt;
 
@@ -220,10 +241,23 @@ static Jxta_status tcp_connections_add(Tcp_connections *me, Jxta_transport_tcp_c
     }
 
     APR_RING_INSERT_TAIL(me, elt, tcp_conn_elt, link);
+    elt->stamp = get_tcp_connection_last_time_used(conn);
+    APR_RING_INSERT_TAIL(&tp->lru, elt, tcp_conn_elt, lru);
+    ++tp->conn_cnt;
 
 	return JXTA_SUCCESS;
 }
 
+/*
+ * Stop tracking a connection, must be called with the transport mutex held.
+ */
+static void tcp_connections_remove(Jxta_transport_tcp * tp, Tcp_conn_elt * elt)
+{
+    APR_RING_REMOVE(elt, link);
+    APR_RING_REMOVE(elt, lru);
+    --tp->conn_cnt;
+}
+
 static Jxta_status tcp_connections_lookup(Tcp_connections *me, Jxta_endpoint_address *ea, Jxta_transport_tcp_connection **conn)
 {
     Tcp_conn_elt *elt;
@@ -331,6 +365,9 @@ static Jxta_status init(Jxta_module * module, Jxta_PG * group, Jxta_id * assigne
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_ERROR, FILEANDLINE "Out of memory");
         return JXTA_NOMEM;
     }
+    APR_RING_INIT(&_self->lru, tcp_conn_elt, lru);
+    _self->conn_cnt = 0;
+    _self->conn_reserved = 0;
 
     jxta_PG_get_configadv(group, &conf_adv);
     if (conf_adv == NULL) {
@@ -482,6 +519,28 @@ static Jxta_status init(Jxta_module * module, Jxta_PG * group, Jxta_id * assigne
     if (!jxta_TCPTransportAdvertisement_get_ServerOff(tta)) {
         _self->be_server = JXTA_TRUE;
     }
+
+    /* Receive backlog limit per connection */
+    len = jxta_TCPTransportAdvertisement_get_RecvBufferLimit(tta);
+    _self->recv_buffer_limit = (len > 0) ? len : 0;
+
+    /* Message element compression */
+    len = jxta_TCPTransportAdvertisement_get_CompressThreshold(tta);
+    _self->compress_threshold = (len > 0) ? len : 0;
+#if !defined(GZIP_ENABLED) || !defined(GUNZIP_ENABLED)
+    if (_self->compress_threshold > 0) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Compression is not available, ignoring CompressThreshold.\n");
+        _self->compress_threshold = 0;
+    }
+#endif
+
+    /* Connection cap and idle timeout */
+    len = jxta_TCPTransportAdvertisement_get_MaxConnections(tta);
+    _self->max_connections = (len > 0) ? len : 0;
+    len = jxta_TCPTransportAdvertisement_get_IdleTimeout(tta);
+    _self->idle_timeout = (Jxta_time_diff) ((len > 0) ? len : MESSENGER_TIMEOUT) * 1000;
+    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_INFO, "TCP Transport max connections = %u, idle timeout = %"
+                    APR_INT64_T_FMT "ms\n", _self->max_connections, _self->idle_timeout);
     JXTA_OBJECT_RELEASE(tta);
 
     /* Multicast start */
@@ -539,67 +598,159 @@ static Jxta_status JXTA_STDCALL accept_cb(void *param, void *arg)
         return JXTA_FAILED;
     }
 
+    if (JXTA_SUCCESS != reserve_connection(me)) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Too many connections. Closing incoming socket.\n");
+        apr_socket_shutdown(input_socket, APR_SHUTDOWN_READWRITE);
+        apr_socket_close(input_socket);
+        return JXTA_BUSY;
+    }
+
     conn = jxta_transport_tcp_connection_new_2(me, input_socket);
     if (conn == NULL) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Failed creating connection. Closing socket.\n");
         apr_socket_shutdown(input_socket, APR_SHUTDOWN_READWRITE);
         apr_socket_close(input_socket);
+        apr_thread_mutex_lock(me->mutex);
+        unreserve_connection(me);
+        apr_thread_mutex_unlock(me->mutex);
         return JXTA_FAILED;
     }
 
-    tcp_connections_add(me->outbounds, conn);
+    apr_thread_mutex_lock(me->mutex);
+    tcp_connections_add(me, me->inbounds, conn);
+    unreserve_connection(me);
+    apr_thread_mutex_unlock(me->mutex);
     JXTA_OBJECT_RELEASE(conn);
 
     return JXTA_SUCCESS;
 }
 
-static Jxta_status check_unused_connections(Jxta_transport_tcp * me, Tcp_connections * conns)
+/*
+ * Walk the connections in idle order, least recently used first, to drop the closed connections and close the ones unused
+ * for longer than the idle timeout. Up to evict more connections unused for at least MIN_IDLE_BEFORE_EVICTION_JPR are closed
+ * to make room for new connections.
+ * Connections used since they were queued are moved back to the end of the idle order, the walk stops at the first
+ * connection which is neither closed, used nor expired. The cost is proportional to the number of connections evicted or
+ * used since the last walk rather than to the number of connections.
+ *
+ * @return the number of connections which could not be evicted.
+ */
+static apr_uint32_t check_unused_connections(Jxta_transport_tcp * me, apr_uint32_t evict)
 {
     Tcp_conn_elt * elt;
-    Tcp_conn_elt * next;
+    Tcp_conn_lru victims;
     Jxta_transport_tcp_connection * tc;
-    int i;
+    Jxta_time now;
+    Jxta_time last_used;
+    apr_uint32_t requeued;
+    int closed, expired, evicted;
 
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "Started TCP messenger removal iteration for messengers[%pp]\n", conns);
+    APR_RING_INIT(&victims, tcp_conn_elt, lru);
+    closed = expired = evicted = 0;
+    requeued = 0;
+    now = jpr_time_now();
 
     apr_thread_mutex_lock(me->mutex);
-
-    i = 0;
-    for (elt = APR_RING_FIRST(conns); elt != APR_RING_SENTINEL(conns, tcp_conn_elt, link); elt = next) {
-        if (jxta_module_state((Jxta_module *) me) != JXTA_MODULE_STARTED) {
-           break;
-        }
-
-        next = APR_RING_NEXT(elt, link);
+    while (!APR_RING_EMPTY(&me->lru, tcp_conn_elt, lru)) {
+        elt = APR_RING_FIRST(&me->lru);
         tc = elt->conn;
 
         if (CONN_DISCONNECTED == tcp_connection_state(tc)) {
-            APR_RING_REMOVE(elt, link);
+            tcp_connections_remove(me, elt);
             tcp_conn_free(elt);
-            i++;
+            closed++;
             continue;
         }
 
-        /* check that the connection belonging to the messenger has
-         * not been used for a while. By removing it from here, the connection will be once no one hold the messenger. Do we want
-         * to close connection no matter what? */
-        if ((get_tcp_connection_last_time_used(tc) + CLOSE_CONNECTION_AFTER_TIMEOUT_JPR) < jpr_time_now()) {
-#ifndef CONSERVATIVE_MESSENGER_REMOVAL
-            jxta_transport_tcp_connection_close(tc);
-#endif
-            APR_RING_REMOVE(elt, link);
-            tcp_conn_free(elt);
-            i++;
+        last_used = get_tcp_connection_last_time_used(tc);
+        if (last_used > elt->stamp && requeued < me->conn_cnt) {
+            APR_RING_REMOVE(elt, lru);
+            elt->stamp = last_used;
+            APR_RING_INSERT_TAIL(&me->lru, elt, tcp_conn_elt, lru);
+            requeued++;
             continue;
         }
+
+        if (last_used + me->idle_timeout < now) {
+            expired++;
+        } else if (evict > 0 && last_used + MIN_IDLE_BEFORE_EVICTION_JPR < now) {
+            evict--;
+            evicted++;
+        } else {
+            break;
+        }
+        tcp_connections_remove(me, elt);
+        APR_RING_INSERT_TAIL(&victims, elt, tcp_conn_elt, lru);
+    }
+    apr_atomic_add32(&me->stats.conn_expired, expired);
+    apr_atomic_add32(&me->stats.conn_evicted, evicted);
+    apr_thread_mutex_unlock(me->mutex);
+
+    /* close outside of the transport lock, closing emits event to the endpoint */
+    while (!APR_RING_EMPTY(&victims, tcp_conn_elt, lru)) {
+        elt = APR_RING_FIRST(&victims);
+        APR_RING_REMOVE(elt, lru);
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Closing unused TCP connection[%pp].\n", elt->conn);
+        jxta_transport_tcp_connection_close(elt->conn);
+        tcp_conn_free(elt);
+    }
+
+    if (closed || expired || evicted) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG,
+                        "Removed %d closed connections, closed %d expired and %d evicted connections, %u remaining.\n",
+                        closed, expired, evicted, me->conn_cnt);
+    }
+    return evict;
+}
+
+/*
+ * Make sure there is room for a new connection, evicting least recently used connections when the cap is reached.
+ * The room is checked and reserved under the transport mutex, so that concurrent accepts and connects cannot exceed the
+ * cap. A successful reservation must be released with unreserve_connection() once the connection is tracked or was not
+ * created.
+ *
+ * @return JXTA_SUCCESS if a new connection can be created, JXTA_BUSY otherwise.
+ */
+static Jxta_status reserve_connection(Jxta_transport_tcp * me)
+{
+    apr_uint32_t need;
+
+    if (0 == me->max_connections) {
+        return JXTA_SUCCESS;
     }
 
+    apr_thread_mutex_lock(me->mutex);
+    if (me->conn_cnt + me->conn_reserved >= me->max_connections) {
+        need = me->conn_cnt + me->conn_reserved - me->max_connections + 1;
+        /* evictions close connections, which cannot be done with the lock held */
+        apr_thread_mutex_unlock(me->mutex);
+        check_unused_connections(me, need);
+        apr_thread_mutex_lock(me->mutex);
+    }
+
+    if (me->conn_cnt + me->conn_reserved >= me->max_connections) {
+        apr_thread_mutex_unlock(me->mutex);
+        apr_atomic_inc32(&me->stats.conn_refused);
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Reached maximum of %u connections, no idle connection to evict.\n",
+                        me->max_connections);
+        return JXTA_BUSY;
+    }
+    ++me->conn_reserved;
     apr_thread_mutex_unlock(me->mutex);
 
-    jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "%d TCP messengers were removed from messengers[%pp]\n", i, conns);
     return JXTA_SUCCESS;
 }
 
+/*
+ * Release a room obtained from reserve_connection(), must be called with the transport mutex held.
+ */
+static void unreserve_connection(Jxta_transport_tcp * me)
+{
+    if (0 != me->max_connections && me->conn_reserved > 0) {
+        --me->conn_reserved;
+    }
+}
+
 /*
  * The entry point for the remove_unused_messengers thread, 
  * the reads watches the hashtable of messengers and removes
@@ -616,8 +767,11 @@ static void *APR_THREAD_FUNC remove_unused_connections(apr_thread_t * thread, vo
 
     assert(PTValid(arg, _jxta_transport_tcp));
 
-    check_unused_connections(me, me->inbounds);
-    check_unused_connections(me, me->outbounds);
+    if (JXTA_MODULE_STARTED != jxta_module_state((Jxta_module *) me)) {
+        return NULL;
+    }
+
+    check_unused_connections(me, 0);
 
     apr_thread_mutex_lock(me->mutex);
     if (JXTA_MODULE_STARTED == jxta_module_state((Jxta_module *) me)) {
@@ -743,7 +897,21 @@ static JxtaEndpointMessenger *messenger_get(Jxta_transport * me, Jxta_endpoint_a
         rv = tcp_connections_lookup(myself->outbounds, dest, &tc);
     }
     /* End: Drop this section to optimize */
-    if (JXTA_SUCCESS != rv) {
+    if (JXTA_SUCCESS != rv && myself->max_connections) {
+        /* reserving may evict connections, which cannot be done with the lock held */
+        apr_thread_mutex_unlock(myself->mutex);
+        rv = reserve_connection(myself);
+        apr_thread_mutex_lock(myself->mutex);
+        if (JXTA_SUCCESS != rv) {
+            apr_thread_mutex_unlock(myself->mutex);
+            return NULL;
+        }
+        rv = tcp_connections_lookup(myself->outbounds, dest, &tc);
+        if (JXTA_SUCCESS != rv) {
+            rv = create_outbound_connection(myself, dest, &tc);
+        }
+        unreserve_connection(myself);
+    } else if (JXTA_SUCCESS != rv) {
         rv = create_outbound_connection(myself, dest, &tc);
     }
     apr_thread_mutex_unlock(myself->mutex);
@@ -863,6 +1031,12 @@ static Jxta_transport_tcp *jxta_transport_tcp_construct(_jxta_transport_tcp * _s
     _self->srv_poll = NULL;
     _self->srv_socket = NULL;
 
+    _self->recv_buffer_limit = 0;
+    _self->compress_threshold = 0;
+    _self->max_connections = 0;
+    _self->idle_timeout = (Jxta_time_diff) MESSENGER_TIMEOUT * 1000;
+    memset(&_self->stats, 0, sizeof(_self->stats));
+
     _self->group = NULL;
 
     return _self;
@@ -892,6 +1066,9 @@ void jxta_transport_tcp_destruct(Jxta_transport_tcp * tp)
 
     tcp_connections_destroy(_self->inbounds);
     tcp_connections_destroy(_self->outbounds);
+    APR_RING_INIT(&_self->lru, tcp_conn_elt, lru);
+    _self->conn_cnt = 0;
+    _self->conn_reserved = 0;
 
     if (_self->public_addr != NULL) {
         JXTA_OBJECT_RELEASE(_self->public_addr);
@@ -1000,6 +1177,132 @@ Jxta_boolean jxta_transport_tcp_get_allow_multicast(Jxta_transport_tcp * me)
     return _self->allow_multicast;
 }
 
+apr_size_t jxta_transport_tcp_get_recv_buffer_limit(Jxta_transport_tcp * me)
+{
+    _jxta_transport_tcp *_self = PTValid(me, _jxta_transport_tcp);
+
+    return _self->recv_buffer_limit;
+}
+
+apr_size_t jxta_transport_tcp_get_compress_threshold(Jxta_transport_tcp * me)
+{
+    _jxta_transport_tcp *_self = PTValid(me, _jxta_transport_tcp);
+
+    return _self->compress_threshold;
+}
+
+JXTA_DECLARE(void) jxta_transport_tcp_get_stats(Jxta_transport_tcp * me, Jxta_transport_tcp_stats * stats)
+{
+    _jxta_transport_tcp *_self = PTValid(me, _jxta_transport_tcp);
+
+    stats->recv_paused = apr_atomic_read32(&_self->stats.recv_paused);
+    stats->recv_resumed = apr_atomic_read32(&_self->stats.recv_resumed);
+    stats->conn_expired = apr_atomic_read32(&_self->stats.conn_expired);
+    stats->conn_evicted = apr_atomic_read32(&_self->stats.conn_evicted);
+    stats->conn_refused = apr_atomic_read32(&_self->stats.conn_refused);
+    apr_thread_mutex_lock(_self->mutex);
+    stats->connections = _self->conn_cnt;
+    apr_thread_mutex_unlock(_self->mutex);
+}
+
+JXTA_DECLARE(Jxta_status) jxta_transport_tcp_get_conn_stats(Jxta_transport_tcp * me, Jxta_transport_tcp_conn_stats ** stats,
+                                                            apr_size_t * count)
+{
+    _jxta_transport_tcp *_self = PTValid(me, _jxta_transport_tcp);
+    Jxta_transport_tcp_connection **conns;
+    Jxta_transport_tcp_conn_stats *result;
+    Jxta_transport_tcp_conn_stats *entry;
+    Tcp_conn_elt *elt;
+    apr_pool_t *pool;
+    apr_hash_t *peers;
+    Jxta_id *peer_id;
+    JString *key;
+    apr_size_t conn_cnt;
+    apr_size_t i;
+    apr_size_t n;
+
+    *stats = NULL;
+    *count = 0;
+
+    if (APR_SUCCESS != apr_pool_create(&pool, NULL)) {
+        return JXTA_NOMEM;
+    }
+    peers = apr_hash_make(pool);
+
+    /* share the connections, the statistics are collected without holding the transport lock */
+    apr_thread_mutex_lock(_self->mutex);
+    conn_cnt = _self->conn_cnt;
+    conns = calloc(conn_cnt + 1, sizeof(*conns));
+    result = calloc(conn_cnt + 1, sizeof(*result));
+    if (NULL == conns || NULL == result) {
+        apr_thread_mutex_unlock(_self->mutex);
+        free(conns);
+        free(result);
+        apr_pool_destroy(pool);
+        return JXTA_NOMEM;
+    }
+    i = 0;
+    for (elt = APR_RING_FIRST(&_self->lru); elt != APR_RING_SENTINEL(&_self->lru, tcp_conn_elt, lru);
+         elt = APR_RING_NEXT(elt, lru)) {
+        conns[i++] = JXTA_OBJECT_SHARE(elt->conn);
+    }
+    apr_thread_mutex_unlock(_self->mutex);
+
+    n = 0;
+    for (i = 0; i < conn_cnt; i++) {
+        if (CONN_CONNECTED != tcp_connection_state(conns[i])) {
+            JXTA_OBJECT_RELEASE(conns[i]);
+            continue;
+        }
+        peer_id = jxta_transport_tcp_connection_get_destination_peerid(conns[i]);
+        if (NULL == peer_id) {
+            JXTA_OBJECT_RELEASE(conns[i]);
+            continue;
+        }
+        jxta_id_to_jstring(peer_id, &key);
+        entry = apr_hash_get(peers, jstring_get_string(key), APR_HASH_KEY_STRING);
+        if (NULL == entry) {
+            entry = &result[n++];
+            entry->peer_id = JXTA_OBJECT_SHARE(peer_id);
+            apr_hash_set(peers, apr_pstrdup(pool, jstring_get_string(key)), APR_HASH_KEY_STRING, entry);
+        }
+        if (JXTA_SUCCESS != tcp_connection_add_stats(conns[i], entry) && 0 == entry->connections) {
+            /* connection closed in between, drop the entry which was just added */
+            apr_hash_set(peers, jstring_get_string(key), APR_HASH_KEY_STRING, NULL);
+            JXTA_OBJECT_RELEASE(entry->peer_id);
+            memset(entry, 0, sizeof(*entry));
+            --n;
+        }
+        JXTA_OBJECT_RELEASE(key);
+        JXTA_OBJECT_RELEASE(peer_id);
+        JXTA_OBJECT_RELEASE(conns[i]);
+    }
+    free(conns);
+    apr_pool_destroy(pool);
+
+    *stats = result;
+    *count = n;
+    return JXTA_SUCCESS;
+}
+
+JXTA_DECLARE(void) jxta_transport_tcp_conn_stats_free(Jxta_transport_tcp_conn_stats * stats, apr_size_t count)
+{
+    apr_size_t i;
+
+    if (NULL == stats) {
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        JXTA_OBJECT_RELEASE(stats[i].peer_id);
+    }
+    free(stats);
+}
+
+void tcp_transport_recv_paused(Jxta_transport_tcp * me, Jxta_boolean paused)
+{
+    apr_atomic_inc32(paused ? &me->stats.recv_paused : &me->stats.recv_resumed);
+}
+
 static Jxta_status create_outbound_connection(Jxta_transport_tcp * me, Jxta_endpoint_address * dest, 
                                               Jxta_transport_tcp_connection ** tc)
 {
@@ -1013,7 +1316,7 @@ static Jxta_status create_outbound_connection(Jxta_transport_tcp * me, Jxta_endp
         return JXTA_FAILED;
     }
 
-    tcp_connections_add(me->outbounds, conn);
+    tcp_connections_add(me, me->outbounds, conn);
     *tc = conn;
 
     return JXTA_SUCCESS;
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2002 Sun Microsystems, Inc.  All rights
+ * reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+#ifndef __JXTA_TRANSPORT_TCP_H__
+#define __JXTA_TRANSPORT_TCP_H__
+
+#include "jxta_apr.h"
+#include "jxta_types.h"
+#include "jxta_id.h"
+#include "jxta_transport_tcp_connection.h"
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+};
+#endif
+#endif
+
+/* Statistics of the TCP transport */
+typedef struct _jxta_transport_tcp_stats {
+    /* number of times reading a connection was suspended because too much received data was pending */
+    apr_uint32_t recv_paused;
+    /* number of times reading a connection was resumed */
+    apr_uint32_t recv_resumed;
+    /* number of connections currently tracked */
+    apr_uint32_t connections;
+    /* number of connections closed after the idle timeout */
+    apr_uint32_t conn_expired;
+    /* number of idle connections closed to make room for a new one when the cap was reached */
+    apr_uint32_t conn_evicted;
+    /* number of new connections refused because the cap was reached with no idle connection to evict */
+    apr_uint32_t conn_refused;
+} Jxta_transport_tcp_stats;
+
+/* Latency histograms are decades: < 100us, < 1ms, < 10ms, < 100ms, < 1s, and 1s or more */
+#define TCP_LATENCY_BUCKETS 6
+
+/* Traffic statistics of the connections with a remote peer */
+typedef struct _jxta_transport_tcp_conn_stats {
+    Jxta_id *peer_id;
+    /* number of connections with the peer */
+    apr_uint32_t connections;
+    apr_uint64_t bytes_sent;
+    apr_uint64_t bytes_received;
+    apr_uint32_t msgs_sent;
+    apr_uint32_t msgs_received;
+    /* number of times writing had to wait for the socket to be writable */
+    apr_uint32_t flush_eagain;
+    /* longest time a message waited for the connection before being written */
+    apr_interval_time_t write_wait_max;
+    /* time messages waited for the connection before being written */
+    apr_uint32_t write_wait[TCP_LATENCY_BUCKETS];
+    /* time taken to write messages */
+    apr_uint32_t write_time[TCP_LATENCY_BUCKETS];
+    /* size of the elements considered for compression before and after compression, the ratio is encoded / raw */
+    apr_uint64_t compress_raw_bytes;
+    apr_uint64_t compress_encoded_bytes;
+} Jxta_transport_tcp_conn_stats;
+
+/**
+ * Get the counters of the TCP transport.
+ *
+ * @param me the TCP transport, as returned by jxta_endpoint_service_lookup_transport() for the "tcp" protocol
+ * @param stats receives the counters
+ */
+JXTA_DECLARE(void) jxta_transport_tcp_get_stats(Jxta_transport_tcp * me, Jxta_transport_tcp_stats * stats);
+
+/**
+ * Take a snapshot of the traffic statistics per remote peer. Connections still exchanging welcome messages are not included.
+ *
+ * @param me the TCP transport
+ * @param stats receives an array of statistics, one per remote peer, to be freed with
+ * jxta_transport_tcp_conn_stats_free
+ * @param count receives the number of entries in the array
+ * @return JXTA_SUCCESS or JXTA_NOMEM
+ */
+JXTA_DECLARE(Jxta_status) jxta_transport_tcp_get_conn_stats(Jxta_transport_tcp * me, Jxta_transport_tcp_conn_stats ** stats,
+                                                            apr_size_t * count);
+
+/**
+ * Free the statistics returned by jxta_transport_tcp_get_conn_stats.
+ *
+ * @param stats the array of statistics
+ * @param count the number of entries in the array
+ */
+JXTA_DECLARE(void) jxta_transport_tcp_conn_stats_free(Jxta_transport_tcp_conn_stats * stats, apr_size_t count);
+
+#ifdef __cplusplus
+#if 0
+{
+#endif
+}
+#endif
+
+#endif /* __JXTA_TRANSPORT_TCP_H__ */
+
+/* vi: set ts=4 sw=4 tw=130 et: */
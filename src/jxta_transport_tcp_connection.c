@@ -126,6 +126,8 @@ struct _jxta_transport_tcp_connection {
     Jxta_welcome_message *my_welcome;
     Jxta_welcome_message *its_welcome;
     int use_msg_version;
+    /* minimum size of the elements to compress, 0 unless both sides accept compressed elements */
+    apr_size_t compress_threshold;
 
     apr_bucket_alloc_t *bk_list;
     apr_bucket_brigade *brigade;
@@ -141,6 +143,23 @@ struct _jxta_transport_tcp_connection {
     apr_time_t last_time_used;
     Jxta_boolean inbound;
 
+    /* receive backpressure, protected by reading_lock */
+    apr_size_t recv_limit;
+    apr_size_t recv_pending;
+    Jxta_boolean recv_paused;
+    apr_uint32_t recv_pause_cnt;
+
+    /* traffic statistics, send side protected by mutex, receive side by reading_lock */
+    apr_uint64_t bytes_sent;
+    apr_uint64_t bytes_received;
+    apr_uint32_t msgs_sent;
+    apr_uint32_t msgs_received;
+    apr_uint32_t flush_eagain;
+    apr_interval_time_t write_wait_max;
+    apr_uint32_t write_wait[TCP_LATENCY_BUCKETS];
+    apr_uint32_t write_time[TCP_LATENCY_BUCKETS];
+    Jxta_message_compress_stats compress_stats;
+
     TcpMessenger * msgr;
 };
 
@@ -334,6 +353,22 @@ static Jxta_transport_tcp_connection *tcp_connection_new(Jxta_transport_tcp * tp
     _self->last_time_used = apr_time_now();
     _self->inbound = FALSE;
 
+    _self->recv_limit = jxta_transport_tcp_get_recv_buffer_limit(tp);
+    _self->recv_pending = 0;
+    _self->recv_paused = FALSE;
+    _self->recv_pause_cnt = 0;
+
+    _self->bytes_sent = 0;
+    _self->bytes_received = 0;
+    _self->msgs_sent = 0;
+    _self->msgs_received = 0;
+    _self->flush_eagain = 0;
+    _self->write_wait_max = 0;
+    memset(_self->write_wait, 0, sizeof(_self->write_wait));
+    memset(_self->write_time, 0, sizeof(_self->write_time));
+    _self->compress_threshold = 0;
+    memset(&_self->compress_stats, 0, sizeof(_self->compress_stats));
+
     return _self;
 }
 
@@ -535,7 +570,8 @@ static Jxta_status tcp_connection_start_socket(Jxta_transport_tcp_connection * m
     apr_socket_opt_set(me->shared_socket, APR_SO_NONBLOCK, 1);
     apr_socket_timeout_set(me->shared_socket, 0);
     
-    me->my_welcome = welcome_message_new_1(me->dest_addr, public_addr, peerid, TRUE, 1);
+    me->my_welcome = welcome_message_new_3(me->dest_addr, public_addr, peerid, TRUE, 1,
+                                           jxta_transport_tcp_get_compress_threshold(me->tp) > 0);
     JXTA_OBJECT_RELEASE(peerid);
     if (me->my_welcome == NULL) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Failed to create welcome message\n");
@@ -740,7 +776,12 @@ static int split_message(const char *data, apr_size_t *len, void *arg)
     return (0 == ctx->deficit);
 }
 
-static Jxta_status split_brigade(apr_bucket_brigade * in, apr_bucket_brigade * out, split_fn fn, void *arg)
+/*
+ * Move data from in to out until fn is satisfied.
+ *
+ * @param taken incremented by the number of bytes moved which had already been read from the socket.
+ */
+static Jxta_status split_brigade(apr_bucket_brigade * in, apr_bucket_brigade * out, split_fn fn, void *arg, apr_size_t *taken)
 {
     Jxta_status rv;
     apr_bucket *e;
@@ -748,9 +789,11 @@ static Jxta_status split_brigade(apr_bucket_brigade * in, apr_bucket_brigade * o
     apr_size_t len;
     apr_size_t used;
     int done = 0;
+    int from_socket;
 
     while (!done && !APR_BRIGADE_EMPTY(in)) {
         e = APR_BRIGADE_FIRST(in);
+        from_socket = APR_BUCKET_IS_SOCKET(e);
         rv = apr_bucket_read(e, &data, &len, APR_BLOCK_READ);
         if (APR_SUCCESS != rv) {
             return rv;
@@ -765,6 +808,9 @@ static Jxta_status split_brigade(apr_bucket_brigade * in, apr_bucket_brigade * o
         if (done && used < len) {
             apr_bucket_split(e, used);
         }
+        if (!from_socket) {
+            *taken += used;
+        }
 
         APR_BUCKET_REMOVE(e);
         APR_BRIGADE_INSERT_TAIL(out, e);
@@ -791,6 +837,24 @@ static Jxta_status handle_reading_error(Jxta_transport_tcp_connection * me, apr_
     return rv;
 }
 
+/*
+ * Account for received data handed to the parser and resume reading the socket once the backlog is half drained.
+ * Must be called with reading_lock held.
+ */
+static void recv_consumed(Jxta_transport_tcp_connection * me, apr_size_t taken)
+{
+    me->recv_pending = (taken < me->recv_pending) ? me->recv_pending - taken : 0;
+
+    if (me->recv_paused && me->recv_pending <= me->recv_limit / 2) {
+        if (JXTA_SUCCESS == jxta_endpoint_service_resume_poll(me->endpoint, me->poll)) {
+            me->recv_paused = FALSE;
+            tcp_transport_recv_paused(me->tp, FALSE);
+            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "TCP connection[%pp] resumed reading with %" APR_SIZE_T_FMT
+                            " bytes pending.\n", me, me->recv_pending);
+        }
+    }
+}
+
 static apr_status_t process_welcome(Jxta_transport_tcp_connection *me)
 {
     apr_status_t rv;
@@ -802,8 +866,11 @@ static apr_status_t process_welcome(Jxta_transport_tcp_connection *me)
     int my_msg_version;
     const char *colon;
     const char *remote_addr;
+    apr_size_t taken;
 
-    rv = split_brigade(me->brigade, me->buf, split_welcome, NULL);
+    taken = 0;
+    rv = split_brigade(me->brigade, me->buf, split_welcome, NULL, &taken);
+    recv_consumed(me, taken);
     if (APR_SUCCESS != rv) {
         return rv;
     }
@@ -831,6 +898,12 @@ static apr_status_t process_welcome(Jxta_transport_tcp_connection *me)
 
     me->use_msg_version = its_msg_version < my_msg_version ? its_msg_version : my_msg_version;
 
+    /* compressed elements require the version 2 message format */
+    if (me->use_msg_version >= 1 && welcome_message_get_deflate(me->my_welcome)
+        && welcome_message_get_deflate(me->its_welcome)) {
+        me->compress_threshold = jxta_transport_tcp_get_compress_threshold(me->tp);
+    }
+
     JXTA_OBJECT_RELEASE(me->dest_addr);
     me->dest_addr = welcome_message_get_publicaddr(me->its_welcome);
 
@@ -852,6 +925,7 @@ static void* APR_THREAD_FUNC process_data(apr_thread_t * thd, void * arg)
     Tcp_msg_ctx *ctx = &me->msg_ctx;
     Jxta_status rv = APR_EOF;
     apr_size_t sz, len;
+    apr_size_t taken;
     char *data;
 
     apr_thread_mutex_lock(me->reading_lock);
@@ -882,7 +956,9 @@ static void* APR_THREAD_FUNC process_data(apr_thread_t * thd, void * arg)
         }
 
         if (NULL == ctx->msg) {
-            rv = split_brigade(me->brigade, me->buf, split_headers, ctx);
+            taken = 0;
+            rv = split_brigade(me->brigade, me->buf, split_headers, ctx, &taken);
+            recv_consumed(me, taken);
             if (APR_SUCCESS != rv) {
                 handle_reading_error(me, rv);
                 break;
@@ -902,11 +978,14 @@ static void* APR_THREAD_FUNC process_data(apr_thread_t * thd, void * arg)
             ctx->deficit = ctx->msg_size;
         }
 
-        rv = split_brigade(me->brigade, me->buf, split_message, ctx);
+        taken = 0;
+        rv = split_brigade(me->brigade, me->buf, split_message, ctx, &taken);
+        recv_consumed(me, taken);
         if (APR_SUCCESS != rv) {
             handle_reading_error(me, rv);
             break;
         }
+        ++me->msgs_received;
 
         apr_thread_mutex_unlock(me->reading_lock);
 
@@ -939,6 +1018,8 @@ static void* APR_THREAD_FUNC process_data(apr_thread_t * thd, void * arg)
 /**
  * Drain the socket data into the brigade, then return the socket
  * for next poll.
+ * If the amount of data pending to be processed exceeds the limit, stop reading and suspend polling the socket until the
+ * backlog is processed.
  */
 static Jxta_status drain_socket(Jxta_transport_tcp_connection *me)
 {
@@ -950,6 +1031,16 @@ static Jxta_status drain_socket(Jxta_transport_tcp_connection *me)
     e = APR_BRIGADE_LAST(me->brigade);
     assert(APR_BUCKET_IS_SOCKET(e) || APR_BUCKET_IS_IMMORTAL(e));
     while (1) {
+        if (me->recv_limit && me->recv_pending > me->recv_limit) {
+            if (!me->recv_paused && JXTA_SUCCESS == jxta_endpoint_service_pause_poll(me->endpoint, me->poll)) {
+                me->recv_paused = TRUE;
+                ++me->recv_pause_cnt;
+                tcp_transport_recv_paused(me->tp, TRUE);
+                jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "TCP connection[%pp] paused reading with %" APR_SIZE_T_FMT
+                                " bytes pending.\n", me, me->recv_pending);
+            }
+            break;
+        }
         rv = apr_bucket_read(e, &ignore, &len, APR_BLOCK_READ);
         if (APR_SUCCESS != rv) {
             break;
@@ -959,6 +1050,8 @@ static Jxta_status drain_socket(Jxta_transport_tcp_connection *me)
             handle_reading_error(me, APR_EOF);
             return APR_EOF;
         }
+        me->recv_pending += len;
+        me->bytes_received += len;
         e = APR_BUCKET_NEXT(e);
     }
     return APR_SUCCESS;
@@ -1040,6 +1133,14 @@ static Jxta_status JXTA_STDCALL msg_wireformat_size(void *arg, const char *buf,
     return JXTA_SUCCESS;
 }
 
+static Jxta_status JXTA_STDCALL msg_wireformat_encode(void *arg, const char *buf, apr_size_t len)
+{
+    JString *encoded = (JString *) arg;
+
+    jstring_append_0(encoded, buf, len);
+    return JXTA_SUCCESS;
+}
+
 static Jxta_status JXTA_STDCALL write_to_tcp_connection(void *stream, const char *buf, apr_size_t size)
 {
     Jxta_transport_tcp_connection * myself = stream;
@@ -1063,12 +1164,33 @@ static Jxta_status JXTA_STDCALL write_to_tcp_connection(void *stream, const char
     return flush(myself, buf, size);
 }
 
+/*
+ * Index of the latency histogram bucket for the interval, buckets are decades starting under 100 microseconds.
+ */
+static int latency_bucket(apr_interval_time_t t)
+{
+    int i;
+    apr_interval_time_t limit = 100;
+
+    for (i = 0; i < TCP_LATENCY_BUCKETS - 1; i++) {
+        if (t < limit) {
+            break;
+        }
+        limit *= 10;
+    }
+    return i;
+}
+
 JXTA_DECLARE(Jxta_status) jxta_transport_tcp_connection_send_message(Jxta_transport_tcp_connection * me, Jxta_message * msg)
 {
     Jxta_status res;
     _jxta_transport_tcp_connection *_self = (_jxta_transport_tcp_connection *) me;
     apr_int64_t msg_size;
     Jxta_endpoint_address *addr;
+    apr_time_t queued;
+    apr_time_t begin;
+    JString *encoded = NULL;
+    Jxta_message_compress_stats compress_stats;
 
     JXTA_OBJECT_CHECK_VALID(_self);
 
@@ -1090,20 +1212,38 @@ JXTA_DECLARE(Jxta_status) jxta_transport_tcp_connection_send_message(Jxta_transp
     JXTA_OBJECT_RELEASE(addr);
 
     msg_size = 0;
-    res = jxta_message_write_1(msg, APP_MSG, _self->use_msg_version, msg_wireformat_size, &msg_size);
+    if (_self->compress_threshold > 0) {
+        /* serialize once, compressing the elements twice to compute the size would be too costly */
+        memset(&compress_stats, 0, sizeof(compress_stats));
+        encoded = jstring_new_0();
+        res = (NULL == encoded) ? JXTA_NOMEM :
+            jxta_message_write_2(msg, APP_MSG, _self->use_msg_version, _self->compress_threshold, &compress_stats,
+                                 msg_wireformat_encode, encoded);
+        msg_size = (NULL == encoded) ? 0 : jstring_length(encoded);
+    } else {
+        res = jxta_message_write_1(msg, APP_MSG, _self->use_msg_version, msg_wireformat_size, &msg_size);
+    }
     if (JXTA_SUCCESS != res) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Failed to determine message size.\n");
+        if (NULL != encoded) {
+            JXTA_OBJECT_RELEASE(encoded);
+        }
         JXTA_OBJECT_RELEASE(msg);
         return res;
     }
 
+    queued = apr_time_now();
     apr_thread_mutex_lock(_self->mutex);
+    begin = apr_time_now();
 
     /* write message packet header */
     res = message_packet_header_write(write_to_tcp_connection, (void *) _self, msg_size, FALSE, NULL);
     if (JXTA_SUCCESS != res) {
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Failed to write packet header.\n");
         apr_thread_mutex_unlock(_self->mutex);
+        if (NULL != encoded) {
+            JXTA_OBJECT_RELEASE(encoded);
+        }
         JXTA_OBJECT_RELEASE(msg);
         return res;
     }
@@ -1111,7 +1251,13 @@ JXTA_DECLARE(Jxta_status) jxta_transport_tcp_connection_send_message(Jxta_transp
     jxta_log_append(__log_cat, JXTA_LOG_LEVEL_TRACE, "send_message: msg_size=%" APR_INT64_T_FMT "\n", msg_size);
 
     /* write message body */
-    res = jxta_message_write_1(msg, APP_MSG, _self->use_msg_version, write_to_tcp_connection, _self);
+    if (NULL != encoded) {
+        res = write_to_tcp_connection(_self, jstring_get_string(encoded), jstring_length(encoded));
+        _self->compress_stats.raw_bytes += compress_stats.raw_bytes;
+        _self->compress_stats.encoded_bytes += compress_stats.encoded_bytes;
+    } else {
+        res = jxta_message_write_1(msg, APP_MSG, _self->use_msg_version, write_to_tcp_connection, _self);
+    }
     if (_self->d_out_index != 0) {
         res = tcp_connection_flush(_self);
     }
@@ -1119,11 +1265,20 @@ JXTA_DECLARE(Jxta_status) jxta_transport_tcp_connection_send_message(Jxta_transp
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Failed to send the message [%pp]\n", msg);
     } else {
         _self->last_time_used = apr_time_now();
+        ++_self->msgs_sent;
+        if (begin - queued > _self->write_wait_max) {
+            _self->write_wait_max = begin - queued;
+        }
+        ++_self->write_wait[latency_bucket(begin - queued)];
+        ++_self->write_time[latency_bucket(_self->last_time_used - begin)];
         jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Message [%pp] sent on [%pp]\n", msg, _self);
     }
 
     apr_thread_mutex_unlock(_self->mutex);
 
+    if (NULL != encoded) {
+        JXTA_OBJECT_RELEASE(encoded);
+    }
     JXTA_OBJECT_RELEASE(msg);
 
     return res;
@@ -1139,6 +1294,7 @@ static Jxta_status flush(Jxta_transport_tcp_connection * me, const char *buf, ap
     while (written > 0) {
         status = apr_socket_send(me->shared_socket, buf, &written);
         if (APR_STATUS_IS_EAGAIN(status) || APR_STATUS_IS_TIMEUP(status)) {
+            ++me->flush_eagain;
             jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, FILEANDLINE "Waiting to write to connection[%pp]\n", me);
             apr_poll(&me->pollfd, 1, &nsds, -1);
             jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, FILEANDLINE "Continue to write to connection[%pp]\n", me);
@@ -1149,6 +1305,7 @@ static Jxta_status flush(Jxta_transport_tcp_connection * me, const char *buf, ap
             return JXTA_FAILED;
         }
         total_written += written;
+        me->bytes_sent += written;
         buf += written;
         written = size - total_written;
     }
@@ -1165,6 +1322,40 @@ static Jxta_status tcp_connection_flush(Jxta_transport_tcp_connection * _self)
     return status;
 }
 
+Jxta_status tcp_connection_add_stats(Jxta_transport_tcp_connection * me, Jxta_transport_tcp_conn_stats * stats)
+{
+    int i;
+
+    JXTA_OBJECT_CHECK_VALID(me);
+
+    apr_thread_mutex_lock(me->reading_lock);
+    if (NULL == me->its_welcome) {
+        apr_thread_mutex_unlock(me->reading_lock);
+        return JXTA_ITEM_NOTFOUND;
+    }
+    stats->bytes_received += me->bytes_received;
+    stats->msgs_received += me->msgs_received;
+    apr_thread_mutex_unlock(me->reading_lock);
+
+    apr_thread_mutex_lock(me->mutex);
+    stats->bytes_sent += me->bytes_sent;
+    stats->msgs_sent += me->msgs_sent;
+    stats->flush_eagain += me->flush_eagain;
+    stats->compress_raw_bytes += me->compress_stats.raw_bytes;
+    stats->compress_encoded_bytes += me->compress_stats.encoded_bytes;
+    if (me->write_wait_max > stats->write_wait_max) {
+        stats->write_wait_max = me->write_wait_max;
+    }
+    for (i = 0; i < TCP_LATENCY_BUCKETS; i++) {
+        stats->write_wait[i] += me->write_wait[i];
+        stats->write_time[i] += me->write_time[i];
+    }
+    apr_thread_mutex_unlock(me->mutex);
+
+    stats->connections++;
+    return JXTA_SUCCESS;
+}
+
 Jxta_time get_tcp_connection_last_time_used(Jxta_transport_tcp_connection * tcp_connection)
 {
     assert(tcp_connection);
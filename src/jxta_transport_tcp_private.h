@@ -63,6 +63,7 @@
 #include "jxta_endpoint_service.h"
 #include "jxta_endpoint_service.h"
 #include "jxta_transport_tcp_connection.h"
+#include "jxta_transport_tcp.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -85,7 +86,6 @@ typedef enum e_tcp_connection_state {
     CONN_DISCONNECTED,
 } Tcp_connection_state;
 
-
 Jxta_transport_tcp *jxta_transport_tcp_new_instance(void);
 
 Jxta_endpoint_service *jxta_transport_tcp_get_endpoint_service(Jxta_transport_tcp * me);
@@ -102,11 +102,21 @@ Jxta_endpoint_address *jxta_transport_tcp_get_public_addr(Jxta_transport_tcp * m
 
 Jxta_boolean jxta_transport_tcp_get_allow_multicast(Jxta_transport_tcp * me);
 
+apr_size_t jxta_transport_tcp_get_recv_buffer_limit(Jxta_transport_tcp * me);
+
+/**
+ * Minimum size of the message elements to compress, 0 if compression is disabled.
+ */
+apr_size_t jxta_transport_tcp_get_compress_threshold(Jxta_transport_tcp * me);
+
+void tcp_transport_recv_paused(Jxta_transport_tcp * me, Jxta_boolean paused);
+
 void tcp_got_inbound_connection(Jxta_transport_tcp * me, Jxta_transport_tcp_connection * conn);
 
 Jxta_time get_tcp_connection_last_time_used(Jxta_transport_tcp_connection * tcp_connection);
 
 Tcp_connection_state tcp_connection_state(Jxta_transport_tcp_connection *me);
+Jxta_status tcp_connection_add_stats(Jxta_transport_tcp_connection * me, Jxta_transport_tcp_conn_stats * stats);
 Jxta_status tcp_connection_get_messenger(Jxta_transport_tcp_connection *me, apr_interval_time_t timeout, TcpMessenger **msgr);
 
 #ifdef __cplusplus
@@ -67,6 +67,7 @@ static const char* GREETING = "JXTAHELLO";
 static const char* SPACE = " ";
 static const char* CURRENTVERSION = "3.0";
 static const char* CRLF = "\r\n";
+static const char* DEFLATE_CAPABILITY = "deflate";
 static const Jxta_welcome_message_version CURRENT_VERSION = JXTA_WELCOME_MESSAGE_VERSION_3_0;
 
 struct _welcome_message {
@@ -77,6 +78,7 @@ struct _welcome_message {
     JString *peer_id;
     Jxta_boolean noprop;
     int use_message_version;   
+    Jxta_boolean deflate;
     
     Jxta_welcome_message_version version;
     
@@ -104,6 +106,13 @@ static _welcome_message_mutable * welcome_message_new(void)
 
 JXTA_DECLARE(Jxta_welcome_message *) welcome_message_new_1(Jxta_endpoint_address * dest_addr, Jxta_endpoint_address * public_addr,
                                              JString *peerid, Jxta_boolean noprop, int message_version )
+{
+    return welcome_message_new_3(dest_addr, public_addr, peerid, noprop, message_version, FALSE);
+}
+
+JXTA_DECLARE(Jxta_welcome_message *) welcome_message_new_3(Jxta_endpoint_address * dest_addr, Jxta_endpoint_address * public_addr,
+                                             JString *peerid, Jxta_boolean noprop, int message_version,
+                                             Jxta_boolean deflate )
 {
     _welcome_message_mutable *myself = welcome_message_new();
     
@@ -125,6 +134,7 @@ JXTA_DECLARE(Jxta_welcome_message *) welcome_message_new_1(Jxta_endpoint_address
         myself->peer_id = JXTA_OBJECT_SHARE(peerid);
         myself->noprop = noprop;
         myself->use_message_version = message_version;
+        myself->deflate = deflate;
         myself->version = JXTA_WELCOME_MESSAGE_VERSION_3_0;
 
         myself->welcome_str = jstring_new_0();
@@ -153,6 +163,11 @@ JXTA_DECLARE(Jxta_welcome_message *) welcome_message_new_1(Jxta_endpoint_address
             jstring_append_2(myself->welcome_str, SPACE);
             sprintf( version, "%d", myself->use_message_version );
             jstring_append_2(myself->welcome_str, version );
+            /* Optional capabilities, only sent when enabled to keep the plain 3.0 form for everybody else */
+            if( myself->deflate ) {
+                jstring_append_2(myself->welcome_str, SPACE);
+                jstring_append_2(myself->welcome_str, DEFLATE_CAPABILITY);
+            }
         }
         jstring_append_2(myself->welcome_str, SPACE);
         jstring_append_2(myself->welcome_str, CURRENTVERSION);
@@ -307,9 +322,20 @@ JXTA_DECLARE( Jxta_welcome_message *) welcome_message_new_2(JString * welcome_st
         }
         current = next + 1;
 
-        if( current != last ) {
-            jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Extra tokens in 3.0 welcome message : %s\n", line );
-            goto Common_Exit;            
+        /* [<CAPABILITY>...] */
+        while( current != last ) {
+            next = strchr( current, ' ' );
+            if( (NULL == next) || (0 == (next - current)) ) {
+                jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, "Extra tokens in 3.0 welcome message : %s\n", line );
+                goto Common_Exit;            
+            }
+            if( (strlen(DEFLATE_CAPABILITY) == (size_t) (next - current)) && 
+                (0 == strncmp(DEFLATE_CAPABILITY, current, (next - current))) ) {
+                myself->deflate = TRUE;
+            } else {
+                jxta_log_append(__log_cat, JXTA_LOG_LEVEL_DEBUG, "Ignoring unknown capability in welcome message : %s\n", line );
+            }
+            current = next + 1;
         }
     
         myself->version = JXTA_WELCOME_MESSAGE_VERSION_3_0;
@@ -407,6 +433,15 @@ JXTA_DECLARE(int) welcome_message_get_message_version(Jxta_welcome_message * me)
     return myself->use_message_version;
 }
 
+JXTA_DECLARE(Jxta_boolean) welcome_message_get_deflate(Jxta_welcome_message * me)
+{
+    _welcome_message_mutable * myself = (_welcome_message_mutable *) me;
+
+    JXTA_OBJECT_CHECK_VALID(myself);
+    
+    return myself->deflate;
+}
+
 JXTA_DECLARE(JString *) welcome_message_get_welcome(Jxta_welcome_message * me)
 {
     _welcome_message_mutable * myself = (_welcome_message_mutable *) me;
@@ -83,6 +83,15 @@ JXTA_DECLARE(Jxta_welcome_message *) welcome_message_new_1(Jxta_endpoint_address
                                              JString *peerid, Jxta_boolean noprop, int message_version );
 JXTA_DECLARE( Jxta_welcome_message *) welcome_message_new_2(JString * welcome_str);
 
+/**
+ * Create a welcome message advertising the optional capabilities of the local peer.
+ *
+ * @param deflate TRUE if message elements compressed with the "deflate" encoding are accepted.
+ **/
+JXTA_DECLARE(Jxta_welcome_message *) welcome_message_new_3(Jxta_endpoint_address * dest_addr, Jxta_endpoint_address * public_addr,
+                                             JString *peerid, Jxta_boolean noprop, int message_version,
+                                             Jxta_boolean deflate );
+
 JXTA_DECLARE(Jxta_endpoint_address *) welcome_message_get_publicaddr(Jxta_welcome_message * me);
 
 JXTA_DECLARE(Jxta_endpoint_address *) welcome_message_get_destaddr(Jxta_welcome_message * me);
@@ -91,6 +100,8 @@ JXTA_DECLARE(JString *) welcome_message_get_peerid(Jxta_welcome_message * me);
 
 JXTA_DECLARE(int) welcome_message_get_message_version(Jxta_welcome_message * me);
 
+JXTA_DECLARE(Jxta_boolean) welcome_message_get_deflate(Jxta_welcome_message * me);
+
 JXTA_DECLARE(JString *) welcome_message_get_welcome(Jxta_welcome_message * me);
 
 #ifdef __cplusplus
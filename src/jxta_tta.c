@@ -82,9 +82,23 @@ enum tokentype {
     InterfaceAddress_,
     ConfigMode_,
     ServerOff_,
-    ClientOff_
+    ClientOff_,
+    RecvBufferLimit_,
+    MaxConnections_,
+    IdleTimeout_,
+    CompressThreshold_
 };
 
+/* bytes of received but not yet processed data allowed per connection */
+#define DEFAULT_RECV_BUFFER_LIMIT (256 * 1024)
+
+/* no limit on the number of connections, close connections unused for 5 minutes */
+#define DEFAULT_MAX_CONNECTIONS 0
+#define DEFAULT_IDLE_TIMEOUT (5 * 60)
+
+/* message element compression disabled */
+#define DEFAULT_COMPRESS_THRESHOLD 0
+
 #ifndef INET_ADDRSTRLEN
 #define INET_ADDRSTRLEN 16
 #endif
@@ -109,6 +123,10 @@ struct _jxta_TCPTransportAdvertisement {
     Jxta_boolean ServerOff;
     Jxta_boolean ClientOff;
     Jxta_boolean PublicAddressOnly; /* not implemented yet.. */
+    int RecvBufferLimit;
+    int MaxConnections;
+    int IdleTimeout;
+    int CompressThreshold;
 };
 
     /* Forw decl. of un-exported function */
@@ -258,6 +276,46 @@ static void handleClientOff(void *userdata, const XML_Char * cd, int len)
     ad->ClientOff = TRUE;
 }
 
+static void handleRecvBufferLimit(void *userdata, const XML_Char * cd, int len)
+{
+    Jxta_TCPTransportAdvertisement *ad = (Jxta_TCPTransportAdvertisement *) userdata;
+
+    if (len == 0)
+        return;
+
+    ad->RecvBufferLimit = atoi(cd);
+}
+
+static void handleMaxConnections(void *userdata, const XML_Char * cd, int len)
+{
+    Jxta_TCPTransportAdvertisement *ad = (Jxta_TCPTransportAdvertisement *) userdata;
+
+    if (len == 0)
+        return;
+
+    ad->MaxConnections = atoi(cd);
+}
+
+static void handleIdleTimeout(void *userdata, const XML_Char * cd, int len)
+{
+    Jxta_TCPTransportAdvertisement *ad = (Jxta_TCPTransportAdvertisement *) userdata;
+
+    if (len == 0)
+        return;
+
+    ad->IdleTimeout = atoi(cd);
+}
+
+static void handleCompressThreshold(void *userdata, const XML_Char * cd, int len)
+{
+    Jxta_TCPTransportAdvertisement *ad = (Jxta_TCPTransportAdvertisement *) userdata;
+
+    if (len == 0)
+        return;
+
+    ad->CompressThreshold = atoi(cd);
+}
+
 JXTA_DECLARE(JString *)
     jxta_TCPTransportAdvertisement_get_Protocol(Jxta_TCPTransportAdvertisement * ad)
 {
@@ -441,6 +499,50 @@ JXTA_DECLARE(void)
     ad->ClientOff = isOff;
 }
 
+JXTA_DECLARE(int) jxta_TCPTransportAdvertisement_get_RecvBufferLimit(Jxta_TCPTransportAdvertisement * ad)
+{
+    return ad->RecvBufferLimit;
+}
+
+JXTA_DECLARE(void)
+    jxta_TCPTransportAdvertisement_set_RecvBufferLimit(Jxta_TCPTransportAdvertisement * ad, int limit)
+{
+    ad->RecvBufferLimit = limit;
+}
+
+JXTA_DECLARE(int) jxta_TCPTransportAdvertisement_get_MaxConnections(Jxta_TCPTransportAdvertisement * ad)
+{
+    return ad->MaxConnections;
+}
+
+JXTA_DECLARE(void)
+    jxta_TCPTransportAdvertisement_set_MaxConnections(Jxta_TCPTransportAdvertisement * ad, int max)
+{
+    ad->MaxConnections = max;
+}
+
+JXTA_DECLARE(int) jxta_TCPTransportAdvertisement_get_IdleTimeout(Jxta_TCPTransportAdvertisement * ad)
+{
+    return ad->IdleTimeout;
+}
+
+JXTA_DECLARE(void)
+    jxta_TCPTransportAdvertisement_set_IdleTimeout(Jxta_TCPTransportAdvertisement * ad, int timeout)
+{
+    ad->IdleTimeout = timeout;
+}
+
+JXTA_DECLARE(int) jxta_TCPTransportAdvertisement_get_CompressThreshold(Jxta_TCPTransportAdvertisement * ad)
+{
+    return ad->CompressThreshold;
+}
+
+JXTA_DECLARE(void)
+    jxta_TCPTransportAdvertisement_set_CompressThreshold(Jxta_TCPTransportAdvertisement * ad, int threshold)
+{
+    ad->CompressThreshold = threshold;
+}
+
 /** Now, build an array of the keyword structs.  Since 
  * a top-level, or null state may be of interest, 
  * let that lead off.  Then, walk through the enums,
@@ -462,6 +564,10 @@ static const Kwdtab Jxta_TCPTransportAdvertisement_tags[] = {
     {"ConfigMode", ConfigMode_, *handleConfigMode, NULL, NULL},
     {"ClientOff", ClientOff_, *handleClientOff, NULL, NULL},
     {"ServerOff", ServerOff_, *handleServerOff, NULL, NULL},
+    {"RecvBufferLimit", RecvBufferLimit_, *handleRecvBufferLimit, NULL, NULL},
+    {"MaxConnections", MaxConnections_, *handleMaxConnections, NULL, NULL},
+    {"IdleTimeout", IdleTimeout_, *handleIdleTimeout, NULL, NULL},
+    {"CompressThreshold", CompressThreshold_, *handleCompressThreshold, NULL, NULL},
     {NULL, 0, 0, NULL, NULL}
 };
 
@@ -532,6 +638,34 @@ JXTA_DECLARE(Jxta_status)
         jstring_append_2(string, "<ClientOff/>\n");
     }
 
+    if (DEFAULT_RECV_BUFFER_LIMIT != ad->RecvBufferLimit) {
+        jstring_append_2(string, "<RecvBufferLimit>");
+        apr_snprintf(port, sizeof(port), "%d", ad->RecvBufferLimit);
+        jstring_append_2(string, port);
+        jstring_append_2(string, "</RecvBufferLimit>\n");
+    }
+
+    if (DEFAULT_MAX_CONNECTIONS != ad->MaxConnections) {
+        jstring_append_2(string, "<MaxConnections>");
+        apr_snprintf(port, sizeof(port), "%d", ad->MaxConnections);
+        jstring_append_2(string, port);
+        jstring_append_2(string, "</MaxConnections>\n");
+    }
+
+    if (DEFAULT_IDLE_TIMEOUT != ad->IdleTimeout) {
+        jstring_append_2(string, "<IdleTimeout>");
+        apr_snprintf(port, sizeof(port), "%d", ad->IdleTimeout);
+        jstring_append_2(string, port);
+        jstring_append_2(string, "</IdleTimeout>\n");
+    }
+
+    if (DEFAULT_COMPRESS_THRESHOLD != ad->CompressThreshold) {
+        jstring_append_2(string, "<CompressThreshold>");
+        apr_snprintf(port, sizeof(port), "%d", ad->CompressThreshold);
+        jstring_append_2(string, port);
+        jstring_append_2(string, "</CompressThreshold>\n");
+    }
+
     jstring_append_2(string, "</jxta:TransportAdvertisement>\n");
 
     *result = string;
@@ -558,6 +692,10 @@ static Jxta_TCPTransportAdvertisement *jxta_TCPTransportAdvertisement_construct(
         self->ServerOff = FALSE;
         self->PublicAddressOnly = FALSE;
         self->InterfaceAddress = NULL;
+        self->RecvBufferLimit = DEFAULT_RECV_BUFFER_LIMIT;
+        self->MaxConnections = DEFAULT_MAX_CONNECTIONS;
+        self->IdleTimeout = DEFAULT_IDLE_TIMEOUT;
+        self->CompressThreshold = DEFAULT_COMPRESS_THRESHOLD;
     }
 
     return self;
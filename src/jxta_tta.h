@@ -112,6 +112,33 @@ JXTA_DECLARE(void) jxta_TCPTransportAdvertisement_set_ServerOff(Jxta_TCPTranspor
 JXTA_DECLARE(Jxta_boolean) jxta_TCPTransportAdvertisement_get_ClientOff(Jxta_TCPTransportAdvertisement *);
 JXTA_DECLARE(void) jxta_TCPTransportAdvertisement_set_ClientOff(Jxta_TCPTransportAdvertisement *, Jxta_boolean);
 
+/**
+ * Maximum number of bytes received on a connection and not yet processed. Reading from the connection is suspended until
+ * the backlog is processed once the limit is exceeded. 0 means no limit.
+ */
+JXTA_DECLARE(int) jxta_TCPTransportAdvertisement_get_RecvBufferLimit(Jxta_TCPTransportAdvertisement *);
+JXTA_DECLARE(void) jxta_TCPTransportAdvertisement_set_RecvBufferLimit(Jxta_TCPTransportAdvertisement *, int);
+
+/**
+ * Maximum number of concurrent connections. When the limit is reached, the least recently used idle connections are closed
+ * to make room for new ones. 0 means no limit.
+ */
+JXTA_DECLARE(int) jxta_TCPTransportAdvertisement_get_MaxConnections(Jxta_TCPTransportAdvertisement *);
+JXTA_DECLARE(void) jxta_TCPTransportAdvertisement_set_MaxConnections(Jxta_TCPTransportAdvertisement *, int);
+
+/**
+ * Number of seconds a connection can stay unused before being closed.
+ */
+JXTA_DECLARE(int) jxta_TCPTransportAdvertisement_get_IdleTimeout(Jxta_TCPTransportAdvertisement *);
+JXTA_DECLARE(void) jxta_TCPTransportAdvertisement_set_IdleTimeout(Jxta_TCPTransportAdvertisement *, int);
+
+/**
+ * Minimum size in bytes of the message elements compressed when sent to peers accepting compressed elements. 0 disables
+ * compression.
+ */
+JXTA_DECLARE(int) jxta_TCPTransportAdvertisement_get_CompressThreshold(Jxta_TCPTransportAdvertisement *);
+JXTA_DECLARE(void) jxta_TCPTransportAdvertisement_set_CompressThreshold(Jxta_TCPTransportAdvertisement *, int);
+
 JXTA_DECLARE(Jxta_vector *) jxta_TCPTransportAdvertisement_get_indexes(Jxta_advertisement *);
 
 #ifdef __cplusplus
@@ -98,6 +98,14 @@ struct _LimitedRangeRdvMessage {
 
 static void LimitedRangeRdvMessage_delete(LimitedRangeRdvMessage * ad);
 
+/* offsets in the binary form of the header */
+#define LRW_MAGIC_0 'L'
+#define LRW_MAGIC_1 'W'
+#define LRW_VERSION 1
+#define LRW_OFFSET_DIR 3
+#define LRW_OFFSET_TTL 4
+#define LRW_FIXED_SIZE 8
+
 /** Handler functions.  Each of these is responsible for
 * dealing with all of the character data associated with the 
 * tag name.
@@ -376,4 +384,149 @@ JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_parse_file(LimitedRangeRdvMessa
     return jxta_advertisement_parse_file((Jxta_advertisement *) ad, stream);
 }
 
+static Jxta_status lrw_add_string(Jxta_bytevector * bytes, JString * string)
+{
+    size_t len = (NULL == string) ? 0 : jstring_length(string);
+    unsigned char prefix[2];
+    Jxta_status res;
+
+    if (len > 0xFFFF) {
+        return JXTA_INVALID_ARGUMENT;
+    }
+    prefix[0] = (unsigned char) (len >> 8);
+    prefix[1] = (unsigned char) len;
+    res = jxta_bytevector_add_bytes_at(bytes, prefix, jxta_bytevector_size(bytes), sizeof(prefix));
+    if (JXTA_SUCCESS == res && len > 0) {
+        res = jxta_bytevector_add_bytes_at(bytes, (unsigned char const *) jstring_get_string(string), jxta_bytevector_size(bytes),
+                                           len);
+    }
+    return res;
+}
+
+static Jxta_status lrw_get_string(const unsigned char *buf, size_t len, size_t * offset, JString ** string)
+{
+    size_t slen;
+
+    if (*offset + 2 > len) {
+        return JXTA_INVALID_ARGUMENT;
+    }
+    slen = ((size_t) buf[*offset] << 8) | buf[*offset + 1];
+    *offset += 2;
+    if (*offset + slen > len) {
+        return JXTA_INVALID_ARGUMENT;
+    }
+
+    if (NULL != *string) {
+        JXTA_OBJECT_RELEASE(*string);
+        *string = NULL;
+    }
+    if (slen > 0) {
+        *string = jstring_new_1(slen);
+        if (NULL == *string) {
+            return JXTA_NOMEM;
+        }
+        jstring_append_0(*string, (const char *) buf + *offset, slen);
+    }
+    *offset += slen;
+    return JXTA_SUCCESS;
+}
+
+JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_get_binary(LimitedRangeRdvMessage * ad, Jxta_bytevector ** bytes)
+{
+    unsigned char fixed[LRW_FIXED_SIZE];
+    Jxta_bytevector *result;
+    Jxta_status res;
+
+    if (bytes == NULL) {
+        return JXTA_INVALID_ARGUMENT;
+    }
+
+    result = jxta_bytevector_new_1(LRW_FIXED_SIZE + 128);
+    if (NULL == result) {
+        return JXTA_NOMEM;
+    }
+
+    fixed[0] = LRW_MAGIC_0;
+    fixed[1] = LRW_MAGIC_1;
+    fixed[2] = LRW_VERSION;
+    res = jxta_bytevector_add_bytes_at(result, fixed, 0, sizeof(fixed));
+    if (JXTA_SUCCESS == res) {
+        res = lrw_add_string(result, ad->src_peer_id);
+    }
+    if (JXTA_SUCCESS == res) {
+        res = lrw_add_string(result, ad->svc_name);
+    }
+    if (JXTA_SUCCESS == res) {
+        res = lrw_add_string(result, ad->svc_params);
+    }
+    if (JXTA_SUCCESS == res) {
+        res = LimitedRangeRdvMessage_binary_set_TTL_direction((char *) jxta_bytevector_content_ptr(result),
+                                                              jxta_bytevector_size(result), ad->ttl, ad->dir);
+    }
+
+    if (JXTA_SUCCESS != res) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Failed to encode binary walk header %d\n", res);
+        JXTA_OBJECT_RELEASE(result);
+        return res;
+    }
+
+    *bytes = result;
+    return JXTA_SUCCESS;
+}
+
+JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_parse_binary(LimitedRangeRdvMessage * ad, const char *buf, size_t len)
+{
+    Jxta_status res;
+    size_t offset = LRW_FIXED_SIZE;
+
+    res = LimitedRangeRdvMessage_binary_get_TTL_direction(buf, len, &ad->ttl, &ad->dir);
+    if (JXTA_SUCCESS == res) {
+        res = lrw_get_string((const unsigned char *) buf, len, &offset, &ad->src_peer_id);
+    }
+    if (JXTA_SUCCESS == res) {
+        res = lrw_get_string((const unsigned char *) buf, len, &offset, &ad->svc_name);
+    }
+    if (JXTA_SUCCESS == res) {
+        res = lrw_get_string((const unsigned char *) buf, len, &offset, &ad->svc_params);
+    }
+
+    if (JXTA_SUCCESS != res) {
+        jxta_log_append(__log_cat, JXTA_LOG_LEVEL_WARNING, FILEANDLINE "Invalid binary walk header of %u bytes\n",
+                        (unsigned int) len);
+    }
+    return res;
+}
+
+JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_binary_get_TTL_direction(const char *buf, size_t len, int *ttl,
+                                                                          Walk_direction * dir)
+{
+    const unsigned char *p = (const unsigned char *) buf;
+
+    if (NULL == buf || len < LRW_FIXED_SIZE || LRW_MAGIC_0 != p[0] || LRW_MAGIC_1 != p[1] || LRW_VERSION != p[2]) {
+        return JXTA_INVALID_ARGUMENT;
+    }
+
+    *dir = (Walk_direction) p[LRW_OFFSET_DIR];
+    *ttl = (int) (((apr_uint32_t) p[LRW_OFFSET_TTL] << 24) | ((apr_uint32_t) p[LRW_OFFSET_TTL + 1] << 16) |
+                  ((apr_uint32_t) p[LRW_OFFSET_TTL + 2] << 8) | (apr_uint32_t) p[LRW_OFFSET_TTL + 3]);
+    return JXTA_SUCCESS;
+}
+
+JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_binary_set_TTL_direction(char *buf, size_t len, int ttl, Walk_direction dir)
+{
+    unsigned char *p = (unsigned char *) buf;
+    apr_uint32_t value = (apr_uint32_t) ttl;
+
+    if (NULL == buf || len < LRW_FIXED_SIZE || LRW_MAGIC_0 != p[0] || LRW_MAGIC_1 != p[1] || LRW_VERSION != p[2]) {
+        return JXTA_INVALID_ARGUMENT;
+    }
+
+    p[LRW_OFFSET_DIR] = (unsigned char) dir;
+    p[LRW_OFFSET_TTL] = (unsigned char) (value >> 24);
+    p[LRW_OFFSET_TTL + 1] = (unsigned char) (value >> 16);
+    p[LRW_OFFSET_TTL + 2] = (unsigned char) (value >> 8);
+    p[LRW_OFFSET_TTL + 3] = (unsigned char) value;
+    return JXTA_SUCCESS;
+}
+
 /* vim: set ts=4 sw=4 et tw=130: */
@@ -60,6 +60,7 @@
 #include "jxta_advertisement.h"
 #include "jstring.h"
 #include "jxta_vector.h"
+#include "jxta_bytevector.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -78,12 +79,52 @@ typedef enum Walk_directions Walk_direction;
 
 typedef struct _LimitedRangeRdvMessage LimitedRangeRdvMessage;
 
+/**
+ * Mime type of the message element carrying the compact binary form of the walk header. The binary form is only sent to
+ * the peers which announced they understand it, the XML form is used with everybody else.
+ *
+ * Layout, integers in network byte order:
+ *     'L' 'W' <version:1> <dir:1> <TTL:4> then <length:2> <bytes> for SrcPeerID, SrcSvcName and SrcSvcParams.
+ **/
+#define LIMITEDRANGERDVMESSAGE_BINARY_MIME "application/x-jxta-lrw"
+
 JXTA_DECLARE(LimitedRangeRdvMessage *) LimitedRangeRdvMessage_new(void);
 JXTA_DECLARE(void) LimitedRangeRdvMessage_set_handlers(LimitedRangeRdvMessage *, XML_Parser, void *);
 JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_get_xml(LimitedRangeRdvMessage *, JString ** xml);
 JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_parse_charbuffer(LimitedRangeRdvMessage *, const char *, int len);
 JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_parse_file(LimitedRangeRdvMessage *, FILE * stream);
 
+/**
+ * Encode the walk header in its binary form.
+ *
+ * @param ad The walk header.
+ * @param bytes Receives a new bytevector with the encoded header.
+ * @return JXTA_SUCCESS or JXTA_NOMEM.
+ **/
+JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_get_binary(LimitedRangeRdvMessage * ad, Jxta_bytevector ** bytes);
+
+/**
+ * Decode a walk header from its binary form.
+ *
+ * @return JXTA_SUCCESS or JXTA_INVALID_ARGUMENT if the buffer is not a valid binary walk header.
+ **/
+JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_parse_binary(LimitedRangeRdvMessage * ad, const char *buf, size_t len);
+
+/**
+ * Read the TTL and the direction of a binary walk header without decoding the rest of it.
+ *
+ * @return JXTA_SUCCESS or JXTA_INVALID_ARGUMENT if the buffer is not a valid binary walk header.
+ **/
+JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_binary_get_TTL_direction(const char *buf, size_t len, int *ttl,
+                                                                          Walk_direction * dir);
+
+/**
+ * Update the TTL and the direction of a binary walk header in place.
+ *
+ * @return JXTA_SUCCESS or JXTA_INVALID_ARGUMENT if the buffer is not a valid binary walk header.
+ **/
+JXTA_DECLARE(Jxta_status) LimitedRangeRdvMessage_binary_set_TTL_direction(char *buf, size_t len, int ttl, Walk_direction dir);
+
 JXTA_DECLARE(int) LimitedRangeRdvMessage_get_TTL(LimitedRangeRdvMessage * ad);
 JXTA_DECLARE(void) LimitedRangeRdvMessage_set_TTL(LimitedRangeRdvMessage * ad, int ttl);
 
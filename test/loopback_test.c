@@ -0,0 +1,418 @@
+/* 
+ * Copyright (c) 2001 Sun Microsystems, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+/*
+ * Two peers run in this process, each with its own net peer group started from its own directory so they get distinct
+ * peer and group ids, and a loopback transport. Messages are sent from the first peer to the second one, directly and
+ * propagated.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <apr_file_io.h>
+
+#include "jxta.h"
+#include "jxta_peergroup.h"
+#include "jxta_platformconfig.h"
+#include "jxta_tta.h"
+#include "jxta_transport_loopback.h"
+
+#include "../src/jxta_private.h"
+#include "../src/jxta_endpoint_service_priv.h"
+
+#include "unittest_jxta_func.h"
+
+#define LOOPBACK_TEST_SERVICE_NAME "jxta:LoopbackTest"
+#define LOOPBACK_TEST_SERVICE_PARAMS "LoopbackTestParams"
+#define LOOPBACK_TEST_NS "jxta"
+#define LOOPBACK_TEST_ELEMENT "LoopbackTest"
+
+/* how long to wait for the deliveries, in microseconds */
+#define LOOPBACK_TEST_WAIT (10 * APR_USEC_PER_SEC)
+
+typedef struct {
+    const char *home;
+    Jxta_PG *pg;
+    Jxta_endpoint_service *endpoint;
+    Jxta_transport_loopback *tp;
+    void *cookie;
+    volatile apr_uint32_t received;
+} Loopback_peer;
+
+static apr_pool_t *pool = NULL;
+static Loopback_peer peers[2] = { {"loopback_peer1"}, {"loopback_peer2"} };
+
+static Jxta_status JXTA_STDCALL loopback_test_cb(Jxta_object * obj, void *arg)
+{
+    Loopback_peer *peer = arg;
+    Jxta_message_element *el = NULL;
+
+    if (JXTA_SUCCESS == jxta_message_get_element_2((Jxta_message *) obj, LOOPBACK_TEST_NS, LOOPBACK_TEST_ELEMENT, &el)) {
+        apr_atomic_inc32(&peer->received);
+        JXTA_OBJECT_RELEASE(el);
+    }
+    return JXTA_SUCCESS;
+}
+
+/*
+ * The net peer group reads its PlatformConfig from the current directory. Give each peer its own, with a new peer id in a
+ * new group id so both net peer groups can be registered in the process, and no TCP server competing for the same port.
+ */
+static Jxta_status loopback_peer_config(void)
+{
+    Jxta_PA *config;
+    Jxta_svc *svc = NULL;
+    Jxta_TCPTransportAdvertisement *tta;
+    Jxta_id *gid = NULL;
+    Jxta_id *pid = NULL;
+    Jxta_status rv;
+
+    config = jxta_PlatformConfig_read("PlatformConfig");
+    if (NULL != config) {
+        JXTA_OBJECT_RELEASE(config);
+        return JXTA_SUCCESS;
+    }
+
+    config = jxta_PlatformConfig_create_default();
+    if (NULL == config) {
+        return JXTA_NOMEM;
+    }
+
+    jxta_id_peergroupid_new_1(&gid);
+    jxta_id_peerid_new_1(&pid, gid);
+    jxta_PA_set_GID(config, gid);
+    jxta_PA_set_PID(config, pid);
+    JXTA_OBJECT_RELEASE(pid);
+    JXTA_OBJECT_RELEASE(gid);
+
+    jxta_PA_get_Svc_with_id(config, jxta_tcpproto_classid_get(), &svc);
+    if (NULL != svc) {
+        tta = jxta_svc_get_TCPTransportAdvertisement(svc);
+        if (NULL != tta) {
+            jxta_TCPTransportAdvertisement_set_ServerOff(tta, TRUE);
+            jxta_TCPTransportAdvertisement_set_MulticastOff(tta, TRUE);
+            JXTA_OBJECT_RELEASE(tta);
+        }
+        JXTA_OBJECT_RELEASE(svc);
+    }
+
+    rv = jxta_PlatformConfig_write(config, "PlatformConfig");
+    JXTA_OBJECT_RELEASE(config);
+    return rv;
+}
+
+static const char *loopback_peer_start(Loopback_peer * peer, const char *cwd)
+{
+    const char *noargs[] = { NULL };
+    apr_status_t status;
+    Jxta_status rv;
+
+    status = apr_dir_make(peer->home, APR_OS_DEFAULT, pool);
+    if (APR_SUCCESS != status && !APR_STATUS_IS_EEXIST(status)) {
+        return FILEANDLINE;
+    }
+    if (APR_SUCCESS != apr_filepath_set(peer->home, pool)) {
+        return FILEANDLINE;
+    }
+
+    rv = loopback_peer_config();
+    if (JXTA_SUCCESS == rv) {
+        rv = jxta_PG_new_netpg(&peer->pg);
+    }
+    apr_filepath_set(cwd, pool);
+    if (JXTA_SUCCESS != rv) {
+        return FILEANDLINE;
+    }
+
+    jxta_PG_get_endpoint_service(peer->pg, &peer->endpoint);
+
+    peer->tp = jxta_transport_loopback_new_instance();
+    if (NULL == peer->tp) {
+        return FILEANDLINE;
+    }
+    if (JXTA_SUCCESS != jxta_module_init((Jxta_module *) peer->tp, peer->pg, NULL, NULL)) {
+        return FILEANDLINE;
+    }
+    if (JXTA_SUCCESS != jxta_module_start((Jxta_module *) peer->tp, noargs)) {
+        return FILEANDLINE;
+    }
+
+    rv = endpoint_service_add_recipient(peer->endpoint, &peer->cookie, LOOPBACK_TEST_SERVICE_NAME,
+                                        LOOPBACK_TEST_SERVICE_PARAMS, loopback_test_cb, peer);
+    if (JXTA_SUCCESS != rv) {
+        return FILEANDLINE;
+    }
+
+    return NULL;
+}
+
+static void loopback_peer_stop(Loopback_peer * peer)
+{
+    if (NULL != peer->cookie) {
+        endpoint_service_remove_recipient(peer->endpoint, peer->cookie);
+        peer->cookie = NULL;
+    }
+    if (NULL != peer->tp) {
+        jxta_module_stop((Jxta_module *) peer->tp);
+        JXTA_OBJECT_RELEASE(peer->tp);
+        peer->tp = NULL;
+    }
+    if (NULL != peer->endpoint) {
+        JXTA_OBJECT_RELEASE(peer->endpoint);
+        peer->endpoint = NULL;
+    }
+    if (NULL != peer->pg) {
+        jxta_module_stop((Jxta_module *) peer->pg);
+        JXTA_OBJECT_RELEASE(peer->pg);
+        peer->pg = NULL;
+    }
+}
+
+static Jxta_message *loopback_test_msg(void)
+{
+    Jxta_message *msg;
+    Jxta_message_element *el;
+
+    msg = jxta_message_new();
+    el = jxta_message_element_new_2(LOOPBACK_TEST_NS, LOOPBACK_TEST_ELEMENT, "text/plain", "hello", 5, NULL);
+    jxta_message_add_element(msg, el);
+    JXTA_OBJECT_RELEASE(el);
+    return msg;
+}
+
+/* wait until the peer received the expected number of messages, TRUE if it did */
+static Jxta_boolean loopback_wait(Loopback_peer * peer, apr_uint32_t expected)
+{
+    apr_time_t until = apr_time_now() + LOOPBACK_TEST_WAIT;
+
+    while (apr_atomic_read32(&peer->received) < expected && apr_time_now() < until) {
+        apr_sleep(10 * 1000);
+    }
+    return apr_atomic_read32(&peer->received) == expected;
+}
+
+const char *test_loopback_start(void)
+{
+    char *cwd = NULL;
+    const char *result;
+    int i;
+
+    if (APR_SUCCESS != apr_pool_create(&pool, NULL)) {
+        return FILEANDLINE;
+    }
+    if (APR_SUCCESS != apr_filepath_get(&cwd, APR_FILEPATH_NATIVE, pool)) {
+        return FILEANDLINE;
+    }
+
+    for (i = 0; i < 2; i++) {
+        result = loopback_peer_start(&peers[i], cwd);
+        if (NULL != result) {
+            return result;
+        }
+    }
+
+    return NULL;
+}
+
+const char *test_loopback_unicast(void)
+{
+    Jxta_message *msg;
+    Jxta_endpoint_address *public_addr;
+    Jxta_endpoint_address *dest;
+    Jxta_transport_loopback_stats stats;
+    Jxta_status rv;
+    int i;
+
+    public_addr = jxta_transport_publicaddr_get((Jxta_transport *) peers[1].tp);
+    dest = jxta_endpoint_address_new_2(jxta_endpoint_address_get_protocol_name(public_addr),
+                                       jxta_endpoint_address_get_protocol_address(public_addr), LOOPBACK_TEST_SERVICE_NAME,
+                                       LOOPBACK_TEST_SERVICE_PARAMS);
+    JXTA_OBJECT_RELEASE(public_addr);
+
+    apr_atomic_set32(&peers[0].received, 0);
+    apr_atomic_set32(&peers[1].received, 0);
+    for (i = 0; i < 10; i++) {
+        msg = loopback_test_msg();
+        rv = jxta_endpoint_service_send_ex(peers[0].endpoint, msg, dest, TRUE);
+        JXTA_OBJECT_RELEASE(msg);
+        if (JXTA_SUCCESS != rv) {
+            JXTA_OBJECT_RELEASE(dest);
+            return FILEANDLINE;
+        }
+    }
+    JXTA_OBJECT_RELEASE(dest);
+
+    if (!loopback_wait(&peers[1], 10)) {
+        return FILEANDLINE;
+    }
+
+    /* only the destination gets the messages */
+    if (0 != apr_atomic_read32(&peers[0].received)) {
+        return FILEANDLINE;
+    }
+
+    jxta_transport_loopback_get_stats(peers[0].tp, &stats);
+    if (stats.msgs_sent < 10 || 0 != stats.msgs_lost || 0 != stats.msgs_unreachable) {
+        return FILEANDLINE;
+    }
+    jxta_transport_loopback_get_stats(peers[1].tp, &stats);
+    if (stats.msgs_received < 10) {
+        return FILEANDLINE;
+    }
+
+    return NULL;
+}
+
+const char *test_loopback_propagate(void)
+{
+    Jxta_message *msg;
+    int i;
+
+    apr_atomic_set32(&peers[0].received, 0);
+    apr_atomic_set32(&peers[1].received, 0);
+    for (i = 0; i < 10; i++) {
+        msg = loopback_test_msg();
+        jxta_transport_propagate((Jxta_transport *) peers[0].tp, msg, LOOPBACK_TEST_SERVICE_NAME, LOOPBACK_TEST_SERVICE_PARAMS);
+        JXTA_OBJECT_RELEASE(msg);
+    }
+
+    if (!loopback_wait(&peers[1], 10)) {
+        return FILEANDLINE;
+    }
+
+    /* a propagated message is not looped back to its sender */
+    if (0 != apr_atomic_read32(&peers[0].received)) {
+        return FILEANDLINE;
+    }
+
+    return NULL;
+}
+
+const char *test_loopback_loss(void)
+{
+    Jxta_message *msg;
+    Jxta_transport_loopback_stats before;
+    Jxta_transport_loopback_stats after;
+    int i;
+
+    /* every message is lost */
+    if (JXTA_SUCCESS != jxta_transport_loopback_set_link(peers[0].tp, 0, 0, 1000000)) {
+        return FILEANDLINE;
+    }
+
+    jxta_transport_loopback_get_stats(peers[0].tp, &before);
+    apr_atomic_set32(&peers[1].received, 0);
+    for (i = 0; i < 10; i++) {
+        msg = loopback_test_msg();
+        jxta_transport_propagate((Jxta_transport *) peers[0].tp, msg, LOOPBACK_TEST_SERVICE_NAME, LOOPBACK_TEST_SERVICE_PARAMS);
+        JXTA_OBJECT_RELEASE(msg);
+    }
+    apr_sleep(APR_USEC_PER_SEC);
+    jxta_transport_loopback_get_stats(peers[0].tp, &after);
+    jxta_transport_loopback_set_link(peers[0].tp, 0, 0, 0);
+
+    if (0 != apr_atomic_read32(&peers[1].received)) {
+        return FILEANDLINE;
+    }
+    if (after.msgs_lost - before.msgs_lost < 10) {
+        return FILEANDLINE;
+    }
+
+    return NULL;
+}
+
+const char *test_loopback_stop(void)
+{
+    loopback_peer_stop(&peers[1]);
+    loopback_peer_stop(&peers[0]);
+
+    if (NULL != pool) {
+        apr_pool_destroy(pool);
+        pool = NULL;
+    }
+    return NULL;
+}
+
+static struct _funcs loopback_test_funcs[] = {
+    {*test_loopback_start, "start two peers with a loopback transport"},
+    {*test_loopback_unicast, "unicast delivery over the loopback transport"},
+    {*test_loopback_propagate, "propagate delivery over the loopback transport"},
+    {*test_loopback_loss, "simulated loss of the loopback link"},
+    {*test_loopback_stop, "stop the peers"},
+
+    {NULL, "null"}
+};
+
+/**
+* Run the unit tests for the loopback transport
+*
+* @param tests_run the variable in which to accumulate the number of tests run
+* @param tests_passed the variable in which to accumulate the number of tests passed
+* @param tests_failed the variable in which to accumulate the number of tests failed
+*
+* @return TRUE if all tests were run successfully, FALSE otherwise
+*/
+Jxta_boolean run_loopback_tests(int *tests_run, int *tests_passed, int *tests_failed)
+{
+    return run_testfunctions(loopback_test_funcs, tests_run, tests_passed, tests_failed);
+}
+
+#ifdef STANDALONE
+int main(int argc, char **argv)
+{
+    return main_test_function(loopback_test_funcs, argc, argv);
+}
+#endif
@@ -56,6 +56,12 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef WIN32
+#include <winsock2.h>
+#else
+#include <netinet/in.h>
+#endif
+
 #include <jxta.h>
 #include <jxta_errno.h>
 
@@ -1246,6 +1252,175 @@ FINAL_EXIT:
     return result;
 }
 
+/**
+* Test that elements above the threshold are compressed on the wire and read back unchanged.
+* 
+* @return NULL for success otherwise a message indicating failure.
+*/
+static char const * test_msg_compressed_read_write(void)
+{
+    char const * result = NULL;
+    Jxta_message *write_message = NULL;
+    Jxta_message *read_message = NULL;
+    Jxta_message_element *el = NULL;
+    Jxta_bytevector *value = NULL;
+    Jxta_message_compress_stats stats;
+    read_write_test_buffer stream_struct;
+    apr_uint64_t msg_size;
+    apr_uint64_t plain_size;
+    char *content = NULL;
+    char *stream = NULL;
+    size_t content_len = 16 * 1024;
+    size_t i;
+
+    content = malloc(content_len);
+    for (i = 0; i < content_len; i++) {
+        content[i] = "<jxta:RA>route</jxta:RA>"[i % 24];
+    }
+
+    write_message = jxta_message_new();
+    read_message = jxta_message_new();
+    el = jxta_message_element_new_2("jxta", "Large", "text/xml", content, content_len, NULL);
+    jxta_message_add_element(write_message, el);
+    JXTA_OBJECT_RELEASE(el);
+    el = NULL;
+
+    plain_size = APR_INT64_C(0);
+    jxta_message_write_1(write_message, NULL, 1, msg_wireformat_size, &plain_size);
+
+    memset(&stats, 0, sizeof(stats));
+    msg_size = APR_INT64_C(0);
+    if (JXTA_SUCCESS != jxta_message_write_2(write_message, NULL, 1, 1024, &stats, msg_wireformat_size, &msg_size)) {
+        result = FILEANDLINE;
+        goto FINAL_EXIT;
+    }
+
+#if defined(GZIP_ENABLED) && defined(GUNZIP_ENABLED)
+    if (msg_size >= plain_size || stats.raw_bytes != content_len || stats.encoded_bytes >= stats.raw_bytes) {
+        result = FILEANDLINE ": element was not compressed\n";
+        goto FINAL_EXIT;
+    }
+#endif
+
+    stream = calloc(msg_size, sizeof(char));
+    stream_struct.buffer = stream;
+    stream_struct.position = 0;
+    if (JXTA_SUCCESS != jxta_message_write_2(write_message, NULL, 1, 1024, NULL, writeFunction, &stream_struct)) {
+        result = FILEANDLINE;
+        goto FINAL_EXIT;
+    }
+
+    stream_struct.position = 0;
+    if (JXTA_SUCCESS != jxta_message_read(read_message, NULL, readFromStreamFunction, &stream_struct)) {
+        result = FILEANDLINE;
+        goto FINAL_EXIT;
+    }
+
+    if (JXTA_SUCCESS != jxta_message_get_element_2(read_message, "jxta", "Large", &el)) {
+        result = FILEANDLINE;
+        goto FINAL_EXIT;
+    }
+
+    value = jxta_message_element_get_value(el);
+    if (jxta_bytevector_size(value) != content_len) {
+        result = FILEANDLINE ": wrong element length\n";
+        goto FINAL_EXIT;
+    }
+    for (i = 0; i < content_len; i++) {
+        unsigned char byte;
+
+        jxta_bytevector_get_byte_at(value, &byte, i);
+        if (byte != (unsigned char) content[i]) {
+            result = FILEANDLINE ": wrong element content\n";
+            goto FINAL_EXIT;
+        }
+    }
+
+FINAL_EXIT:
+    if (value != NULL)
+        JXTA_OBJECT_RELEASE(value);
+    if (el != NULL)
+        JXTA_OBJECT_RELEASE(el);
+    if (write_message != NULL)
+        JXTA_OBJECT_RELEASE(write_message);
+    if (read_message != NULL)
+        JXTA_OBJECT_RELEASE(read_message);
+    free(stream);
+    free(content);
+    return result;
+}
+
+#if defined(GZIP_ENABLED) && defined(GUNZIP_ENABLED)
+/**
+* Test that a deflated element announcing a value larger than JXTA_MESSAGE_INFLATE_MAX is rejected.
+* 
+* @return NULL for success otherwise a message indicating failure.
+*/
+static char const * test_msg_compressed_too_large(void)
+{
+    char const * result = NULL;
+    Jxta_message *write_message = NULL;
+    Jxta_message *read_message = NULL;
+    Jxta_message_element *el = NULL;
+    read_write_test_buffer stream_struct;
+    apr_uint64_t msg_size;
+    apr_uint32_t raw_len;
+    apr_uint32_t too_large;
+    char *content = NULL;
+    char *stream = NULL;
+    size_t content_len = 16 * 1024;
+    size_t i;
+
+    content = malloc(content_len);
+    memset(content, 'x', content_len);
+
+    write_message = jxta_message_new();
+    read_message = jxta_message_new();
+    el = jxta_message_element_new_2("jxta", "Large", "text/plain", content, content_len, NULL);
+    jxta_message_add_element(write_message, el);
+    JXTA_OBJECT_RELEASE(el);
+
+    msg_size = APR_INT64_C(0);
+    jxta_message_write_2(write_message, NULL, 1, 1024, NULL, msg_wireformat_size, &msg_size);
+    stream = calloc(msg_size, sizeof(char));
+    stream_struct.buffer = stream;
+    stream_struct.position = 0;
+    if (JXTA_SUCCESS != jxta_message_write_2(write_message, NULL, 1, 1024, NULL, writeFunction, &stream_struct)) {
+        result = FILEANDLINE;
+        goto FINAL_EXIT;
+    }
+
+    /* the deflated body starts with the length of the value, followed by the zlib stream */
+    raw_len = htonl((apr_uint32_t) content_len);
+    for (i = 0; i + sizeof(raw_len) < msg_size; i++) {
+        if (0 == memcmp(stream + i, &raw_len, sizeof(raw_len)) && 0x78 == (unsigned char) stream[i + sizeof(raw_len)]) {
+            break;
+        }
+    }
+    if (i + sizeof(raw_len) >= msg_size) {
+        result = FILEANDLINE ": deflated body not found\n";
+        goto FINAL_EXIT;
+    }
+    too_large = htonl((apr_uint32_t) JXTA_MESSAGE_INFLATE_MAX + 1);
+    memcpy(stream + i, &too_large, sizeof(too_large));
+
+    stream_struct.position = 0;
+    if (JXTA_SUCCESS == jxta_message_read(read_message, NULL, readFromStreamFunction, &stream_struct)) {
+        result = FILEANDLINE ": oversized element was accepted\n";
+        goto FINAL_EXIT;
+    }
+
+FINAL_EXIT:
+    if (write_message != NULL)
+        JXTA_OBJECT_RELEASE(write_message);
+    if (read_message != NULL)
+        JXTA_OBJECT_RELEASE(read_message);
+    free(stream);
+    free(content);
+    return result;
+}
+#endif
+
 static struct _funcs msg_test_funcs[] = {
     /* First run JXTA MESSAGE ELEMENT tests */
     {*test_jxta_message_element_new_1, "construction/retrieval for jxta_message_element_new_1"},
@@ -1264,6 +1439,10 @@ static struct _funcs msg_test_funcs[] = {
     {*test_msg_create, "jxta_message_create"},
     {*test_msg_with_qos, "read/write test with qos"},
     {*test_msg_qos_clone, "jxta_message_clone with qos"},
+    {*test_msg_compressed_read_write, "read/write test with compressed elements"},
+#if defined(GZIP_ENABLED) && defined(GUNZIP_ENABLED)
+    {*test_msg_compressed_too_large, "read test with an oversized compressed element"},
+#endif
 
     {NULL, "null"}
 };
@@ -0,0 +1,236 @@
+/* 
+ * Copyright (c) 2001 Sun Microsystems, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+/*
+ * Duplicate suppression of propagated messages: message ids are remembered per flag for a window and up to a set size, on
+ * a rendezvous provider which is not initialized.
+ */
+
+#include <stdio.h>
+
+#include <apr_strings.h>
+
+#include "jxta.h"
+
+#include "../src/jxta_rdv_service_provider_private.h"
+
+#include "unittest_jxta_func.h"
+
+/* an arbitrary start, the seen set only compares times */
+#define SEEN_TEST_T0 ((Jxta_time) 1000000)
+
+static Jxta_rdv_service_provider *provider = NULL;
+
+static const char *rdv_seen_setup(void)
+{
+    provider = jxta_rdv_service_client_new();
+    if (NULL == provider) {
+        return FILEANDLINE;
+    }
+    return NULL;
+}
+
+static void rdv_seen_teardown(void)
+{
+    if (NULL != provider) {
+        JXTA_OBJECT_RELEASE(provider);
+        provider = NULL;
+    }
+}
+
+static Jxta_boolean seen(const char *msgid, int flag, Jxta_time now)
+{
+    return jxta_rdv_service_provider_seen_check_and_set_priv(provider, msgid, flag, now);
+}
+
+/**
+ * A message id is reported once per flag, received copies count as duplicates and second propagations as repropagations.
+ */
+const char *test_rdv_seen_dedup(void)
+{
+    const char *failed;
+    Jxta_rdv_propagate_stats stats;
+
+    if (NULL != (failed = rdv_seen_setup())) {
+        rdv_seen_teardown();
+        return failed;
+    }
+
+    if (seen("msg-1", RDV_SEEN_DELIVERED, SEEN_TEST_T0) || !seen("msg-1", RDV_SEEN_DELIVERED, SEEN_TEST_T0)) {
+        failed = FILEANDLINE;
+    } else if (seen("msg-1", RDV_SEEN_PROPAGATED, SEEN_TEST_T0) || !seen("msg-1", RDV_SEEN_PROPAGATED, SEEN_TEST_T0)) {
+        failed = FILEANDLINE;
+    } else if (seen("msg-2", RDV_SEEN_PROPAGATED, SEEN_TEST_T0) || seen("msg-2", RDV_SEEN_DELIVERED, SEEN_TEST_T0)) {
+        failed = FILEANDLINE;
+    }
+
+    if (NULL == failed) {
+        jxta_rdv_service_provider_get_propagate_stats(provider, &stats);
+        if (2 != stats.tracked || 3 != stats.received || 1 != stats.duplicates || 1 != stats.repropagations
+            || 0 != stats.evicted) {
+            failed = FILEANDLINE;
+        }
+    }
+
+    rdv_seen_teardown();
+    return failed;
+}
+
+/**
+ * A message id is remembered until the end of the window and forgotten from then on.
+ */
+const char *test_rdv_seen_window(void)
+{
+    const char *failed;
+    Jxta_rdv_propagate_stats stats;
+
+    if (NULL != (failed = rdv_seen_setup())) {
+        rdv_seen_teardown();
+        return failed;
+    }
+
+    seen("msg-early", RDV_SEEN_DELIVERED, SEEN_TEST_T0);
+    seen("msg-late", RDV_SEEN_DELIVERED, SEEN_TEST_T0 + RDV_SEEN_WINDOW / 2);
+
+    if (!seen("msg-early", RDV_SEEN_DELIVERED, SEEN_TEST_T0 + RDV_SEEN_WINDOW - 1)) {
+        failed = FILEANDLINE;
+    } else if (seen("msg-early", RDV_SEEN_DELIVERED, SEEN_TEST_T0 + RDV_SEEN_WINDOW)) {
+        failed = FILEANDLINE;
+    } else if (!seen("msg-late", RDV_SEEN_DELIVERED, SEEN_TEST_T0 + RDV_SEEN_WINDOW)) {
+        failed = FILEANDLINE;
+    }
+
+    if (NULL == failed) {
+        jxta_rdv_service_provider_get_propagate_stats(provider, &stats);
+        /* expired ids are not evictions */
+        if (2 != stats.tracked || 0 != stats.evicted) {
+            failed = FILEANDLINE;
+        }
+    }
+
+    rdv_seen_teardown();
+    return failed;
+}
+
+/**
+ * The set holds at most RDV_SEEN_MAX message ids, the oldest are evicted before the end of their window.
+ */
+const char *test_rdv_seen_eviction(void)
+{
+    const char *failed;
+    Jxta_rdv_propagate_stats stats;
+    char msgid[32];
+    int i;
+
+    if (NULL != (failed = rdv_seen_setup())) {
+        rdv_seen_teardown();
+        return failed;
+    }
+
+    for (i = 0; i <= RDV_SEEN_MAX && NULL == failed; i++) {
+        apr_snprintf(msgid, sizeof(msgid), "msg-%d", i);
+        if (seen(msgid, RDV_SEEN_PROPAGATED, SEEN_TEST_T0 + i)) {
+            failed = FILEANDLINE;
+        }
+    }
+
+    if (NULL == failed) {
+        jxta_rdv_service_provider_get_propagate_stats(provider, &stats);
+        if (RDV_SEEN_MAX != stats.tracked || 1 != stats.evicted) {
+            failed = FILEANDLINE;
+        }
+    }
+
+    /* the newest id is still known, the oldest one was evicted */
+    apr_snprintf(msgid, sizeof(msgid), "msg-%d", RDV_SEEN_MAX);
+    if (NULL == failed && !seen(msgid, RDV_SEEN_PROPAGATED, SEEN_TEST_T0 + RDV_SEEN_MAX)) {
+        failed = FILEANDLINE;
+    }
+    if (NULL == failed && seen("msg-0", RDV_SEEN_PROPAGATED, SEEN_TEST_T0 + RDV_SEEN_MAX)) {
+        failed = FILEANDLINE;
+    }
+
+    rdv_seen_teardown();
+    return failed;
+}
+
+static struct _funcs rdv_seen_test_funcs[] = {
+    {*test_rdv_seen_dedup, "suppress duplicate propagated messages"},
+    {*test_rdv_seen_window, "forget propagated messages after the seen window"},
+    {*test_rdv_seen_eviction, "evict the oldest propagated messages over the seen set size"},
+
+    {NULL, "null"}
+};
+
+/**
+* Run the unit tests for the duplicate suppression of propagated messages
+*
+* @param tests_run the variable in which to accumulate the number of tests run
+* @param tests_passed the variable in which to accumulate the number of tests passed
+* @param tests_failed the variable in which to accumulate the number of tests failed
+*
+* @return TRUE if all tests were run successfully, FALSE otherwise
+*/
+Jxta_boolean run_rdv_seen_tests(int *tests_run, int *tests_passed, int *tests_failed)
+{
+    return run_testfunctions(rdv_seen_test_funcs, tests_run, tests_passed, tests_failed);
+}
+
+#ifdef STANDALONE
+int main(int argc, char **argv)
+{
+    return main_test_function(rdv_seen_test_funcs, argc, argv);
+}
+#endif
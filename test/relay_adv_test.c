@@ -54,6 +54,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "jxta.h"
 
@@ -82,6 +83,7 @@ const char *test_jxta_relaya_serialization(void) {
     FILE *testfile;
     JString *dump1;
     JString *dump2;
+    JString *spill_dir;
 
     ad = jxta_RelayAdvertisement_new();
     
@@ -106,6 +108,12 @@ const char *test_jxta_relaya_serialization(void) {
         return FILEANDLINE;
     }
 
+    spill_dir = jxta_RelayAdvertisement_get_SpillDirectory(ad);
+    if( 0 != strcmp(jstring_get_string(spill_dir), "/var/spool/jxta/relay") ) {
+        return FILEANDLINE;
+    }
+    JXTA_OBJECT_RELEASE(spill_dir);
+
     result = jxta_advertisement_get_xml(ad, &dump1);
     if( JXTA_SUCCESS != result ) {
         return FILEANDLINE;
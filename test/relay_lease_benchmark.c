@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2002 Sun Microsystems, Inc.  All rights
+ * reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+/**
+ * Relay lease benchmark: times the lease table of a relay server granting leases, finding the lease of a client, as it
+ * does for each message relayed, renewing leases and removing the expired ones, as its timer does.
+ *
+ * usage: relay_lease_benchmark [leases [lookups]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_time.h>
+
+#include "jxta.h"
+#include "jxta_id.h"
+#include "jxta_relay.h"
+#include "jxta_builtinmodules_private.h"
+#include "jxta_relay_private.h"
+
+#define DEFAULT_LEASES 10000
+#define DEFAULT_LOOKUPS 100000
+
+/* milliseconds, the first half of the leases expire during the benchmark */
+#define SHORT_LEASE 2000
+#define LONG_LEASE (60 * 60 * 1000)
+
+/* spreads the lookups over the leases rather than walking them in insertion order */
+#define LOOKUP_STRIDE 7919
+
+static void report(const char *name, unsigned int count, unsigned int found, apr_time_t elapsed)
+{
+    printf("%-8s %u ops, %u found, %" APR_TIME_T_FMT " us, %.3f us/op\n", name, count, found, elapsed,
+           (double) elapsed / count);
+}
+
+static char *pid_new(void)
+{
+    Jxta_id *id;
+    JString *str;
+    char *pid;
+
+    jxta_id_peerid_new_1(&id, jxta_id_defaultNetPeerGroupID);
+    jxta_id_to_jstring(id, &str);
+    pid = strdup(jstring_get_string(str));
+    JXTA_OBJECT_RELEASE(str);
+    JXTA_OBJECT_RELEASE(id);
+    return pid;
+}
+
+int main(int argc, char *argv[])
+{
+    Jxta_transport_relay_public *relay;
+    char **pids;
+    char **unknown;
+    apr_time_t begin;
+    apr_time_t granted;
+    unsigned int nleases = DEFAULT_LEASES;
+    unsigned int lookups = DEFAULT_LOOKUPS;
+    unsigned int found;
+    unsigned int left;
+    unsigned int i;
+
+    if (argc > 1) {
+        nleases = (unsigned int) strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        lookups = (unsigned int) strtoul(argv[2], NULL, 10);
+    }
+    if (nleases < 2 || lookups == 0) {
+        fprintf(stderr, "usage: %s [leases [lookups]]\n", argv[0]);
+        return -1;
+    }
+
+    jxta_initialize();
+
+    relay = (Jxta_transport_relay_public *) jxta_transport_relay_new_instance();
+    pids = calloc(nleases, sizeof(*pids));
+    unknown = calloc(nleases, sizeof(*unknown));
+    if (NULL == relay || NULL == pids || NULL == unknown || JXTA_SUCCESS != relay_leases_setup(relay, nleases)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    for (i = 0; i < nleases; i++) {
+        pids[i] = pid_new();
+        unknown[i] = pid_new();
+    }
+    printf("%u leases\n", nleases);
+
+    found = 0;
+    granted = begin = apr_time_now();
+    for (i = 0; i < nleases; i++) {
+        found += JXTA_SUCCESS == relay_lease_grant(relay, pids[i], i < nleases / 2 ? SHORT_LEASE : LONG_LEASE) ? 1 : 0;
+    }
+    report("grant", nleases, found, apr_time_now() - begin);
+
+    found = 0;
+    begin = apr_time_now();
+    for (i = 0; i < lookups; i++) {
+        found += relay_lease_exists(relay, pids[((apr_uint64_t) i * LOOKUP_STRIDE) % nleases]) ? 1 : 0;
+    }
+    report("hit", lookups, found, apr_time_now() - begin);
+
+    found = 0;
+    begin = apr_time_now();
+    for (i = 0; i < lookups; i++) {
+        found += relay_lease_exists(relay, unknown[((apr_uint64_t) i * LOOKUP_STRIDE) % nleases]) ? 1 : 0;
+    }
+    report("miss", lookups, found, apr_time_now() - begin);
+
+    /* renewing moves a lease to the end of the expiry order */
+    found = 0;
+    begin = apr_time_now();
+    for (i = nleases / 2; i < nleases; i++) {
+        found += JXTA_SUCCESS == relay_lease_grant(relay, pids[i], LONG_LEASE) ? 1 : 0;
+    }
+    report("renew", nleases - nleases / 2, found, apr_time_now() - begin);
+
+    /* the timer finds the first lease still valid */
+    begin = apr_time_now();
+    left = (unsigned int) relay_leases_expire(relay);
+    report("sweep", 1, left, apr_time_now() - begin);
+
+    begin = granted + (apr_time_t) SHORT_LEASE * 1000 + 100000;
+    if (apr_time_now() < begin) {
+        apr_sleep(begin - apr_time_now());
+    }
+    begin = apr_time_now();
+    left = (unsigned int) relay_leases_expire(relay);
+    report("expire", nleases - left, left, apr_time_now() - begin);
+
+    for (i = 0; i < nleases; i++) {
+        free(pids[i]);
+        free(unknown[i]);
+    }
+    free(pids);
+    free(unknown);
+    JXTA_OBJECT_RELEASE(relay);
+
+    jxta_terminate();
+    return 0;
+}
+
+/* vim: set ts=4 sw=4 tw=130 et: */
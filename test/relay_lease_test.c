@@ -0,0 +1,397 @@
+/* 
+ * Copyright (c) 2001 Sun Microsystems, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+/*
+ * Lease management of a relay server: leases are granted, renewed and removed once expired through the code the relay
+ * uses for lease requests, and messages are stored, spilled and replayed for a client, on a relay instance which is not
+ * started.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_time.h>
+#include <apr_strings.h>
+#include <apr_file_io.h>
+
+#include "jxta.h"
+#include "jxta_relay.h"
+
+#include "../src/jxta_builtinmodules_private.h"
+#include "../src/jxta_relay_private.h"
+
+#include "unittest_jxta_func.h"
+
+#define RELAY_LEASE_TEST_MAX 3
+
+/* milliseconds, the checks allow half a short lease of scheduling delay */
+#define SHORT_LEASE 1000
+#define LONG_LEASE (60 * 60 * 1000)
+
+static Jxta_transport_relay_public *relay = NULL;
+
+static const char *relay_lease_setup(void)
+{
+    relay = (Jxta_transport_relay_public *) jxta_transport_relay_new_instance();
+    if (NULL == relay) {
+        return FILEANDLINE;
+    }
+    if (JXTA_SUCCESS != relay_leases_setup(relay, RELAY_LEASE_TEST_MAX)) {
+        return FILEANDLINE;
+    }
+    return NULL;
+}
+
+static void relay_lease_teardown(void)
+{
+    if (NULL != relay) {
+        JXTA_OBJECT_RELEASE(relay);
+        relay = NULL;
+    }
+}
+
+static void sleep_ms(int ms)
+{
+    apr_sleep((apr_interval_time_t) ms * 1000);
+}
+
+#define SPILL_TEST_DIR "relay_lease_test.spill"
+#define SPILL_TEST_PAYLOAD 1000
+
+/* messages of the same size, numbered by their seq element */
+static Jxta_message *spill_msg_new(int seq)
+{
+    Jxta_message *msg;
+    Jxta_message_element *el;
+    char payload[SPILL_TEST_PAYLOAD];
+    char seq_str[16];
+
+    msg = jxta_message_new();
+    apr_snprintf(seq_str, sizeof(seq_str), "%04d", seq);
+    el = jxta_message_element_new_2("test", "seq", "text/plain", seq_str, strlen(seq_str), NULL);
+    jxta_message_add_element(msg, el);
+    JXTA_OBJECT_RELEASE(el);
+    memset(payload, 'x', sizeof(payload));
+    el = jxta_message_element_new_2("test", "payload", "application/octet-stream", payload, sizeof(payload), NULL);
+    jxta_message_add_element(msg, el);
+    JXTA_OBJECT_RELEASE(el);
+
+    return msg;
+}
+
+static int spill_msg_seq(Jxta_message * msg)
+{
+    Jxta_message_element *el = NULL;
+    Jxta_bytevector *value;
+    char seq_str[16];
+    unsigned int len;
+
+    if (JXTA_SUCCESS != jxta_message_get_element_2(msg, "test", "seq", &el) || NULL == el) {
+        return -1;
+    }
+    value = jxta_message_element_get_value(el);
+    len = jxta_bytevector_size(value);
+    if (len >= sizeof(seq_str)) {
+        len = sizeof(seq_str) - 1;
+    }
+    jxta_bytevector_get_bytes_at(value, (unsigned char *) seq_str, 0, len);
+    seq_str[len] = 0;
+    JXTA_OBJECT_RELEASE(value);
+    JXTA_OBJECT_RELEASE(el);
+
+    return atoi(seq_str);
+}
+
+static Jxta_status spill_put(int seq)
+{
+    Jxta_message *msg = spill_msg_new(seq);
+    Jxta_status status;
+
+    status = relay_archive_put(relay, "client-spill", msg);
+    JXTA_OBJECT_RELEASE(msg);
+    return status;
+}
+
+/* take the next message, which must be the one numbered seq */
+static Jxta_boolean spill_take(int seq)
+{
+    Jxta_message *msg = NULL;
+    Jxta_boolean taken;
+
+    if (JXTA_SUCCESS != relay_archive_take(relay, "client-spill", &msg)) {
+        return FALSE;
+    }
+    taken = (seq == spill_msg_seq(msg));
+    JXTA_OBJECT_RELEASE(msg);
+    return taken;
+}
+
+static Jxta_boolean spill_stats_check(apr_uint32_t archived, apr_uint32_t spilled, apr_uint32_t dropped)
+{
+    Jxta_relay_archive_stats stats;
+
+    if (JXTA_SUCCESS != jxta_relay_get_archive_stats(relay, &stats)) {
+        return FALSE;
+    }
+    return archived == stats.archived_msgs && spilled == stats.spilled_msgs && dropped == stats.dropped_msgs;
+}
+
+/**
+ * Leases are added up to the maximum, granting a lease again to a client renews it.
+ */
+const char *test_relay_lease_insert(void)
+{
+    const char *failed;
+
+    if (NULL != (failed = relay_lease_setup())) {
+        relay_lease_teardown();
+        return failed;
+    }
+
+    if (JXTA_SUCCESS != relay_lease_grant(relay, "client-a", LONG_LEASE)
+        || JXTA_SUCCESS != relay_lease_grant(relay, "client-b", LONG_LEASE)
+        || JXTA_SUCCESS != relay_lease_grant(relay, "client-c", LONG_LEASE)) {
+        failed = FILEANDLINE;
+    } else if (!relay_lease_exists(relay, "client-a") || !relay_lease_exists(relay, "client-c")
+               || relay_lease_exists(relay, "client-d")) {
+        failed = FILEANDLINE;
+    } else if (JXTA_BUSY != relay_lease_grant(relay, "client-d", LONG_LEASE) || relay_lease_exists(relay, "client-d")) {
+        failed = FILEANDLINE;
+    } else if (JXTA_SUCCESS != relay_lease_grant(relay, "client-b", LONG_LEASE)) {
+        /* renewals are not refused at the maximum */
+        failed = FILEANDLINE;
+    } else if (RELAY_LEASE_TEST_MAX != relay_leases_expire(relay)) {
+        failed = FILEANDLINE;
+    }
+
+    relay_lease_teardown();
+    return failed;
+}
+
+/**
+ * Leases granted out of expiry order are removed in expiry order, and only once expired.
+ */
+const char *test_relay_lease_expire(void)
+{
+    const char *failed;
+
+    if (NULL != (failed = relay_lease_setup())) {
+        relay_lease_teardown();
+        return failed;
+    }
+
+    relay_lease_grant(relay, "client-long", LONG_LEASE);
+    relay_lease_grant(relay, "client-late", 3 * SHORT_LEASE);
+    relay_lease_grant(relay, "client-early", SHORT_LEASE);
+
+    if (3 != relay_leases_expire(relay)) {
+        failed = FILEANDLINE;
+    }
+
+    sleep_ms(2 * SHORT_LEASE);
+    if (NULL == failed && 2 != relay_leases_expire(relay)) {
+        failed = FILEANDLINE;
+    }
+    if (NULL == failed && (relay_lease_exists(relay, "client-early") || !relay_lease_exists(relay, "client-late"))) {
+        failed = FILEANDLINE;
+    }
+
+    sleep_ms(2 * SHORT_LEASE);
+    if (NULL == failed && 1 != relay_leases_expire(relay)) {
+        failed = FILEANDLINE;
+    }
+    if (NULL == failed && (relay_lease_exists(relay, "client-late") || !relay_lease_exists(relay, "client-long"))) {
+        failed = FILEANDLINE;
+    }
+
+    relay_lease_teardown();
+    return failed;
+}
+
+/**
+ * A renewed lease moves in the expiry order and outlives its first term, an expired one is granted anew.
+ */
+const char *test_relay_lease_renew(void)
+{
+    const char *failed;
+
+    if (NULL != (failed = relay_lease_setup())) {
+        relay_lease_teardown();
+        return failed;
+    }
+
+    relay_lease_grant(relay, "client-renewed", 2 * SHORT_LEASE);
+    relay_lease_grant(relay, "client-other", 5 * SHORT_LEASE / 2);
+
+    /* renewed past its first term and past client-other */
+    sleep_ms(3 * SHORT_LEASE / 2);
+    relay_lease_grant(relay, "client-renewed", 2 * SHORT_LEASE);
+
+    /* client-other is removed only if client-renewed moved behind it in the expiry order */
+    sleep_ms(3 * SHORT_LEASE / 2);
+    if (1 != relay_leases_expire(relay) || !relay_lease_exists(relay, "client-renewed")
+        || relay_lease_exists(relay, "client-other")) {
+        failed = FILEANDLINE;
+    }
+
+    sleep_ms(3 * SHORT_LEASE / 2);
+    if (NULL == failed && (0 != relay_leases_expire(relay) || relay_lease_exists(relay, "client-renewed"))) {
+        failed = FILEANDLINE;
+    }
+
+    if (NULL == failed
+        && (JXTA_SUCCESS != relay_lease_grant(relay, "client-renewed", SHORT_LEASE) || 1 != relay_leases_expire(relay))) {
+        failed = FILEANDLINE;
+    }
+
+    relay_lease_teardown();
+    return failed;
+}
+
+/**
+ * Messages over the memory budget of a client go to its spill file, up to the spill budget, and are delivered in order. The
+ * file is bounded by the budget even when it is partly replayed.
+ */
+const char *test_relay_lease_spill(void)
+{
+    const char *failed;
+    JString *wire;
+    Jxta_message *msg;
+    apr_size_t size;
+    apr_pool_t *pool = NULL;
+    int i;
+
+    if (NULL != (failed = relay_lease_setup())) {
+        relay_lease_teardown();
+        return failed;
+    }
+
+    /* two messages in memory, three in the spill file */
+    msg = spill_msg_new(0);
+    wire = jstring_new_0();
+    jxta_message_to_jstring(msg, "application/x-jxta-msg", wire);
+    size = jstring_length(wire);
+    JXTA_OBJECT_RELEASE(wire);
+    JXTA_OBJECT_RELEASE(msg);
+    if (JXTA_SUCCESS != relay_archive_setup(relay, SPILL_TEST_DIR, 5 * size / 2, (apr_off_t) (7 * size / 2))
+        || JXTA_SUCCESS != relay_lease_grant(relay, "client-spill", LONG_LEASE)) {
+        relay_lease_teardown();
+        return FILEANDLINE;
+    }
+
+    for (i = 0; i < 5 && NULL == failed; i++) {
+        if (JXTA_SUCCESS != spill_put(i)) {
+            failed = FILEANDLINE;
+        }
+    }
+    if (NULL == failed && (JXTA_SUCCESS == spill_put(5) || !spill_stats_check(2, 3, 1))) {
+        failed = FILEANDLINE;
+    }
+
+    /* the third take loads two messages of the file, which keeps its size until replayed to its end */
+    for (i = 0; i < 3 && NULL == failed; i++) {
+        if (!spill_take(i)) {
+            failed = FILEANDLINE;
+        }
+    }
+    if (NULL == failed && (!spill_stats_check(1, 1, 1) || JXTA_SUCCESS == spill_put(6) || !spill_stats_check(1, 1, 2))) {
+        failed = FILEANDLINE;
+    }
+
+    /* once replayed, the file is removed and messages are kept in memory again */
+    if (NULL == failed && (!spill_take(3) || !spill_take(4) || spill_take(-1) || !spill_stats_check(0, 0, 2))) {
+        failed = FILEANDLINE;
+    }
+    if (NULL == failed && (JXTA_SUCCESS != spill_put(7) || !spill_stats_check(1, 0, 2) || !spill_take(7))) {
+        failed = FILEANDLINE;
+    }
+
+    relay_lease_teardown();
+    apr_pool_create(&pool, NULL);
+    apr_dir_remove(SPILL_TEST_DIR, pool);
+    apr_pool_destroy(pool);
+    return failed;
+}
+
+static struct _funcs relay_lease_test_funcs[] = {
+    {*test_relay_lease_insert, "grant relay leases up to the maximum"},
+    {*test_relay_lease_expire, "remove the expired relay leases in expiry order"},
+    {*test_relay_lease_renew, "renew relay leases"},
+    {*test_relay_lease_spill, "spill and replay the messages of a relay client"},
+
+    {NULL, "null"}
+};
+
+/**
+* Run the unit tests for the relay leases
+*
+* @param tests_run the variable in which to accumulate the number of tests run
+* @param tests_passed the variable in which to accumulate the number of tests passed
+* @param tests_failed the variable in which to accumulate the number of tests failed
+*
+* @return TRUE if all tests were run successfully, FALSE otherwise
+*/
+Jxta_boolean run_relay_lease_tests(int *tests_run, int *tests_passed, int *tests_failed)
+{
+    return run_testfunctions(relay_lease_test_funcs, tests_run, tests_passed, tests_failed);
+}
+
+#ifdef STANDALONE
+int main(int argc, char **argv)
+{
+    return main_test_function(relay_lease_test_funcs, argc, argv);
+}
+#endif
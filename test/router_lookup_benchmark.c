@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2002 Sun Microsystems, Inc.  All rights
+ * reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+/**
+ * Route lookup benchmark: times the router client recording the route of peers, as it does for the source of each
+ * routed message, and looking the routes up again, as it does for the destination of each outgoing message.
+ *
+ * usage: router_lookup_benchmark [peers [lookups]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <apr_time.h>
+
+#include "jxta.h"
+#include "jxta_id.h"
+#include "jxta_vector.h"
+#include "jxta_endpoint_address.h"
+#include "jxta_builtinmodules_private.h"
+#include "jxta_router_client_private.h"
+
+#define DEFAULT_PEERS 10000
+#define DEFAULT_LOOKUPS 100000
+
+/* spreads the lookups over the peers rather than walking them in insertion order */
+#define LOOKUP_STRIDE 7919
+
+static void report(const char *name, unsigned int count, unsigned int found, apr_time_t elapsed)
+{
+    printf("%-8s %u ops, %u found, %" APR_TIME_T_FMT " us, %.3f us/op\n", name, count, found, elapsed,
+           (double) elapsed / count);
+}
+
+int main(int argc, char *argv[])
+{
+    Jxta_router_client *router;
+    Jxta_vector *gateways;
+    Jxta_endpoint_address *gateway;
+    Jxta_endpoint_address *dest;
+    Jxta_id **keys;
+    Jxta_id **unknown;
+    Jxta_id *id;
+    JString *str;
+    apr_time_t begin;
+    unsigned int npeers = DEFAULT_PEERS;
+    unsigned int lookups = DEFAULT_LOOKUPS;
+    unsigned int found;
+    unsigned int i;
+
+    if (argc > 1) {
+        npeers = (unsigned int) strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        lookups = (unsigned int) strtoul(argv[2], NULL, 10);
+    }
+    if (npeers == 0 || lookups == 0) {
+        fprintf(stderr, "usage: %s [peers [lookups]]\n", argv[0]);
+        return -1;
+    }
+
+    jxta_initialize();
+
+    router = (Jxta_router_client *) jxta_router_client_new_instance();
+    gateways = jxta_vector_new(1);
+    gateway = jxta_endpoint_address_new("tcp://127.0.0.1:9701");
+    keys = calloc(npeers, sizeof(*keys));
+    unknown = calloc(npeers, sizeof(*unknown));
+    if (NULL == router || NULL == gateways || NULL == gateway || NULL == keys || NULL == unknown) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    jxta_vector_add_object_last(gateways, (Jxta_object *) gateway);
+    JXTA_OBJECT_RELEASE(gateway);
+
+    /* the router looks up ids parsed from addresses, never the instance it stored */
+    for (i = 0; i < npeers; i++) {
+        jxta_id_peerid_new_1(&id, jxta_id_defaultNetPeerGroupID);
+        jxta_id_to_jstring(id, &str);
+        jxta_id_from_jstring(&keys[i], str);
+        JXTA_OBJECT_RELEASE(str);
+        JXTA_OBJECT_RELEASE(id);
+        jxta_id_peerid_new_1(&unknown[i], jxta_id_defaultNetPeerGroupID);
+    }
+    printf("%u peers\n", npeers);
+
+    begin = apr_time_now();
+    for (i = 0; i < npeers; i++) {
+        dest = jxta_endpoint_address_new_3(keys[i], NULL, NULL);
+        router_client_update_route(router, dest, gateways);
+        JXTA_OBJECT_RELEASE(dest);
+    }
+    report("insert", npeers, npeers, apr_time_now() - begin);
+
+    found = 0;
+    begin = apr_time_now();
+    for (i = 0; i < lookups; i++) {
+        found += router_client_has_route(router, keys[((apr_uint64_t) i * LOOKUP_STRIDE) % npeers]) ? 1 : 0;
+    }
+    report("hit", lookups, found, apr_time_now() - begin);
+
+    found = 0;
+    begin = apr_time_now();
+    for (i = 0; i < lookups; i++) {
+        found += router_client_has_route(router, unknown[((apr_uint64_t) i * LOOKUP_STRIDE) % npeers]) ? 1 : 0;
+    }
+    report("miss", lookups, found, apr_time_now() - begin);
+
+    for (i = 0; i < npeers; i++) {
+        JXTA_OBJECT_RELEASE(keys[i]);
+        JXTA_OBJECT_RELEASE(unknown[i]);
+    }
+    free(keys);
+    free(unknown);
+    JXTA_OBJECT_RELEASE(gateways);
+    JXTA_OBJECT_RELEASE(router);
+
+    jxta_terminate();
+    return 0;
+}
+
+/* vim: set ts=4 sw=4 tw=130 et: */
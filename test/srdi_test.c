@@ -3,6 +3,14 @@
 #include "jxta.h"
 #include "jxta_srdi.h"
 #include "jxta_id.h"
+#ifdef GZIP_ENABLED
+#include <string.h>
+#include <zlib.h>
+#include <apr_strings.h>
+#include "jxta_rsrdi.h"
+#include "jxta_builtinmodules_private.h"
+#include "jxta_resolver_service_private.h"
+#endif
 
 Jxta_boolean srdi_ttl_test(Jxta_SRDIMessage * ad)
 {
@@ -62,6 +70,219 @@ Jxta_boolean srdi_entry_test(Jxta_SRDIMessage * ad)
     return TRUE;
 }
 
+#ifdef GZIP_ENABLED
+static const char *SRDI_TEST_REMOTE = "urn:jxta:uuid-59616261646162614A787461503250333B22A41D261D498DA1419E7F4ABBFD2E03";
+
+static Jxta_resolver_service *srdi_resolver_new(apr_pool_t * pool, Jxta_boolean srdi_dict)
+{
+    Jxta_resolver_service *resolver;
+    Jxta_id *peerid = NULL;
+
+    resolver = (Jxta_resolver_service *) jxta_resolver_service_ref_new_instance();
+    jxta_id_from_cstr(&peerid, "urn:jxta:uuid-59616261646162614A787461503250330000000000000000000000000000000103");
+    if (JXTA_SUCCESS != resolver_zip_setup(resolver, pool, peerid, srdi_dict)) {
+        JXTA_OBJECT_RELEASE(resolver);
+        resolver = NULL;
+    }
+    JXTA_OBJECT_RELEASE(peerid);
+    return resolver;
+}
+
+/*
+ * Hand the resolver the dictionary announcement of the remote peer, as carried by its SRDI messages.
+ */
+static void srdi_dict_announce(Jxta_resolver_service * resolver, unsigned long id)
+{
+    Jxta_message *msg;
+    Jxta_message_element *el;
+    char buf[256];
+
+    apr_snprintf(buf, sizeof(buf), "%lu %s", id, SRDI_TEST_REMOTE);
+    msg = jxta_message_new();
+    el = jxta_message_element_new_2("jxta", "SrdiDict", "text/plain", buf, strlen(buf), NULL);
+    jxta_message_add_element(msg, el);
+    resolver_srdi_dict_learn(resolver, msg);
+    JXTA_OBJECT_RELEASE(el);
+    JXTA_OBJECT_RELEASE(msg);
+}
+
+static Jxta_boolean srdi_roundtrip_check(Jxta_resolver_service * resolver, const char *doc, size_t len, unsigned char *in,
+                                         size_t in_len)
+{
+    unsigned char *out = NULL;
+    size_t out_len = 0;
+    Jxta_boolean passed;
+
+    passed = (Z_OK == resolver_zip_uncompress(resolver, &out, &out_len, in, in_len) && out_len == len
+              && 0 == memcmp(out, doc, len));
+    free(out);
+    return passed;
+}
+
+/*
+ * Compress the ResolverSRDI document of the fixture for a peer before and after it announced the preset dictionary. Each
+ * compression runs twice, the second time with a recycled stream.
+ */
+Jxta_boolean srdi_compression_test(Jxta_SRDIMessage * ad)
+{
+    apr_pool_t *pool = NULL;
+    Jxta_resolver_service *resolver = NULL;
+    Jxta_resolver_service *plain = NULL;
+    Jxta_id *remote = NULL;
+    JString *payload = NULL;
+    JString *handler;
+    JString *doc = NULL;
+    ResolverSrdi *srdi;
+    const char *dict_bytes;
+    size_t dict_size;
+    unsigned long dict_id;
+    unsigned char *gzip[2] = { NULL, NULL };
+    unsigned char *dict[2] = { NULL, NULL };
+    size_t gzip_len[2];
+    size_t dict_len[2];
+    unsigned char *out = NULL;
+    size_t out_len;
+    Jxta_boolean used;
+    const char *str;
+    size_t len;
+    int i;
+    Jxta_boolean passed = FALSE;
+
+    jxta_srdi_message_get_xml(ad, &payload);
+    handler = jstring_new_2("urn:jxta:uuid-DEADBEEFDEAFBABAFEEDBABE0000000305");
+    srdi = jxta_resolver_srdi_new_1(handler, payload, NULL);
+    jxta_resolver_srdi_get_xml(srdi, &doc);
+    str = jstring_get_string(doc);
+    len = jstring_length(doc);
+
+    dict_bytes = resolver_srdi_dictionary_get(&dict_size);
+    dict_id = adler32(adler32(0L, Z_NULL, 0), (const Bytef *) dict_bytes, dict_size);
+
+    apr_pool_create(&pool, NULL);
+    jxta_id_from_cstr(&remote, SRDI_TEST_REMOTE);
+    resolver = srdi_resolver_new(pool, TRUE);
+    plain = srdi_resolver_new(pool, FALSE);
+    if (NULL == resolver || NULL == plain) {
+        fprintf(stderr, "srdi_compression_test failed to set up the resolvers\n");
+        goto FINAL_EXIT;
+    }
+
+    /* gzip until the peer announced the dictionary, a recycled stream deflates the same bytes */
+    for (i = 0; i < 2; i++) {
+        if (0 != resolver_zip_compress(resolver, remote, &gzip[i], &gzip_len[i], str, len, &used) || used
+            || !srdi_roundtrip_check(resolver, str, len, gzip[i], gzip_len[i])) {
+            fprintf(stderr, "srdi_compression_test gzip %d failed\n", i);
+            goto FINAL_EXIT;
+        }
+    }
+    if (gzip_len[0] != gzip_len[1] || 0 != memcmp(gzip[0], gzip[1], gzip_len[0])) {
+        fprintf(stderr, "srdi_compression_test recycled gzip stream differs\n");
+        goto FINAL_EXIT;
+    }
+
+    /* the dictionary is used once announced, a recycled stream must load it again and inflating asks for it */
+    srdi_dict_announce(resolver, dict_id);
+    for (i = 0; i < 2; i++) {
+        if (0 != resolver_zip_compress(resolver, remote, &dict[i], &dict_len[i], str, len, &used) || !used
+            || !srdi_roundtrip_check(resolver, str, len, dict[i], dict_len[i])) {
+            fprintf(stderr, "srdi_compression_test dictionary %d failed\n", i);
+            goto FINAL_EXIT;
+        }
+    }
+    if (dict_len[0] != dict_len[1] || 0 != memcmp(dict[0], dict[1], dict_len[0]) || dict_len[0] >= gzip_len[0]) {
+        fprintf(stderr, "srdi_compression_test recycled dictionary stream differs or does not compress better\n");
+        goto FINAL_EXIT;
+    }
+    printf("ResolverSRDI %u bytes, gzip %u bytes (%.2f), gzip with dictionary %u bytes (%.2f)\n", (unsigned int) len,
+           (unsigned int) gzip_len[0], (double) len / gzip_len[0], (unsigned int) dict_len[0], (double) len / dict_len[0]);
+
+    /* the zlib header names the dictionary by its adler32 */
+    dict[1][2] ^= 0xff;
+    if (Z_DATA_ERROR != resolver_zip_uncompress(resolver, &out, &out_len, dict[1], dict_len[1]) || NULL != out) {
+        fprintf(stderr, "srdi_compression_test accepted an unknown dictionary\n");
+        goto FINAL_EXIT;
+    }
+
+    /* another dictionary makes the peer fall back to gzip, a resolver without the feature never uses it */
+    srdi_dict_announce(resolver, dict_id + 1);
+    srdi_dict_announce(plain, dict_id);
+    free(gzip[1]);
+    gzip[1] = NULL;
+    if (0 != resolver_zip_compress(resolver, remote, &gzip[1], &gzip_len[1], str, len, &used) || used) {
+        fprintf(stderr, "srdi_compression_test kept the dictionary of a peer which changed it\n");
+        goto FINAL_EXIT;
+    }
+    free(gzip[1]);
+    gzip[1] = NULL;
+    if (0 != resolver_zip_compress(plain, remote, &gzip[1], &gzip_len[1], str, len, &used) || used) {
+        fprintf(stderr, "srdi_compression_test used the dictionary while disabled\n");
+        goto FINAL_EXIT;
+    }
+    passed = TRUE;
+
+  FINAL_EXIT:
+    for (i = 0; i < 2; i++) {
+        free(gzip[i]);
+        free(dict[i]);
+    }
+    if (NULL != plain)
+        JXTA_OBJECT_RELEASE(plain);
+    if (NULL != resolver)
+        JXTA_OBJECT_RELEASE(resolver);
+    JXTA_OBJECT_RELEASE(remote);
+    apr_pool_destroy(pool);
+    JXTA_OBJECT_RELEASE(doc);
+    JXTA_OBJECT_RELEASE(srdi);
+    JXTA_OBJECT_RELEASE(handler);
+    JXTA_OBJECT_RELEASE(payload);
+    return passed;
+}
+
+/*
+ * A well compressed document grows the inflate buffer several times, up to the limit an SRDI message may inflate to.
+ */
+Jxta_boolean srdi_inflate_limit_test(void)
+{
+    apr_pool_t *pool = NULL;
+    Jxta_resolver_service *resolver;
+    char *doc;
+    size_t len = RESOLVER_SRDI_INFLATE_MAX + 1;
+    size_t i;
+    unsigned char *zipped = NULL;
+    size_t zipped_len;
+    unsigned char *out = NULL;
+    size_t out_len;
+    Jxta_boolean used;
+    Jxta_boolean passed = FALSE;
+
+    doc = malloc(len);
+    for (i = 0; i < len; i++) {
+        doc[i] = "&lt;Entry&gt;\n"[i % 14];
+    }
+
+    apr_pool_create(&pool, NULL);
+    resolver = srdi_resolver_new(pool, FALSE);
+    if (NULL != resolver) {
+        /* a quarter of the limit, far beyond the first guess of 8 times the deflated size */
+        if (0 == resolver_zip_compress(resolver, NULL, &zipped, &zipped_len, doc, len / 4, &used)
+            && srdi_roundtrip_check(resolver, doc, len / 4, zipped, zipped_len)) {
+            free(zipped);
+            zipped = NULL;
+            passed = (0 == resolver_zip_compress(resolver, NULL, &zipped, &zipped_len, doc, len, &used)
+                      && Z_DATA_ERROR == resolver_zip_uncompress(resolver, &out, &out_len, zipped, zipped_len) && NULL == out);
+        }
+        free(zipped);
+        JXTA_OBJECT_RELEASE(resolver);
+    }
+    apr_pool_destroy(pool);
+    free(doc);
+    if (!passed) {
+        fprintf(stderr, "srdi_inflate_limit_test failed\n");
+    }
+    return passed;
+}
+#endif
+
 int main(int argc, char **argv)
 {
     int retval;
@@ -97,6 +318,18 @@ int main(int argc, char **argv)
         printf("test failed srdi_entry_test\n");
         return -1;
     }
+#ifdef GZIP_ENABLED
+    retval = srdi_compression_test(ad);
+    if (!retval) {
+        printf("test failed srdi_compression_test\n");
+        return -1;
+    }
+    retval = srdi_inflate_limit_test();
+    if (!retval) {
+        printf("test failed srdi_inflate_limit_test\n");
+        return -1;
+    }
+#endif
     jxta_terminate();
     return 0;
 }
@@ -166,6 +166,24 @@ Jxta_boolean run_jxta_route_adv_tests(int *tests_run, int *tests_passed, int *te
 
 Jxta_boolean run_jxta_rq_tests(int *tests_run, int *tests_passed, int *tests_failed);
 
+/**
+ * The prototype for the walk_msg_test runs. It is defined in
+* walk_msg_test.c
+*/
+Jxta_boolean run_walk_msg_tests(int *tests_run, int *tests_passed, int *tests_failed);
+
+/**
+ * The prototype for the relay_lease_test runs. It is defined in
+* relay_lease_test.c
+*/
+Jxta_boolean run_relay_lease_tests(int *tests_run, int *tests_passed, int *tests_failed);
+
+/**
+ * The prototype for the rdv_seen_test runs. It is defined in
+* rdv_seen_test.c
+*/
+Jxta_boolean run_rdv_seen_tests(int *tests_run, int *tests_passed, int *tests_failed);
+
 /** 
 * The list of tests to run, terminated by NULL
 */
@@ -188,6 +206,9 @@ static struct _suite testfuncs[] = {
     {*run_jxta_route_adv_tests, "Jxta_apa Tests"},
     {*run_jxta_apa_adv_tests, "Jxta_routea Tests"},
     {*run_jxta_rq_tests, "Resolver Query Tests"},
+    {*run_walk_msg_tests, "Walk header Tests"},
+    {*run_relay_lease_tests, "Relay lease Tests"},
+    {*run_rdv_seen_tests, "Rendezvous seen message Tests"},
 
     {NULL, "null"}
 };
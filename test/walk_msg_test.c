@@ -0,0 +1,218 @@
+/* 
+ * Copyright (c) 2001 Sun Microsystems, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The end-user documentation included with the redistribution,
+ *    if any, must include the following acknowledgment:
+ *       "This product includes software developed by the
+ *       Sun Microsystems, Inc. for Project JXTA."
+ *    Alternately, this acknowledgment may appear in the software itself,
+ *    if and wherever such third-party acknowledgments normally appear.
+ *
+ * 4. The names "Sun", "Sun Microsystems, Inc.", "JXTA" and "Project JXTA" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact Project JXTA at http://www.jxta.org.
+ *
+ * 5. Products derived from this software may not be called "JXTA",
+ *    nor may "JXTA" appear in their name, without prior written
+ *    permission of Sun.
+ *
+ * THIS SOFTWARE IS PROVIDED AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL SUN MICROSYSTEMS OR
+ * ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by many
+ * individuals on behalf of Project JXTA.  For more
+ * information on Project JXTA, please see
+ * <http://www.jxta.org/>.
+ *
+ * This license is based on the BSD license adopted by the Apache Foundation.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "jxta.h"
+#include "jxta_walk_msg.h"
+
+#include "unittest_jxta_func.h"
+
+static LimitedRangeRdvMessage *build_header(void)
+{
+    LimitedRangeRdvMessage *header = LimitedRangeRdvMessage_new();
+
+    LimitedRangeRdvMessage_set_TTL(header, 7);
+    LimitedRangeRdvMessage_set_direction(header, WALK_BOTH);
+    LimitedRangeRdvMessage_set_SrcPeerID(header, "urn:jxta:uuid-59616261646162614A78746150325033C0FFEE0000000000000000000000000003");
+    LimitedRangeRdvMessage_set_SrcSvcName(header, "jxta.service.resolver");
+    LimitedRangeRdvMessage_set_SrcSvcParams(header, "");
+
+    return header;
+}
+
+const char *test_walk_msg_binary(void)
+{
+    LimitedRangeRdvMessage *header = build_header();
+    LimitedRangeRdvMessage *copy;
+    Jxta_bytevector *bytes = NULL;
+    Jxta_status result;
+
+    result = LimitedRangeRdvMessage_get_binary(header, &bytes);
+    JXTA_OBJECT_RELEASE(header);
+    if (JXTA_SUCCESS != result) {
+        return FILEANDLINE;
+    }
+
+    copy = LimitedRangeRdvMessage_new();
+    result = LimitedRangeRdvMessage_parse_binary(copy, jxta_bytevector_content_ptr(bytes), jxta_bytevector_size(bytes));
+    if (JXTA_SUCCESS != result) {
+        return FILEANDLINE;
+    }
+
+    if (7 != LimitedRangeRdvMessage_get_TTL(copy) || WALK_BOTH != LimitedRangeRdvMessage_get_direction(copy)) {
+        return FILEANDLINE;
+    }
+
+    if (0 != strcmp("jxta.service.resolver", LimitedRangeRdvMessage_get_SrcSvcName(copy))) {
+        return FILEANDLINE;
+    }
+
+    if (NULL != LimitedRangeRdvMessage_get_SrcSvcParams(copy)) {
+        return FILEANDLINE;
+    }
+
+    /* a truncated header is rejected */
+    result = LimitedRangeRdvMessage_parse_binary(copy, jxta_bytevector_content_ptr(bytes), jxta_bytevector_size(bytes) - 1);
+    if (JXTA_SUCCESS == result) {
+        return FILEANDLINE;
+    }
+
+    JXTA_OBJECT_RELEASE(copy);
+    JXTA_OBJECT_RELEASE(bytes);
+
+    return NULL;
+}
+
+const char *test_walk_msg_binary_update(void)
+{
+    LimitedRangeRdvMessage *header = build_header();
+    Jxta_bytevector *bytes = NULL;
+    Jxta_status result;
+    char *buf;
+    size_t len;
+    int ttl;
+    Walk_direction dir;
+
+    result = LimitedRangeRdvMessage_get_binary(header, &bytes);
+    JXTA_OBJECT_RELEASE(header);
+    if (JXTA_SUCCESS != result) {
+        return FILEANDLINE;
+    }
+
+    len = jxta_bytevector_size(bytes);
+    buf = malloc(len);
+    memcpy(buf, jxta_bytevector_content_ptr(bytes), len);
+    JXTA_OBJECT_RELEASE(bytes);
+
+    result = LimitedRangeRdvMessage_binary_set_TTL_direction(buf, len, 6, WALK_DOWN);
+    if (JXTA_SUCCESS != result) {
+        return FILEANDLINE;
+    }
+
+    result = LimitedRangeRdvMessage_binary_get_TTL_direction(buf, len, &ttl, &dir);
+    if (JXTA_SUCCESS != result || 6 != ttl || WALK_DOWN != dir) {
+        return FILEANDLINE;
+    }
+
+    /* an XML header is not mistaken for a binary one */
+    result = LimitedRangeRdvMessage_binary_get_TTL_direction("<?xml version=\"1.0\"?>", 21, &ttl, &dir);
+    if (JXTA_SUCCESS == result) {
+        return FILEANDLINE;
+    }
+
+    free(buf);
+
+    return NULL;
+}
+
+const char *test_walk_msg_xml(void)
+{
+    LimitedRangeRdvMessage *header = build_header();
+    LimitedRangeRdvMessage *copy;
+    JString *dump;
+    Jxta_status result;
+
+    result = LimitedRangeRdvMessage_get_xml(header, &dump);
+    JXTA_OBJECT_RELEASE(header);
+    if (JXTA_SUCCESS != result) {
+        return FILEANDLINE;
+    }
+
+    copy = LimitedRangeRdvMessage_new();
+    result = LimitedRangeRdvMessage_parse_charbuffer(copy, jstring_get_string(dump), jstring_length(dump));
+    JXTA_OBJECT_RELEASE(dump);
+    if (JXTA_SUCCESS != result) {
+        return FILEANDLINE;
+    }
+
+    if (7 != LimitedRangeRdvMessage_get_TTL(copy) || WALK_BOTH != LimitedRangeRdvMessage_get_direction(copy)) {
+        return FILEANDLINE;
+    }
+
+    JXTA_OBJECT_RELEASE(copy);
+
+    return NULL;
+}
+
+static struct _funcs walk_msg_test_funcs[] = {
+    {*test_walk_msg_xml, "read/write test for the XML walk header"},
+    {*test_walk_msg_binary, "read/write test for the binary walk header"},
+    {*test_walk_msg_binary_update, "in place update of the binary walk header"},
+
+    {NULL, "null"}
+};
+
+/**
+* Run the unit tests for the walk header routines
+*
+* @param tests_run the variable in which to accumulate the number of tests run
+* @param tests_passed the variable in which to accumulate the number of tests passed
+* @param tests_failed the variable in which to accumulate the number of tests failed
+*
+* @return TRUE if all tests were run successfully, FALSE otherwise
+*/
+Jxta_boolean run_walk_msg_tests(int *tests_run, int *tests_passed, int *tests_failed)
+{
+    return run_testfunctions(walk_msg_test_funcs, tests_run, tests_passed, tests_failed);
+}
+
+#ifdef STANDALONE
+int main(int argc, char **argv)
+{
+    return main_test_function(walk_msg_test_funcs, argc, argv);
+}
+#endif